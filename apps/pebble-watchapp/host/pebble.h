@@ -0,0 +1,446 @@
+#pragma once
+
+// Host-native stand-in for the Pebble SDK header.
+// Only the API surface used by src/c is declared here; signatures, enum values
+// and the packed Dictionary/Tuple layout mirror SDK 4.3 so that buffer sizes and
+// return codes behave the same as on the watch. Control hooks for tests and
+// benchmarks live in pebble_stub.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Logging
+
+typedef enum {
+    APP_LOG_LEVEL_ERROR = 1,
+    APP_LOG_LEVEL_WARNING = 50,
+    APP_LOG_LEVEL_INFO = 100,
+    APP_LOG_LEVEL_DEBUG = 200,
+    APP_LOG_LEVEL_DEBUG_VERBOSE = 255
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number,
+             const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+
+#define APP_LOG(level, fmt, ...) \
+    app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+// Time
+
+// Redirect the libc clock to the stub's controllable clock.
+time_t stub_time(time_t *tloc);
+#define time(tloc) stub_time(tloc)
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms);
+
+// Status codes
+
+typedef int32_t status_t;
+
+#define S_SUCCESS 0
+#define E_ERROR (-1)
+#define E_INVALID_ARGUMENT (-4)
+#define E_OUT_OF_STORAGE (-6)
+#define E_DOES_NOT_EXIST (-8)
+
+// Persistent storage
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+status_t persist_delete(const uint32_t key);
+
+// Event loop
+
+void app_event_loop(void);
+
+// Timers
+
+struct AppTimer;
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+
+// Tick timer service
+
+typedef enum {
+    SECOND_UNIT = 1 << 0,
+    MINUTE_UNIT = 1 << 1,
+    HOUR_UNIT = 1 << 2,
+    DAY_UNIT = 1 << 3,
+    MONTH_UNIT = 1 << 4,
+    YEAR_UNIT = 1 << 5
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+// Graphics types
+
+typedef struct GPoint {
+    int16_t x;
+    int16_t y;
+} GPoint;
+
+typedef struct GSize {
+    int16_t w;
+    int16_t h;
+} GSize;
+
+typedef struct GRect {
+    GPoint origin;
+    GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint){(x), (y)})
+#define GSize(w, h) ((GSize){(w), (h)})
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+#define GRectZero GRect(0, 0, 0, 0)
+
+typedef union GColor8 {
+    uint8_t argb;
+    struct {
+        uint8_t b:2;
+        uint8_t g:2;
+        uint8_t r:2;
+        uint8_t a:2;
+    };
+} GColor8;
+
+typedef GColor8 GColor;
+
+#define GColorClearARGB8 ((uint8_t)0x00)
+#define GColorBlackARGB8 ((uint8_t)0xC0)
+#define GColorRedARGB8 ((uint8_t)0xF0)
+#define GColorGreenARGB8 ((uint8_t)0xCC)
+#define GColorYellowARGB8 ((uint8_t)0xFC)
+#define GColorOrangeARGB8 ((uint8_t)0xF8)
+#define GColorBlueARGB8 ((uint8_t)0xC3)
+#define GColorLightGrayARGB8 ((uint8_t)0xEA)
+#define GColorWhiteARGB8 ((uint8_t)0xFF)
+
+#define GColorClear ((GColor8){.argb = GColorClearARGB8})
+#define GColorBlack ((GColor8){.argb = GColorBlackARGB8})
+#define GColorRed ((GColor8){.argb = GColorRedARGB8})
+#define GColorGreen ((GColor8){.argb = GColorGreenARGB8})
+#define GColorYellow ((GColor8){.argb = GColorYellowARGB8})
+#define GColorOrange ((GColor8){.argb = GColorOrangeARGB8})
+#define GColorBlue ((GColor8){.argb = GColorBlueARGB8})
+#define GColorLightGray ((GColor8){.argb = GColorLightGrayARGB8})
+#define GColorWhite ((GColor8){.argb = GColorWhiteARGB8})
+
+bool gcolor_equal(GColor8 x, GColor8 y);
+
+typedef enum {
+    GCornerNone = 0,
+    GCornerTopLeft = 1 << 0,
+    GCornerTopRight = 1 << 1,
+    GCornerBottomLeft = 1 << 2,
+    GCornerBottomRight = 1 << 3,
+    GCornersAll = GCornerTopLeft | GCornerTopRight | GCornerBottomLeft | GCornerBottomRight
+} GCornerMask;
+
+typedef enum {
+    GTextOverflowModeWordWrap,
+    GTextOverflowModeTrailingEllipsis,
+    GTextOverflowModeFill
+} GTextOverflowMode;
+
+typedef enum {
+    GTextAlignmentLeft,
+    GTextAlignmentCenter,
+    GTextAlignmentRight
+} GTextAlignment;
+
+struct GContext;
+typedef struct GContext GContext;
+
+struct FontInfo;
+typedef struct FontInfo *GFont;
+
+typedef struct GTextAttributes GTextAttributes;
+
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_28_BOLD "RESOURCE_ID_GOTHIC_28_BOLD"
+
+GFont fonts_get_system_font(const char *font_key);
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes);
+
+// Layers and windows
+
+struct Layer;
+typedef struct Layer Layer;
+typedef void (*LayerUpdateProc)(struct Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void *layer_get_data(const Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer *layer);
+GRect layer_get_bounds(const Layer *layer);
+GRect layer_get_frame(const Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *child);
+void layer_set_hidden(Layer *layer, bool hidden);
+bool layer_get_hidden(const Layer *layer);
+
+struct Window;
+typedef struct Window Window;
+typedef void (*WindowHandler)(struct Window *window);
+
+typedef struct WindowHandlers {
+    WindowHandler load;
+    WindowHandler appear;
+    WindowHandler disappear;
+    WindowHandler unload;
+} WindowHandlers;
+
+Window *window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_background_color(Window *window, GColor background_color);
+Layer *window_get_root_layer(const Window *window);
+void window_stack_push(Window *window, bool animated);
+bool window_stack_remove(Window *window, bool animated);
+void window_stack_pop_all(const bool animated);
+Window *window_stack_get_top_window(void);
+
+// Dictionaries
+
+typedef enum {
+    TUPLE_BYTE_ARRAY = 0,
+    TUPLE_CSTRING = 1,
+    TUPLE_UINT = 2,
+    TUPLE_INT = 3
+} TupleType;
+
+typedef struct __attribute__((__packed__)) {
+    uint32_t key;
+    TupleType type:8;
+    uint16_t length;
+    union {
+        uint8_t data[0];
+        char cstring[0];
+        uint8_t uint8;
+        uint16_t uint16;
+        uint32_t uint32;
+        int8_t int8;
+        int16_t int16;
+        int32_t int32;
+    } value[];
+} Tuple;
+
+struct Dictionary;
+typedef struct Dictionary Dictionary;
+
+typedef struct {
+    Dictionary *dictionary;
+    const void *end;
+    Tuple *cursor;
+} DictionaryIterator;
+
+typedef enum {
+    DICT_OK = 0,
+    DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+    DICT_INVALID_ARGS = 1 << 2,
+    DICT_INTERNAL_INCONSISTENCY = 1 << 3,
+    DICT_MALLOC_FAILED = 1 << 4
+} DictionaryResult;
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...);
+uint32_t dict_size(DictionaryIterator *iter);
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t *const buffer, const uint16_t size);
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t *const data, const uint16_t size);
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *const cstring);
+DictionaryResult dict_write_int(DictionaryIterator *iter, const uint32_t key, const void *integer, const uint8_t width_bytes, const bool is_signed);
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value);
+DictionaryResult dict_write_uint16(DictionaryIterator *iter, const uint32_t key, const uint16_t value);
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value);
+DictionaryResult dict_write_int8(DictionaryIterator *iter, const uint32_t key, const int8_t value);
+DictionaryResult dict_write_int16(DictionaryIterator *iter, const uint32_t key, const int16_t value);
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value);
+uint32_t dict_write_end(DictionaryIterator *iter);
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t *const buffer, const uint16_t size);
+Tuple *dict_read_next(DictionaryIterator *iter);
+Tuple *dict_read_first(DictionaryIterator *iter);
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key);
+
+// AppMessage
+
+typedef enum {
+    APP_MSG_OK = 0,
+    APP_MSG_SEND_TIMEOUT = 1 << 1,
+    APP_MSG_SEND_REJECTED = 1 << 2,
+    APP_MSG_NOT_CONNECTED = 1 << 3,
+    APP_MSG_APP_NOT_RUNNING = 1 << 4,
+    APP_MSG_INVALID_ARGS = 1 << 5,
+    APP_MSG_BUSY = 1 << 6,
+    APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+    APP_MSG_ALREADY_RELEASED = 1 << 9,
+    APP_MSG_CALLBACK_ALREADY_REGISTERED = 1 << 10,
+    APP_MSG_CALLBACK_NOT_REGISTERED = 1 << 11,
+    APP_MSG_OUT_OF_MEMORY = 1 << 12,
+    APP_MSG_CLOSED = 1 << 13,
+    APP_MSG_INTERNAL_ERROR = 1 << 14,
+    APP_MSG_INVALID_STATE = 1 << 15
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void *context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason, void *context);
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+void app_message_deregister_callbacks(void);
+void *app_message_get_context(void);
+void *app_message_set_context(void *context);
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback);
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+uint32_t app_message_inbox_size_maximum(void);
+uint32_t app_message_outbox_size_maximum(void);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+// Bluetooth connection interval
+
+typedef enum {
+    SNIFF_INTERVAL_NORMAL = 0,
+    SNIFF_INTERVAL_REDUCED = 1
+} SniffInterval;
+
+void app_comm_set_sniff_interval(const SniffInterval interval);
+SniffInterval app_comm_get_sniff_interval(void);
+
+// Connection service
+
+typedef void (*ConnectionHandler)(bool connected);
+
+typedef struct {
+    ConnectionHandler pebble_app_connection_handler;
+    ConnectionHandler pebblekit_connection_handler;
+} ConnectionHandlers;
+
+void connection_service_subscribe(ConnectionHandlers conn_handlers);
+void connection_service_unsubscribe(void);
+bool connection_service_peek_pebble_app_connection(void);
+bool connection_service_peek_pebblekit_connection(void);
+
+// Battery
+
+typedef struct {
+    uint8_t charge_percent;
+    bool is_charging;
+    bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+BatteryChargeState battery_state_service_peek(void);
+
+// Data logging
+
+typedef struct DataLoggingSession *DataLoggingSessionRef;
+
+typedef enum {
+    DATA_LOGGING_BYTE_ARRAY = 0,
+    DATA_LOGGING_UINT = 2,
+    DATA_LOGGING_INT = 3
+} DataLoggingItemType;
+
+typedef enum {
+    DATA_LOGGING_SUCCESS = 0,
+    DATA_LOGGING_BUSY,
+    DATA_LOGGING_FULL,
+    DATA_LOGGING_NOT_FOUND,
+    DATA_LOGGING_CLOSED,
+    DATA_LOGGING_INVALID_PARAMS,
+    DATA_LOGGING_INTERNAL_ERR
+} DataLoggingResult;
+
+DataLoggingSessionRef data_logging_create(uint32_t tag, DataLoggingItemType item_type, uint16_t item_length,
+                                          bool resume);
+void data_logging_finish(DataLoggingSessionRef logging_session);
+DataLoggingResult data_logging_log(DataLoggingSessionRef logging_session, const void *data, uint32_t num_items);
+
+// Heap
+
+size_t heap_bytes_used(void);
+
+// Vibes
+
+void vibes_short_pulse(void);
+void vibes_double_pulse(void);
+
+// Health
+
+typedef int32_t HealthValue;
+
+// Sentinel the watchapp compares peeked values against
+#define HealthValueInvalid ((HealthValue)0)
+
+typedef enum {
+    HealthMetricStepCount,
+    HealthMetricActiveSeconds,
+    HealthMetricWalkedDistanceMeters,
+    HealthMetricSleepSeconds,
+    HealthMetricSleepRestfulSeconds,
+    HealthMetricRestingKCalories,
+    HealthMetricActiveKCalories,
+    HealthMetricHeartRateBPM,
+    HealthMetricHeartRateRawBPM
+} HealthMetric;
+
+typedef enum {
+    HealthEventSignificantUpdate = 0,
+    HealthEventMovementUpdate,
+    HealthEventSleepUpdate,
+    HealthEventMetricAlert,
+    HealthEventHeartRateUpdate
+} HealthEventType;
+
+typedef void (*HealthEventHandler)(HealthEventType event, void *context);
+
+bool health_service_events_subscribe(HealthEventHandler handler, void *context);
+bool health_service_events_unsubscribe(void);
+bool health_service_set_heart_rate_sample_period(uint16_t interval_sec);
+HealthValue health_service_peek_current_value(HealthMetric metric);
+
+// One minute of the firmware's health history; is_invalid marks minutes
+// without data
+typedef struct {
+    uint8_t steps;
+    uint8_t orientation;
+    uint16_t vmc;
+    bool is_invalid;
+    uint8_t light;
+    uint8_t heart_rate_bpm;
+} HealthMinuteData;
+
+uint32_t health_service_get_minute_history(HealthMinuteData *minute_data, uint32_t max_records,
+                                           time_t *time_start, time_t *time_end);
@@ -0,0 +1,1587 @@
+#include "pebble_stub.h"
+
+#include <stdarg.h>
+
+// Host implementation of the Pebble SDK subset declared in pebble.h.
+// State is process-global, as it is on the watch; stub_reset() returns
+// everything to power-on defaults between test cases.
+
+#define MAX_WINDOWS 8
+#define MAX_FONTS 8
+#define LOG_BUFFER_SIZE 256
+#define TUPLE_HEADER_SIZE (sizeof(Tuple))
+
+_Static_assert(sizeof(Tuple) == 7, "Tuple header must match the SDK wire layout");
+
+struct Dictionary {
+    uint8_t count;
+    uint8_t head[];
+} __attribute__((__packed__));
+
+struct Layer {
+    GRect frame;
+    LayerUpdateProc update_proc;
+    Layer *parent;
+    Layer *first_child;
+    Layer *next_sibling;
+    Window *window;
+    bool hidden;
+    uint8_t data[];
+};
+
+struct Window {
+    Layer *root_layer;
+    WindowHandlers handlers;
+    GColor background_color;
+    bool loaded;
+    bool dirty;
+};
+
+struct GContext {
+    GColor fill_color;
+    GColor text_color;
+    GRect clip;
+    GPoint offset;
+};
+
+struct FontInfo {
+    const char *key;
+};
+
+struct AppTimer {
+    uint64_t due_ms;
+    AppTimerCallback callback;
+    void *data;
+    AppTimer *next;
+};
+
+typedef enum {
+    OUTBOX_IDLE,
+    OUTBOX_WRITING,
+    OUTBOX_SENDING
+} OutboxState;
+
+static StubStats s_stats;
+static StubEventLoop s_event_loop;
+static bool s_log_echo;
+static uint64_t s_now_ms = STUB_DEFAULT_EPOCH_MS;
+
+static Window *s_window_stack[MAX_WINDOWS];
+static int s_window_count;
+static struct FontInfo s_fonts[MAX_FONTS];
+static int s_font_count;
+
+static AppTimer *s_timers;
+
+typedef struct {
+    bool used;
+    uint32_t key;
+    uint16_t size;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+static PersistEntry s_persist[STUB_PERSIST_MAX_KEYS];
+
+static TickHandler s_tick_handler;
+static TimeUnits s_tick_units;
+static uint64_t s_next_tick_ms;
+
+static SniffInterval s_sniff_interval;
+static uint64_t s_sniff_since_ms;
+
+static ConnectionHandlers s_connection_handlers;
+static bool s_connected;
+
+struct DataLoggingSession {
+    bool used;
+    bool open;
+    uint32_t tag;
+    DataLoggingItemType item_type;
+    uint16_t item_length;
+    uint32_t bytes;
+    uint8_t data[STUB_DATALOG_SESSION_BYTES];
+};
+
+static struct DataLoggingSession s_datalog[STUB_DATALOG_MAX_SESSIONS];
+static uint32_t s_datalog_capacity;
+
+static size_t s_heap_used;
+
+static BatteryStateHandler s_battery_handler;
+static BatteryChargeState s_battery_state;
+
+static HealthEventHandler s_health_handler;
+static void *s_health_context;
+static HealthValue s_health_values[HealthMetricHeartRateRawBPM + 1];
+static uint16_t s_health_sample_period;
+
+// Minute history slots, indexed by minute number modulo the history length
+typedef struct {
+    uint32_t minute;
+    uint32_t bpm_sum;
+    uint16_t readings;
+} HealthMinuteSlot;
+
+static HealthMinuteSlot s_health_minutes[STUB_HEALTH_HISTORY_MINUTES];
+
+static AppMessageInboxReceived s_inbox_received;
+static AppMessageInboxDropped s_inbox_dropped;
+static AppMessageOutboxSent s_outbox_sent;
+static AppMessageOutboxFailed s_outbox_failed;
+static void *s_appmsg_context;
+static uint8_t *s_inbox_buffer;
+static uint8_t *s_outbox_buffer;
+static uint8_t *s_last_sent_buffer;
+static uint32_t s_inbox_size;
+static uint32_t s_outbox_size;
+static uint32_t s_inbox_maximum = STUB_APPMSG_SIZE_MAXIMUM;
+static uint32_t s_outbox_maximum = STUB_APPMSG_SIZE_MAXIMUM;
+static uint32_t s_last_sent_size;
+static DictionaryIterator s_outbox_iter;
+static OutboxState s_outbox_state;
+static bool s_auto_ack;
+static uint32_t s_ack_latency_ms;
+static uint8_t s_nack_percent;
+static uint32_t s_nack_random;
+static bool s_ack_scheduled;
+static uint64_t s_ack_due_ms;
+static StubOutboxObserver s_outbox_observer;
+static void *s_outbox_observer_context;
+
+// Global state
+
+void stub_reset(void) {
+    while (s_timers) {
+        AppTimer *next = s_timers->next;
+        free(s_timers);
+        s_timers = next;
+    }
+    free(s_inbox_buffer);
+    free(s_outbox_buffer);
+    free(s_last_sent_buffer);
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_event_loop = NULL;
+    s_log_echo = false;
+    s_now_ms = STUB_DEFAULT_EPOCH_MS;
+
+    memset(s_window_stack, 0, sizeof(s_window_stack));
+    s_window_count = 0;
+
+    s_tick_handler = NULL;
+    s_tick_units = 0;
+    s_next_tick_ms = 0;
+
+    memset(s_persist, 0, sizeof(s_persist));
+
+    s_sniff_interval = SNIFF_INTERVAL_NORMAL;
+    s_sniff_since_ms = 0;
+
+    s_connection_handlers = (ConnectionHandlers){ 0 };
+    s_connected = true;
+
+    memset(s_datalog, 0, sizeof(s_datalog));
+    s_datalog_capacity = STUB_DATALOG_SESSION_BYTES;
+
+    s_heap_used = 0;
+
+    s_battery_handler = NULL;
+    s_battery_state = (BatteryChargeState){ .charge_percent = 100 };
+
+    s_health_handler = NULL;
+    s_health_context = NULL;
+    memset(s_health_values, 0, sizeof(s_health_values));
+    s_health_sample_period = 0;
+    memset(s_health_minutes, 0, sizeof(s_health_minutes));
+
+    s_inbox_received = NULL;
+    s_inbox_dropped = NULL;
+    s_outbox_sent = NULL;
+    s_outbox_failed = NULL;
+    s_appmsg_context = NULL;
+    s_inbox_buffer = NULL;
+    s_outbox_buffer = NULL;
+    s_last_sent_buffer = NULL;
+    s_inbox_size = 0;
+    s_outbox_size = 0;
+    s_inbox_maximum = STUB_APPMSG_SIZE_MAXIMUM;
+    s_outbox_maximum = STUB_APPMSG_SIZE_MAXIMUM;
+    s_last_sent_size = 0;
+    s_outbox_state = OUTBOX_IDLE;
+    s_auto_ack = false;
+    s_ack_latency_ms = 0;
+    s_nack_percent = 0;
+    s_nack_random = 1;
+    s_ack_scheduled = false;
+    s_outbox_observer = NULL;
+    s_outbox_observer_context = NULL;
+}
+
+void stub_app_exit(void) {
+    static PersistEntry saved[STUB_PERSIST_MAX_KEYS];
+    static HealthMinuteSlot saved_minutes[STUB_HEALTH_HISTORY_MINUTES];
+    static struct DataLoggingSession saved_datalog[STUB_DATALOG_MAX_SESSIONS];
+    memcpy(saved, s_persist, sizeof(saved));
+    memcpy(saved_minutes, s_health_minutes, sizeof(saved_minutes));
+    memcpy(saved_datalog, s_datalog, sizeof(saved_datalog));
+    uint32_t datalog_capacity = s_datalog_capacity;
+    // The firmware drops a reduced interval the app left behind
+    app_comm_set_sniff_interval(SNIFF_INTERVAL_NORMAL);
+    StubStats stats = s_stats;
+    uint64_t now_ms = s_now_ms;
+
+    stub_reset();
+
+    memcpy(s_persist, saved, sizeof(saved));
+    memcpy(s_health_minutes, saved_minutes, sizeof(saved_minutes));
+    memcpy(s_datalog, saved_datalog, sizeof(saved_datalog));
+    s_datalog_capacity = datalog_capacity;
+    s_stats = stats;
+    s_now_ms = now_ms;
+}
+
+const StubStats *stub_get_stats(void) {
+    return &s_stats;
+}
+
+void stub_reset_stats(void) {
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+void stub_set_event_loop(StubEventLoop loop) {
+    s_event_loop = loop;
+}
+
+void stub_log_set_echo(bool echo) {
+    s_log_echo = echo;
+}
+
+void app_event_loop(void) {
+    if (s_event_loop) {
+        s_event_loop();
+    }
+}
+
+// Logging
+
+static const char *log_level_name(uint8_t level) {
+    switch (level) {
+        case APP_LOG_LEVEL_ERROR: return "E";
+        case APP_LOG_LEVEL_WARNING: return "W";
+        case APP_LOG_LEVEL_INFO: return "I";
+        case APP_LOG_LEVEL_DEBUG: return "D";
+        default: return "V";
+    }
+}
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number,
+             const char *fmt, ...) {
+    // Format unconditionally so benchmarks see the same cost as the watch
+    char message[LOG_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+
+    s_stats.log_calls++;
+    if (length > 0) {
+        s_stats.log_bytes += (uint32_t)length;
+    }
+
+    if (s_log_echo) {
+        fprintf(stderr, "[%s] %s:%d> %s\n", log_level_name(log_level),
+                src_filename, src_line_number, message);
+    }
+}
+
+// Virtual clock and timers
+
+void stub_clock_set_ms(uint64_t epoch_ms) {
+    s_now_ms = epoch_ms;
+}
+
+uint64_t stub_clock_now_ms(void) {
+    return s_now_ms;
+}
+
+time_t stub_time(time_t *tloc) {
+    time_t now = (time_t)(s_now_ms / 1000);
+    if (tloc) {
+        *tloc = now;
+    }
+    return now;
+}
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms) {
+    uint16_t ms = (uint16_t)(s_now_ms % 1000);
+    if (t_utc) {
+        *t_utc = (time_t)(s_now_ms / 1000);
+    }
+    if (out_ms) {
+        *out_ms = ms;
+    }
+    return ms;
+}
+
+static void timer_unlink(AppTimer *timer) {
+    AppTimer **link = &s_timers;
+    while (*link) {
+        if (*link == timer) {
+            *link = timer->next;
+            return;
+        }
+        link = &(*link)->next;
+    }
+}
+
+static bool timer_is_registered(AppTimer *timer) {
+    for (AppTimer *it = s_timers; it; it = it->next) {
+        if (it == timer) {
+            return true;
+        }
+    }
+    return false;
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+    if (!callback) {
+        return NULL;
+    }
+    AppTimer *timer = malloc(sizeof(AppTimer));
+    if (!timer) {
+        return NULL;
+    }
+    timer->due_ms = s_now_ms + timeout_ms;
+    timer->callback = callback;
+    timer->data = callback_data;
+    timer->next = s_timers;
+    s_timers = timer;
+    return timer;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+    if (!timer_is_registered(timer_handle)) {
+        return false;
+    }
+    timer_handle->due_ms = s_now_ms + new_timeout_ms;
+    return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+    if (timer_is_registered(timer_handle)) {
+        timer_unlink(timer_handle);
+        free(timer_handle);
+    }
+}
+
+static AppTimer *next_due_timer(uint64_t limit_ms) {
+    AppTimer *earliest = NULL;
+    for (AppTimer *it = s_timers; it; it = it->next) {
+        if (it->due_ms <= limit_ms && (!earliest || it->due_ms < earliest->due_ms)) {
+            earliest = it;
+        }
+    }
+    return earliest;
+}
+
+// Tick timer service
+
+static uint64_t tick_period_ms(void) {
+    if (s_tick_units & SECOND_UNIT) {
+        return 1000;
+    }
+    if (s_tick_units & MINUTE_UNIT) {
+        return 60 * 1000;
+    }
+    return 60 * 60 * 1000;
+}
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+    s_tick_handler = handler;
+    s_tick_units = tick_units;
+
+    // First tick on the next whole-unit boundary of the UTC wall clock
+    uint64_t period = tick_period_ms();
+    s_next_tick_ms = (s_now_ms / period + 1) * period;
+}
+
+void tick_timer_service_unsubscribe(void) {
+    s_tick_handler = NULL;
+    s_tick_units = 0;
+}
+
+bool stub_tick_is_subscribed(void) {
+    return s_tick_handler != NULL;
+}
+
+static void fire_tick(void) {
+    time_t now = (time_t)(s_now_ms / 1000);
+    struct tm tick_time;
+    gmtime_r(&now, &tick_time);
+
+    TimeUnits changed = SECOND_UNIT;
+    if (tick_time.tm_sec == 0) {
+        changed |= MINUTE_UNIT;
+        if (tick_time.tm_min == 0) {
+            changed |= HOUR_UNIT;
+        }
+    }
+    s_next_tick_ms += tick_period_ms();
+    s_stats.ticks_fired++;
+    s_tick_handler(&tick_time, changed);
+}
+
+static void deliver_outbox_result(void);
+
+void stub_advance_ms(uint32_t ms) {
+    uint64_t target_ms = s_now_ms + ms;
+
+    // Dispatch due events in timestamp order, rendering after each one
+    for (;;) {
+        AppTimer *timer = next_due_timer(target_ms);
+        bool ack_due = s_ack_scheduled && s_ack_due_ms <= target_ms;
+        bool tick_due = s_tick_handler && s_next_tick_ms <= target_ms &&
+                        (!timer || s_next_tick_ms <= timer->due_ms) &&
+                        (!ack_due || s_next_tick_ms <= s_ack_due_ms);
+
+        if (tick_due) {
+            s_now_ms = s_next_tick_ms;
+            fire_tick();
+        } else if (ack_due && (!timer || s_ack_due_ms <= timer->due_ms)) {
+            if (s_ack_due_ms > s_now_ms) {
+                s_now_ms = s_ack_due_ms;
+            }
+            deliver_outbox_result();
+        } else if (timer) {
+            if (timer->due_ms > s_now_ms) {
+                s_now_ms = timer->due_ms;
+            }
+            AppTimerCallback callback = timer->callback;
+            void *data = timer->data;
+            timer_unlink(timer);
+            free(timer);
+            s_stats.timers_fired++;
+            callback(data);
+        } else {
+            break;
+        }
+        stub_render();
+    }
+
+    s_now_ms = target_ms;
+}
+
+// Graphics
+
+bool gcolor_equal(GColor8 x, GColor8 y) {
+    return x.argb == y.argb;
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+    for (int i = 0; i < s_font_count; i++) {
+        if (strcmp(s_fonts[i].key, font_key) == 0) {
+            return &s_fonts[i];
+        }
+    }
+    if (s_font_count == MAX_FONTS) {
+        return NULL;
+    }
+    s_fonts[s_font_count].key = font_key;
+    return &s_fonts[s_font_count++];
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+    ctx->fill_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+    ctx->text_color = color;
+}
+
+static GRect clip_rect(const GContext *ctx, GRect rect) {
+    int x0 = rect.origin.x + ctx->offset.x;
+    int y0 = rect.origin.y + ctx->offset.y;
+    int x1 = x0 + rect.size.w;
+    int y1 = y0 + rect.size.h;
+    int cx0 = ctx->clip.origin.x;
+    int cy0 = ctx->clip.origin.y;
+    int cx1 = cx0 + ctx->clip.size.w;
+    int cy1 = cy0 + ctx->clip.size.h;
+
+    if (x0 < cx0) x0 = cx0;
+    if (y0 < cy0) y0 = cy0;
+    if (x1 > cx1) x1 = cx1;
+    if (y1 > cy1) y1 = cy1;
+    if (x1 <= x0 || y1 <= y0) {
+        return GRectZero;
+    }
+    return GRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+    (void)corner_radius;
+    (void)corner_mask;
+    GRect clipped = clip_rect(ctx, rect);
+    s_stats.fill_rects++;
+    s_stats.fill_pixels += (uint64_t)clipped.size.w * (uint64_t)clipped.size.h;
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+    GRect box = GRect(p.x - radius, p.y - radius, 2 * radius + 1, 2 * radius + 1);
+    GRect clipped = clip_rect(ctx, box);
+    s_stats.fill_rects++;
+    s_stats.fill_pixels += (uint64_t)clipped.size.w * (uint64_t)clipped.size.h;
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes) {
+    (void)ctx;
+    (void)font;
+    (void)box;
+    (void)overflow_mode;
+    (void)alignment;
+    (void)text_attributes;
+    s_stats.text_draws++;
+    if (text) {
+        s_stats.text_bytes += (uint32_t)strlen(text);
+    }
+}
+
+// Layers
+
+static Window *layer_window(const Layer *layer) {
+    while (layer && !layer->window) {
+        layer = layer->parent;
+    }
+    return layer ? layer->window : NULL;
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+    Layer *layer = calloc(1, sizeof(Layer) + data_size);
+    if (layer) {
+        layer->frame = frame;
+    }
+    return layer;
+}
+
+Layer *layer_create(GRect frame) {
+    return layer_create_with_data(frame, 0);
+}
+
+void layer_remove_from_parent(Layer *child) {
+    if (!child || !child->parent) {
+        return;
+    }
+    Window *window = layer_window(child);
+    Layer **link = &child->parent->first_child;
+    while (*link) {
+        if (*link == child) {
+            *link = child->next_sibling;
+            break;
+        }
+        link = &(*link)->next_sibling;
+    }
+    child->parent = NULL;
+    child->next_sibling = NULL;
+    if (window) {
+        window->dirty = true;
+    }
+}
+
+void layer_destroy(Layer *layer) {
+    if (!layer) {
+        return;
+    }
+    layer_remove_from_parent(layer);
+    // Orphan any children still attached, as the firmware does
+    Layer *child = layer->first_child;
+    while (child) {
+        Layer *next = child->next_sibling;
+        child->parent = NULL;
+        child->next_sibling = NULL;
+        child = next;
+    }
+    free(layer);
+}
+
+void *layer_get_data(const Layer *layer) {
+    return layer ? (void *)layer->data : NULL;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+    if (layer) {
+        layer->update_proc = update_proc;
+    }
+}
+
+void layer_mark_dirty(Layer *layer) {
+    if (!layer) {
+        return;
+    }
+    s_stats.dirty_marks++;
+    Window *window = layer_window(layer);
+    if (window) {
+        window->dirty = true;
+    }
+}
+
+GRect layer_get_frame(const Layer *layer) {
+    return layer ? layer->frame : GRectZero;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+    return layer ? GRect(0, 0, layer->frame.size.w, layer->frame.size.h) : GRectZero;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+    if (!parent || !child) {
+        return;
+    }
+    layer_remove_from_parent(child);
+    child->parent = parent;
+    Layer **link = &parent->first_child;
+    while (*link) {
+        link = &(*link)->next_sibling;
+    }
+    *link = child;
+    layer_mark_dirty(parent);
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+    if (layer && layer->hidden != hidden) {
+        layer->hidden = hidden;
+        layer_mark_dirty(layer);
+    }
+}
+
+bool layer_get_hidden(const Layer *layer) {
+    return layer ? layer->hidden : true;
+}
+
+// Windows
+
+Window *window_create(void) {
+    Window *window = calloc(1, sizeof(Window));
+    if (!window) {
+        return NULL;
+    }
+    window->root_layer = layer_create(GRect(0, 0, STUB_SCREEN_WIDTH, STUB_SCREEN_HEIGHT));
+    if (!window->root_layer) {
+        free(window);
+        return NULL;
+    }
+    window->root_layer->window = window;
+    window->background_color = GColorWhite;
+    return window;
+}
+
+void window_destroy(Window *window) {
+    if (!window) {
+        return;
+    }
+    window_stack_remove(window, false);
+    layer_destroy(window->root_layer);
+    free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+    if (window) {
+        window->handlers = handlers;
+    }
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+    if (window) {
+        window->background_color = background_color;
+        window->dirty = true;
+    }
+}
+
+Layer *window_get_root_layer(const Window *window) {
+    return window ? window->root_layer : NULL;
+}
+
+Window *window_stack_get_top_window(void) {
+    return s_window_count > 0 ? s_window_stack[s_window_count - 1] : NULL;
+}
+
+static int window_stack_index(const Window *window) {
+    for (int i = 0; i < s_window_count; i++) {
+        if (s_window_stack[i] == window) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void window_stack_push(Window *window, bool animated) {
+    (void)animated;
+    if (!window || window_stack_index(window) >= 0 || s_window_count == MAX_WINDOWS) {
+        return;
+    }
+
+    Window *previous = window_stack_get_top_window();
+    if (previous && previous->handlers.disappear) {
+        previous->handlers.disappear(previous);
+    }
+
+    s_window_stack[s_window_count++] = window;
+    if (!window->loaded) {
+        window->loaded = true;
+        if (window->handlers.load) {
+            window->handlers.load(window);
+        }
+    }
+    if (window->handlers.appear) {
+        window->handlers.appear(window);
+    }
+    window->dirty = true;
+}
+
+bool window_stack_remove(Window *window, bool animated) {
+    (void)animated;
+    int index = window_stack_index(window);
+    if (index < 0) {
+        return false;
+    }
+
+    bool was_top = index == s_window_count - 1;
+    for (int i = index; i < s_window_count - 1; i++) {
+        s_window_stack[i] = s_window_stack[i + 1];
+    }
+    s_window_count--;
+
+    if (was_top && window->handlers.disappear) {
+        window->handlers.disappear(window);
+    }
+    if (window->loaded) {
+        window->loaded = false;
+        if (window->handlers.unload) {
+            window->handlers.unload(window);
+        }
+    }
+
+    Window *top = window_stack_get_top_window();
+    if (was_top && top) {
+        if (top->handlers.appear) {
+            top->handlers.appear(top);
+        }
+        top->dirty = true;
+    }
+    return true;
+}
+
+void window_stack_pop_all(const bool animated) {
+    while (s_window_count > 0) {
+        window_stack_remove(s_window_stack[s_window_count - 1], animated);
+    }
+}
+
+// Rendering
+
+static void render_layer(Layer *layer, GContext *ctx, GPoint origin) {
+    if (layer->hidden) {
+        return;
+    }
+
+    GPoint layer_origin = GPoint(origin.x + layer->frame.origin.x, origin.y + layer->frame.origin.y);
+    if (layer->update_proc) {
+        ctx->offset = layer_origin;
+        ctx->clip = GRect(layer_origin.x, layer_origin.y, layer->frame.size.w, layer->frame.size.h);
+        s_stats.layer_updates++;
+        layer->update_proc(layer, ctx);
+    }
+
+    for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+        render_layer(child, ctx, layer_origin);
+    }
+}
+
+void stub_render(void) {
+    Window *window = window_stack_get_top_window();
+    if (!window || !window->dirty) {
+        return;
+    }
+    window->dirty = false;
+    s_stats.renders++;
+
+    // The firmware repaints the whole layer tree of the top window
+    GContext ctx = {
+        .fill_color = GColorBlack,
+        .text_color = GColorBlack,
+        .clip = GRect(0, 0, STUB_SCREEN_WIDTH, STUB_SCREEN_HEIGHT),
+        .offset = GPoint(0, 0),
+    };
+    if (!gcolor_equal(window->background_color, GColorClear)) {
+        ctx.fill_color = window->background_color;
+        graphics_fill_rect(&ctx, ctx.clip, 0, GCornerNone);
+    }
+    render_layer(window->root_layer, &ctx, GPoint(0, 0));
+}
+
+bool stub_window_is_dirty(void) {
+    Window *window = window_stack_get_top_window();
+    return window && window->dirty;
+}
+
+// Dictionaries
+
+static Tuple *tuple_at(const DictionaryIterator *iter, const uint8_t *cursor) {
+    const uint8_t *end = iter->end;
+    if (cursor + TUPLE_HEADER_SIZE > end) {
+        return NULL;
+    }
+    Tuple *tuple = (Tuple *)cursor;
+    if (cursor + TUPLE_HEADER_SIZE + tuple->length > end) {
+        return NULL;
+    }
+    return tuple;
+}
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...) {
+    uint32_t size = sizeof(Dictionary);
+    va_list args;
+    va_start(args, tuple_count);
+    for (uint8_t i = 0; i < tuple_count; i++) {
+        size += TUPLE_HEADER_SIZE + va_arg(args, uint32_t);
+    }
+    va_end(args);
+    return size;
+}
+
+uint32_t dict_size(DictionaryIterator *iter) {
+    if (!iter || !iter->dictionary) {
+        return 0;
+    }
+    return (uint32_t)((const uint8_t *)iter->end - (const uint8_t *)iter->dictionary);
+}
+
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t *const buffer, const uint16_t size) {
+    if (!iter || !buffer) {
+        return DICT_INVALID_ARGS;
+    }
+    if (size < sizeof(Dictionary)) {
+        return DICT_NOT_ENOUGH_STORAGE;
+    }
+    iter->dictionary = (Dictionary *)buffer;
+    iter->dictionary->count = 0;
+    iter->cursor = (Tuple *)iter->dictionary->head;
+    iter->end = buffer + size;
+    return DICT_OK;
+}
+
+static DictionaryResult dict_write_tuple(DictionaryIterator *iter, uint32_t key, TupleType type,
+                                         const void *data, uint16_t length) {
+    if (!iter || !iter->dictionary || (!data && length > 0)) {
+        return DICT_INVALID_ARGS;
+    }
+    uint8_t *cursor = (uint8_t *)iter->cursor;
+    if (cursor + TUPLE_HEADER_SIZE + length > (const uint8_t *)iter->end) {
+        return DICT_NOT_ENOUGH_STORAGE;
+    }
+    Tuple *tuple = (Tuple *)cursor;
+    tuple->key = key;
+    tuple->type = type;
+    tuple->length = length;
+    if (length > 0) {
+        memcpy(tuple->value->data, data, length);
+    }
+    iter->dictionary->count++;
+    iter->cursor = (Tuple *)(cursor + TUPLE_HEADER_SIZE + length);
+    return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t *const data, const uint16_t size) {
+    return dict_write_tuple(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *const cstring) {
+    if (!cstring) {
+        return dict_write_tuple(iter, key, TUPLE_CSTRING, NULL, 0);
+    }
+    return dict_write_tuple(iter, key, TUPLE_CSTRING, cstring, (uint16_t)(strlen(cstring) + 1));
+}
+
+DictionaryResult dict_write_int(DictionaryIterator *iter, const uint32_t key, const void *integer, const uint8_t width_bytes, const bool is_signed) {
+    if (width_bytes != 1 && width_bytes != 2 && width_bytes != 4) {
+        return DICT_INVALID_ARGS;
+    }
+    return dict_write_tuple(iter, key, is_signed ? TUPLE_INT : TUPLE_UINT, integer, width_bytes);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+    return dict_write_int(iter, key, &value, sizeof(value), false);
+}
+
+DictionaryResult dict_write_uint16(DictionaryIterator *iter, const uint32_t key, const uint16_t value) {
+    return dict_write_int(iter, key, &value, sizeof(value), false);
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value) {
+    return dict_write_int(iter, key, &value, sizeof(value), false);
+}
+
+DictionaryResult dict_write_int8(DictionaryIterator *iter, const uint32_t key, const int8_t value) {
+    return dict_write_int(iter, key, &value, sizeof(value), true);
+}
+
+DictionaryResult dict_write_int16(DictionaryIterator *iter, const uint32_t key, const int16_t value) {
+    return dict_write_int(iter, key, &value, sizeof(value), true);
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+    return dict_write_int(iter, key, &value, sizeof(value), true);
+}
+
+uint32_t dict_write_end(DictionaryIterator *iter) {
+    if (!iter || !iter->dictionary) {
+        return 0;
+    }
+    iter->end = iter->cursor;
+    iter->cursor = (Tuple *)iter->dictionary->head;
+    return dict_size(iter);
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter) {
+    if (!iter || !iter->dictionary || !iter->cursor) {
+        return NULL;
+    }
+    Tuple *tuple = tuple_at(iter, (const uint8_t *)iter->cursor);
+    if (!tuple) {
+        iter->cursor = NULL;
+        return NULL;
+    }
+    iter->cursor = (Tuple *)((uint8_t *)tuple + TUPLE_HEADER_SIZE + tuple->length);
+    return tuple;
+}
+
+Tuple *dict_read_first(DictionaryIterator *iter) {
+    if (!iter || !iter->dictionary) {
+        return NULL;
+    }
+    iter->cursor = (Tuple *)iter->dictionary->head;
+    return dict_read_next(iter);
+}
+
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t *const buffer, const uint16_t size) {
+    if (!iter || !buffer || size < sizeof(Dictionary)) {
+        return NULL;
+    }
+    iter->dictionary = (Dictionary *)buffer;
+    iter->end = buffer + size;
+    return dict_read_first(iter);
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+    if (!iter || !iter->dictionary) {
+        return NULL;
+    }
+    const uint8_t *cursor = iter->dictionary->head;
+    for (uint8_t i = 0; i < iter->dictionary->count; i++) {
+        Tuple *tuple = tuple_at(iter, cursor);
+        if (!tuple) {
+            return NULL;
+        }
+        if (tuple->key == key) {
+            return tuple;
+        }
+        cursor += TUPLE_HEADER_SIZE + tuple->length;
+    }
+    return NULL;
+}
+
+// AppMessage
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+    if (s_inbox_buffer || s_outbox_buffer) {
+        return APP_MSG_INVALID_STATE;
+    }
+    if (size_inbound > s_inbox_maximum || size_outbound > s_outbox_maximum) {
+        return APP_MSG_OUT_OF_MEMORY;
+    }
+    s_inbox_buffer = calloc(1, size_inbound ? size_inbound : 1);
+    s_outbox_buffer = calloc(1, size_outbound ? size_outbound : 1);
+    s_last_sent_buffer = calloc(1, size_outbound ? size_outbound : 1);
+    if (!s_inbox_buffer || !s_outbox_buffer || !s_last_sent_buffer) {
+        return APP_MSG_OUT_OF_MEMORY;
+    }
+    s_inbox_size = size_inbound;
+    s_outbox_size = size_outbound;
+    return APP_MSG_OK;
+}
+
+void app_message_deregister_callbacks(void) {
+    s_inbox_received = NULL;
+    s_inbox_dropped = NULL;
+    s_outbox_sent = NULL;
+    s_outbox_failed = NULL;
+    s_appmsg_context = NULL;
+}
+
+void *app_message_get_context(void) {
+    return s_appmsg_context;
+}
+
+void *app_message_set_context(void *context) {
+    void *previous = s_appmsg_context;
+    s_appmsg_context = context;
+    return previous;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+    AppMessageInboxReceived previous = s_inbox_received;
+    s_inbox_received = received_callback;
+    return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+    AppMessageInboxDropped previous = s_inbox_dropped;
+    s_inbox_dropped = dropped_callback;
+    return previous;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+    AppMessageOutboxSent previous = s_outbox_sent;
+    s_outbox_sent = sent_callback;
+    return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+    AppMessageOutboxFailed previous = s_outbox_failed;
+    s_outbox_failed = failed_callback;
+    return previous;
+}
+
+uint32_t app_message_inbox_size_maximum(void) {
+    return s_inbox_maximum;
+}
+
+uint32_t app_message_outbox_size_maximum(void) {
+    return s_outbox_maximum;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+    if (!iterator) {
+        return APP_MSG_INVALID_ARGS;
+    }
+    s_stats.outbox_begins++;
+    if (!s_outbox_buffer) {
+        return APP_MSG_INVALID_STATE;
+    }
+    if (s_outbox_state != OUTBOX_IDLE) {
+        s_stats.outbox_busy++;
+        return APP_MSG_BUSY;
+    }
+    if (dict_write_begin(&s_outbox_iter, s_outbox_buffer, (uint16_t)s_outbox_size) != DICT_OK) {
+        return APP_MSG_BUFFER_OVERFLOW;
+    }
+    s_outbox_state = OUTBOX_WRITING;
+    *iterator = &s_outbox_iter;
+    return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+    if (s_outbox_state != OUTBOX_WRITING) {
+        return APP_MSG_INVALID_STATE;
+    }
+    if (!s_connected) {
+        s_outbox_state = OUTBOX_IDLE;
+        s_stats.outbox_offline++;
+        return APP_MSG_NOT_CONNECTED;
+    }
+    uint32_t size = dict_write_end(&s_outbox_iter);
+    memcpy(s_last_sent_buffer, s_outbox_buffer, size);
+    s_last_sent_size = size;
+    s_outbox_state = OUTBOX_SENDING;
+
+    s_stats.outbox_sends++;
+    s_stats.outbox_bytes += size;
+    if (s_outbox_observer) {
+        s_outbox_observer(s_outbox_buffer, (uint16_t)size, s_outbox_observer_context);
+    }
+    if (s_auto_ack) {
+        s_ack_scheduled = true;
+        s_ack_due_ms = s_now_ms + s_ack_latency_ms;
+    }
+    return APP_MSG_OK;
+}
+
+static void finish_outbox(bool acked, AppMessageResult reason) {
+    if (s_outbox_state != OUTBOX_SENDING) {
+        return;
+    }
+    // The outbox is released before the callback so it may send again
+    s_outbox_state = OUTBOX_IDLE;
+    s_ack_scheduled = false;
+
+    DictionaryIterator iter;
+    dict_read_begin_from_buffer(&iter, s_last_sent_buffer, (uint16_t)s_last_sent_size);
+    if (acked) {
+        s_stats.outbox_acks++;
+        if (s_outbox_sent) {
+            s_outbox_sent(&iter, s_appmsg_context);
+        }
+    } else {
+        s_stats.outbox_nacks++;
+        if (s_outbox_failed) {
+            s_outbox_failed(&iter, reason, s_appmsg_context);
+        }
+    }
+}
+
+static void deliver_outbox_result(void) {
+    // Deterministic pseudo-random link failures for flaky-phone simulations
+    s_nack_random = s_nack_random * 1664525u + 1013904223u;
+    if ((s_nack_random >> 8) % 100 < s_nack_percent) {
+        finish_outbox(false, APP_MSG_SEND_TIMEOUT);
+    } else {
+        finish_outbox(true, APP_MSG_OK);
+    }
+}
+
+void stub_appmsg_set_outbox_observer(StubOutboxObserver observer, void *context) {
+    s_outbox_observer = observer;
+    s_outbox_observer_context = context;
+}
+
+void stub_appmsg_set_auto_ack(bool enabled, uint32_t latency_ms) {
+    s_auto_ack = enabled;
+    s_ack_latency_ms = latency_ms;
+}
+
+void stub_appmsg_set_auto_nack_percent(uint8_t percent) {
+    s_nack_percent = percent > 100 ? 100 : percent;
+}
+
+bool stub_appmsg_outbox_pending(void) {
+    return s_outbox_state == OUTBOX_SENDING;
+}
+
+void stub_appmsg_ack(void) {
+    finish_outbox(true, APP_MSG_OK);
+    stub_render();
+}
+
+void stub_appmsg_nack(AppMessageResult reason) {
+    finish_outbox(false, reason);
+    stub_render();
+}
+
+bool stub_appmsg_last_sent(DictionaryIterator *iter) {
+    if (!iter || s_last_sent_size == 0) {
+        return false;
+    }
+    dict_read_begin_from_buffer(iter, s_last_sent_buffer, (uint16_t)s_last_sent_size);
+    return true;
+}
+
+AppMessageResult stub_appmsg_deliver(const uint8_t *data, uint16_t size) {
+    if (!s_inbox_buffer) {
+        return APP_MSG_CLOSED;
+    }
+    AppMessageResult result = APP_MSG_OK;
+    if (size > s_inbox_size) {
+        s_stats.inbox_dropped++;
+        result = APP_MSG_BUFFER_OVERFLOW;
+        if (s_inbox_dropped) {
+            s_inbox_dropped(result, s_appmsg_context);
+        }
+    } else {
+        memcpy(s_inbox_buffer, data, size);
+        s_stats.inbox_messages++;
+        s_stats.inbox_bytes += size;
+        if (s_inbox_received) {
+            DictionaryIterator iter;
+            dict_read_begin_from_buffer(&iter, s_inbox_buffer, size);
+            s_inbox_received(&iter, s_appmsg_context);
+        }
+    }
+    stub_render();
+    return result;
+}
+
+void stub_appmsg_set_size_maximum(uint32_t inbox, uint32_t outbox) {
+    s_inbox_maximum = inbox;
+    s_outbox_maximum = outbox;
+}
+
+uint32_t stub_appmsg_inbox_size(void) {
+    return s_inbox_size;
+}
+
+uint32_t stub_appmsg_outbox_size(void) {
+    return s_outbox_size;
+}
+
+// Persistent storage
+
+static PersistEntry *persist_find(uint32_t key) {
+    for (int i = 0; i < STUB_PERSIST_MAX_KEYS; i++) {
+        if (s_persist[i].used && s_persist[i].key == key) {
+            return &s_persist[i];
+        }
+    }
+    return NULL;
+}
+
+uint32_t stub_persist_used_bytes(void) {
+    uint32_t used = 0;
+    for (int i = 0; i < STUB_PERSIST_MAX_KEYS; i++) {
+        if (s_persist[i].used) {
+            used += s_persist[i].size;
+        }
+    }
+    return used;
+}
+
+bool persist_exists(const uint32_t key) {
+    return persist_find(key) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+    PersistEntry *entry = persist_find(key);
+    return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+    PersistEntry *entry = persist_find(key);
+    if (!entry) {
+        return E_DOES_NOT_EXIST;
+    }
+    size_t size = entry->size < buffer_size ? entry->size : buffer_size;
+    memcpy(buffer, entry->data, size);
+    return (int)size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+    if (!data || size > PERSIST_DATA_MAX_LENGTH) {
+        return E_INVALID_ARGUMENT;
+    }
+
+    PersistEntry *entry = persist_find(key);
+    uint32_t used = stub_persist_used_bytes() - (entry ? entry->size : 0);
+    if (used + size > STUB_PERSIST_MAX_BYTES) {
+        return E_OUT_OF_STORAGE;
+    }
+    if (!entry) {
+        for (int i = 0; i < STUB_PERSIST_MAX_KEYS && !entry; i++) {
+            if (!s_persist[i].used) {
+                entry = &s_persist[i];
+            }
+        }
+        if (!entry) {
+            return E_OUT_OF_STORAGE;
+        }
+    }
+
+    entry->used = true;
+    entry->key = key;
+    entry->size = (uint16_t)size;
+    memcpy(entry->data, data, size);
+    s_stats.persist_writes++;
+    s_stats.persist_bytes += (uint32_t)size;
+    return (int)size;
+}
+
+status_t persist_delete(const uint32_t key) {
+    // Counted whether or not the key exists; the firmware searches flash either way
+    s_stats.persist_deletes++;
+    PersistEntry *entry = persist_find(key);
+    if (!entry) {
+        return E_DOES_NOT_EXIST;
+    }
+    entry->used = false;
+    return S_SUCCESS;
+}
+
+// Bluetooth connection interval
+
+void app_comm_set_sniff_interval(const SniffInterval interval) {
+    if (interval == s_sniff_interval) {
+        return;
+    }
+    if (s_sniff_interval == SNIFF_INTERVAL_REDUCED) {
+        s_stats.sniff_reduced_ms += s_now_ms - s_sniff_since_ms;
+    }
+    s_sniff_interval = interval;
+    s_sniff_since_ms = s_now_ms;
+    s_stats.sniff_switches++;
+}
+
+SniffInterval app_comm_get_sniff_interval(void) {
+    return s_sniff_interval;
+}
+
+// Connection service
+
+void connection_service_subscribe(ConnectionHandlers conn_handlers) {
+    s_connection_handlers = conn_handlers;
+}
+
+void connection_service_unsubscribe(void) {
+    s_connection_handlers = (ConnectionHandlers){ 0 };
+}
+
+bool connection_service_peek_pebble_app_connection(void) {
+    return s_connected;
+}
+
+bool connection_service_peek_pebblekit_connection(void) {
+    return s_connected;
+}
+
+void stub_connection_set(bool connected) {
+    if (connected == s_connected) {
+        return;
+    }
+    s_connected = connected;
+    if (!connected) {
+        finish_outbox(false, APP_MSG_NOT_CONNECTED);
+    }
+    if (s_connection_handlers.pebble_app_connection_handler) {
+        s_connection_handlers.pebble_app_connection_handler(connected);
+    }
+    if (s_connection_handlers.pebblekit_connection_handler) {
+        s_connection_handlers.pebblekit_connection_handler(connected);
+    }
+    stub_render();
+}
+
+bool stub_connection_is_subscribed(void) {
+    return s_connection_handlers.pebble_app_connection_handler != NULL ||
+           s_connection_handlers.pebblekit_connection_handler != NULL;
+}
+
+// Battery
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+    s_battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+    s_battery_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+    return s_battery_state;
+}
+
+void stub_battery_set(uint8_t charge_percent, bool is_charging) {
+    s_battery_state.charge_percent = charge_percent;
+    s_battery_state.is_charging = is_charging;
+    s_battery_state.is_plugged = is_charging;
+    if (s_battery_handler) {
+        s_battery_handler(s_battery_state);
+    }
+    stub_render();
+}
+
+bool stub_battery_is_subscribed(void) {
+    return s_battery_handler != NULL;
+}
+
+// Data logging
+
+static struct DataLoggingSession *datalog_find(uint32_t tag) {
+    for (int i = 0; i < STUB_DATALOG_MAX_SESSIONS; i++) {
+        if (s_datalog[i].used && s_datalog[i].tag == tag) {
+            return &s_datalog[i];
+        }
+    }
+    return NULL;
+}
+
+DataLoggingSessionRef data_logging_create(uint32_t tag, DataLoggingItemType item_type, uint16_t item_length,
+                                          bool resume) {
+    if (item_length == 0) {
+        return NULL;
+    }
+    // Resuming picks up a session with the same tag and layout that an
+    // earlier run left open
+    struct DataLoggingSession *session = datalog_find(tag);
+    if (session && resume && session->open && session->item_type == item_type &&
+        session->item_length == item_length) {
+        return session;
+    }
+    for (int i = 0; i < STUB_DATALOG_MAX_SESSIONS; i++) {
+        if (!s_datalog[i].used) {
+            session = &s_datalog[i];
+            memset(session, 0, sizeof(*session));
+            session->used = true;
+            session->open = true;
+            session->tag = tag;
+            session->item_type = item_type;
+            session->item_length = item_length;
+            return session;
+        }
+    }
+    return NULL;
+}
+
+void data_logging_finish(DataLoggingSessionRef logging_session) {
+    if (logging_session) {
+        logging_session->open = false;
+    }
+}
+
+DataLoggingResult data_logging_log(DataLoggingSessionRef logging_session, const void *data, uint32_t num_items) {
+    if (!logging_session || !data) {
+        return DATA_LOGGING_INVALID_PARAMS;
+    }
+    if (!logging_session->open) {
+        return DATA_LOGGING_CLOSED;
+    }
+    s_stats.datalog_logs++;
+    uint32_t bytes = num_items * logging_session->item_length;
+    if (logging_session->bytes + bytes > s_datalog_capacity) {
+        return DATA_LOGGING_FULL;
+    }
+    memcpy(&logging_session->data[logging_session->bytes], data, bytes);
+    logging_session->bytes += bytes;
+    s_stats.datalog_items += num_items;
+    s_stats.datalog_bytes += bytes;
+    return DATA_LOGGING_SUCCESS;
+}
+
+const uint8_t *stub_datalog_items(uint32_t tag, uint32_t *count) {
+    struct DataLoggingSession *session = datalog_find(tag);
+    if (!session) {
+        *count = 0;
+        return NULL;
+    }
+    *count = session->bytes / session->item_length;
+    return session->data;
+}
+
+bool stub_datalog_is_open(uint32_t tag) {
+    struct DataLoggingSession *session = datalog_find(tag);
+    return session && session->open;
+}
+
+void stub_datalog_set_capacity(uint32_t bytes) {
+    s_datalog_capacity = bytes < STUB_DATALOG_SESSION_BYTES ? bytes : STUB_DATALOG_SESSION_BYTES;
+}
+
+// Heap
+
+size_t heap_bytes_used(void) {
+    return s_heap_used;
+}
+
+void stub_heap_set_used(size_t bytes) {
+    s_heap_used = bytes;
+}
+
+// Vibes
+
+void vibes_short_pulse(void) {
+    s_stats.vibe_pulses++;
+}
+
+void vibes_double_pulse(void) {
+    s_stats.vibe_pulses += 2;
+}
+
+// Health
+
+bool health_service_events_subscribe(HealthEventHandler handler, void *context) {
+    s_health_handler = handler;
+    s_health_context = context;
+    return handler != NULL;
+}
+
+bool health_service_events_unsubscribe(void) {
+    s_health_handler = NULL;
+    s_health_context = NULL;
+    return true;
+}
+
+bool health_service_set_heart_rate_sample_period(uint16_t interval_sec) {
+    s_health_sample_period = interval_sec;
+    return true;
+}
+
+HealthValue health_service_peek_current_value(HealthMetric metric) {
+    if ((unsigned)metric > HealthMetricHeartRateRawBPM) {
+        return HealthValueInvalid;
+    }
+    return s_health_values[metric];
+}
+
+static HealthMinuteSlot *health_minute_slot(uint32_t minute) {
+    HealthMinuteSlot *slot = &s_health_minutes[minute % STUB_HEALTH_HISTORY_MINUTES];
+    if (slot->minute != minute) {
+        *slot = (HealthMinuteSlot){ .minute = minute };
+    }
+    return slot;
+}
+
+uint32_t health_service_get_minute_history(HealthMinuteData *minute_data, uint32_t max_records,
+                                           time_t *time_start, time_t *time_end) {
+    if (!minute_data || !time_start || !time_end) {
+        return 0;
+    }
+
+    // Only whole minutes still inside the history are returned
+    uint32_t now_minute = (uint32_t)(s_now_ms / 1000 / 60);
+    uint32_t oldest = now_minute > STUB_HEALTH_HISTORY_MINUTES ? now_minute - STUB_HEALTH_HISTORY_MINUTES : 0;
+    uint32_t first = (uint32_t)(*time_start / 60);
+    uint32_t end = (uint32_t)((*time_end + 59) / 60);
+    if (first < oldest) {
+        first = oldest;
+    }
+    if (end > now_minute) {
+        end = now_minute;
+    }
+
+    uint32_t count = end > first ? end - first : 0;
+    if (count > max_records) {
+        count = max_records;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const HealthMinuteSlot *slot = &s_health_minutes[(first + i) % STUB_HEALTH_HISTORY_MINUTES];
+        bool valid = slot->minute == first + i && slot->readings > 0;
+        minute_data[i] = (HealthMinuteData){
+            .is_invalid = !valid,
+            .heart_rate_bpm = valid ? (uint8_t)(slot->bpm_sum / slot->readings) : 0,
+        };
+    }
+
+    *time_start = (time_t)first * 60;
+    *time_end = (time_t)(first + count) * 60;
+    return count;
+}
+
+void stub_health_set_value(HealthMetric metric, HealthValue value) {
+    if ((unsigned)metric <= HealthMetricHeartRateRawBPM) {
+        s_health_values[metric] = value;
+    }
+    if (metric == HealthMetricHeartRateBPM && value > 0 && value <= UINT8_MAX) {
+        HealthMinuteSlot *slot = health_minute_slot((uint32_t)(s_now_ms / 1000 / 60));
+        slot->bpm_sum += (uint32_t)value;
+        slot->readings++;
+    }
+}
+
+void stub_health_record_minute(time_t minute_start, uint8_t bpm) {
+    HealthMinuteSlot *slot = health_minute_slot((uint32_t)(minute_start / 60));
+    slot->bpm_sum = bpm;
+    slot->readings = bpm > 0 ? 1 : 0;
+}
+
+void stub_health_emit(HealthEventType event) {
+    s_stats.health_events++;
+    if (s_health_handler) {
+        s_health_handler(event, s_health_context);
+    }
+    stub_render();
+}
+
+bool stub_health_is_subscribed(void) {
+    return s_health_handler != NULL;
+}
+
+uint16_t stub_health_sample_period(void) {
+    return s_health_sample_period;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <pebble.h>
+
+// Control surface of the host SDK fake. Tests and benchmarks use these hooks
+// to drive the virtual clock, inject SDK events and read back what the
+// watchapp did with them. Every injected event is followed by a render pass,
+// like the firmware redrawing dirty windows after each event handler returns.
+
+#define STUB_SCREEN_WIDTH 144
+#define STUB_SCREEN_HEIGHT 168
+
+#define STUB_DEFAULT_EPOCH_MS 1700000000000ULL
+#define STUB_APPMSG_SIZE_MAXIMUM 8200
+
+// Per-app persistent storage limit on the watch
+#define STUB_PERSIST_MAX_BYTES 4096
+#define STUB_PERSIST_MAX_KEYS 64
+
+// Minutes of health history the firmware keeps
+#define STUB_HEALTH_HISTORY_MINUTES 1440
+
+// Data logging spool: open or undelivered sessions, and bytes per session
+#define STUB_DATALOG_MAX_SESSIONS 4
+#define STUB_DATALOG_SESSION_BYTES 65536
+
+typedef struct {
+    // Rendering
+    uint32_t dirty_marks;
+    uint32_t renders;
+    uint32_t layer_updates;
+    uint32_t fill_rects;
+    uint64_t fill_pixels;
+    uint32_t text_draws;
+    uint32_t text_bytes;
+
+    // Logging
+    uint32_t log_calls;
+    uint32_t log_bytes;
+
+    // AppMessage
+    uint32_t outbox_begins;
+    uint32_t outbox_busy;
+    uint32_t outbox_sends;
+    uint32_t outbox_bytes;
+    uint32_t outbox_acks;
+    uint32_t outbox_nacks;
+    uint32_t outbox_offline;
+    uint32_t inbox_messages;
+    uint32_t inbox_bytes;
+    uint32_t inbox_dropped;
+
+    // Bluetooth connection interval
+    uint32_t sniff_switches;
+    uint64_t sniff_reduced_ms;
+
+    // Data logging
+    uint32_t datalog_logs;
+    uint32_t datalog_items;
+    uint32_t datalog_bytes;
+
+    // Persistent storage
+    uint32_t persist_writes;
+    uint32_t persist_bytes;
+    uint32_t persist_deletes;
+
+    // Events
+    uint32_t health_events;
+    uint32_t timers_fired;
+    uint32_t ticks_fired;
+
+    // Vibes
+    uint32_t vibe_pulses;
+} StubStats;
+
+typedef void (*StubEventLoop)(void);
+typedef void (*StubOutboxObserver)(const uint8_t *data, uint16_t size, void *context);
+
+// Watchapp entry point; the host build renames main() in src/c/main.c
+int pebblerun_main(void);
+
+// Global state
+void stub_reset(void);
+// Reclaims what the firmware frees when the app exits, so pebblerun_main()
+// can run again; persistent storage, the clock and stats are kept
+void stub_app_exit(void);
+const StubStats *stub_get_stats(void);
+void stub_reset_stats(void);
+void stub_set_event_loop(StubEventLoop loop);
+void stub_log_set_echo(bool echo);
+
+// Virtual clock
+void stub_clock_set_ms(uint64_t epoch_ms);
+uint64_t stub_clock_now_ms(void);
+void stub_advance_ms(uint32_t ms);
+
+// Tick timer service
+bool stub_tick_is_subscribed(void);
+
+// Rendering
+void stub_render(void);
+bool stub_window_is_dirty(void);
+
+// Persistent storage, kept across pebblerun_main() runs until stub_reset()
+uint32_t stub_persist_used_bytes(void);
+
+// Connection service; the phone starts connected. Disconnecting fails the
+// message in flight, and sends fail until it reconnects
+void stub_connection_set(bool connected);
+bool stub_connection_is_subscribed(void);
+
+// Data logging spool, kept across pebblerun_main() runs like persistent
+// storage. Items of the session with this tag, oldest first, or NULL if
+// there is none; a full session refuses further items
+const uint8_t *stub_datalog_items(uint32_t tag, uint32_t *count);
+bool stub_datalog_is_open(uint32_t tag);
+void stub_datalog_set_capacity(uint32_t bytes);
+
+// App heap in use, as heap_bytes_used() reports it; 0 after a reset
+void stub_heap_set_used(size_t bytes);
+
+// Battery state service; the charge starts at 100 % and unplugged
+void stub_battery_set(uint8_t charge_percent, bool is_charging);
+bool stub_battery_is_subscribed(void);
+
+// Health service
+void stub_health_set_value(HealthMetric metric, HealthValue value);
+void stub_health_emit(HealthEventType event);
+bool stub_health_is_subscribed(void);
+uint16_t stub_health_sample_period(void);
+// Heart rate values set above are averaged into the minute history, which
+// like persistent storage outlives pebblerun_main() runs
+void stub_health_record_minute(time_t minute_start, uint8_t bpm);
+
+// AppMessage
+void stub_appmsg_set_outbox_observer(StubOutboxObserver observer, void *context);
+void stub_appmsg_set_auto_ack(bool enabled, uint32_t latency_ms);
+void stub_appmsg_set_auto_nack_percent(uint8_t percent);
+bool stub_appmsg_outbox_pending(void);
+void stub_appmsg_ack(void);
+void stub_appmsg_nack(AppMessageResult reason);
+bool stub_appmsg_last_sent(DictionaryIterator *iter);
+AppMessageResult stub_appmsg_deliver(const uint8_t *data, uint16_t size);
+// Caps what app_message_open accepts and the *_size_maximum calls report,
+// as on an older firmware or a platform with less memory
+void stub_appmsg_set_size_maximum(uint32_t inbox, uint32_t outbox);
+uint32_t stub_appmsg_inbox_size(void);
+uint32_t stub_appmsg_outbox_size(void);
@@ -0,0 +1,405 @@
+#include "replay.h"
+
+#include <ctype.h>
+
+#include "common.h"
+
+#define LINE_BUFFER_SIZE 512
+#define MS_PER_HOUR 3600000ULL
+#define REPLAY_SETTLE_MS 30000
+
+// Phone resend policy for WORKOUT frames, as in PebbleConnectionManager
+#define REPLAY_FRAME_RESEND_S 30
+#define REPLAY_PACE_RESEND_DELTA 5
+
+// Fields of an "in" event; frame fields are packed into one KEY_WORKOUT tuple
+typedef enum {
+    REPLAY_FIELD_CMD,
+    REPLAY_FIELD_UPLINK,
+    REPLAY_FIELD_TIME,
+    REPLAY_FIELD_PACE,
+    REPLAY_FIELD_DIST,
+    REPLAY_FIELD_FLAGS
+} ReplayField;
+
+typedef struct {
+    const char *name;
+    ReplayField field;
+} ReplayKey;
+
+static const ReplayKey s_replay_keys[] = {
+    { "cmd", REPLAY_FIELD_CMD },
+    { "uplink", REPLAY_FIELD_UPLINK },
+    { "time", REPLAY_FIELD_TIME },
+    { "pace", REPLAY_FIELD_PACE },
+    { "dist", REPLAY_FIELD_DIST },
+    { "flags", REPLAY_FIELD_FLAGS },
+};
+
+static const ReplayTrace *s_trace;
+static const ReplayOptions *s_options;
+static ReplayReport *s_report;
+
+// Trace storage
+
+void replay_trace_init(ReplayTrace *trace) {
+    trace->events = NULL;
+    trace->count = 0;
+    trace->capacity = 0;
+}
+
+void replay_trace_free(ReplayTrace *trace) {
+    free(trace->events);
+    replay_trace_init(trace);
+}
+
+static ReplayEvent *trace_append(ReplayTrace *trace) {
+    if (trace->count == trace->capacity) {
+        size_t capacity = trace->capacity ? trace->capacity * 2 : 256;
+        ReplayEvent *events = realloc(trace->events, capacity * sizeof(ReplayEvent));
+        if (!events) {
+            return NULL;
+        }
+        trace->events = events;
+        trace->capacity = capacity;
+    }
+    ReplayEvent *event = &trace->events[trace->count];
+    memset(event, 0, sizeof(*event));
+    return event;
+}
+
+// Parsing
+
+static const ReplayKey *find_key(const char *name, size_t length) {
+    for (size_t i = 0; i < sizeof(s_replay_keys) / sizeof(s_replay_keys[0]); i++) {
+        if (strlen(s_replay_keys[i].name) == length && strncmp(s_replay_keys[i].name, name, length) == 0) {
+            return &s_replay_keys[i];
+        }
+    }
+    return NULL;
+}
+
+static void put_le(uint8_t *data, uint32_t value, uint8_t width) {
+    for (uint8_t i = 0; i < width; i++) {
+        data[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static bool parse_inbox(ReplayEvent *event, char *args) {
+    DictionaryIterator iter;
+    dict_write_begin(&iter, event->payload, sizeof(event->payload));
+
+    uint8_t frame[WORKOUT_FRAME_SIZE] = { WORKOUT_FRAME_VERSION };
+    bool has_frame = false;
+
+    char *token = strtok(args, " \t");
+    if (!token) {
+        return false;
+    }
+    for (; token; token = strtok(NULL, " \t")) {
+        char *separator = strchr(token, '=');
+        if (!separator) {
+            return false;
+        }
+        const ReplayKey *key = find_key(token, (size_t)(separator - token));
+        if (!key) {
+            return false;
+        }
+        char *end;
+        unsigned long value = strtoul(separator + 1, &end, 0);
+        if (end == separator + 1 || *end != '\0') {
+            return false;
+        }
+
+        switch (key->field) {
+            case REPLAY_FIELD_CMD:
+                if (dict_write_uint8(&iter, KEY_CMD, (uint8_t)value) != DICT_OK) {
+                    return false;
+                }
+                continue;
+            case REPLAY_FIELD_UPLINK:
+                if (dict_write_uint8(&iter, KEY_UPLINK, (uint8_t)value) != DICT_OK) {
+                    return false;
+                }
+                continue;
+            case REPLAY_FIELD_TIME:
+                put_le(&frame[WORKOUT_ELAPSED_OFFSET], (uint32_t)value, 4);
+                break;
+            case REPLAY_FIELD_PACE:
+                put_le(&frame[WORKOUT_PACE_OFFSET], (uint32_t)value, 2);
+                break;
+            case REPLAY_FIELD_DIST:
+                put_le(&frame[WORKOUT_DISTANCE_OFFSET], (uint32_t)value, 4);
+                break;
+            case REPLAY_FIELD_FLAGS:
+                frame[WORKOUT_FLAGS_OFFSET] = (uint8_t)value;
+                break;
+        }
+        has_frame = true;
+    }
+
+    if (has_frame && dict_write_data(&iter, KEY_WORKOUT, frame, sizeof(frame)) != DICT_OK) {
+        return false;
+    }
+
+    event->type = REPLAY_EVENT_INBOX;
+    event->size = (uint16_t)dict_write_end(&iter);
+    return true;
+}
+
+bool replay_trace_parse_line(ReplayTrace *trace, const char *line) {
+    char buffer[LINE_BUFFER_SIZE];
+    strncpy(buffer, line, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    buffer[strcspn(buffer, "\r\n#")] = '\0';
+
+    char *cursor = buffer;
+    while (isspace((unsigned char)*cursor)) {
+        cursor++;
+    }
+    if (*cursor == '\0') {
+        return true;
+    }
+
+    char *end;
+    unsigned long t_ms = strtoul(cursor, &end, 10);
+    if (end == cursor || !isspace((unsigned char)*end)) {
+        return false;
+    }
+    if (trace->count > 0 && t_ms < trace->events[trace->count - 1].t_ms) {
+        return false;
+    }
+
+    char *verb = strtok(end, " \t");
+    char *args = strtok(NULL, "");
+    if (!verb || !args) {
+        return false;
+    }
+
+    ReplayEvent *event = trace_append(trace);
+    if (!event) {
+        return false;
+    }
+    event->t_ms = (uint32_t)t_ms;
+
+    if (strcmp(verb, "hr") == 0) {
+        long bpm = strtol(args, &end, 10);
+        if (end == args) {
+            return false;
+        }
+        event->type = REPLAY_EVENT_HR;
+        event->hr_bpm = (HealthValue)bpm;
+    } else if (strcmp(verb, "link") == 0) {
+        long connected = strtol(args, &end, 10);
+        if (end == args || (connected != 0 && connected != 1)) {
+            return false;
+        }
+        event->type = REPLAY_EVENT_LINK;
+        event->connected = connected == 1;
+    } else if (strcmp(verb, "in") == 0) {
+        if (!parse_inbox(event, args)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    trace->count++;
+    return true;
+}
+
+bool replay_trace_load(ReplayTrace *trace, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "replay: cannot open %s\n", path);
+        return false;
+    }
+
+    char line[LINE_BUFFER_SIZE];
+    unsigned line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+        if (!replay_trace_parse_line(trace, line)) {
+            fprintf(stderr, "replay: %s:%u: invalid event\n", path, line_number);
+            ok = false;
+        }
+    }
+
+    fclose(file);
+    return ok;
+}
+
+// Synthetic session
+
+static uint32_t next_random(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+void replay_trace_synthesize(ReplayTrace *trace, uint32_t duration_s, uint32_t seed) {
+    // Steady run: START, 1 Hz HR random walk with occasional sensor dropouts,
+    // phone sending a workout frame when pace moves or the resend interval
+    // passes, then STOP
+    char line[LINE_BUFFER_SIZE];
+    uint32_t state = seed;
+    int hr = 95;
+    int pace_s = 330;
+    int sent_pace_s = 0;
+    uint32_t sent_second = 0;
+
+    replay_trace_parse_line(trace, "0 in cmd=1");
+    for (uint32_t second = 1; second <= duration_s; second++) {
+        int target = 150;
+        hr += (target - hr) / 20 + (int)(next_random(&state) % 5) - 2;
+        bool dropout = next_random(&state) % 200 == 0;
+        snprintf(line, sizeof(line), "%u hr %d", second * 1000, dropout ? HealthValueInvalid : hr);
+        replay_trace_parse_line(trace, line);
+
+        pace_s += (int)(next_random(&state) % 3) - 1;
+        if (abs(pace_s - sent_pace_s) < REPLAY_PACE_RESEND_DELTA &&
+            second - sent_second < REPLAY_FRAME_RESEND_S) {
+            continue;
+        }
+        uint32_t distance_m = second * 1000 / (uint32_t)pace_s;
+        snprintf(line, sizeof(line), "%u in time=%u pace=%d dist=%u",
+                 second * 1000 + 500, second, pace_s, distance_m);
+        replay_trace_parse_line(trace, line);
+        sent_pace_s = pace_s;
+        sent_second = second;
+    }
+    snprintf(line, sizeof(line), "%u in cmd=2", duration_s * 1000 + 900);
+    replay_trace_parse_line(trace, line);
+}
+
+// Replay
+
+void replay_options_default(ReplayOptions *options) {
+    options->ack_latency_ms = REPLAY_DEFAULT_ACK_LATENCY_MS;
+    options->nack_percent = 0;
+    options->uplink = UPLINK_APPMESSAGE;
+    options->echo_log = false;
+}
+
+static uint64_t cpu_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void replay_event_loop(void) {
+    uint64_t start_ms = stub_clock_now_ms();
+    uint64_t cpu_start = cpu_now_ns();
+    uint64_t last_hr_ms = 0;
+    bool hr_taken = false;
+
+    if (s_options->uplink != UPLINK_APPMESSAGE) {
+        uint8_t buffer[16];
+        DictionaryIterator iter;
+        dict_write_begin(&iter, buffer, sizeof(buffer));
+        dict_write_uint8(&iter, KEY_UPLINK, s_options->uplink);
+        stub_appmsg_deliver(buffer, (uint16_t)dict_write_end(&iter));
+    }
+
+    for (size_t i = 0; i < s_trace->count; i++) {
+        const ReplayEvent *event = &s_trace->events[i];
+        uint64_t elapsed_ms = stub_clock_now_ms() - start_ms;
+        if (event->t_ms > elapsed_ms) {
+            stub_advance_ms((uint32_t)(event->t_ms - elapsed_ms));
+        }
+
+        switch (event->type) {
+            case REPLAY_EVENT_HR: {
+                // Recorded readings are 1 Hz; skip those the sensor would not
+                // have taken at the sample period the app asked for
+                uint64_t period_ms = (uint64_t)stub_health_sample_period() * 1000;
+                uint64_t now_ms = stub_clock_now_ms();
+                if (hr_taken && period_ms > 1000 && now_ms - last_hr_ms < period_ms) {
+                    s_report->hr_skipped++;
+                    break;
+                }
+                hr_taken = true;
+                last_hr_ms = now_ms;
+                stub_health_set_value(HealthMetricHeartRateBPM, event->hr_bpm);
+                stub_health_emit(HealthEventHeartRateUpdate);
+                break;
+            }
+            case REPLAY_EVENT_INBOX:
+                stub_appmsg_deliver(event->payload, event->size);
+                break;
+            case REPLAY_EVENT_LINK:
+                stub_connection_set(event->connected);
+                break;
+        }
+        s_report->events++;
+    }
+
+    // Let in-flight ACKs and retries settle
+    stub_advance_ms(s_options->ack_latency_ms + REPLAY_SETTLE_MS);
+
+    s_report->cpu_ns = cpu_now_ns() - cpu_start;
+    s_report->duration_ms = (uint32_t)(stub_clock_now_ms() - start_ms);
+}
+
+void replay_run(const ReplayTrace *trace, const ReplayOptions *options, ReplayReport *report) {
+    memset(report, 0, sizeof(*report));
+    s_trace = trace;
+    s_options = options;
+    s_report = report;
+
+    stub_reset();
+    stub_log_set_echo(options->echo_log);
+    stub_appmsg_set_auto_ack(true, options->ack_latency_ms);
+    stub_appmsg_set_auto_nack_percent(options->nack_percent);
+    stub_set_event_loop(replay_event_loop);
+    pebblerun_main();
+
+    report->stats = *stub_get_stats();
+    s_trace = NULL;
+    s_options = NULL;
+    s_report = NULL;
+}
+
+static void print_counter(FILE *out, const char *name, uint64_t value, uint32_t duration_ms) {
+    uint64_t per_hour = duration_ms ? value * MS_PER_HOUR / duration_ms : 0;
+    fprintf(out, "%-16s %12llu %12llu\n", name,
+            (unsigned long long)value, (unsigned long long)per_hour);
+}
+
+void replay_report_print(const ReplayReport *report, FILE *out) {
+    const StubStats *stats = &report->stats;
+    uint32_t duration = report->duration_ms;
+
+    fprintf(out, "%-16s %12u\n", "duration_s", duration / 1000);
+    fprintf(out, "%-16s %12u\n", "events", report->events);
+    fprintf(out, "%-16s %12s %12s\n", "counter", "total", "per_hour");
+    print_counter(out, "cpu_us", report->cpu_ns / 1000, duration);
+    print_counter(out, "health_events", stats->health_events, duration);
+    print_counter(out, "hr_skipped", report->hr_skipped, duration);
+    print_counter(out, "inbox_messages", stats->inbox_messages, duration);
+    print_counter(out, "inbox_bytes", stats->inbox_bytes, duration);
+    print_counter(out, "inbox_dropped", stats->inbox_dropped, duration);
+    print_counter(out, "outbox_sends", stats->outbox_sends, duration);
+    print_counter(out, "outbox_bytes", stats->outbox_bytes, duration);
+    print_counter(out, "outbox_busy", stats->outbox_busy, duration);
+    print_counter(out, "outbox_acks", stats->outbox_acks, duration);
+    print_counter(out, "outbox_nacks", stats->outbox_nacks, duration);
+    print_counter(out, "outbox_offline", stats->outbox_offline, duration);
+    print_counter(out, "sniff_switches", stats->sniff_switches, duration);
+    print_counter(out, "sniff_reduced_ms", stats->sniff_reduced_ms, duration);
+    print_counter(out, "datalog_logs", stats->datalog_logs, duration);
+    print_counter(out, "datalog_bytes", stats->datalog_bytes, duration);
+    print_counter(out, "persist_writes", stats->persist_writes, duration);
+    print_counter(out, "persist_bytes", stats->persist_bytes, duration);
+    print_counter(out, "persist_deletes", stats->persist_deletes, duration);
+    print_counter(out, "timers_fired", stats->timers_fired, duration);
+    print_counter(out, "ticks_fired", stats->ticks_fired, duration);
+    print_counter(out, "vibe_pulses", stats->vibe_pulses, duration);
+    print_counter(out, "dirty_marks", stats->dirty_marks, duration);
+    print_counter(out, "renders", stats->renders, duration);
+    print_counter(out, "layer_updates", stats->layer_updates, duration);
+    print_counter(out, "fill_pixels", stats->fill_pixels, duration);
+    print_counter(out, "text_draws", stats->text_draws, duration);
+    print_counter(out, "log_calls", stats->log_calls, duration);
+    print_counter(out, "log_bytes", stats->log_bytes, duration);
+}
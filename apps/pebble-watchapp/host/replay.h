@@ -0,0 +1,72 @@
+#pragma once
+
+#include "pebble_stub.h"
+
+// Deterministic session replay on top of the SDK fake.
+//
+// A trace is a text file with one event per line, timestamps in milliseconds
+// relative to the start of the session and non-decreasing:
+//
+//   # comment
+//   0     in cmd=1
+//   1000  hr 142
+//   1500  in time=1 pace=330 dist=3
+//
+// "hr <bpm>" peeks the value through HealthMetricHeartRateBPM and raises a
+// HealthEventHeartRateUpdate, unless the app's sample period means the sensor
+// would not have taken that reading; "in <name>=<value>..." delivers one inbound
+// AppMessage. "cmd" becomes a KEY_CMD tuple; "time" (s), "pace" (s/km),
+// "dist" (m) and "flags" are packed into a single KEY_WORKOUT frame; "uplink"
+// becomes a KEY_UPLINK tuple. "link 0"
+// and "link 1" disconnect and reconnect the phone. Events are replayed on the virtual
+// clock, so a three hour session runs in well under a second of host time.
+
+#define REPLAY_PAYLOAD_MAX 256
+#define REPLAY_DEFAULT_ACK_LATENCY_MS 60
+
+typedef enum {
+    REPLAY_EVENT_HR,
+    REPLAY_EVENT_INBOX,
+    REPLAY_EVENT_LINK
+} ReplayEventType;
+
+typedef struct {
+    uint32_t t_ms;
+    ReplayEventType type;
+    HealthValue hr_bpm;
+    bool connected;
+    uint16_t size;
+    uint8_t payload[REPLAY_PAYLOAD_MAX];
+} ReplayEvent;
+
+typedef struct {
+    ReplayEvent *events;
+    size_t count;
+    size_t capacity;
+} ReplayTrace;
+
+typedef struct {
+    uint32_t ack_latency_ms;
+    uint8_t nack_percent;
+    // Sent ahead of the trace, as the phone would before START
+    uint8_t uplink;
+    bool echo_log;
+} ReplayOptions;
+
+typedef struct {
+    uint32_t duration_ms;
+    uint32_t events;
+    uint32_t hr_skipped;
+    uint64_t cpu_ns;
+    StubStats stats;
+} ReplayReport;
+
+void replay_trace_init(ReplayTrace *trace);
+void replay_trace_free(ReplayTrace *trace);
+bool replay_trace_parse_line(ReplayTrace *trace, const char *line);
+bool replay_trace_load(ReplayTrace *trace, const char *path);
+void replay_trace_synthesize(ReplayTrace *trace, uint32_t duration_s, uint32_t seed);
+
+void replay_options_default(ReplayOptions *options);
+void replay_run(const ReplayTrace *trace, const ReplayOptions *options, ReplayReport *report);
+void replay_report_print(const ReplayReport *report, FILE *out);
@@ -0,0 +1,67 @@
+#include "replay.h"
+
+// Command line front end for the replay engine.
+//
+//   pebblerun-replay [--ack-latency MS] [--nack-percent P] [--uplink U] [--log] TRACE
+//   pebblerun-replay [--ack-latency MS] [--nack-percent P] [--uplink U] [--log] --synthetic SECONDS [--seed N]
+//
+// Prints totals and per-simulated-hour rates; diff the output of two builds
+// to compare them.
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: pebblerun-replay [--ack-latency MS] [--nack-percent P] [--uplink U] [--log] TRACE\n"
+            "       pebblerun-replay [--ack-latency MS] [--nack-percent P] [--uplink U] [--log] --synthetic SECONDS [--seed N]\n");
+}
+
+int main(int argc, char **argv) {
+    ReplayOptions options;
+    replay_options_default(&options);
+
+    const char *trace_path = NULL;
+    uint32_t synthetic_s = 0;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ack-latency") == 0 && i + 1 < argc) {
+            options.ack_latency_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--nack-percent") == 0 && i + 1 < argc) {
+            options.nack_percent = (uint8_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--uplink") == 0 && i + 1 < argc) {
+            options.uplink = (uint8_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc) {
+            synthetic_s = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--log") == 0) {
+            options.echo_log = true;
+        } else if (argv[i][0] != '-' && !trace_path) {
+            trace_path = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!trace_path == !synthetic_s) {
+        usage();
+        return 2;
+    }
+
+    ReplayTrace trace;
+    replay_trace_init(&trace);
+    if (trace_path) {
+        if (!replay_trace_load(&trace, trace_path)) {
+            replay_trace_free(&trace);
+            return 1;
+        }
+    } else {
+        replay_trace_synthesize(&trace, synthetic_s, seed);
+    }
+
+    ReplayReport report;
+    replay_run(&trace, &options, &report);
+    replay_report_print(&report, stdout);
+
+    replay_trace_free(&trace);
+    return 0;
+}
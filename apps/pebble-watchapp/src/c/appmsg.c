@@ -2,116 +2,847 @@
 #include "common.h"
 #include "ui.h"
 #include "hr.h"
+#include "session.h"
+#include "workout.h"
+#include "journal.h"
+#include "backfill.h"
+#include "hrpack.h"
+#include "zones.h"
+#include "datalog.h"
+#include "log.h"
+#include "perf.h"
 
-// Buffer sizes for AppMessage
-#define OUTBOX_SIZE 64
-#define INBOX_SIZE 128
+// Buffer sizes for AppMessage, derived from the shared schema's worst-case
+// messages; a firmware offering less caps them at init
+#define OUTBOX_SIZE MESSAGE_OUTBOX_SIZE
+#define INBOX_SIZE MESSAGE_INBOX_SIZE
 
-static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "AppMessage received");
+// Dictionary header (1) and tuple header (7) leave the rest for the value
+#define MESSAGE_OVERHEAD (1 + 7)
+#define OUTBOX_VALUE_MAX (OUTBOX_SIZE - MESSAGE_OVERHEAD)
+
+// Single-tuple message waiting for its turn in the outbox
+typedef struct {
+    uint32_t key;
+    TupleType type;
+    uint8_t length;
+    uint8_t attempts;
+    bool coalesce;
+    // HR_BATCH frames take a sequence number when first sent; a resend
+    // already has its original one
+    bool sequenced;
+    bool resend;
+    uint8_t data[OUTBOX_VALUE_MAX];
+} OutboxEntry;
+
+// Acknowledged HR_BATCH frames, kept for the phone's RESEND requests
+typedef struct {
+    uint8_t length;
+    uint8_t data[HR_BATCH_VALUE_MAX];
+} SentFrame;
+
+// FIFO of outgoing messages; the head entry is the one in flight
+static OutboxEntry s_queue[APPMSG_QUEUE_CAPACITY];
+static uint8_t s_queue_head = 0;
+static uint8_t s_queue_count = 0;
+static bool s_in_flight = false;
+static AppTimer *s_retry_timer = NULL;
+
+// Whether the phone app is reachable; nothing is sent while it is not
+static bool s_connected = true;
+
+// Buffers actually opened, as advertised in HELLO
+static uint32_t s_inbox_size = INBOX_SIZE;
+static uint8_t s_outbox_value_max = OUTBOX_VALUE_MAX;
+
+static uint16_t s_next_seq = 0;
+static SentFrame s_sent[APPMSG_RESEND_HISTORY];
+static uint8_t s_sent_next = 0;
+
+// Bluetooth sniff interval currently asked for, since when, and the time
+// spent at each one before that
+static SniffInterval s_sniff = SNIFF_INTERVAL_NORMAL;
+static uint64_t s_sniff_since_ms = 0;
+static uint32_t s_sniff_ms[SNIFF_INTERVAL_REDUCED + 1];
+
+static void queue_pump(void);
+static void keep_entry(const OutboxEntry *entry);
+
+// Little endian helpers for the byte array frames
+static uint16_t read_uint16(const uint8_t *data) {
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static uint32_t read_uint32(const uint8_t *data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void write_uint16(uint8_t *data, uint16_t value) {
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+}
+
+static void write_uint32(uint8_t *data, uint32_t value) {
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+}
+
+static uint64_t wall_clock_ms(void) {
+    time_t now_s;
+    uint16_t now_ms;
+    time_ms(&now_s, &now_ms);
+    return (uint64_t)now_s * 1000 + now_ms;
+}
+
+static void set_sniff_interval(SniffInterval interval) {
+    if (interval == s_sniff) {
+        return;
+    }
+    uint64_t now_ms = wall_clock_ms();
+    s_sniff_ms[s_sniff] += (uint32_t)(now_ms - s_sniff_since_ms);
+    s_sniff = interval;
+    s_sniff_since_ms = now_ms;
+    app_comm_set_sniff_interval(interval);
+}
+
+static OutboxEntry *queue_at(uint8_t index) {
+    return &s_queue[(s_queue_head + index) % APPMSG_QUEUE_CAPACITY];
+}
+
+static void queue_pop(void) {
+    s_queue_head = (s_queue_head + 1) % APPMSG_QUEUE_CAPACITY;
+    s_queue_count--;
+}
+
+// Reduced while messages wait, so each goes out and is acknowledged without
+// waiting on the radio; journaled and backfilled data drain through the
+// queue, so they count too. A head backing off after a failure is held up
+// by the link rather than by the radio, so it waits at the normal interval.
+static void update_sniff_interval(void) {
+    bool busy = s_connected && s_queue_count > 0 && queue_at(0)->attempts == 0;
+    set_sniff_interval(busy ? SNIFF_INTERVAL_REDUCED : SNIFF_INTERVAL_NORMAL);
+}
+
+static void retry_timer_callback(void *data) {
+    s_retry_timer = NULL;
+    queue_pump();
+    update_sniff_interval();
+}
+
+static void schedule_retry(uint8_t attempts) {
+    uint32_t delay_ms = APPMSG_RETRY_BASE_MS << (attempts > 0 ? attempts - 1 : 0);
+    if (delay_ms > APPMSG_RETRY_MAX_MS) {
+        delay_ms = APPMSG_RETRY_MAX_MS;
+    }
+    if (!s_retry_timer) {
+        s_retry_timer = app_timer_register(delay_ms, retry_timer_callback, NULL);
+    }
+}
+
+static bool is_hr_entry(const OutboxEntry *entry) {
+    return entry->key == KEY_HR_BATCH || entry->key == KEY_HR_MINUTES || entry->key == KEY_HR_LIVE;
+}
+
+// Retries the head entry after a backoff, or drops it once out of attempts
+static void queue_fail_head(void) {
+    OutboxEntry *entry = queue_at(0);
+    
+    // Without a phone there is nothing to retry against: HR data waits in
+    // the journal and backfill range, anything else at the head of the queue
+    if (!s_connected) {
+        if (is_hr_entry(entry)) {
+            keep_entry(entry);
+            queue_pop();
+        }
+        return;
+    }
+    
+    entry->attempts++;
+    if (entry->attempts > APPMSG_MAX_RETRIES) {
+        LOG(APP_LOG_LEVEL_ERROR, "Dropping key %d after %d attempts",
+            (int)entry->key, entry->attempts);
+        keep_entry(entry);
+        queue_pop();
+        queue_pump();
+        return;
+    }
+    schedule_retry(entry->attempts);
+}
+
+static bool queue_push(uint32_t key, TupleType type, const void *data, uint8_t length, bool coalesce,
+                       bool resend) {
+    if (length > s_outbox_value_max) {
+        LOG(APP_LOG_LEVEL_ERROR, "Outgoing value too large: %d", length);
+        return false;
+    }
+    
+    // A newer value for a coalescing key replaces the queued one; the
+    // in-flight head is left alone
+    OutboxEntry *entry = NULL;
+    if (coalesce) {
+        for (uint8_t i = s_in_flight ? 1 : 0; i < s_queue_count; i++) {
+            OutboxEntry *candidate = queue_at(i);
+            if (candidate->coalesce && candidate->key == key) {
+                entry = candidate;
+                break;
+            }
+        }
+    }
+    
+    if (!entry) {
+        if (s_queue_count == APPMSG_QUEUE_CAPACITY) {
+            LOG(APP_LOG_LEVEL_WARNING, "Outbox queue full, message deferred");
+            return false;
+        }
+        entry = queue_at(s_queue_count);
+        s_queue_count++;
+    }
+    
+    entry->key = key;
+    entry->type = type;
+    entry->length = length;
+    entry->attempts = 0;
+    entry->coalesce = coalesce;
+    entry->sequenced = resend;
+    entry->resend = resend;
+    memcpy(entry->data, data, length);
     
+    queue_pump();
+    update_sniff_interval();
+    return true;
+}
+
+static void queue_pump(void) {
+    if (!s_connected || s_in_flight || s_retry_timer || s_queue_count == 0) {
+        return;
+    }
+    
+    OutboxEntry *entry = queue_at(0);
+    if (entry->key == KEY_HR_BATCH && !entry->sequenced) {
+        write_uint16(&entry->data[HR_BATCH_SEQ_OFFSET], s_next_seq++);
+        entry->sequenced = true;
+    }
+    
+    DictionaryIterator *iter;
+    AppMessageResult result = app_message_outbox_begin(&iter);
+    if (result != APP_MSG_OK) {
+        LOG(APP_LOG_LEVEL_WARNING, "Failed to begin outbox: %d", result);
+        schedule_retry(1);
+        return;
+    }
+    
+    DictionaryResult dict_result;
+    switch (entry->type) {
+        case TUPLE_BYTE_ARRAY:
+            dict_result = dict_write_data(iter, entry->key, entry->data, entry->length);
+            break;
+        case TUPLE_CSTRING:
+            dict_result = dict_write_cstring(iter, entry->key, (const char *)entry->data);
+            break;
+        default:
+            dict_result = dict_write_int(iter, entry->key, entry->data, entry->length,
+                                         entry->type == TUPLE_INT);
+            break;
+    }
+    if (dict_result != DICT_OK) {
+        // Cannot succeed on retry either, so drop it
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to write key %d to dictionary: %d",
+            (int)entry->key, dict_result);
+        queue_pop();
+        queue_pump();
+        return;
+    }
+    
+    result = app_message_outbox_send();
+    if (result != APP_MSG_OK) {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to send message: %d", result);
+        perf_count_failure(result);
+        queue_fail_head();
+        return;
+    }
+    
+    s_in_flight = true;
+}
+
+// Keeps the data of an undeliverable HR frame for a later drain: batch
+// samples go to the journal, minute frames back to the backfill range. A
+// live value is stale by then and its sample is in the spool, so it is dropped.
+static void keep_entry(const OutboxEntry *entry) {
+    if (entry->key == KEY_HR_MINUTES && entry->length >= HR_MINUTES_HEADER_SIZE) {
+        uint32_t base_time = read_uint32(&entry->data[HR_MINUTES_BASE_TIME_OFFSET]);
+        backfill_add_range(base_time, base_time + entry->data[HR_MINUTES_COUNT_OFFSET] * 60);
+        return;
+    }
+    if (entry->key != KEY_HR_BATCH || entry->length < HR_BATCH_HEADER_SIZE) {
+        return;
+    }
+    
+    // Decoded a sample at a time; a malformed tail is lost, the rest is kept
+    HRSample sample = {
+        .timestamp = read_uint32(&entry->data[HR_BATCH_BASE_TIME_OFFSET]),
+        .bpm = entry->data[HR_BATCH_BPM_OFFSET],
+        .quality = entry->data[HR_BATCH_QUALITY_OFFSET]
+    };
+    uint8_t count = entry->data[HR_BATCH_COUNT_OFFSET];
+    if (count == 0) {
+        return;
+    }
+    journal_append(&sample, 1);
+    
+    HRPackReader reader;
+    hrpack_reader_init(&reader, &entry->data[HR_BATCH_HEADER_SIZE], entry->length - HR_BATCH_HEADER_SIZE,
+                       entry->data[HR_BATCH_STEP_OFFSET], sample);
+    for (uint8_t i = 1; i < count && hrpack_next(&reader, &sample); i++) {
+        journal_append(&sample, 1);
+    }
+}
+
+// Sends journaled samples, then backfilled minutes, while the queue is
+// quiet, keeping room for live data
+static void drain_backlog(void) {
+    if (!s_connected) {
+        return;
+    }
+    
+    while (s_queue_count < APPMSG_JOURNAL_DRAIN_DEPTH && journal_sample_count() > 0) {
+        HRSample samples[HR_BATCH_SIZE];
+        uint16_t count = journal_peek(samples, HR_BATCH_SIZE);
+        uint8_t sent = appmsg_send_hr_batch(samples, (uint8_t)count);
+        if (sent == 0) {
+            return;
+        }
+        journal_consume(sent);
+    }
+    
+    while (s_queue_count < APPMSG_JOURNAL_DRAIN_DEPTH && backfill_pending()) {
+        uint8_t bpm[HR_MINUTES_MAX_MINUTES];
+        uint32_t base_time;
+        uint8_t count = backfill_peek(bpm, HR_MINUTES_MAX_MINUTES, &base_time);
+        if (count == 0 || !appmsg_send_hr_minutes(base_time, bpm, count)) {
+            return;
+        }
+        backfill_consume(count);
+    }
+}
+
+static bool queue_holds(uint32_t key) {
+    for (uint8_t i = 0; i < s_queue_count; i++) {
+        if (queue_at(i)->key == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Queues the persisted HR summary again, unless it is still waiting
+static void send_kept_summary(void) {
+    uint8_t payload[HR_SUMMARY_FRAME_SIZE];
+    if (queue_holds(KEY_HR_SUMMARY) ||
+        persist_read_data(APPMSG_PERSIST_KEY_SUMMARY, payload, sizeof(payload)) != sizeof(payload)) {
+        return;
+    }
+    LOG(APP_LOG_LEVEL_INFO, "Resending undelivered HR summary");
+    queue_push(KEY_HR_SUMMARY, TUPLE_BYTE_ARRAY, payload, sizeof(payload), false, false);
+}
+
+// An acknowledged HR summary no longer needs its persisted copy, unless a
+// newer workout's summary has replaced it
+static void release_summary(const OutboxEntry *entry) {
+    uint8_t payload[HR_SUMMARY_FRAME_SIZE];
+    if (entry->key == KEY_HR_SUMMARY &&
+        persist_read_data(APPMSG_PERSIST_KEY_SUMMARY, payload, sizeof(payload)) == entry->length &&
+        memcmp(payload, entry->data, entry->length) == 0) {
+        persist_delete(APPMSG_PERSIST_KEY_SUMMARY);
+    }
+}
+
+// Remembers an acknowledged HR batch, replacing the oldest one
+static void remember_sent(const OutboxEntry *entry) {
+    if (entry->key != KEY_HR_BATCH || entry->resend) {
+        return;
+    }
+    SentFrame *frame = &s_sent[s_sent_next];
+    frame->length = entry->length;
+    memcpy(frame->data, entry->data, entry->length);
+    s_sent_next = (s_sent_next + 1) % APPMSG_RESEND_HISTORY;
+}
+
+static void handle_inbox(DictionaryIterator *iterator) {
     // Process incoming messages
-    Tuple *pace_tuple = dict_find(iterator, KEY_PACE);
-    if (pace_tuple && pace_tuple->type == TUPLE_CSTRING) {
-        appmsg_handle_pace_update(pace_tuple->value->cstring);
+    Tuple *workout_tuple = dict_find(iterator, KEY_WORKOUT);
+    if (workout_tuple && workout_tuple->type == TUPLE_BYTE_ARRAY) {
+        appmsg_handle_workout_frame(workout_tuple->value->data, workout_tuple->length);
+    }
+    
+    Tuple *resend_tuple = dict_find(iterator, KEY_RESEND);
+    if (resend_tuple && resend_tuple->type == TUPLE_BYTE_ARRAY) {
+        appmsg_handle_resend(resend_tuple->value->data, resend_tuple->length);
     }
     
-    Tuple *time_tuple = dict_find(iterator, KEY_TIME);
-    if (time_tuple && time_tuple->type == TUPLE_CSTRING) {
-        appmsg_handle_time_update(time_tuple->value->cstring);
+    Tuple *zones_tuple = dict_find(iterator, KEY_ZONES);
+    if (zones_tuple && zones_tuple->type == TUPLE_BYTE_ARRAY) {
+        appmsg_handle_zones_frame(zones_tuple->value->data, zones_tuple->length);
+    }
+    
+    // Ahead of the command, so a START in the same message uses it
+    Tuple *uplink_tuple = dict_find(iterator, KEY_UPLINK);
+    if (uplink_tuple && (uplink_tuple->type == TUPLE_UINT || uplink_tuple->type == TUPLE_INT)) {
+        datalog_set_uplink(uplink_tuple->value->uint8);
     }
     
     Tuple *cmd_tuple = dict_find(iterator, KEY_CMD);
-    if (cmd_tuple && cmd_tuple->type == TUPLE_UINT8) {
+    bool has_cmd = cmd_tuple && (cmd_tuple->type == TUPLE_UINT || cmd_tuple->type == TUPLE_INT);
+    if (has_cmd) {
         appmsg_handle_command(cmd_tuple->value->uint8);
     }
+    
+    LOG_EVENT(LOG_EVENT_INBOX, has_cmd ? cmd_tuple->value->uint8 : -1, workout_tuple != NULL);
+}
+
+static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
+    uint32_t started_ms = perf_begin();
+    handle_inbox(iterator);
+    perf_end(PERF_PROBE_INBOX, started_ms);
 }
 
 static void inbox_dropped_callback(AppMessageResult reason, void *context) {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "AppMessage inbox dropped: %d", reason);
+    LOG(APP_LOG_LEVEL_ERROR, "AppMessage inbox dropped: %d", reason);
 }
 
 static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "AppMessage sent successfully");
+    // ACK received: release the head and send the next entry
+    if (s_in_flight) {
+        LOG_EVENT(LOG_EVENT_OUTBOX_SENT, queue_at(0)->key, queue_at(0)->length);
+        s_in_flight = false;
+        remember_sent(queue_at(0));
+        release_summary(queue_at(0));
+        queue_pop();
+    }
+    queue_pump();
+    
+    // The phone is reachable again; catch up on what it missed
+    if (s_queue_count == 0) {
+        drain_backlog();
+    }
+    update_sniff_interval();
 }
 
 static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context) {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "AppMessage send failed: %d", reason);
+    LOG(APP_LOG_LEVEL_ERROR, "AppMessage send failed: %d", reason);
+    perf_count_failure(reason);
+    
+    if (s_in_flight) {
+        LOG_EVENT(LOG_EVENT_OUTBOX_FAILED, queue_at(0)->key, reason);
+        s_in_flight = false;
+        queue_fail_head();
+    }
+    update_sniff_interval();
+}
+
+// Moves queued HR frames to the journal and backfill range, dropping live
+// values and leaving the rest queued in order; the head is left alone while in flight, since its
+// failure callback is still to come
+static void stash_queued_hr(void) {
+    uint8_t kept = s_in_flight ? 1 : 0;
+    for (uint8_t i = kept; i < s_queue_count; i++) {
+        OutboxEntry *entry = queue_at(i);
+        if (is_hr_entry(entry)) {
+            keep_entry(entry);
+        } else {
+            if (kept != i) {
+                *queue_at(kept) = *entry;
+            }
+            kept++;
+        }
+    }
+    s_queue_count = kept;
+}
+
+// On disconnect the uplink goes quiet: no retries, and HR data is stashed
+// until the phone is back. On reconnect it catches up once, latest first:
+// whatever else was queued, then the samples still buffered in RAM, then
+// the journal and the backfill range through the usual drain.
+static void connection_handler(bool connected) {
+    if (connected == s_connected) {
+        return;
+    }
+    s_connected = connected;
+    LOG(APP_LOG_LEVEL_INFO, "Phone %s", connected ? "connected" : "disconnected");
+    
+    if (!connected) {
+        if (s_retry_timer) {
+            app_timer_cancel(s_retry_timer);
+            s_retry_timer = NULL;
+        }
+        stash_queued_hr();
+    } else {
+        if (s_queue_count > 0) {
+            queue_at(0)->attempts = 0;
+        }
+        queue_pump();
+        send_kept_summary();
+        hr_flush_samples();
+        drain_backlog();
+    }
+    update_sniff_interval();
+}
+
+// Opens the schema's buffers, or the firmware's largest if those are smaller
+static AppMessageResult open_buffers(void) {
+    uint32_t inbox_maximum = app_message_inbox_size_maximum();
+    uint32_t outbox_maximum = app_message_outbox_size_maximum();
+    s_inbox_size = inbox_maximum < INBOX_SIZE ? inbox_maximum : INBOX_SIZE;
+    uint32_t outbox_size = outbox_maximum < OUTBOX_SIZE ? outbox_maximum : OUTBOX_SIZE;
+    s_outbox_value_max = outbox_size > MESSAGE_OVERHEAD ? (uint8_t)(outbox_size - MESSAGE_OVERHEAD) : 0;
+    if (s_inbox_size < INBOX_SIZE || outbox_size < OUTBOX_SIZE) {
+        LOG(APP_LOG_LEVEL_WARNING, "AppMessage buffers capped at %d/%d bytes",
+            (int)s_inbox_size, (int)outbox_size);
+    }
+    
+    return app_message_open(s_inbox_size, outbox_size);
+}
+
+// Tells the phone which protocol this build speaks and how large its
+// messages may be; queued ahead of any backlog
+static void send_hello(void) {
+    uint8_t payload[HELLO_FRAME_SIZE];
+    payload[HELLO_PROTOCOL_OFFSET] = PROTOCOL_VERSION;
+    write_uint16(&payload[HELLO_MAX_VALUE_OFFSET], s_outbox_value_max);
+    write_uint16(&payload[HELLO_INBOX_OFFSET], (uint16_t)s_inbox_size);
+    queue_push(KEY_HELLO, TUPLE_BYTE_ARRAY, payload, sizeof(payload), false, false);
 }
 
 void appmsg_init(void) {
+    s_queue_head = 0;
+    s_queue_count = 0;
+    s_in_flight = false;
+    s_sent_next = 0;
+    memset(s_sent, 0, sizeof(s_sent));
+    s_connected = connection_service_peek_pebble_app_connection();
+    s_sniff = SNIFF_INTERVAL_NORMAL;
+    s_sniff_since_ms = wall_clock_ms();
+    memset(s_sniff_ms, 0, sizeof(s_sniff_ms));
+    
+    // Sequence numbers continue across runs so the phone does not take a
+    // relaunch for duplicates
+    uint8_t seq[2];
+    s_next_seq = persist_read_data(APPMSG_PERSIST_KEY_SEQ, seq, sizeof(seq)) == sizeof(seq) ? read_uint16(seq) : 0;
+    
     // Open AppMessage with defined buffer sizes
     app_message_register_inbox_received(inbox_received_callback);
     app_message_register_inbox_dropped(inbox_dropped_callback);
     app_message_register_outbox_sent(outbox_sent_callback);
     app_message_register_outbox_failed(outbox_failed_callback);
+    connection_service_subscribe((ConnectionHandlers){
+        .pebble_app_connection_handler = connection_handler
+    });
     
-    AppMessageResult result = app_message_open(INBOX_SIZE, OUTBOX_SIZE);
+    AppMessageResult result = open_buffers();
     if (result == APP_MSG_OK) {
-        APP_LOG(APP_LOG_LEVEL_INFO, "AppMessage initialized successfully");
+        LOG(APP_LOG_LEVEL_INFO, "AppMessage initialized successfully");
+        send_hello();
+        // A summary and samples left over from an earlier run or disconnect
+        send_kept_summary();
+        drain_backlog();
     } else {
-        APP_LOG(APP_LOG_LEVEL_ERROR, "AppMessage initialization failed: %d", result);
+        LOG(APP_LOG_LEVEL_ERROR, "AppMessage initialization failed: %d", result);
     }
 }
 
 void appmsg_deinit(void) {
+    // Unacknowledged HR frames outlive the app in the journal and backfill range
+    for (uint8_t i = 0; i < s_queue_count; i++) {
+        keep_entry(queue_at(i));
+    }
+    s_queue_count = 0;
+    
+    uint8_t seq[2];
+    write_uint16(seq, s_next_seq);
+    if (persist_write_data(APPMSG_PERSIST_KEY_SEQ, seq, sizeof(seq)) < 0) {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to persist HR frame sequence");
+    }
+    
+    if (s_retry_timer) {
+        app_timer_cancel(s_retry_timer);
+        s_retry_timer = NULL;
+    }
+    set_sniff_interval(SNIFF_INTERVAL_NORMAL);
+    connection_service_unsubscribe();
     app_message_deregister_callbacks();
-    APP_LOG(APP_LOG_LEVEL_INFO, "AppMessage deinitialized");
+    LOG(APP_LOG_LEVEL_INFO, "AppMessage deinitialized");
 }
 
-void appmsg_send_hr(uint16_t hr_bpm) {
-    DictionaryIterator *iter;
-    AppMessageResult result = app_message_outbox_begin(&iter);
+// The first sample and the quality of all of them ride in the header; the
+// sequence number is filled in when the frame is first sent
+static void write_batch_header(uint8_t *payload, const HRSample *first, uint8_t count, uint8_t step) {
+    payload[HR_BATCH_COUNT_OFFSET] = count;
+    write_uint16(&payload[HR_BATCH_SEQ_OFFSET], 0);
+    write_uint32(&payload[HR_BATCH_BASE_TIME_OFFSET], first->timestamp);
+    payload[HR_BATCH_STEP_OFFSET] = step;
+    payload[HR_BATCH_QUALITY_OFFSET] = first->quality;
+    payload[HR_BATCH_BPM_OFFSET] = first->bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)first->bpm;
+}
+
+void appmsg_send_hr(uint16_t hr_bpm, uint8_t quality) {
+    // Timestamped like a DataLogging record, but under its own key and
+    // unsequenced, so the phone shows it without storing the sample twice;
+    // only the latest live reading matters, so it replaces a queued one and
+    // is not kept while the phone is away
+    if (!s_connected) {
+        return;
+    }
+    uint8_t payload[HR_RECORD_SIZE];
+    write_uint32(&payload[HR_RECORD_TIME_OFFSET], (uint32_t)time(NULL));
+    payload[HR_RECORD_BPM_OFFSET] = hr_bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)hr_bpm;
+    payload[HR_RECORD_QUALITY_OFFSET] = quality;
+    queue_push(KEY_HR_LIVE, TUPLE_BYTE_ARRAY, payload, sizeof(payload), true, false);
+}
+
+uint8_t appmsg_send_hr_batch(const HRSample *samples, uint8_t count) {
+    if (!samples || count == 0) {
+        return 0;
+    }
     
-    if (result == APP_MSG_OK) {
-        result = dict_write_uint16(iter, KEY_HR, hr_bpm);
-        if (result == DICT_OK) {
-            result = app_message_outbox_send();
-            if (result != APP_MSG_OK) {
-                APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to send HR message: %d", result);
+    // Taken straight to the journal while the phone is away, so the caller
+    // does not keep retrying; they go out in the catch-up on reconnect
+    if (!s_connected) {
+        journal_append(samples, count);
+        return count;
+    }
+    
+    // As many samples as pack into one frame the outbox can hold; the
+    // caller sends the rest next
+    if (s_outbox_value_max < HR_BATCH_HEADER_SIZE) {
+        return 0;
+    }
+    uint8_t stream_max = s_outbox_value_max - HR_BATCH_HEADER_SIZE;
+    if (stream_max > HR_BATCH_STREAM_MAX) {
+        stream_max = HR_BATCH_STREAM_MAX;
+    }
+    
+    // One quality per frame, so a change of quality starts the next one
+    uint8_t run = 1;
+    while (run < count && samples[run].quality == samples[0].quality) {
+        run++;
+    }
+    
+    uint8_t payload[HR_BATCH_VALUE_MAX];
+    uint8_t step = hrpack_choose_step(samples, run);
+    uint8_t length;
+    uint8_t packed = hrpack_encode(samples, run, step, &payload[HR_BATCH_HEADER_SIZE], stream_max, &length);
+    write_batch_header(payload, samples, packed, step);
+    
+    if (!queue_push(KEY_HR_BATCH, TUPLE_BYTE_ARRAY, payload, HR_BATCH_HEADER_SIZE + length, false, false)) {
+        return 0;
+    }
+    
+    return packed;
+}
+
+bool appmsg_send_hr_minutes(uint32_t base_time, const uint8_t *bpm, uint8_t count) {
+    if (!bpm || count == 0 || count > HR_MINUTES_MAX_MINUTES) {
+        return false;
+    }
+    
+    uint8_t payload[HR_MINUTES_HEADER_SIZE + HR_MINUTES_MAX_MINUTES * HR_MINUTES_MINUTE_SIZE];
+    payload[HR_MINUTES_COUNT_OFFSET] = count;
+    write_uint32(&payload[HR_MINUTES_BASE_TIME_OFFSET], base_time);
+    for (uint8_t i = 0; i < count; i++) {
+        payload[HR_MINUTES_HEADER_SIZE + i * HR_MINUTES_MINUTE_SIZE + HR_MINUTES_MINUTE_BPM_OFFSET] = bpm[i];
+    }
+    
+    return queue_push(KEY_HR_MINUTES, TUPLE_BYTE_ARRAY, payload,
+                      HR_MINUTES_HEADER_SIZE + count * HR_MINUTES_MINUTE_SIZE, false, false);
+}
+
+bool appmsg_send_hr_summary(const HRStats *stats) {
+    if (!stats) {
+        return false;
+    }
+    
+    static const uint8_t zone_offsets[HR_STATS_ZONE_COUNT] = {
+        HR_SUMMARY_ZONE1_OFFSET, HR_SUMMARY_ZONE2_OFFSET, HR_SUMMARY_ZONE3_OFFSET,
+        HR_SUMMARY_ZONE4_OFFSET, HR_SUMMARY_ZONE5_OFFSET
+    };
+    uint8_t payload[HR_SUMMARY_FRAME_SIZE];
+    write_uint32(&payload[HR_SUMMARY_SECONDS_OFFSET], stats->seconds);
+    payload[HR_SUMMARY_AVG_OFFSET] = stats->avg_bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)stats->avg_bpm;
+    payload[HR_SUMMARY_MIN_OFFSET] = stats->min_bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)stats->min_bpm;
+    payload[HR_SUMMARY_MAX_OFFSET] = stats->max_bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)stats->max_bpm;
+    for (uint8_t i = 0; i < HR_STATS_ZONE_COUNT; i++) {
+        write_uint32(&payload[zone_offsets[i]], stats->zone_s[i]);
+    }
+    
+    // Kept until acknowledged, so a STOP the phone never hears about is not
+    // the end of it
+    if (persist_write_data(APPMSG_PERSIST_KEY_SUMMARY, payload, sizeof(payload)) < 0) {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to persist HR summary");
+    }
+    return queue_push(KEY_HR_SUMMARY, TUPLE_BYTE_ARRAY, payload, sizeof(payload), false, false);
+}
+
+bool appmsg_send_perf(const PerfSnapshot *snapshot) {
+    if (!snapshot || s_outbox_value_max < PERF_HEADER_SIZE + PERF_PROBE_SIZE) {
+        return false;
+    }
+    
+    // As many probes per frame as the outbox holds, each frame with the header
+    uint8_t per_frame = (s_outbox_value_max - PERF_HEADER_SIZE) / PERF_PROBE_SIZE;
+    if (per_frame > PERF_MAX_PROBES) {
+        per_frame = PERF_MAX_PROBES;
+    }
+    static const uint8_t bucket_offsets[PERF_BUCKET_COUNT] = {
+        PERF_PROBE_UNDER_2MS_OFFSET, PERF_PROBE_UNDER_8MS_OFFSET,
+        PERF_PROBE_UNDER_32MS_OFFSET, PERF_PROBE_OVER_32MS_OFFSET
+    };
+    uint8_t payload[PERF_HEADER_SIZE + PERF_MAX_PROBES * PERF_PROBE_SIZE];
+    write_uint32(&payload[PERF_UPTIME_OFFSET], snapshot->uptime_s);
+    write_uint16(&payload[PERF_HEAP_PEAK_OFFSET],
+                 snapshot->heap_peak > UINT16_MAX ? UINT16_MAX : (uint16_t)snapshot->heap_peak);
+    write_uint16(&payload[PERF_FAIL_TIMEOUT_OFFSET], snapshot->fail_timeout);
+    write_uint16(&payload[PERF_FAIL_NACK_OFFSET], snapshot->fail_nack);
+    write_uint16(&payload[PERF_FAIL_OFFLINE_OFFSET], snapshot->fail_offline);
+    write_uint16(&payload[PERF_FAIL_OTHER_OFFSET], snapshot->fail_other);
+    write_uint16(&payload[PERF_SNIFF_REDUCED_OFFSET], snapshot->sniff_reduced_s);
+    
+    for (uint8_t first = 0; first < PERF_PROBE_COUNT; first += per_frame) {
+        uint8_t count = PERF_PROBE_COUNT - first < per_frame ? PERF_PROBE_COUNT - first : per_frame;
+        payload[PERF_COUNT_OFFSET] = count;
+        for (uint8_t i = 0; i < count; i++) {
+            const PerfProbeStats *probe = &snapshot->probes[first + i];
+            uint8_t *record = &payload[PERF_HEADER_SIZE + i * PERF_PROBE_SIZE];
+            record[PERF_PROBE_ID_OFFSET] = first + i;
+            write_uint32(&record[PERF_PROBE_CALLS_OFFSET], probe->calls);
+            write_uint32(&record[PERF_PROBE_TOTAL_MS_OFFSET], probe->total_ms);
+            write_uint16(&record[PERF_PROBE_MAX_MS_OFFSET], probe->max_ms);
+            for (uint8_t b = 0; b < PERF_BUCKET_COUNT; b++) {
+                write_uint16(&record[bucket_offsets[b]], probe->buckets[b]);
             }
-        } else {
-            APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to write HR to dictionary: %d", result);
         }
-    } else {
-        APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to begin outbox: %d", result);
+        if (!queue_push(KEY_PERF, TUPLE_BYTE_ARRAY, payload, PERF_HEADER_SIZE + count * PERF_PROBE_SIZE,
+                        false, false)) {
+            return false;
+        }
     }
+    return true;
+}
+
+void appmsg_send_backlog(void) {
+    if (s_queue_count == 0) {
+        drain_backlog();
+    }
+}
+
+uint8_t appmsg_queue_depth(void) {
+    return s_queue_count;
+}
+
+bool appmsg_is_connected(void) {
+    return s_connected;
+}
+
+uint32_t appmsg_sniff_ms(SniffInterval interval) {
+    uint32_t total = s_sniff_ms[interval];
+    if (interval == s_sniff) {
+        total += (uint32_t)(wall_clock_ms() - s_sniff_since_ms);
+    }
+    return total;
 }
 
 void appmsg_handle_command(uint8_t cmd) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Received command: %d", cmd);
+    LOG(APP_LOG_LEVEL_INFO, "Received command: %d", cmd);
     
+    // Diagnostics, outside the workout's state machine
     switch (cmd) {
-        case CMD_START:
-            APP_LOG(APP_LOG_LEVEL_INFO, "Starting workout session");
-            ui_show_window();
-            hr_start_monitoring();
+        case CMD_DUMP_LOG:
+            log_ring_dump();
             break;
-            
-        case CMD_STOP:
-            APP_LOG(APP_LOG_LEVEL_INFO, "Stopping workout session");
-            hr_stop_monitoring();
-            ui_hide_window();
-            // Return to default watchface by removing all windows
-            window_stack_pop_all(false);
+        case CMD_PERF_SNAPSHOT: {
+            PerfSnapshot snapshot;
+            perf_snapshot(&snapshot);
+            uint32_t reduced_s = appmsg_sniff_ms(SNIFF_INTERVAL_REDUCED) / 1000;
+            snapshot.sniff_reduced_s = reduced_s > UINT16_MAX ? UINT16_MAX : (uint16_t)reduced_s;
+            if (!appmsg_send_perf(&snapshot)) {
+                LOG(APP_LOG_LEVEL_WARNING, "Perf snapshot not queued");
+            }
             break;
-            
+        }
         default:
-            APP_LOG(APP_LOG_LEVEL_WARNING, "Unknown command: %d", cmd);
+            workout_handle_command(cmd);
             break;
     }
 }
 
-void appmsg_handle_pace_update(const char* pace) {
-    if (pace) {
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Pace update: %s", pace);
-        ui_update_pace(pace);
+bool appmsg_handle_workout_frame(const uint8_t *data, uint16_t length) {
+    // Newer phones may append fields; only the version 1 prefix is read
+    if (!data || length < WORKOUT_FRAME_SIZE || data[WORKOUT_VERSION_OFFSET] < WORKOUT_FRAME_VERSION) {
+        LOG(APP_LOG_LEVEL_WARNING, "Invalid workout frame, %d bytes", length);
+        return false;
+    }
+    
+    WorkoutMetrics metrics = {
+        .elapsed_s = read_uint32(&data[WORKOUT_ELAPSED_OFFSET]),
+        .pace_s_per_km = read_uint16(&data[WORKOUT_PACE_OFFSET]),
+        .distance_m = read_uint32(&data[WORKOUT_DISTANCE_OFFSET]),
+        .flags = data[WORKOUT_FLAGS_OFFSET]
+    };
+    
+    // Elapsed time is counted locally; the phone's value only corrects drift
+    workout_sync(metrics.elapsed_s, metrics.flags & WORKOUT_FLAG_PAUSED);
+    metrics.elapsed_s = session_elapsed_s();
+    ui_update_workout(&metrics);
+    return true;
+}
+
+uint8_t appmsg_handle_resend(const uint8_t *data, uint16_t length) {
+    if (!data || length < RESEND_FRAME_SIZE) {
+        LOG(APP_LOG_LEVEL_WARNING, "Invalid resend frame, %d bytes", length);
+        return 0;
     }
+    
+    uint16_t first = read_uint16(&data[RESEND_FIRST_SEQ_OFFSET]);
+    uint8_t count = data[RESEND_COUNT_OFFSET];
+    if (count > APPMSG_RESEND_HISTORY) {
+        count = APPMSG_RESEND_HISTORY;
+    }
+    
+    // Frames that aged out of the history were journaled or are gone; the
+    // phone fills those from later batches and backfill
+    uint8_t queued = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t seq = (uint16_t)(first + i);
+        for (uint8_t j = 0; j < APPMSG_RESEND_HISTORY; j++) {
+            const SentFrame *frame = &s_sent[j];
+            if (frame->length >= HR_BATCH_HEADER_SIZE && read_uint16(&frame->data[HR_BATCH_SEQ_OFFSET]) == seq) {
+                if (!queue_push(KEY_HR_BATCH, TUPLE_BYTE_ARRAY, frame->data, frame->length, false, true)) {
+                    return queued;
+                }
+                queued++;
+                break;
+            }
+        }
+    }
+    
+    LOG(APP_LOG_LEVEL_INFO, "Resending %d of %d HR frames from %d", queued, count, first);
+    return queued;
 }
 
-void appmsg_handle_time_update(const char* time) {
-    if (time) {
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Time update: %s", time);
-        ui_update_time(time);
+bool appmsg_handle_zones_frame(const uint8_t *data, uint16_t length) {
+    if (!data || length < ZONES_FRAME_SIZE) {
+        LOG(APP_LOG_LEVEL_WARNING, "Invalid zones frame, %d bytes", length);
+        return false;
+    }
+    
+    // All bounds zero asks for the percentages of the max HR
+    const uint8_t *lower = &data[ZONES_ZONE1_OFFSET];
+    for (uint8_t i = 0; i < HR_STATS_ZONE_COUNT; i++) {
+        if (lower[i]) {
+            return zones_set_thresholds(lower);
+        }
     }
+    zones_set_max_hr(data[ZONES_MAX_HR_OFFSET]);
+    return true;
 }
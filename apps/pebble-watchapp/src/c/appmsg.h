@@ -1,15 +1,56 @@
 #pragma once
 
 #include <pebble.h>
+#include "common.h"
+
+// Outgoing queue: one message in flight, retried with exponential backoff
+#define APPMSG_QUEUE_CAPACITY 8
+#define APPMSG_MAX_RETRIES 5
+#define APPMSG_RETRY_BASE_MS 500
+#define APPMSG_RETRY_MAX_MS 8000
+
+// Journaled HR and backfilled minutes are drained only while the queue is
+// shallower than this; a frame that exhausts its retries or is still queued
+// at exit is kept for a later drain
+#define APPMSG_JOURNAL_DRAIN_DEPTH (APPMSG_QUEUE_CAPACITY / 2)
+
+// The last acknowledged HR_BATCH frames are kept for RESEND requests; frame
+// sequence numbers are persisted across runs
+#define APPMSG_RESEND_HISTORY 8
+#define APPMSG_PERSIST_KEY_SEQ 0x4C00
+
+// The HR summary sent at STOP is persisted until the phone acknowledges it,
+// and queued again on reconnect and at the next launch
+#define APPMSG_PERSIST_KEY_SUMMARY 0x4C01
+
+// While the phone app is disconnected nothing is sent or retried: HR
+// batches go to the journal and the live value is dropped. Reconnecting
+// sends what is still queued, then the newest samples, then the backlog
+
+// The radio runs at SNIFF_INTERVAL_REDUCED only while messages are waiting
+// to go out, and drops back to normal as soon as the queue drains
 
 // AppMessage functions
 void appmsg_init(void);
 void appmsg_deinit(void);
 
 // Send functions
-void appmsg_send_hr(uint16_t hr_bpm);
+void appmsg_send_hr(uint16_t hr_bpm, uint8_t quality);
+uint8_t appmsg_send_hr_batch(const HRSample *samples, uint8_t count);
+bool appmsg_send_hr_minutes(uint32_t base_time, const uint8_t *bpm, uint8_t count);
+bool appmsg_send_hr_summary(const HRStats *stats);
+// One or more PERF frames, depending on the outbox size
+bool appmsg_send_perf(const PerfSnapshot *snapshot);
+void appmsg_send_backlog(void);
+uint8_t appmsg_queue_depth(void);
+bool appmsg_is_connected(void);
+
+// Time at each sniff interval since appmsg_init, including the current
+// stretch; PERF snapshots carry the reduced total
+uint32_t appmsg_sniff_ms(SniffInterval interval);
 
 // Message handling
 void appmsg_handle_command(uint8_t cmd);
-void appmsg_handle_pace_update(const char* pace);
-void appmsg_handle_time_update(const char* time);
+bool appmsg_handle_workout_frame(const uint8_t *data, uint16_t length);
+uint8_t appmsg_handle_resend(const uint8_t *data, uint16_t length);
+bool appmsg_handle_zones_frame(const uint8_t *data, uint16_t length);
@@ -0,0 +1,143 @@
+#include "backfill.h"
+#include "log.h"
+
+#define SECONDS_PER_MINUTE 60
+#define PERSIST_SIZE 8
+
+// Reasons the live uplink is currently not delivering, and since when
+static uint8_t s_gap_reasons = 0;
+static uint32_t s_gap_start = 0;
+
+// Minute-aligned range still to send, empty when from == to
+static uint32_t s_from = 0;
+static uint32_t s_to = 0;
+
+static uint32_t read_uint32(const uint8_t *data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void write_uint32(uint8_t *data, uint32_t value) {
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+}
+
+void backfill_init(void) {
+    s_gap_reasons = 0;
+    s_gap_start = 0;
+    s_from = 0;
+    s_to = 0;
+    
+    uint8_t data[PERSIST_SIZE];
+    if (persist_read_data(BACKFILL_PERSIST_KEY, data, sizeof(data)) == PERSIST_SIZE) {
+        backfill_add_range(read_uint32(&data[0]), read_uint32(&data[4]));
+        persist_delete(BACKFILL_PERSIST_KEY);
+    }
+}
+
+void backfill_deinit(void) {
+    // A gap still open at exit ends here; the next run sends it
+    if (s_gap_reasons) {
+        s_gap_reasons = 0;
+        backfill_add_range(s_gap_start, (uint32_t)time(NULL));
+    }
+    if (!backfill_pending()) {
+        return;
+    }
+    
+    uint8_t data[PERSIST_SIZE];
+    write_uint32(&data[0], s_from);
+    write_uint32(&data[4], s_to);
+    if (persist_write_data(BACKFILL_PERSIST_KEY, data, sizeof(data)) < 0) {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to persist backfill range");
+    }
+}
+
+void backfill_gap_begin(BackfillGapReason reason) {
+    if (s_gap_reasons == 0) {
+        s_gap_start = (uint32_t)time(NULL);
+    }
+    s_gap_reasons |= reason;
+}
+
+void backfill_gap_end(BackfillGapReason reason) {
+    if (!(s_gap_reasons & reason)) {
+        return;
+    }
+    s_gap_reasons &= ~reason;
+    if (s_gap_reasons == 0) {
+        backfill_add_range(s_gap_start, (uint32_t)time(NULL));
+    }
+}
+
+void backfill_add_range(uint32_t from, uint32_t to) {
+    if (to < from + BACKFILL_MIN_GAP_S) {
+        return;
+    }
+    
+    // Whole minutes covering the range; a pending range is widened to
+    // include it
+    from -= from % SECONDS_PER_MINUTE;
+    to += (SECONDS_PER_MINUTE - to % SECONDS_PER_MINUTE) % SECONDS_PER_MINUTE;
+    if (backfill_pending()) {
+        from = from < s_from ? from : s_from;
+        to = to > s_to ? to : s_to;
+    }
+    if (to - from > BACKFILL_MAX_MINUTES * SECONDS_PER_MINUTE) {
+        from = to - BACKFILL_MAX_MINUTES * SECONDS_PER_MINUTE;
+    }
+    
+    LOG(APP_LOG_LEVEL_INFO, "Backfilling %d minutes of HR", (int)((to - from) / SECONDS_PER_MINUTE));
+    s_from = from;
+    s_to = to;
+}
+
+uint8_t backfill_peek(uint8_t *bpm, uint8_t max_minutes, uint32_t *base_time) {
+    if (!backfill_pending()) {
+        return 0;
+    }
+    if (max_minutes > HR_MINUTES_MAX_MINUTES) {
+        max_minutes = HR_MINUTES_MAX_MINUTES;
+    }
+    
+    HealthMinuteData minutes[HR_MINUTES_MAX_MINUTES];
+    time_t start = (time_t)s_from;
+    time_t end = (time_t)s_to;
+    uint32_t count = health_service_get_minute_history(minutes, max_minutes, &start, &end);
+    if (count == 0) {
+        // Not recorded yet, or gone from the history if it is this old
+        if (s_to + BACKFILL_MAX_MINUTES * SECONDS_PER_MINUTE < (uint32_t)time(NULL)) {
+            LOG(APP_LOG_LEVEL_WARNING, "Dropping stale backfill range");
+            s_from = 0;
+            s_to = 0;
+        }
+        return 0;
+    }
+    
+    // Minutes before what the history still holds cannot be sent anymore
+    if ((uint32_t)start > s_from) {
+        s_from = (uint32_t)start;
+    }
+    if (count > max_minutes) {
+        count = max_minutes;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        bpm[i] = minutes[i].is_invalid ? 0 : minutes[i].heart_rate_bpm;
+    }
+    *base_time = s_from;
+    return (uint8_t)count;
+}
+
+void backfill_consume(uint8_t minutes) {
+    s_from += minutes * SECONDS_PER_MINUTE;
+    if (s_from >= s_to) {
+        s_from = 0;
+        s_to = 0;
+    }
+}
+
+bool backfill_pending(void) {
+    return s_to > s_from;
+}
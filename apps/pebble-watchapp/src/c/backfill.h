@@ -0,0 +1,39 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// Backfill of per-minute HR from the health service's minute history.
+//
+// Samples the phone does not get straight away wait in the journal, so only
+// time no sample was kept for is backfilled: while the live uplink is
+// switched off on a low battery, tracked as a gap until every reason for it
+// has cleared, and chunks the journal overwrote before they were sent. Their
+// minutes become a pending range that is read back with
+// health_service_get_minute_history and sent as HR_MINUTES frames. A range
+// still pending at exit is persisted for the next run.
+
+#define BACKFILL_PERSIST_KEY 0x4B00
+
+// Shorter gaps are left to the journal; longer ones keep their newest minutes
+#define BACKFILL_MIN_GAP_S 60
+#define BACKFILL_MAX_MINUTES 360
+
+typedef enum {
+    BACKFILL_GAP_LOW_BATTERY = 1 << 0
+} BackfillGapReason;
+
+void backfill_init(void);
+void backfill_deinit(void);
+
+void backfill_gap_begin(BackfillGapReason reason);
+void backfill_gap_end(BackfillGapReason reason);
+
+// Adds [from, to) to the pending range, e.g. for samples that were not kept
+void backfill_add_range(uint32_t from, uint32_t to);
+
+// Oldest whole minutes first; returns how many of the next minutes the
+// history has, 0 BPM for minutes without a reading
+uint8_t backfill_peek(uint8_t *bpm, uint8_t max_minutes, uint32_t *base_time);
+void backfill_consume(uint8_t minutes);
+bool backfill_pending(void);
@@ -1,25 +1,79 @@
 #pragma once
 
-// AppMessage keys (must match mobile app)
-typedef enum {
-    KEY_PACE = 0,
-    KEY_TIME = 1,
-    KEY_HR = 2,
-    KEY_CMD = 3
-} AppMessageKey;
+// AppMessage keys, commands and frame layouts (must match mobile app)
+#include "message_keys.h"
+
+// Timestamped HR reading
+typedef struct {
+    uint32_t timestamp;
+    uint16_t bpm;
+    uint8_t quality;  // HrBatchQuality
+} HRSample;
+
+// Workout HR statistics from hrstats.c, sent as the HR_SUMMARY frame
+#define HR_STATS_ZONE_COUNT 5
+typedef struct {
+    uint32_t seconds;
+    uint16_t avg_bpm;
+    uint16_t min_bpm;
+    uint16_t max_bpm;
+    uint32_t zone_s[HR_STATS_ZONE_COUNT];
+} HRStats;
+
+// Handler timings and failure counts from perf.c, sent as PERF frames
+#define PERF_PROBE_COUNT 3  // PerfProbe values
+#define PERF_BUCKET_COUNT 4
+typedef struct {
+    uint32_t calls;
+    uint32_t total_ms;
+    uint16_t max_ms;
+    uint16_t buckets[PERF_BUCKET_COUNT];  // under 2, 8 and 32 ms, and longer
+} PerfProbeStats;
 
-// Commands
+typedef struct {
+    uint32_t uptime_s;
+    uint32_t heap_peak;
+    uint16_t fail_timeout;
+    uint16_t fail_nack;
+    uint16_t fail_offline;
+    uint16_t fail_other;
+    uint16_t sniff_reduced_s;  // filled in by appmsg.c, which drives the radio
+    PerfProbeStats probes[PERF_PROBE_COUNT];
+} PerfSnapshot;
+
+// Decoded KEY_WORKOUT frame
+typedef struct {
+    uint32_t elapsed_s;
+    uint16_t pace_s_per_km;
+    uint32_t distance_m;
+    uint8_t flags;
+} WorkoutMetrics;
+
+// Workout lifecycle, driven by workout.c
 typedef enum {
-    CMD_START = 1,
-    CMD_STOP = 2
-} Command;
+    WORKOUT_IDLE,
+    WORKOUT_RUNNING,
+    WORKOUT_PAUSED,
+    WORKOUT_STOPPING
+} WorkoutState;
+
+// Display strings, formatted when their value changes so drawing only blits
+#define DISPLAY_TEXT_SIZE 24
+typedef struct {
+    char hr[DISPLAY_TEXT_SIZE];
+    char pace[DISPLAY_TEXT_SIZE];
+    char time[DISPLAY_TEXT_SIZE];
+    char hr_stats[DISPLAY_TEXT_SIZE];
+} DisplayText;
 
 // App state
 typedef struct {
     bool is_active;
+    WorkoutState state;
     uint16_t current_hr;
-    char pace_text[16];
-    char time_text[16];
+    uint8_t hr_zone;  // zones.h, 0 without a reading
+    WorkoutMetrics workout;
+    DisplayText text;
 } AppState;
 
 // Global app state
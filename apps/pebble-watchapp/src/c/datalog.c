@@ -0,0 +1,122 @@
+#include "datalog.h"
+#include "hr.h"
+#include "log.h"
+
+static uint8_t s_uplink = UPLINK_APPMESSAGE;
+
+// Tag of the running workout, 0 outside one, and its session once opened
+static uint32_t s_tag = 0;
+static DataLoggingSessionRef s_session = NULL;
+
+static uint8_t s_records[HR_BATCH_SIZE * HR_RECORD_SIZE];
+
+static void write_uint32(uint8_t *data, uint32_t value) {
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+}
+
+void datalog_init(void) {
+    s_tag = 0;
+    s_session = NULL;
+    
+    uint8_t uplink;
+    if (persist_read_data(DATALOG_PERSIST_KEY, &uplink, sizeof(uplink)) == sizeof(uplink) && uplink == UPLINK_DATALOG) {
+        s_uplink = UPLINK_DATALOG;
+    } else {
+        s_uplink = UPLINK_APPMESSAGE;
+    }
+}
+
+static void close_session(void) {
+    if (s_session) {
+        data_logging_finish(s_session);
+        s_session = NULL;
+    }
+}
+
+void datalog_deinit(void) {
+    // Left open for the next run to resume
+    s_session = NULL;
+    s_tag = 0;
+}
+
+bool datalog_set_uplink(uint8_t uplink) {
+    if (uplink != UPLINK_APPMESSAGE && uplink != UPLINK_DATALOG) {
+        LOG(APP_LOG_LEVEL_WARNING, "Unknown uplink: %d", uplink);
+        return false;
+    }
+    if (uplink == s_uplink) {
+        return true;
+    }
+    s_uplink = uplink;
+    
+    if (persist_write_data(DATALOG_PERSIST_KEY, &uplink, sizeof(uplink)) < 0) {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to persist uplink");
+    }
+    LOG(APP_LOG_LEVEL_INFO, "HR history uplink: %s", uplink == UPLINK_DATALOG ? "DataLogging" : "AppMessage");
+    return true;
+}
+
+bool datalog_enabled(void) {
+    return s_uplink == UPLINK_DATALOG;
+}
+
+void datalog_begin(uint32_t workout_start) {
+    close_session();
+    s_tag = workout_start;
+    
+    if (persist_write_data(DATALOG_PERSIST_KEY_TAG, &s_tag, sizeof(s_tag)) < 0) {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to persist DataLogging tag");
+    }
+}
+
+void datalog_join(uint32_t started_by) {
+    uint32_t tag;
+    if (persist_read_data(DATALOG_PERSIST_KEY_TAG, &tag, sizeof(tag)) == sizeof(tag) &&
+        tag <= started_by + DATALOG_JOIN_SLACK_S &&
+        (tag >= started_by || started_by - tag <= DATALOG_JOIN_MAX_PAUSED_S)) {
+        close_session();
+        s_tag = tag;
+        return;
+    }
+    datalog_begin(started_by);
+}
+
+void datalog_end(void) {
+    close_session();
+    s_tag = 0;
+    persist_delete(DATALOG_PERSIST_KEY_TAG);
+}
+
+uint8_t datalog_write(const HRSample *samples, uint8_t count) {
+    if (!datalog_enabled() || s_tag == 0 || !samples || count == 0) {
+        return 0;
+    }
+    if (count > HR_BATCH_SIZE) {
+        count = HR_BATCH_SIZE;
+    }
+    
+    if (!s_session) {
+        s_session = data_logging_create(s_tag, DATA_LOGGING_BYTE_ARRAY, HR_RECORD_SIZE, true);
+        if (!s_session) {
+            LOG(APP_LOG_LEVEL_ERROR, "Failed to open DataLogging session");
+            return 0;
+        }
+    }
+    
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t *record = &s_records[i * HR_RECORD_SIZE];
+        write_uint32(&record[HR_RECORD_TIME_OFFSET], samples[i].timestamp);
+        record[HR_RECORD_BPM_OFFSET] = samples[i].bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)samples[i].bpm;
+        record[HR_RECORD_QUALITY_OFFSET] = samples[i].quality;
+    }
+    
+    DataLoggingResult result = data_logging_log(s_session, s_records, count);
+    if (result != DATA_LOGGING_SUCCESS) {
+        LOG(APP_LOG_LEVEL_WARNING, "DataLogging refused %d samples: %d", count, result);
+        return 0;
+    }
+    return count;
+}
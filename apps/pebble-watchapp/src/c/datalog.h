@@ -0,0 +1,47 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// HR history through the firmware's DataLogging spool instead of AppMessage.
+//
+// When the phone selects UPLINK_DATALOG, the batches the ring would have
+// sent as HR_BATCH frames are written as HR_RECORD items into a session
+// tagged with the workout's start time, and the firmware batches and
+// delivers them on its own schedule. AppMessage is left with live values,
+// the summary and commands. The choice is persisted until the phone changes
+// it.
+
+#define DATALOG_PERSIST_KEY 0x4E00
+#define DATALOG_PERSIST_KEY_TAG 0x4E01
+
+// How far before the start implied by the phone's elapsed time a persisted
+// tag may lie and still be the same workout; the phone's elapsed time leaves
+// out pauses, which move that start later than the real one
+#define DATALOG_JOIN_MAX_PAUSED_S (4 * 60 * 60)
+#define DATALOG_JOIN_SLACK_S 5
+
+void datalog_init(void);
+void datalog_deinit(void);
+
+// Rejects an unknown uplink
+bool datalog_set_uplink(uint8_t uplink);
+bool datalog_enabled(void);
+
+// A new workout's tag, persisted until datalog_end(). Sessions are opened at
+// the first write, and resumed if an earlier run of the same workout left
+// one open
+void datalog_begin(uint32_t workout_start);
+
+// Rejoins a workout after a relaunch, from the start its elapsed time
+// implies: the persisted tag if it can belong to that workout, otherwise a
+// new tag at started_by
+void datalog_join(uint32_t started_by);
+
+// The workout is over: finishes the session and forgets the tag. An app
+// exit leaves both, so the next run can rejoin the session
+void datalog_end(void);
+
+// Returns how many samples the spool took, 0 when DataLogging is off or the
+// spool refuses them
+uint8_t datalog_write(const HRSample *samples, uint8_t count);
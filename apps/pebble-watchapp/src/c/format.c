@@ -0,0 +1,75 @@
+#include "format.h"
+
+#include <string.h>
+
+// Writes value in decimal, zero-padded to min_digits; returns the end of the text
+static char *put_uint(char *out, uint32_t value, uint8_t min_digits) {
+    char digits[10];
+    uint8_t count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    
+    while (count < min_digits) {
+        digits[count++] = '0';
+    }
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+static char *put_text(char *out, const char *text) {
+    size_t length = strlen(text);
+    memcpy(out, text, length);
+    return out + length;
+}
+
+void format_hr(char *out, uint16_t bpm) {
+    char *end = bpm > 0 ? put_uint(out, bpm, 1) : put_text(out, "--");
+    end = put_text(end, " BPM");
+    *end = '\0';
+}
+
+static uint16_t clamp_bpm(uint16_t bpm) {
+    return bpm > HR_MAX ? HR_MAX : bpm;
+}
+
+void format_hr_stats(char *out, uint16_t rolling_bpm, uint16_t avg_bpm, uint16_t max_bpm) {
+    char *end = out;
+    if (max_bpm > 0) {
+        if (rolling_bpm > 0) {
+            end = put_text(end, "30s ");
+            end = put_uint(end, clamp_bpm(rolling_bpm), 1);
+            *end++ = ' ';
+        }
+        end = put_text(end, "avg ");
+        end = put_uint(end, clamp_bpm(avg_bpm), 1);
+        end = put_text(end, " max ");
+        end = put_uint(end, clamp_bpm(max_bpm), 1);
+    }
+    *end = '\0';
+}
+
+void format_pace(char *out, uint16_t pace_s_per_km) {
+    char *end;
+    if (pace_s_per_km > 0) {
+        end = put_uint(out, pace_s_per_km / 60, 1);
+        *end++ = ':';
+        end = put_uint(end, pace_s_per_km % 60, 2);
+    } else {
+        end = put_text(out, "--:--");
+    }
+    end = put_text(end, "/km");
+    *end = '\0';
+}
+
+void format_duration(char *out, uint32_t elapsed_s) {
+    char *end = put_uint(out, elapsed_s / 3600, 2);
+    *end++ = ':';
+    end = put_uint(end, elapsed_s / 60 % 60, 2);
+    *end++ = ':';
+    end = put_uint(end, elapsed_s % 60, 2);
+    *end = '\0';
+}
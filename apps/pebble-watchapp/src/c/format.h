@@ -0,0 +1,22 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// Integer-only display formatting. Runs when a value changes, never while
+// drawing, and avoids pulling printf into the frame loop. Every output fits
+// in DISPLAY_TEXT_SIZE including the terminator: BPM values are clamped to
+// HR_MAX, so the longest, the HR statistics, is 23 characters.
+
+// "150 BPM", or "-- BPM" without a reading
+void format_hr(char *out, uint16_t bpm);
+
+// "5:30/km", or "--:--/km" without a pace
+void format_pace(char *out, uint16_t pace_s_per_km);
+
+// "30s 152 avg 148 max 171", or "" before the first reading; the first value
+// is the rolling mean, left out while its window is empty
+void format_hr_stats(char *out, uint16_t rolling_bpm, uint16_t avg_bpm, uint16_t max_bpm);
+
+// "01:02:03"; hours widen past two digits rather than wrap
+void format_duration(char *out, uint32_t elapsed_s);
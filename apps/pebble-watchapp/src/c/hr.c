@@ -2,37 +2,277 @@
 #include "common.h"
 #include "ui.h"
 #include "appmsg.h"
+#include "journal.h"
+#include "backfill.h"
+#include "hrquality.h"
+#include "hrstats.h"
+#include "zones.h"
+#include "datalog.h"
+#include "log.h"
+#include "perf.h"
 
 static bool s_hr_monitoring = false;
 
-static void hr_event_handler(HealthEventType event, void *context) {
+// Sample period controller state
+static uint16_t s_sample_period = 0;
+static bool s_workout_paused = false;
+static uint16_t s_recent[HR_STABLE_WINDOW];
+static uint8_t s_recent_count = 0;
+static uint8_t s_recent_next = 0;
+
+// Live upload is off on a low battery; the gap is backfilled in slices
+static bool s_uplink_off = false;
+static uint32_t s_live_sent_at = 0;
+static uint32_t s_uplink_off_since = 0;
+
+// Ring buffer of samples not yet handed to AppMessage
+static HRSample s_ring[HR_RING_CAPACITY];
+static uint16_t s_ring_head = 0;
+static uint16_t s_ring_count = 0;
+static AppTimer *s_flush_timer = NULL;
+
+static void flush_timer_callback(void *data) {
+    s_flush_timer = NULL;
+    hr_flush_samples();
+}
+
+static void schedule_flush(uint32_t timeout_ms) {
+    if (!s_flush_timer || !app_timer_reschedule(s_flush_timer, timeout_ms)) {
+        s_flush_timer = app_timer_register(timeout_ms, flush_timer_callback, NULL);
+    }
+}
+
+static void cancel_flush(void) {
+    if (s_flush_timer) {
+        app_timer_cancel(s_flush_timer);
+        s_flush_timer = NULL;
+    }
+}
+
+static void recent_reset(void) {
+    s_recent_count = 0;
+    s_recent_next = 0;
+}
+
+static void recent_push(uint16_t hr_bpm) {
+    // A jump restarts the window so the period snaps back to fast
+    if (s_recent_count > 0) {
+        uint16_t last = s_recent[(s_recent_next + HR_STABLE_WINDOW - 1) % HR_STABLE_WINDOW];
+        uint16_t jump = hr_bpm > last ? hr_bpm - last : last - hr_bpm;
+        if (jump >= HR_TRANSITION_BPM) {
+            recent_reset();
+        }
+    }
+    
+    s_recent[s_recent_next] = hr_bpm;
+    s_recent_next = (s_recent_next + 1) % HR_STABLE_WINDOW;
+    if (s_recent_count < HR_STABLE_WINDOW) {
+        s_recent_count++;
+    }
+}
+
+static bool recent_is_stable(void) {
+    if (s_recent_count < HR_STABLE_WINDOW) {
+        return false;
+    }
+    uint16_t min = s_recent[0];
+    uint16_t max = s_recent[0];
+    for (uint8_t i = 1; i < HR_STABLE_WINDOW; i++) {
+        if (s_recent[i] < min) {
+            min = s_recent[i];
+        }
+        if (s_recent[i] > max) {
+            max = s_recent[i];
+        }
+    }
+    return max - min <= HR_STABLE_SPREAD_BPM;
+}
+
+static bool battery_is_low(void) {
+    BatteryChargeState battery = battery_state_service_peek();
+    return !battery.is_plugged && battery.charge_percent <= HR_BATTERY_LOW_PERCENT;
+}
+
+static uint16_t choose_sample_period(void) {
+    if (s_workout_paused) {
+        return HR_PERIOD_SLOW_S;
+    }
+    if (!recent_is_stable()) {
+        return HR_PERIOD_FAST_S;
+    }
+    return battery_is_low() ? HR_PERIOD_SLOW_S : HR_PERIOD_STABLE_S;
+}
+
+static void update_sample_period(void) {
+    if (!s_hr_monitoring) {
+        return;
+    }
+    
+    uint16_t period = choose_sample_period();
+    if (period == s_sample_period) {
+        return;
+    }
+    if (health_service_set_heart_rate_sample_period(period)) {
+        LOG(APP_LOG_LEVEL_DEBUG, "HR sample period %d s", period);
+        s_sample_period = period;
+    } else {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to set HR sample period");
+    }
+}
+
+static void set_uplink_off(bool off) {
+    if (off == s_uplink_off) {
+        return;
+    }
+    s_uplink_off = off;
+    
+    if (off) {
+        // What is buffered still goes out; the minute history covers the rest
+        hr_flush_samples();
+        s_uplink_off_since = (uint32_t)time(NULL);
+        backfill_gap_begin(BACKFILL_GAP_LOW_BATTERY);
+        LOG(APP_LOG_LEVEL_INFO, "Battery low, live HR upload off");
+    } else {
+        backfill_gap_end(BACKFILL_GAP_LOW_BATTERY);
+        appmsg_send_backlog();
+        LOG(APP_LOG_LEVEL_INFO, "Live HR upload on");
+    }
+}
+
+// Closes the current slice of a low battery gap so the phone is not left
+// waiting for the battery to recover
+static void backfill_slice(void) {
+    uint32_t now = (uint32_t)time(NULL);
+    if (now - s_uplink_off_since < HR_LOW_BATTERY_BACKFILL_S) {
+        return;
+    }
+    s_uplink_off_since = now;
+    backfill_gap_end(BACKFILL_GAP_LOW_BATTERY);
+    appmsg_send_backlog();
+    backfill_gap_begin(BACKFILL_GAP_LOW_BATTERY);
+}
+
+static void battery_handler(BatteryChargeState charge) {
+    set_uplink_off(s_hr_monitoring && battery_is_low());
+    update_sample_period();
+}
+
+static void ring_push(uint16_t hr_bpm, uint8_t quality) {
+    if (s_ring_count == HR_RING_CAPACITY) {
+        // Keep the newest data in RAM; the oldest moves to the journal
+        journal_append(&s_ring[s_ring_head], 1);
+        s_ring_head = (s_ring_head + 1) % HR_RING_CAPACITY;
+        s_ring_count--;
+        LOG(APP_LOG_LEVEL_WARNING, "HR buffer full, journaled oldest sample");
+    }
+    
+    HRSample *sample = &s_ring[(s_ring_head + s_ring_count) % HR_RING_CAPACITY];
+    sample->timestamp = (uint32_t)time(NULL);
+    sample->bpm = hr_bpm;
+    sample->quality = quality;
+    s_ring_count++;
+    
+    // Flush on size, otherwise make sure the age threshold is armed
+    if (s_ring_count >= HR_BATCH_SIZE) {
+        hr_flush_samples();
+    } else if (!s_flush_timer) {
+        schedule_flush(s_workout_paused ? HR_BATCH_PAUSED_MAX_AGE_MS : HR_BATCH_MAX_AGE_MS);
+    }
+}
+
+// The batches go to the DataLogging spool, so the phone's display is fed
+// separately; a queued value is replaced by a newer one
+static void send_live(uint16_t hr_bpm, uint8_t quality) {
+    uint32_t now = (uint32_t)time(NULL);
+    if (!datalog_enabled() || now - s_live_sent_at < HR_LIVE_INTERVAL_S) {
+        return;
+    }
+    s_live_sent_at = now;
+    appmsg_send_hr(hr_bpm, quality);
+}
+
+// Colors the HR by zone and buzzes on a transition: once going up, twice
+// coming down
+static void update_zone(uint16_t hr_bpm) {
+    uint8_t previous = zones_current();
+    if (zones_update((uint32_t)time(NULL), hr_bpm)) {
+        if (zones_current() > previous) {
+            vibes_short_pulse();
+        } else {
+            vibes_double_pulse();
+        }
+        LOG(APP_LOG_LEVEL_INFO, "HR zone %d", zones_current());
+    }
+    ui_update_hr_zone(zones_current());
+}
+
+static void handle_health_event(HealthEventType event) {
     if (event == HealthEventHeartRateUpdate) {
         HealthValue hr_value = health_service_peek_current_value(HealthMetricHeartRateBPM);
         
         if (hr_value != HealthValueInvalid) {
             uint16_t hr_bpm = (uint16_t)hr_value;
+            uint8_t quality = hrquality_rate((uint32_t)time(NULL), hr_bpm, s_sample_period);
+            if (quality == HR_BATCH_QUALITY_BAD) {
+                // Neither shown nor uploaded, and kept out of the period controller
+                LOG_EVENT(LOG_EVENT_HR_REJECTED, hr_bpm, 0);
+                return;
+            }
             
-            // Update UI
+            // Update UI; paused time stays out of the workout statistics and
+            // zone alerts
             ui_update_hr(hr_bpm);
+            if (!s_workout_paused) {
+                HRStats stats;
+                hrstats_add((uint32_t)time(NULL), hr_bpm);
+                hrstats_get(&stats);
+                ui_update_hr_stats(hrstats_rolling_mean(), stats.avg_bpm, stats.max_bpm);
+                update_zone(hr_bpm);
+            }
+            
+            // Queue HR data for the next batched upload, unless the minute
+            // history stands in for it
+            if (s_uplink_off) {
+                backfill_slice();
+            } else {
+                ring_push(hr_bpm, quality);
+                send_live(hr_bpm, quality);
+            }
             
-            // Send HR data to mobile app
-            appmsg_send_hr(hr_bpm);
+            recent_push(hr_bpm);
+            update_sample_period();
             
-            APP_LOG(APP_LOG_LEVEL_INFO, "HR: %d BPM", hr_bpm);
+            LOG_EVENT(LOG_EVENT_HR_READING, hr_bpm, quality);
         } else {
-            APP_LOG(APP_LOG_LEVEL_WARNING, "Invalid HR reading");
+            hrquality_note_invalid();
+            LOG_EVENT(LOG_EVENT_HR_INVALID, 0, 0);
         }
     }
 }
 
+static void hr_event_handler(HealthEventType event, void *context) {
+    uint32_t started_ms = perf_begin();
+    handle_health_event(event);
+    perf_end(PERF_PROBE_HR_EVENT, started_ms);
+}
+
 void hr_init(void) {
+    s_ring_head = 0;
+    s_ring_count = 0;
+    s_sample_period = 0;
+    s_workout_paused = false;
+    s_uplink_off = false;
+    s_live_sent_at = 0;
+    recent_reset();
+    hrquality_reset();
+    
     // Check if health service is available
     if (!health_service_events_subscribe(hr_event_handler, NULL)) {
-        APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to subscribe to health events");
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to subscribe to health events");
         return;
     }
     
-    APP_LOG(APP_LOG_LEVEL_INFO, "HR monitoring initialized");
+    LOG(APP_LOG_LEVEL_INFO, "HR monitoring initialized");
 }
 
 void hr_deinit(void) {
@@ -40,37 +280,127 @@ void hr_deinit(void) {
         hr_stop_monitoring();
     }
     
+    cancel_flush();
+    
+    // Whatever the outgoing queue could not take is kept for the next run
+    while (s_ring_count > 0) {
+        journal_append(&s_ring[s_ring_head], 1);
+        s_ring_head = (s_ring_head + 1) % HR_RING_CAPACITY;
+        s_ring_count--;
+    }
+    
     health_service_events_unsubscribe();
-    APP_LOG(APP_LOG_LEVEL_INFO, "HR monitoring deinitialized");
+    LOG(APP_LOG_LEVEL_INFO, "HR monitoring deinitialized");
 }
 
 void hr_start_monitoring(void) {
     if (s_hr_monitoring) {
-        APP_LOG(APP_LOG_LEVEL_WARNING, "HR monitoring already active");
+        LOG(APP_LOG_LEVEL_WARNING, "HR monitoring already active");
         return;
     }
     
-    // Set HR sample period to 1 second for active monitoring
-    if (health_service_set_heart_rate_sample_period(1)) {
+    // Start fast; the controller relaxes the period once HR settles
+    s_workout_paused = false;
+    recent_reset();
+    hrquality_reset();
+    hrstats_reset();
+    ui_update_hr_stats(0, 0, 0);
+    zones_reset();
+    s_live_sent_at = 0;
+    if (health_service_set_heart_rate_sample_period(HR_PERIOD_FAST_S)) {
         s_hr_monitoring = true;
-        APP_LOG(APP_LOG_LEVEL_INFO, "HR monitoring started (1s interval)");
+        s_sample_period = HR_PERIOD_FAST_S;
+        battery_state_service_subscribe(battery_handler);
+        set_uplink_off(battery_is_low());
+        LOG(APP_LOG_LEVEL_INFO, "HR monitoring started (1s interval)");
     } else {
-        APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to set HR sample period");
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to set HR sample period");
     }
 }
 
 void hr_stop_monitoring(void) {
     if (!s_hr_monitoring) {
-        APP_LOG(APP_LOG_LEVEL_WARNING, "HR monitoring not active");
+        LOG(APP_LOG_LEVEL_WARNING, "HR monitoring not active");
         return;
     }
     
     // Reset HR sample period to default (less frequent)
+    battery_state_service_unsubscribe();
     health_service_set_heart_rate_sample_period(0);
     s_hr_monitoring = false;
+    s_sample_period = 0;
+    
+    // Upload whatever is still buffered, and the minutes of a low battery gap
+    hr_flush_samples();
+    set_uplink_off(false);
     
     // Clear HR display
     ui_update_hr(0);
+    zones_reset();
+    ui_update_hr_zone(0);
     
-    APP_LOG(APP_LOG_LEVEL_INFO, "HR monitoring stopped");
+    LOG(APP_LOG_LEVEL_INFO, "HR monitoring stopped");
+}
+
+void hr_flush_samples(void) {
+    // Hand everything buffered to the DataLogging spool when that is the
+    // uplink, otherwise, or if it refuses them, to the outgoing queue one
+    // batch per message
+    while (s_ring_count > 0) {
+        HRSample batch[HR_BATCH_SIZE];
+        uint8_t count = s_ring_count < HR_BATCH_SIZE ? s_ring_count : HR_BATCH_SIZE;
+        for (uint8_t i = 0; i < count; i++) {
+            batch[i] = s_ring[(s_ring_head + i) % HR_RING_CAPACITY];
+        }
+        
+        uint8_t sent = datalog_write(batch, count);
+        if (sent == 0) {
+            sent = appmsg_send_hr_batch(batch, count);
+        }
+        if (sent == 0) {
+            // Outgoing queue is full; retry once it has drained
+            schedule_flush(HR_BATCH_RETRY_MS);
+            return;
+        }
+        s_ring_head = (s_ring_head + sent) % HR_RING_CAPACITY;
+        s_ring_count -= sent;
+    }
+    
+    cancel_flush();
+}
+
+uint16_t hr_pending_samples(void) {
+    return s_ring_count;
+}
+
+void hr_set_workout_paused(bool paused) {
+    if (paused == s_workout_paused) {
+        return;
+    }
+    s_workout_paused = paused;
+    
+    // Resuming is a transition: sample fast until HR settles again. The
+    // first reading either side of the pause stands only for itself.
+    recent_reset();
+    hrstats_break();
+    update_sample_period();
+}
+
+uint16_t hr_sample_period(void) {
+    return s_sample_period;
+}
+
+bool hr_uplink_is_off(void) {
+    return s_uplink_off;
+}
+
+void hr_send_summary(void) {
+    HRStats stats;
+    hrstats_get(&stats);
+    if (stats.seconds == 0) {
+        return;
+    }
+    if (!appmsg_send_hr_summary(&stats)) {
+        LOG(APP_LOG_LEVEL_WARNING, "HR summary not queued");
+    }
 }
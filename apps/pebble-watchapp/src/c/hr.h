@@ -8,5 +8,47 @@ void hr_deinit(void);
 void hr_start_monitoring(void);
 void hr_stop_monitoring(void);
 
+// Adaptive sample period: 1 s after a start, resume or HR jump, relaxed once
+// the last HR_STABLE_WINDOW readings stay within HR_STABLE_SPREAD_BPM, and
+// slowest while paused or stable on a low, unplugged battery. Paused batches
+// also wait up to HR_BATCH_PAUSED_MAX_AGE_MS before uploading.
+#define HR_PERIOD_FAST_S 1
+#define HR_PERIOD_STABLE_S 5
+#define HR_PERIOD_SLOW_S 10
+#define HR_STABLE_WINDOW 8
+#define HR_STABLE_SPREAD_BPM 6
+#define HR_TRANSITION_BPM 8
+#define HR_BATTERY_LOW_PERCENT 20
+
+void hr_set_workout_paused(bool paused);
+uint16_t hr_sample_period(void);
+
+// On a low, unplugged battery the live upload stops and the health minute
+// history is backfilled instead, a slice every HR_LOW_BATTERY_BACKFILL_S and
+// the rest when the battery recovers or monitoring stops
+#define HR_LOW_BATTERY_BACKFILL_S 900
+
+bool hr_uplink_is_off(void);
+
+// Sample buffering and batched upload; a packed frame holds a steady
+// minute at the fastest period, so batches go out about once a minute
+#define HR_RING_CAPACITY 64
+#define HR_BATCH_SIZE 60
+#define HR_BATCH_MAX_AGE_MS 60000
+#define HR_BATCH_PAUSED_MAX_AGE_MS 120000
+#define HR_BATCH_RETRY_MS 1000
+
+// With DataLogging as the uplink (datalog.h) the phone still gets the latest
+// reading under HR_LIVE for its display, at most every HR_LIVE_INTERVAL_S,
+// about as often as batches go out otherwise
+#define HR_LIVE_INTERVAL_S 60
+
+void hr_flush_samples(void);
+uint16_t hr_pending_samples(void);
+
+// Queues the workout's HR statistics (hrstats.h) as an HR_SUMMARY frame,
+// unless there were no readings
+void hr_send_summary(void);
+
 // HR event callback type
 typedef void (*HRCallback)(uint16_t hr_bpm);
@@ -0,0 +1,158 @@
+#include "hrpack.h"
+
+// Payload bits per varint nibble; eleven nibbles cover a uint32
+#define VARINT_BITS 3
+#define VARINT_MAX_NIBBLES 11
+
+// Escape code plus the gap and delta varints
+#define ESCAPED_MAX_NIBBLES (1 + 2 * VARINT_MAX_NIBBLES)
+
+static uint8_t clamp_bpm(uint16_t bpm) {
+    return bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)bpm;
+}
+
+// Small steps either way become small codes: 0, -1, +1, -2, +2...
+static uint32_t zigzag(int32_t delta) {
+    return delta >= 0 ? (uint32_t)delta << 1 : ((uint32_t)-delta << 1) - 1;
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static uint8_t put_varint(uint8_t *nibbles, uint32_t value) {
+    uint8_t count = 0;
+    while (value >= HR_BATCH_CODE_VARINT_MORE) {
+        nibbles[count++] = (uint8_t)((value & (HR_BATCH_CODE_VARINT_MORE - 1)) | HR_BATCH_CODE_VARINT_MORE);
+        value >>= VARINT_BITS;
+    }
+    nibbles[count++] = (uint8_t)value;
+    return count;
+}
+
+static void put_nibble(uint8_t *stream, uint16_t index, uint8_t nibble) {
+    if (index % 2 == 0) {
+        // Also clears the low half, which pads an odd stream
+        stream[index / 2] = (uint8_t)(nibble << 4);
+    } else {
+        stream[index / 2] |= nibble;
+    }
+}
+
+uint8_t hrpack_choose_step(const HRSample *samples, uint8_t count) {
+    uint8_t best = 1;
+    uint8_t best_votes = 0;
+    for (uint8_t i = 1; i < count; i++) {
+        // Also skips a clock going backwards, which wraps to a huge gap
+        uint32_t gap = samples[i].timestamp - samples[i - 1].timestamp;
+        if (gap == 0 || gap > UINT8_MAX) {
+            continue;
+        }
+    
+        // Earlier occurrences of this gap were already counted
+        uint8_t votes = 0;
+        for (uint8_t j = i; j < count; j++) {
+            if (samples[j].timestamp - samples[j - 1].timestamp == gap) {
+                votes++;
+            }
+        }
+        if (votes > best_votes) {
+            best = (uint8_t)gap;
+            best_votes = votes;
+        }
+    }
+    return best;
+}
+
+uint8_t hrpack_encode(const HRSample *samples, uint8_t count, uint8_t step,
+                      uint8_t *stream, uint8_t max_bytes, uint8_t *length) {
+    uint16_t used = 0;
+    uint8_t packed = count > 0 ? 1 : 0;
+    
+    for (; packed < count; packed++) {
+        const HRSample *previous = &samples[packed - 1];
+        const HRSample *sample = &samples[packed];
+        if (sample->timestamp < previous->timestamp) {
+            // The next frame starts from here
+            break;
+        }
+        uint32_t gap = sample->timestamp - previous->timestamp;
+        uint32_t delta = zigzag((int32_t)clamp_bpm(sample->bpm) - (int32_t)clamp_bpm(previous->bpm));
+    
+        uint8_t code[ESCAPED_MAX_NIBBLES];
+        uint8_t size = 0;
+        if (gap == step && delta < HR_BATCH_CODE_ESCAPE) {
+            code[size++] = (uint8_t)delta;
+        } else {
+            code[size++] = HR_BATCH_CODE_ESCAPE;
+            size += put_varint(&code[size], gap);
+            size += put_varint(&code[size], delta);
+        }
+        if (used + size > max_bytes * 2) {
+            break;
+        }
+    
+        for (uint8_t i = 0; i < size; i++) {
+            put_nibble(stream, used++, code[i]);
+        }
+    }
+    
+    *length = (uint8_t)((used + 1) / 2);
+    return packed;
+}
+
+void hrpack_reader_init(HRPackReader *reader, const uint8_t *stream, uint8_t length,
+                        uint8_t step, HRSample first) {
+    reader->stream = stream;
+    reader->nibbles = (uint16_t)(length * 2);
+    reader->next = 0;
+    reader->step = step;
+    reader->last = first;
+}
+
+static bool take_nibble(HRPackReader *reader, uint8_t *nibble) {
+    if (reader->next >= reader->nibbles) {
+        return false;
+    }
+    uint8_t byte = reader->stream[reader->next / 2];
+    *nibble = reader->next % 2 == 0 ? byte >> 4 : byte & 0x0F;
+    reader->next++;
+    return true;
+}
+
+static bool take_varint(HRPackReader *reader, uint32_t *value) {
+    *value = 0;
+    for (uint8_t i = 0; i < VARINT_MAX_NIBBLES; i++) {
+        uint8_t nibble;
+        if (!take_nibble(reader, &nibble)) {
+            return false;
+        }
+        *value |= (uint32_t)(nibble & (HR_BATCH_CODE_VARINT_MORE - 1)) << (i * VARINT_BITS);
+        if (!(nibble & HR_BATCH_CODE_VARINT_MORE)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool hrpack_next(HRPackReader *reader, HRSample *sample) {
+    uint8_t code;
+    if (!take_nibble(reader, &code)) {
+        return false;
+    }
+    
+    uint32_t gap = reader->step;
+    uint32_t delta = code;
+    if (code == HR_BATCH_CODE_ESCAPE && (!take_varint(reader, &gap) || !take_varint(reader, &delta))) {
+        return false;
+    }
+    int32_t bpm = (int32_t)reader->last.bpm + unzigzag(delta);
+    if (bpm < 0 || bpm > UINT8_MAX) {
+        return false;
+    }
+    
+    reader->last.timestamp += gap;
+    reader->last.bpm = (uint16_t)bpm;
+    *sample = reader->last;
+    return true;
+}
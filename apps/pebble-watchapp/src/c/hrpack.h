@@ -0,0 +1,37 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// Nibble packing of the HR_BATCH sample stream. The first sample travels in
+// the frame header; each later one is a single nibble holding its zig-zag BPM
+// delta (-7..+7) when it comes STEP seconds after the previous sample.
+// Anything else is HR_BATCH_CODE_ESCAPE followed by the gap in seconds and
+// the zig-zag delta as nibble varints: 3 bits per nibble, low bits first,
+// HR_BATCH_CODE_VARINT_MORE set on all but the last. Nibbles fill each byte
+// high half first; an odd stream ends in a zero pad nibble.
+
+// The most common gap between the samples, clamped to 1..255; ties go to
+// the earliest
+uint8_t hrpack_choose_step(const HRSample *samples, uint8_t count);
+
+// Packs samples after the first into stream, stopping at the first sample
+// that does not fit in max_bytes or goes back in time. Returns how many
+// samples, the first included, the frame carries; *length is the stream size.
+uint8_t hrpack_encode(const HRSample *samples, uint8_t count, uint8_t step,
+                      uint8_t *stream, uint8_t max_bytes, uint8_t *length);
+
+// Walks a packed stream, one sample after another
+typedef struct {
+    const uint8_t *stream;
+    uint16_t nibbles;
+    uint16_t next;
+    uint8_t step;
+    HRSample last;
+} HRPackReader;
+
+void hrpack_reader_init(HRPackReader *reader, const uint8_t *stream, uint8_t length,
+                        uint8_t step, HRSample first);
+
+// False at the end of the stream or on a malformed code
+bool hrpack_next(HRPackReader *reader, HRSample *sample);
@@ -0,0 +1,71 @@
+#include "hrquality.h"
+
+// Last reading rated OK or better, and the last BAD one since
+static HRSample s_accepted;
+static bool s_has_accepted = false;
+static HRSample s_rejected;
+static bool s_has_rejected = false;
+
+static uint8_t s_invalid_score = 0;
+
+static uint16_t bpm_distance(uint16_t a, uint16_t b) {
+    return a > b ? a - b : b - a;
+}
+
+static uint8_t rate_jump(uint32_t timestamp, uint16_t bpm, uint16_t period_s) {
+    // Nothing to compare against
+    if (!s_has_accepted || timestamp < s_accepted.timestamp) {
+        return HR_BATCH_QUALITY_GOOD;
+    }
+    uint32_t gap = timestamp - s_accepted.timestamp;
+    if (gap > (uint32_t)HR_QUALITY_DROPOUT_PERIODS * (period_s > 0 ? period_s : 1)) {
+        return HR_BATCH_QUALITY_GOOD;
+    }
+    
+    uint32_t allowance = gap > 1 ? (gap - 1) * HR_QUALITY_SLEW_BPM_PER_S : 0;
+    uint16_t jump = bpm_distance(bpm, s_accepted.bpm);
+    if (jump > HR_QUALITY_JUMP_BAD_BPM + allowance) {
+        bool confirms = s_has_rejected && bpm_distance(bpm, s_rejected.bpm) <= HR_QUALITY_JUMP_GOOD_BPM;
+        return confirms ? HR_BATCH_QUALITY_OK : HR_BATCH_QUALITY_BAD;
+    }
+    return jump > HR_QUALITY_JUMP_GOOD_BPM + allowance ? HR_BATCH_QUALITY_OK : HR_BATCH_QUALITY_GOOD;
+}
+
+void hrquality_reset(void) {
+    s_has_accepted = false;
+    s_has_rejected = false;
+    s_invalid_score = 0;
+}
+
+void hrquality_note_invalid(void) {
+    s_invalid_score += HR_QUALITY_INVALID_WEIGHT;
+    if (s_invalid_score > HR_QUALITY_INVALID_MAX) {
+        s_invalid_score = HR_QUALITY_INVALID_MAX;
+    }
+}
+
+uint8_t hrquality_rate(uint32_t timestamp, uint16_t bpm, uint16_t period_s) {
+    bool in_range = bpm >= HR_QUALITY_MIN_BPM && bpm <= HR_QUALITY_MAX_BPM;
+    uint8_t quality = in_range ? rate_jump(timestamp, bpm, period_s) : HR_BATCH_QUALITY_BAD;
+    
+    if (s_invalid_score >= HR_QUALITY_INVALID_BAD) {
+        quality = HR_BATCH_QUALITY_BAD;
+    } else if (s_invalid_score >= HR_QUALITY_INVALID_OK && quality > HR_BATCH_QUALITY_OK) {
+        quality = HR_BATCH_QUALITY_OK;
+    }
+    if (s_invalid_score > 0) {
+        s_invalid_score--;
+    }
+    
+    HRSample sample = { .timestamp = timestamp, .bpm = bpm, .quality = quality };
+    if (quality == HR_BATCH_QUALITY_BAD) {
+        // Out of range readings never confirm a new level
+        s_rejected = sample;
+        s_has_rejected = in_range;
+    } else {
+        s_accepted = sample;
+        s_has_accepted = true;
+        s_has_rejected = false;
+    }
+    return quality;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// Confidence in each HR reading, sent as the HR_BATCH QUALITY byte.
+//
+// A reading starts out GOOD and is marked down for being outside the
+// plausible range, for jumping from the last accepted reading by more than
+// the heart can change in the time between them, and while the sensor keeps
+// reporting HealthValueInvalid. The jump is only judged while readings are
+// continuous: the first one, and the first after more than
+// HR_QUALITY_DROPOUT_PERIODS sample periods without an accepted reading,
+// have nothing to compare against. A jump is allowed
+// HR_QUALITY_SLEW_BPM_PER_S more for each second past the first; a second
+// reading agreeing with a BAD one confirms a new level and is OK.
+//
+// Invalid readings add HR_QUALITY_INVALID_WEIGHT to a score that each valid
+// reading takes one off, so an isolated dropout costs nothing and a sensor
+// that keeps dropping out caps readings at OK, then BAD.
+
+#define HR_QUALITY_MIN_BPM 30
+#define HR_QUALITY_MAX_BPM 220
+#define HR_QUALITY_JUMP_GOOD_BPM 10
+#define HR_QUALITY_JUMP_BAD_BPM 25
+#define HR_QUALITY_SLEW_BPM_PER_S 3
+#define HR_QUALITY_DROPOUT_PERIODS 3
+#define HR_QUALITY_INVALID_WEIGHT 4
+#define HR_QUALITY_INVALID_OK 8
+#define HR_QUALITY_INVALID_BAD 12
+#define HR_QUALITY_INVALID_MAX 16
+
+void hrquality_reset(void);
+
+// Call for every HealthValueInvalid reading
+void hrquality_note_invalid(void);
+
+// Rates a valid reading taken at timestamp, period_s after the one before
+// was due, and remembers it for the next; returns an HrBatchQuality
+uint8_t hrquality_rate(uint32_t timestamp, uint16_t bpm, uint16_t period_s);
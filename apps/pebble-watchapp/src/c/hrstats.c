@@ -0,0 +1,104 @@
+#include "hrstats.h"
+#include "zones.h"
+
+#include <string.h>
+
+// Totals since the reset; the average is derived when asked for
+static uint32_t s_seconds = 0;
+static uint32_t s_bpm_seconds = 0;
+static uint16_t s_min_bpm = 0;
+static uint16_t s_max_bpm = 0;
+static uint32_t s_zone_s[HR_STATS_ZONE_COUNT];
+
+static uint32_t s_last_time = 0;
+static bool s_has_last = false;
+
+// One BPM per second, 0 for a second without a reading
+static uint8_t s_window[HR_STATS_WINDOW_S];
+static uint8_t s_window_next = 0;
+static uint16_t s_window_sum = 0;
+static uint8_t s_window_filled = 0;
+
+static void window_push(uint8_t bpm) {
+    uint8_t old = s_window[s_window_next];
+    if (old) {
+        s_window_sum -= old;
+        s_window_filled--;
+    }
+    s_window[s_window_next] = bpm;
+    if (bpm) {
+        s_window_sum += bpm;
+        s_window_filled++;
+    }
+    s_window_next = (s_window_next + 1) % HR_STATS_WINDOW_S;
+}
+
+// Pushes count seconds of bpm; more than the window holds only refills it
+static void window_fill(uint8_t bpm, uint32_t count) {
+    if (count > HR_STATS_WINDOW_S) {
+        count = HR_STATS_WINDOW_S;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        window_push(bpm);
+    }
+}
+
+void hrstats_reset(void) {
+    s_seconds = 0;
+    s_bpm_seconds = 0;
+    s_min_bpm = 0;
+    s_max_bpm = 0;
+    memset(s_zone_s, 0, sizeof(s_zone_s));
+    s_has_last = false;
+    memset(s_window, 0, sizeof(s_window));
+    s_window_next = 0;
+    s_window_sum = 0;
+    s_window_filled = 0;
+}
+
+void hrstats_add(uint32_t timestamp, uint16_t bpm) {
+    uint32_t held = 1;
+    if (s_has_last) {
+        uint32_t gap = timestamp > s_last_time ? timestamp - s_last_time : 0;
+        held = gap < HR_STATS_HOLD_MAX_S ? gap : HR_STATS_HOLD_MAX_S;
+        // The part of a long gap nobody measured drops out of the window
+        window_fill(0, gap - held);
+    }
+    s_last_time = timestamp;
+    s_has_last = true;
+    
+    uint8_t window_bpm = bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)bpm;
+    window_fill(window_bpm, held);
+    s_seconds += held;
+    s_bpm_seconds += bpm * held;
+    uint8_t zone = zones_classify(bpm);
+    if (zone > 0) {
+        s_zone_s[zone - 1] += held;
+    }
+    
+    if (s_min_bpm == 0 || bpm < s_min_bpm) {
+        s_min_bpm = bpm;
+    }
+    if (bpm > s_max_bpm) {
+        s_max_bpm = bpm;
+    }
+}
+
+void hrstats_break(void) {
+    s_has_last = false;
+}
+
+uint16_t hrstats_rolling_mean(void) {
+    if (s_window_filled == 0) {
+        return 0;
+    }
+    return (uint16_t)((s_window_sum + s_window_filled / 2) / s_window_filled);
+}
+
+void hrstats_get(HRStats *stats) {
+    stats->seconds = s_seconds;
+    stats->avg_bpm = s_seconds ? (uint16_t)((s_bpm_seconds + s_seconds / 2) / s_seconds) : 0;
+    stats->min_bpm = s_min_bpm;
+    stats->max_bpm = s_max_bpm;
+    memcpy(stats->zone_s, s_zone_s, sizeof(s_zone_s));
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// Running HR statistics for the workout, updated in constant time and
+// memory per reading.
+//
+// Each reading stands for the seconds since the one before it, at most
+// HR_STATS_HOLD_MAX_S, so the average and zone times are weighted by time
+// rather than by how fast the sensor happened to be sampling; the first
+// reading, and the first after hrstats_break(), stands for one second. The
+// rolling mean covers the last HR_STATS_WINDOW_S seconds, in a ring of one
+// BPM per second in which seconds without a reading are left out. Zone times
+// follow the zones.h table; time below zone 1 counts in none of them.
+
+#define HR_STATS_WINDOW_S 30
+#define HR_STATS_HOLD_MAX_S 30
+
+void hrstats_reset(void);
+void hrstats_add(uint32_t timestamp, uint16_t bpm);
+
+// The next reading does not stand for the time since the last one, as
+// across a pause
+void hrstats_break(void);
+
+// 0 without readings in the window
+uint16_t hrstats_rolling_mean(void);
+
+// All zeroes before the first reading
+void hrstats_get(HRStats *stats);
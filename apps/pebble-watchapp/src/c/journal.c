@@ -0,0 +1,265 @@
+#include "journal.h"
+#include "backfill.h"
+#include "log.h"
+
+#include <string.h>
+
+#define JOURNAL_VERSION 1
+#define META_SIZE 4
+
+static uint8_t s_head = 0;
+static uint8_t s_chunks = 0;
+static uint8_t s_head_offset = 0;
+static uint16_t s_total = 0;
+
+// Open chunk, mirrored in RAM until synced
+static uint8_t s_tail[PERSIST_DATA_MAX_LENGTH];
+static uint8_t s_tail_count = 0;
+static uint32_t s_tail_last = 0;
+static uint8_t s_unsynced = 0;
+
+static uint32_t chunk_key(uint8_t index) {
+    return JOURNAL_PERSIST_KEY_CHUNK_BASE + index;
+}
+
+static uint8_t tail_index(void) {
+    return (s_head + s_chunks - 1) % JOURNAL_CHUNK_COUNT;
+}
+
+static uint16_t chunk_size(uint8_t count) {
+    return JOURNAL_CHUNK_HEADER_SIZE + count * 2;
+}
+
+static void write_meta(void) {
+    uint8_t meta[META_SIZE] = { JOURNAL_VERSION, s_head, s_chunks, s_head_offset };
+    if (persist_write_data(JOURNAL_PERSIST_KEY_META, meta, sizeof(meta)) < 0) {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to write journal metadata");
+    }
+}
+
+static void write_tail(void) {
+    s_tail[0] = s_tail_count;
+    if (persist_write_data(chunk_key(tail_index()), s_tail, chunk_size(s_tail_count)) < 0) {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to write journal chunk %d", tail_index());
+    }
+    s_unsynced = 0;
+}
+
+// Loads a chunk, from RAM if it is the open one; returns its sample count
+static uint8_t read_chunk(uint8_t index, uint8_t *buffer) {
+    if (s_chunks > 0 && index == tail_index()) {
+        s_tail[0] = s_tail_count;
+        memcpy(buffer, s_tail, chunk_size(s_tail_count));
+        return s_tail_count;
+    }
+    int size = persist_read_data(chunk_key(index), buffer, PERSIST_DATA_MAX_LENGTH);
+    if (size < JOURNAL_CHUNK_HEADER_SIZE || size < chunk_size(buffer[0])) {
+        return 0;
+    }
+    return buffer[0];
+}
+
+static uint32_t read_uint32(const uint8_t *data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void write_uint32(uint8_t *data, uint32_t value) {
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+}
+
+// Empties the journal; only the chunks in use are deleted
+static void reset(void) {
+    for (uint8_t i = 0; i < s_chunks; i++) {
+        persist_delete(chunk_key((s_head + i) % JOURNAL_CHUNK_COUNT));
+    }
+    s_head = 0;
+    s_chunks = 0;
+    s_head_offset = 0;
+    s_total = 0;
+    s_tail_count = 0;
+    s_unsynced = 0;
+    write_meta();
+}
+
+// Frees the oldest chunk, whether or not it was drained; the minute history
+// stands in for samples it still held
+static void drop_head(void) {
+    uint8_t buffer[PERSIST_DATA_MAX_LENGTH];
+    uint8_t count = read_chunk(s_head, buffer);
+    uint8_t remaining = count > s_head_offset ? count - s_head_offset : 0;
+    s_total -= remaining < s_total ? remaining : s_total;
+    
+    if (remaining > 0) {
+        uint32_t timestamp = read_uint32(&buffer[1]);
+        uint32_t first = timestamp;
+        for (uint8_t i = 0; i < count; i++) {
+            timestamp += buffer[JOURNAL_CHUNK_HEADER_SIZE + i * 2];
+            if (i == s_head_offset) {
+                first = timestamp;
+            }
+        }
+        backfill_add_range(first, timestamp + 1);
+    }
+    
+    persist_delete(chunk_key(s_head));
+    s_head = (s_head + 1) % JOURNAL_CHUNK_COUNT;
+    s_chunks--;
+    s_head_offset = 0;
+}
+
+static void open_chunk(uint32_t timestamp) {
+    if (s_chunks > 0) {
+        write_tail();
+    }
+    if (s_chunks == JOURNAL_CHUNK_COUNT) {
+        LOG(APP_LOG_LEVEL_WARNING, "HR journal full, overwriting oldest chunk");
+        drop_head();
+    }
+    s_chunks++;
+    s_tail_count = 0;
+    write_uint32(&s_tail[1], timestamp);
+    s_tail_last = timestamp;
+    write_meta();
+}
+
+void journal_init(void) {
+    uint8_t meta[META_SIZE];
+    int size = persist_read_data(JOURNAL_PERSIST_KEY_META, meta, sizeof(meta));
+    if (size != META_SIZE || meta[0] != JOURNAL_VERSION ||
+        meta[1] >= JOURNAL_CHUNK_COUNT || meta[2] > JOURNAL_CHUNK_COUNT) {
+        // Nothing stored yet, or written by an incompatible version whose
+        // chunks cannot be trusted to be the ones its metadata names
+        if (size >= 0) {
+            for (uint8_t i = 0; i < JOURNAL_CHUNK_COUNT; i++) {
+                persist_delete(chunk_key(i));
+            }
+        }
+        s_chunks = 0;
+        reset();
+        return;
+    }
+    s_head = meta[1];
+    s_chunks = meta[2];
+    s_head_offset = meta[3];
+    s_tail_count = 0;
+    s_unsynced = 0;
+    
+    // Counts come from the chunks themselves, so samples lost with an
+    // unsynced tail are not counted
+    uint8_t buffer[PERSIST_DATA_MAX_LENGTH];
+    s_total = 0;
+    for (uint8_t i = 0; i < s_chunks; i++) {
+        uint8_t index = (s_head + i) % JOURNAL_CHUNK_COUNT;
+        uint8_t count = 0;
+        int read = persist_read_data(chunk_key(index), buffer, sizeof(buffer));
+        if (read >= JOURNAL_CHUNK_HEADER_SIZE && read >= chunk_size(buffer[0])) {
+            count = buffer[0];
+        }
+        if (i == 0) {
+            s_head_offset = s_head_offset < count ? s_head_offset : count;
+            s_total += count - s_head_offset;
+        } else {
+            s_total += count;
+        }
+        if (i == s_chunks - 1) {
+            // Reopen the newest chunk for appending
+            memcpy(s_tail, buffer, read > 0 ? (size_t)read : 0);
+            s_tail_count = count;
+            s_tail_last = read_uint32(&buffer[1]);
+            for (uint8_t j = 0; j < count; j++) {
+                s_tail_last += buffer[JOURNAL_CHUNK_HEADER_SIZE + j * 2];
+            }
+        }
+    }
+    
+    if (s_total > 0) {
+        LOG(APP_LOG_LEVEL_INFO, "HR journal holds %d samples", s_total);
+    }
+}
+
+void journal_deinit(void) {
+    journal_sync();
+}
+
+void journal_append(const HRSample *samples, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t timestamp = samples[i].timestamp;
+        if (s_chunks == 0 || s_tail_count == JOURNAL_CHUNK_SAMPLES ||
+            (s_tail_count > 0 && (timestamp < s_tail_last || timestamp - s_tail_last > UINT8_MAX))) {
+            open_chunk(timestamp);
+        } else if (s_tail_count == 0) {
+            // Empty open chunk, e.g. after a restart lost its unsynced samples
+            write_uint32(&s_tail[1], timestamp);
+            s_tail_last = timestamp;
+        }
+        
+        uint8_t *sample = &s_tail[JOURNAL_CHUNK_HEADER_SIZE + s_tail_count * 2];
+        sample[0] = (uint8_t)(timestamp - s_tail_last);
+        sample[1] = samples[i].bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)samples[i].bpm;
+        s_tail_last = timestamp;
+        s_tail_count++;
+        s_total++;
+        
+        if (++s_unsynced >= JOURNAL_SYNC_SAMPLES) {
+            write_tail();
+        }
+    }
+}
+
+void journal_sync(void) {
+    if (s_chunks > 0 && s_unsynced > 0) {
+        write_tail();
+    }
+}
+
+uint16_t journal_peek(HRSample *samples, uint16_t max_samples) {
+    if (s_total == 0 || !samples) {
+        return 0;
+    }
+    
+    uint8_t buffer[PERSIST_DATA_MAX_LENGTH];
+    uint8_t count = read_chunk(s_head, buffer);
+    uint32_t timestamp = read_uint32(&buffer[1]);
+    uint16_t copied = 0;
+    for (uint8_t i = 0; i < count && copied < max_samples; i++) {
+        const uint8_t *sample = &buffer[JOURNAL_CHUNK_HEADER_SIZE + i * 2];
+        timestamp += sample[0];
+        if (i >= s_head_offset) {
+            samples[copied].timestamp = timestamp;
+            samples[copied].bpm = sample[1];
+            samples[copied].quality = HR_BATCH_QUALITY_OK;
+            copied++;
+        }
+    }
+    return copied;
+}
+
+void journal_consume(uint16_t count) {
+    uint8_t buffer[PERSIST_DATA_MAX_LENGTH];
+    while (count > 0 && s_total > 0) {
+        uint8_t chunk_count = read_chunk(s_head, buffer);
+        uint8_t available = chunk_count > s_head_offset ? chunk_count - s_head_offset : 0;
+        if (count < available) {
+            s_head_offset += count;
+            s_total -= count;
+            break;
+        }
+        
+        count -= available;
+        if (s_chunks == 1) {
+            // Drained the open chunk too; start over
+            reset();
+            return;
+        }
+        drop_head();
+    }
+    write_meta();
+}
+
+uint16_t journal_sample_count(void) {
+    return s_total;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// Store-and-forward journal of HR samples that could not be uploaded, kept
+// in persistent storage so it survives app exits and long disconnects.
+//
+// Samples are appended to fixed-size chunks, each its own persist key. The
+// open chunk is buffered in RAM and written every JOURNAL_SYNC_SAMPLES or
+// when it fills; a metadata key holds the oldest chunk, the number of chunks
+// and the read offset into the oldest one. When all JOURNAL_CHUNK_COUNT
+// chunks are in use the oldest is overwritten, and its unsent minutes are
+// left to the backfill.
+
+#define JOURNAL_PERSIST_KEY_META 0x4A00
+#define JOURNAL_PERSIST_KEY_CHUNK_BASE 0x4A01
+#define JOURNAL_CHUNK_COUNT 12
+#define JOURNAL_SYNC_SAMPLES 10
+
+// Chunk layout: sample count, UTC seconds of the first sample (uint32 LE),
+// then seconds since the previous sample and BPM, one byte each
+#define JOURNAL_CHUNK_HEADER_SIZE 5
+#define JOURNAL_CHUNK_SAMPLES ((PERSIST_DATA_MAX_LENGTH - JOURNAL_CHUNK_HEADER_SIZE) / 2)
+
+void journal_init(void);
+void journal_deinit(void);
+
+void journal_append(const HRSample *samples, uint16_t count);
+void journal_sync(void);
+
+// Oldest samples first; consumed samples are removed for good. Quality is
+// not stored, so samples come back as HR_BATCH_QUALITY_OK.
+uint16_t journal_peek(HRSample *samples, uint16_t max_samples);
+void journal_consume(uint16_t count);
+uint16_t journal_sample_count(void);
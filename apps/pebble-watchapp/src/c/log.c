@@ -0,0 +1,68 @@
+#include "log.h"
+
+#if LOG_RING_SIZE > 0
+static LogRecord s_ring[LOG_RING_SIZE];
+#endif
+static uint16_t s_next = 0;
+static uint16_t s_count = 0;
+
+static const char *event_name(uint8_t event) {
+    switch (event) {
+        case LOG_EVENT_HR_READING: return "hr";
+        case LOG_EVENT_HR_REJECTED: return "hr_rejected";
+        case LOG_EVENT_HR_INVALID: return "hr_invalid";
+        case LOG_EVENT_INBOX: return "inbox";
+        case LOG_EVENT_OUTBOX_SENT: return "sent";
+        case LOG_EVENT_OUTBOX_FAILED: return "send_failed";
+        case LOG_EVENT_WORKOUT_STATE: return "workout";
+        default: return "?";
+    }
+}
+
+void log_event(uint8_t event, int32_t arg0, int32_t arg1) {
+#if LOG_RING_SIZE > 0
+    LogRecord *record = &s_ring[s_next];
+    time_t now;
+    record->ms = time_ms(&now, NULL);
+    record->time = (uint32_t)now;
+    record->event = event;
+    record->args[0] = arg0;
+    record->args[1] = arg1;
+    
+    s_next = (s_next + 1) % LOG_RING_SIZE;
+    if (s_count < LOG_RING_SIZE) {
+        s_count++;
+    }
+#endif
+}
+
+uint16_t log_ring_count(void) {
+    return s_count;
+}
+
+bool log_ring_get(uint16_t index, LogRecord *record) {
+#if LOG_RING_SIZE > 0
+    if (index >= s_count || !record) {
+        return false;
+    }
+    uint16_t oldest = (uint16_t)((s_next + LOG_RING_SIZE - s_count) % LOG_RING_SIZE);
+    *record = s_ring[(oldest + index) % LOG_RING_SIZE];
+    return true;
+#else
+    return false;
+#endif
+}
+
+void log_ring_clear(void) {
+    s_next = 0;
+    s_count = 0;
+}
+
+void log_ring_dump(void) {
+    LogRecord record;
+    for (uint16_t i = 0; log_ring_get(i, &record); i++) {
+        APP_LOG(APP_LOG_LEVEL_INFO, "%u.%03u %s %d %d", (unsigned)record.time, record.ms,
+                event_name(record.event), (int)record.args[0], (int)record.args[1]);
+    }
+    log_ring_clear();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <pebble.h>
+
+// Logging with a compile-time floor, and a binary ring for hot paths.
+//
+// LOG() takes the same arguments as APP_LOG but compiles to nothing below
+// LOG_LEVEL, so release builds neither format nor send anything over the
+// log channel. Builds that define RELEASE default to LOG_LEVEL_NONE; other
+// builds keep INFO and above. Pass -DLOG_LEVEL=APP_LOG_LEVEL_DEBUG to see
+// the per-message and per-reading detail.
+//
+// Per-reading and per-message events go to LOG_EVENT() instead: an event id
+// and two integers stored in RAM, with no formatting, kept in release builds
+// and printed by log_ring_dump() on demand (CMD_DUMP_LOG).
+
+#define LOG_LEVEL_NONE 0
+
+#ifndef LOG_LEVEL
+#ifdef RELEASE
+#define LOG_LEVEL LOG_LEVEL_NONE
+#else
+#define LOG_LEVEL APP_LOG_LEVEL_INFO
+#endif
+#endif
+
+// The condition is constant, so the call and its arguments are dropped
+// while the compiler still checks them
+#define LOG(level, fmt, ...) \
+    do { \
+        if ((level) <= LOG_LEVEL) { \
+            APP_LOG(level, fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+// Records kept; 0 removes the ring
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 32
+#endif
+
+typedef enum {
+    LOG_EVENT_HR_READING = 1,   // bpm, quality
+    LOG_EVENT_HR_REJECTED,      // bpm
+    LOG_EVENT_HR_INVALID,
+    LOG_EVENT_INBOX,            // command or -1, 1 with a WORKOUT frame
+    LOG_EVENT_OUTBOX_SENT,      // key, bytes
+    LOG_EVENT_OUTBOX_FAILED,    // key, AppMessageResult
+    LOG_EVENT_WORKOUT_STATE,    // from, to
+} LogEvent;
+
+typedef struct {
+    uint32_t time;
+    uint16_t ms;
+    uint8_t event;  // LogEvent
+    int32_t args[2];
+} LogRecord;
+
+#if LOG_RING_SIZE > 0
+#define LOG_EVENT(event, arg0, arg1) log_event((event), (int32_t)(arg0), (int32_t)(arg1))
+#else
+#define LOG_EVENT(event, arg0, arg1) do { (void)(arg0); (void)(arg1); } while (0)
+#endif
+
+void log_event(uint8_t event, int32_t arg0, int32_t arg1);
+
+// Records held, and the index-th oldest; false past the end
+uint16_t log_ring_count(void);
+bool log_ring_get(uint16_t index, LogRecord *record);
+void log_ring_clear(void);
+
+// Prints the ring oldest first, whatever LOG_LEVEL is, and clears it
+void log_ring_dump(void);
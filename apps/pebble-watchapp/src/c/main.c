@@ -3,35 +3,66 @@
 #include "ui.h"
 #include "hr.h"
 #include "appmsg.h"
+#include "session.h"
+#include "workout.h"
+#include "journal.h"
+#include "backfill.h"
+#include "zones.h"
+#include "datalog.h"
+#include "log.h"
+#include "perf.h"
 
 // Global app state
 AppState g_app_state = {
     .is_active = false,
+    .state = WORKOUT_IDLE,
     .current_hr = 0,
-    .pace_text = "--:--/km",
-    .time_text = "00:00:00"
+    .hr_zone = 0,
+    .workout = { 0 },
+    .text = {
+        .hr = "-- BPM",
+        .pace = "--:--/km",
+        .time = "00:00:00"
+    }
 };
 
 static void init(void) {
+    log_ring_clear();
+    perf_init();
+    
     // Initialize UI
     ui_init();
     
-    // Initialize heart rate monitoring
+    // Initialize the HR journal and backfill range, HR zones, the
+    // DataLogging uplink, heart rate monitoring, the session clock and
+    // workout state
+    journal_init();
+    backfill_init();
+    zones_init();
+    datalog_init();
     hr_init();
+    session_init();
+    workout_init();
     
     // Initialize AppMessage
     appmsg_init();
     
-    APP_LOG(APP_LOG_LEVEL_INFO, "PebbleRun initialized");
+    LOG(APP_LOG_LEVEL_INFO, "PebbleRun initialized");
 }
 
 static void deinit(void) {
-    // Cleanup resources
-    appmsg_deinit();
+    // Cleanup resources; HR hands its buffer to the outgoing queue, which
+    // journals whatever is still unsent and returns unsent minutes to backfill
+    workout_deinit();
+    session_deinit();
     hr_deinit();
+    datalog_deinit();
+    appmsg_deinit();
+    backfill_deinit();
+    journal_deinit();
     ui_deinit();
     
-    APP_LOG(APP_LOG_LEVEL_INFO, "PebbleRun deinitialized");
+    LOG(APP_LOG_LEVEL_INFO, "PebbleRun deinitialized");
 }
 
 int main(void) {
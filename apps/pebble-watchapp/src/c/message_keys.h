@@ -0,0 +1,164 @@
+#pragma once
+
+// Generated by shared/proto/schema/generate.py from appmessage.json. Do not edit.
+
+// AppMessage keys
+typedef enum {
+    KEY_CMD = 3,  // uint8 Workout command, see commands
+    KEY_HR_BATCH = 4,  // bytes Buffered HR samples, see the HR_BATCH frame
+    KEY_WORKOUT = 5,  // bytes Elapsed time, pace and distance, see the WORKOUT frame
+    KEY_HR_MINUTES = 7,  // bytes Backfilled per-minute HR from the health history, see the HR_MINUTES frame
+    KEY_RESEND = 8,  // bytes Retransmit request for missing HR_BATCH frames, see the RESEND frame
+    KEY_HELLO = 9,  // bytes Protocol version and buffer sizes, sent at launch, see the HELLO frame
+    KEY_HR_SUMMARY = 10,  // bytes Workout HR statistics, sent at STOP, see the HR_SUMMARY frame
+    KEY_ZONES = 11,  // bytes HR zone configuration, see the ZONES frame
+    KEY_UPLINK = 12,  // uint8 Channel for HR history, see uplinks
+    KEY_PERF = 13,  // bytes Debug counters and handler timings, sent on PERF_SNAPSHOT, see the PERF frame
+    KEY_HR_LIVE = 14  // bytes Latest HR reading for display only, laid out as an HR_RECORD; not history, which the phone takes from HR_BATCH or DataLogging
+} AppMessageKey;
+
+// Largest value per key, in bytes
+#define CMD_VALUE_MAX 1
+#define HR_BATCH_VALUE_MAX 55
+#define WORKOUT_VALUE_MAX 32
+#define HR_MINUTES_VALUE_MAX 55
+#define RESEND_VALUE_MAX 3
+#define HELLO_VALUE_MAX 5
+#define HR_SUMMARY_VALUE_MAX 27
+#define ZONES_VALUE_MAX 6
+#define UPLINK_VALUE_MAX 1
+#define PERF_VALUE_MAX 55
+#define HR_LIVE_VALUE_MAX 6
+
+// Buffer sizes: every inbound key at once, and the largest single outbound tuple
+#define MESSAGE_INBOX_SIZE 79  // dict_calc_buffer_size(5, 1, 32, 3, 6, 1)
+#define MESSAGE_OUTBOX_SIZE 63  // dict_calc_buffer_size(1, 55)
+
+// Bumped whenever a frame layout changes incompatibly
+#define PROTOCOL_VERSION 5
+
+// Commands
+typedef enum {
+    CMD_START = 1,
+    CMD_STOP = 2,
+    CMD_PAUSE = 3,
+    CMD_RESUME = 4,
+    CMD_DUMP_LOG = 5,
+    CMD_PERF_SNAPSHOT = 6
+} Command;
+
+// Uplinks for HR history
+typedef enum {
+    UPLINK_APPMESSAGE = 0,
+    UPLINK_DATALOG = 1
+} Uplink;
+
+// HR_BATCH frame: Header with the first sample, then the rest as nibble codes; SEQ counts frames, STEP is the gap a plain code implies, QUALITY applies to every sample
+#define HR_BATCH_COUNT_OFFSET 0
+#define HR_BATCH_SEQ_OFFSET 1  // uint16, little endian
+#define HR_BATCH_BASE_TIME_OFFSET 3  // uint32, little endian
+#define HR_BATCH_STEP_OFFSET 7
+#define HR_BATCH_QUALITY_OFFSET 8
+#define HR_BATCH_BPM_OFFSET 9
+#define HR_BATCH_HEADER_SIZE 10
+#define HR_BATCH_STREAM_MAX 45
+#define HR_BATCH_MAX_SAMPLES 91
+#define HR_BATCH_CODE_ESCAPE 15
+#define HR_BATCH_CODE_VARINT_MORE 8
+
+typedef enum {
+    HR_BATCH_QUALITY_BAD = 0,
+    HR_BATCH_QUALITY_OK = 1,
+    HR_BATCH_QUALITY_GOOD = 2
+} HrBatchQuality;
+
+// HR_MINUTES frame: Header, then one BPM per consecutive minute from BASE_TIME; 0 means no reading
+#define HR_MINUTES_COUNT_OFFSET 0
+#define HR_MINUTES_BASE_TIME_OFFSET 1  // uint32, little endian
+#define HR_MINUTES_HEADER_SIZE 5
+#define HR_MINUTES_MINUTE_BPM_OFFSET 0
+#define HR_MINUTES_MINUTE_SIZE 1
+#define HR_MINUTES_MAX_MINUTES 50
+
+// RESEND frame: COUNT frames from FIRST_SEQ, wrapping at 65536
+#define RESEND_FIRST_SEQ_OFFSET 0  // uint16, little endian
+#define RESEND_COUNT_OFFSET 2
+#define RESEND_FRAME_SIZE 3
+
+// HELLO frame: PROTOCOL is PROTOCOL_VERSION; MAX_VALUE is the largest value the watch sends in one tuple, INBOX the largest message it accepts
+#define HELLO_PROTOCOL_OFFSET 0
+#define HELLO_MAX_VALUE_OFFSET 1  // uint16, little endian
+#define HELLO_INBOX_OFFSET 3  // uint16, little endian
+#define HELLO_FRAME_SIZE 5
+
+// HR_SUMMARY frame: SECONDS of running time covered by readings, time-weighted AVG, MIN and MAX BPM, and seconds in each of the five zones
+#define HR_SUMMARY_SECONDS_OFFSET 0  // uint32, little endian
+#define HR_SUMMARY_AVG_OFFSET 4
+#define HR_SUMMARY_MIN_OFFSET 5
+#define HR_SUMMARY_MAX_OFFSET 6
+#define HR_SUMMARY_ZONE1_OFFSET 7  // uint32, little endian
+#define HR_SUMMARY_ZONE2_OFFSET 11  // uint32, little endian
+#define HR_SUMMARY_ZONE3_OFFSET 15  // uint32, little endian
+#define HR_SUMMARY_ZONE4_OFFSET 19  // uint32, little endian
+#define HR_SUMMARY_ZONE5_OFFSET 23  // uint32, little endian
+#define HR_SUMMARY_FRAME_SIZE 27
+
+// ZONES frame: ZONE1 to ZONE5 are the lowest BPM of each zone, rising; all zero derives them from MAX_HR as 0 and 60, 70, 80 and 90 percent
+#define ZONES_MAX_HR_OFFSET 0
+#define ZONES_ZONE1_OFFSET 1
+#define ZONES_ZONE2_OFFSET 2
+#define ZONES_ZONE3_OFFSET 3
+#define ZONES_ZONE4_OFFSET 4
+#define ZONES_ZONE5_OFFSET 5
+#define ZONES_FRAME_SIZE 6
+
+// WORKOUT frame: Later versions only append fields, so a longer frame still decodes
+#define WORKOUT_FRAME_VERSION 1
+#define WORKOUT_VERSION_OFFSET 0
+#define WORKOUT_ELAPSED_OFFSET 1  // uint32, little endian
+#define WORKOUT_PACE_OFFSET 5  // uint16, little endian
+#define WORKOUT_DISTANCE_OFFSET 7  // uint32, little endian
+#define WORKOUT_FLAGS_OFFSET 11
+#define WORKOUT_FRAME_SIZE 12
+
+typedef enum {
+    WORKOUT_FLAG_PAUSED = 1
+} WorkoutFlag;
+
+// PERF frame: Counters since launch, then COUNT probes; a snapshot spans as many frames as the probes need, each with the same header. SNIFF_REDUCED is the seconds spent at the reduced Bluetooth sniff interval, the rest of UPTIME at the normal one. Durations are in ms, UNDER_* and OVER_* count calls per duration bucket, all saturating
+#define PERF_COUNT_OFFSET 0
+#define PERF_UPTIME_OFFSET 1  // uint32, little endian
+#define PERF_HEAP_PEAK_OFFSET 5  // uint16, little endian
+#define PERF_FAIL_TIMEOUT_OFFSET 7  // uint16, little endian
+#define PERF_FAIL_NACK_OFFSET 9  // uint16, little endian
+#define PERF_FAIL_OFFLINE_OFFSET 11  // uint16, little endian
+#define PERF_FAIL_OTHER_OFFSET 13  // uint16, little endian
+#define PERF_SNIFF_REDUCED_OFFSET 15  // uint16, little endian
+#define PERF_HEADER_SIZE 17
+#define PERF_PROBE_ID_OFFSET 0
+#define PERF_PROBE_CALLS_OFFSET 1  // uint32, little endian
+#define PERF_PROBE_TOTAL_MS_OFFSET 5  // uint32, little endian
+#define PERF_PROBE_MAX_MS_OFFSET 9  // uint16, little endian
+#define PERF_PROBE_UNDER_2MS_OFFSET 11  // uint16, little endian
+#define PERF_PROBE_UNDER_8MS_OFFSET 13  // uint16, little endian
+#define PERF_PROBE_UNDER_32MS_OFFSET 15  // uint16, little endian
+#define PERF_PROBE_OVER_32MS_OFFSET 17  // uint16, little endian
+#define PERF_PROBE_SIZE 19
+#define PERF_MAX_PROBES 2
+
+typedef enum {
+    PERF_PROBE_CANVAS = 0,
+    PERF_PROBE_INBOX = 1,
+    PERF_PROBE_HR_EVENT = 2
+} PerfProbe;
+
+// HR_RECORD DataLogging item: One HR sample per item of a DataLogging session tagged with the workout's start in UTC seconds; QUALITY as in HR_BATCH
+#define HR_RECORD_TIME_OFFSET 0  // uint32, little endian
+#define HR_RECORD_BPM_OFFSET 4
+#define HR_RECORD_QUALITY_OFFSET 5
+#define HR_RECORD_SIZE 6
+
+// Value ranges
+#define HR_MIN 30
+#define HR_MAX 220
+#define PACE_MAX 3600
@@ -0,0 +1,81 @@
+#include "perf.h"
+
+#include <string.h>
+
+// Upper bounds of the histogram buckets but the last, matching the PERF
+// frame's UNDER_2MS, UNDER_8MS and UNDER_32MS fields
+static const uint16_t s_bucket_ms[PERF_BUCKET_COUNT - 1] = { 2, 8, 32 };
+
+static PerfSnapshot s_perf;
+static uint32_t s_started_s = 0;
+
+static uint32_t now_ms(void) {
+    time_t seconds;
+    uint16_t ms = time_ms(&seconds, NULL);
+    return (uint32_t)seconds * 1000 + ms;
+}
+
+static void add_saturating(uint16_t *counter) {
+    if (*counter < UINT16_MAX) {
+        (*counter)++;
+    }
+}
+
+void perf_init(void) {
+    memset(&s_perf, 0, sizeof(s_perf));
+    s_started_s = (uint32_t)time(NULL);
+}
+
+uint32_t perf_begin(void) {
+    return now_ms();
+}
+
+void perf_end(PerfProbe probe, uint32_t started_ms) {
+    if (probe >= PERF_PROBE_COUNT) {
+        return;
+    }
+    uint32_t duration_ms = now_ms() - started_ms;
+    PerfProbeStats *stats = &s_perf.probes[probe];
+    
+    stats->calls++;
+    stats->total_ms += duration_ms;
+    if (duration_ms > stats->max_ms) {
+        stats->max_ms = duration_ms > UINT16_MAX ? UINT16_MAX : (uint16_t)duration_ms;
+    }
+    uint8_t bucket = 0;
+    while (bucket < PERF_BUCKET_COUNT - 1 && duration_ms >= s_bucket_ms[bucket]) {
+        bucket++;
+    }
+    add_saturating(&stats->buckets[bucket]);
+    
+    uint32_t heap_used = (uint32_t)heap_bytes_used();
+    if (heap_used > s_perf.heap_peak) {
+        s_perf.heap_peak = heap_used;
+    }
+}
+
+void perf_count_failure(AppMessageResult reason) {
+    switch (reason) {
+        case APP_MSG_SEND_TIMEOUT:
+            add_saturating(&s_perf.fail_timeout);
+            break;
+        case APP_MSG_SEND_REJECTED:
+            add_saturating(&s_perf.fail_nack);
+            break;
+        case APP_MSG_NOT_CONNECTED:
+        case APP_MSG_APP_NOT_RUNNING:
+            add_saturating(&s_perf.fail_offline);
+            break;
+        default:
+            add_saturating(&s_perf.fail_other);
+            break;
+    }
+}
+
+void perf_snapshot(PerfSnapshot *snapshot) {
+    if (!snapshot) {
+        return;
+    }
+    *snapshot = s_perf;
+    snapshot->uptime_s = (uint32_t)time(NULL) - s_started_s;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// Counters for comparing builds on real runs.
+//
+// Probes time a handler with time_ms() into a call count, total and maximum
+// duration and a PERF_BUCKET_COUNT histogram. Failed sends are counted by
+// reason, and the heap high-water mark is sampled as each probe ends. The
+// phone asks for a snapshot with CMD_PERF_SNAPSHOT and gets PERF frames
+// back; counters run from launch and are not persisted.
+
+void perf_init(void);
+
+// Wraps every 49 days; only the difference to perf_end() matters
+uint32_t perf_begin(void);
+void perf_end(PerfProbe probe, uint32_t started_ms);
+
+void perf_count_failure(AppMessageResult reason);
+
+void perf_snapshot(PerfSnapshot *snapshot);
@@ -0,0 +1,96 @@
+#include "session.h"
+#include "ui.h"
+#include "log.h"
+
+static bool s_active = false;
+static bool s_running = false;
+static time_t s_start_epoch = 0;
+static uint32_t s_banked_s = 0;
+
+static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
+    ui_update_elapsed(session_elapsed_s());
+}
+
+// Restarts the running interval at now with the given elapsed time banked
+static void anchor(uint32_t elapsed_s, bool running) {
+    s_banked_s = elapsed_s;
+    s_start_epoch = time(NULL);
+    
+    if (running && !s_running) {
+        tick_timer_service_subscribe(SECOND_UNIT, tick_handler);
+    } else if (!running && s_running) {
+        // Nothing changes on screen while paused
+        tick_timer_service_unsubscribe();
+    }
+    s_running = running;
+    ui_update_elapsed(elapsed_s);
+}
+
+void session_init(void) {
+    s_active = false;
+    s_running = false;
+    s_start_epoch = 0;
+    s_banked_s = 0;
+}
+
+void session_deinit(void) {
+    if (s_running) {
+        tick_timer_service_unsubscribe();
+        s_running = false;
+    }
+    s_active = false;
+}
+
+void session_start(void) {
+    s_active = true;
+    anchor(0, true);
+}
+
+void session_stop(void) {
+    if (s_active) {
+        anchor(session_elapsed_s(), false);
+        s_active = false;
+    }
+}
+
+void session_pause(void) {
+    if (s_active && s_running) {
+        anchor(session_elapsed_s(), false);
+    }
+}
+
+void session_resume(void) {
+    if (s_active && !s_running) {
+        anchor(s_banked_s, true);
+    }
+}
+
+void session_sync(uint32_t phone_elapsed_s, bool paused) {
+    if (!s_active) {
+        // Joined a workout already in progress, e.g. after an app restart
+        s_active = true;
+        anchor(phone_elapsed_s, !paused);
+        return;
+    }
+    
+    // Running or paused, PAUSE and RESUME move the clock; the frame only
+    // corrects drift
+    uint32_t local_s = session_elapsed_s();
+    uint32_t drift_s = local_s > phone_elapsed_s ? local_s - phone_elapsed_s : phone_elapsed_s - local_s;
+    if (drift_s > SESSION_DRIFT_MAX_S) {
+        LOG(APP_LOG_LEVEL_INFO, "Session clock off by %d s, resyncing", (int)drift_s);
+        anchor(phone_elapsed_s, s_running);
+    }
+}
+
+uint32_t session_elapsed_s(void) {
+    if (!s_running) {
+        return s_banked_s;
+    }
+    time_t now = time(NULL);
+    return s_banked_s + (now > s_start_epoch ? (uint32_t)(now - s_start_epoch) : 0);
+}
+
+bool session_is_running(void) {
+    return s_running;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <pebble.h>
+
+// Workout session clock. Elapsed time is counted on the watch from a start
+// epoch plus the time banked before the last pause, and ticks the display
+// once a second; the phone's WORKOUT frames only correct it.
+
+// Phone elapsed time is adopted when the local clock is further off than this
+#define SESSION_DRIFT_MAX_S 2
+
+void session_init(void);
+void session_deinit(void);
+
+// START, STOP, PAUSE and RESUME commands
+void session_start(void);
+void session_stop(void);
+void session_pause(void);
+void session_resume(void);
+
+// Elapsed time reported by the phone; its pause state is only read when
+// joining a workout in progress
+void session_sync(uint32_t phone_elapsed_s, bool paused);
+
+uint32_t session_elapsed_s(void);
+bool session_is_running(void);
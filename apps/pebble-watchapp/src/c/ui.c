@@ -1,5 +1,10 @@
 #include "ui.h"
 #include "common.h"
+#include "format.h"
+#include "log.h"
+#include "perf.h"
+
+#include <string.h>
 
 // UI elements
 static Window *s_main_window;
@@ -8,52 +13,270 @@ static Layer *s_canvas_layer;
 // Text elements for display
 static GFont s_font_hr;
 static GFont s_font_data;
+static GFont s_font_stats;
 
 // Colors and styling
-#define COLOR_HR GColorRed
+#define COLOR_HR GColorWhite
 #define COLOR_PACE GColorWhite
 #define COLOR_TIME GColorLightGray
+#define COLOR_HR_STATS GColorOrange
 #define COLOR_BACKGROUND GColorBlack
+#define COLOR_STATUS_RUNNING GColorGreen
+#define COLOR_STATUS_PAUSED GColorYellow
+#define COLOR_HR_ZONE1 GColorLightGray
+#define COLOR_HR_ZONE2 GColorBlue
+#define COLOR_HR_ZONE3 GColorGreen
+#define COLOR_HR_ZONE4 GColorOrange
+#define COLOR_HR_ZONE5 GColorRed
 
-static void canvas_update_proc(Layer *layer, GContext *ctx) {
-    GRect bounds = layer_get_bounds(layer);
+// Screen bands, each repainted only when its mask bit is set. The window
+// background is clear so the framebuffer keeps untouched bands between frames.
+#define REGION_HR (1 << 0)
+#define REGION_PACE (1 << 1)
+#define REGION_TIME (1 << 2)
+#define REGION_STATUS (1 << 3)
+#define REGION_HR_STATS (1 << 4)
+#define REGION_ALL (REGION_HR | REGION_PACE | REGION_TIME | REGION_STATUS | REGION_HR_STATS)
+
+// Bands changed since the last frame, and bands committed for the next render
+static uint8_t s_pending_regions;
+static uint8_t s_dirty_regions;
+
+// Frame slot of the last commit, and the timer that flushes deferred changes
+static uint32_t s_frame_interval_ms = UI_FRAME_INTERVAL_MS;
+static AppTimer *s_frame_timer;
+static uint32_t s_last_frame_slot;
+static bool s_frame_committed;
+
+// What is currently on screen; g_app_state.text holds what should be
+static DisplayText s_shown;
+static uint8_t s_zone_shown;
+static uint8_t s_status_shown;
+
+// Status indicator: hidden, running or paused
+#define STATUS_NONE 0
+#define STATUS_RUNNING 1
+#define STATUS_PAUSED 2
+
+static GRect region_rect(uint8_t region, GRect bounds) {
+    switch (region) {
+        case REGION_HR:
+            return GRect(0, 20, bounds.size.w, 40);
+        case REGION_PACE:
+            return GRect(0, 70, bounds.size.w, 30);
+        case REGION_TIME:
+            return GRect(0, 110, bounds.size.w, 30);
+        case REGION_STATUS:
+            return GRect(bounds.size.w - 16, 4, 12, 12);
+        case REGION_HR_STATS:
+            return GRect(0, 140, bounds.size.w, 24);
+        default:
+            return GRectZero;
+    }
+}
+
+// Zone 0, below zone 1 or without a reading, keeps the plain HR color
+static GColor zone_color(uint8_t zone) {
+    switch (zone) {
+        case 1:
+            return COLOR_HR_ZONE1;
+        case 2:
+            return COLOR_HR_ZONE2;
+        case 3:
+            return COLOR_HR_ZONE3;
+        case 4:
+            return COLOR_HR_ZONE4;
+        case 5:
+            return COLOR_HR_ZONE5;
+        default:
+            return COLOR_HR;
+    }
+}
+
+// Copies text into the on-screen buffer, reporting whether it differed
+static bool replace_text(char *shown, const char *text) {
+    if (strcmp(shown, text) == 0) {
+        return false;
+    }
+    memcpy(shown, text, DISPLAY_TEXT_SIZE);
+    return true;
+}
+
+static uint8_t current_status(void) {
+    if (!g_app_state.is_active || g_app_state.state == WORKOUT_STOPPING) {
+        return STATUS_NONE;
+    }
+    return g_app_state.state == WORKOUT_PAUSED ? STATUS_PAUSED : STATUS_RUNNING;
+}
+
+// Takes the requested bands' current text on screen and returns those that changed
+static uint8_t refresh_regions(uint8_t regions) {
+    uint8_t changed = 0;
+    
+    if ((regions & REGION_HR) && replace_text(s_shown.hr, g_app_state.text.hr)) {
+        changed |= REGION_HR;
+    }
+    if ((regions & REGION_HR) && s_zone_shown != g_app_state.hr_zone) {
+        s_zone_shown = g_app_state.hr_zone;
+        changed |= REGION_HR;
+    }
+    if ((regions & REGION_PACE) && replace_text(s_shown.pace, g_app_state.text.pace)) {
+        changed |= REGION_PACE;
+    }
+    if ((regions & REGION_TIME) && replace_text(s_shown.time, g_app_state.text.time)) {
+        changed |= REGION_TIME;
+    }
+    if ((regions & REGION_HR_STATS) && replace_text(s_shown.hr_stats, g_app_state.text.hr_stats)) {
+        changed |= REGION_HR_STATS;
+    }
+    if ((regions & REGION_STATUS) && s_status_shown != current_status()) {
+        s_status_shown = current_status();
+        changed |= REGION_STATUS;
+    }
+    
+    return changed;
+}
+
+static uint64_t wall_clock_ms(void) {
+    time_t now_s;
+    uint16_t now_ms;
+    time_ms(&now_s, &now_ms);
+    return (uint64_t)now_s * 1000 + now_ms;
+}
+
+static uint32_t current_frame_slot(void) {
+    return (uint32_t)(wall_clock_ms() / s_frame_interval_ms);
+}
+
+// Hands the changed bands to the firmware as a single render
+static void commit_frame(void) {
+    if (s_frame_timer) {
+        app_timer_cancel(s_frame_timer);
+        s_frame_timer = NULL;
+    }
+    s_last_frame_slot = current_frame_slot();
+    s_frame_committed = true;
+    
+    uint8_t changed = refresh_regions(s_pending_regions);
+    s_pending_regions = 0;
+    if (changed) {
+        s_dirty_regions |= changed;
+        layer_mark_dirty(s_canvas_layer);
+    }
+}
+
+static void frame_timer_callback(void *data) {
+    s_frame_timer = NULL;
+    commit_frame();
+}
+
+static void mark_regions_dirty(uint8_t regions) {
+    s_pending_regions |= regions;
+    if (!s_canvas_layer) {
+        // Formatted in full when the window appears
+        return;
+    }
+    
+    // The time band commits straight away so the clock never lags its tick
+    if (!s_frame_committed || s_last_frame_slot != current_frame_slot() ||
+        (regions & REGION_TIME)) {
+        commit_frame();
+        return;
+    }
     
-    // Set background
+    if (!s_frame_timer) {
+        // Land just after the next boundary so a tick there flushes us first
+        uint32_t delay = s_frame_interval_ms - (uint32_t)(wall_clock_ms() % s_frame_interval_ms) +
+                         UI_FRAME_TICK_GRACE_MS;
+        s_frame_timer = app_timer_register(delay, frame_timer_callback, NULL);
+    }
+}
+
+static void clear_region(GContext *ctx, uint8_t region, GRect bounds) {
     graphics_context_set_fill_color(ctx, COLOR_BACKGROUND);
-    graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+    graphics_fill_rect(ctx, region_rect(region, bounds), 0, GCornerNone);
+}
+
+static void draw_canvas(Layer *layer, GContext *ctx) {
+    GRect bounds = layer_get_bounds(layer);
+    uint8_t regions = s_dirty_regions;
+    s_dirty_regions = 0;
     
-    // HR display (large, center-top)
-    graphics_context_set_text_color(ctx, COLOR_HR);
-    char hr_text[16];
-    if (g_app_state.current_hr > 0) {
-        snprintf(hr_text, sizeof(hr_text), "%d BPM", g_app_state.current_hr);
-    } else {
-        snprintf(hr_text, sizeof(hr_text), "-- BPM");
+    // A full repaint also covers the gaps between bands
+    if (regions == REGION_ALL) {
+        graphics_context_set_fill_color(ctx, COLOR_BACKGROUND);
+        graphics_fill_rect(ctx, bounds, 0, GCornerNone);
     }
     
-    GRect hr_rect = GRect(0, 20, bounds.size.w, 40);
-    graphics_draw_text(ctx, hr_text, s_font_hr, hr_rect,
-                      GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+    // HR display (large, center-top)
+    if (regions & REGION_HR) {
+        if (regions != REGION_ALL) {
+            clear_region(ctx, REGION_HR, bounds);
+        }
+        graphics_context_set_text_color(ctx, zone_color(s_zone_shown));
+        graphics_draw_text(ctx, s_shown.hr, s_font_hr, region_rect(REGION_HR, bounds),
+                          GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+    }
     
     // Pace display (medium, center-middle)
-    graphics_context_set_text_color(ctx, COLOR_PACE);
-    GRect pace_rect = GRect(0, 70, bounds.size.w, 30);
-    graphics_draw_text(ctx, g_app_state.pace_text, s_font_data, pace_rect,
-                      GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+    if (regions & REGION_PACE) {
+        if (regions != REGION_ALL) {
+            clear_region(ctx, REGION_PACE, bounds);
+        }
+        graphics_context_set_text_color(ctx, COLOR_PACE);
+        graphics_draw_text(ctx, s_shown.pace, s_font_data, region_rect(REGION_PACE, bounds),
+                          GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+    }
     
     // Time display (medium, center-bottom)
-    graphics_context_set_text_color(ctx, COLOR_TIME);
-    GRect time_rect = GRect(0, 110, bounds.size.w, 30);
-    graphics_draw_text(ctx, g_app_state.time_text, s_font_data, time_rect,
-                      GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+    if (regions & REGION_TIME) {
+        if (regions != REGION_ALL) {
+            clear_region(ctx, REGION_TIME, bounds);
+        }
+        graphics_context_set_text_color(ctx, COLOR_TIME);
+        graphics_draw_text(ctx, s_shown.time, s_font_data, region_rect(REGION_TIME, bounds),
+                          GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+    }
+    
+    // Workout HR statistics (small, bottom), blank until the first reading
+    if (regions & REGION_HR_STATS) {
+        if (regions != REGION_ALL) {
+            clear_region(ctx, REGION_HR_STATS, bounds);
+        }
+        if (s_shown.hr_stats[0]) {
+            graphics_context_set_text_color(ctx, COLOR_HR_STATS);
+            graphics_draw_text(ctx, s_shown.hr_stats, s_font_stats, region_rect(REGION_HR_STATS, bounds),
+                              GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+        }
+    }
     
     // Status indicator
-    if (g_app_state.is_active) {
-        graphics_context_set_fill_color(ctx, GColorGreen);
-        graphics_fill_circle(ctx, GPoint(bounds.size.w - 10, 10), 3);
+    if (regions & REGION_STATUS) {
+        if (regions != REGION_ALL) {
+            clear_region(ctx, REGION_STATUS, bounds);
+        }
+        if (s_status_shown != STATUS_NONE) {
+            graphics_context_set_fill_color(ctx, s_status_shown == STATUS_PAUSED ?
+                                            COLOR_STATUS_PAUSED : COLOR_STATUS_RUNNING);
+            graphics_fill_circle(ctx, GPoint(bounds.size.w - 10, 10), 3);
+        }
     }
 }
 
+static void canvas_update_proc(Layer *layer, GContext *ctx) {
+    uint32_t started_ms = perf_begin();
+    draw_canvas(layer, ctx);
+    perf_end(PERF_PROBE_CANVAS, started_ms);
+}
+
+static void main_window_appear(Window *window) {
+    // Whatever covered the window may have drawn over every band
+    refresh_regions(REGION_ALL);
+    s_pending_regions = 0;
+    s_dirty_regions = REGION_ALL;
+    layer_mark_dirty(s_canvas_layer);
+}
+
 static void main_window_load(Window *window) {
     Layer *window_layer = window_get_root_layer(window);
     GRect bounds = layer_get_bounds(window_layer);
@@ -66,25 +289,45 @@ static void main_window_load(Window *window) {
     // Load fonts
     s_font_hr = fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD);
     s_font_data = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+    // Three values across the bottom band
+    s_font_stats = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD);
 }
 
 static void main_window_unload(Window *window) {
+    if (s_frame_timer) {
+        app_timer_cancel(s_frame_timer);
+        s_frame_timer = NULL;
+    }
+    s_frame_committed = false;
+    
     // Destroy canvas layer
     layer_destroy(s_canvas_layer);
+    s_canvas_layer = NULL;
 }
 
 void ui_init(void) {
+    s_pending_regions = 0;
+    s_dirty_regions = 0;
+    s_frame_timer = NULL;
+    s_frame_committed = false;
+    memset(&s_shown, 0, sizeof(s_shown));
+    s_zone_shown = 0;
+    s_status_shown = STATUS_NONE;
+    s_frame_interval_ms = UI_FRAME_INTERVAL_MS;
+    
     // Create main window
     s_main_window = window_create();
     
     // Set window properties
-    window_set_background_color(s_main_window, COLOR_BACKGROUND);
+    // Clear background: canvas_update_proc paints its own bands
+    window_set_background_color(s_main_window, GColorClear);
     window_set_window_handlers(s_main_window, (WindowHandlers) {
         .load = main_window_load,
+        .appear = main_window_appear,
         .unload = main_window_unload,
     });
     
-    APP_LOG(APP_LOG_LEVEL_INFO, "UI initialized");
+    LOG(APP_LOG_LEVEL_INFO, "UI initialized");
 }
 
 void ui_deinit(void) {
@@ -95,39 +338,70 @@ void ui_deinit(void) {
 }
 
 void ui_update_hr(uint16_t hr) {
-    g_app_state.current_hr = hr;
-    if (s_canvas_layer) {
-        layer_mark_dirty(s_canvas_layer);
+    if (g_app_state.current_hr != hr) {
+        g_app_state.current_hr = hr;
+        format_hr(g_app_state.text.hr, hr);
+        mark_regions_dirty(REGION_HR);
     }
 }
 
-void ui_update_pace(const char* pace) {
-    if (pace) {
-        strncpy(g_app_state.pace_text, pace, sizeof(g_app_state.pace_text) - 1);
-        g_app_state.pace_text[sizeof(g_app_state.pace_text) - 1] = '\0';
-        if (s_canvas_layer) {
-            layer_mark_dirty(s_canvas_layer);
-        }
+void ui_update_hr_zone(uint8_t zone) {
+    if (g_app_state.hr_zone != zone) {
+        g_app_state.hr_zone = zone;
+        mark_regions_dirty(REGION_HR);
+    }
+}
+
+void ui_update_hr_stats(uint16_t rolling_bpm, uint16_t avg_bpm, uint16_t max_bpm) {
+    char text[DISPLAY_TEXT_SIZE];
+    format_hr_stats(text, rolling_bpm, avg_bpm, max_bpm);
+    if (strcmp(text, g_app_state.text.hr_stats) != 0) {
+        memcpy(g_app_state.text.hr_stats, text, DISPLAY_TEXT_SIZE);
+        mark_regions_dirty(REGION_HR_STATS);
     }
 }
 
-void ui_update_time(const char* time) {
-    if (time) {
-        strncpy(g_app_state.time_text, time, sizeof(g_app_state.time_text) - 1);
-        g_app_state.time_text[sizeof(g_app_state.time_text) - 1] = '\0';
-        if (s_canvas_layer) {
-            layer_mark_dirty(s_canvas_layer);
+void ui_update_workout(const WorkoutMetrics *metrics) {
+    if (metrics) {
+        uint8_t regions = 0;
+        if (metrics->pace_s_per_km != g_app_state.workout.pace_s_per_km) {
+            format_pace(g_app_state.text.pace, metrics->pace_s_per_km);
+            regions |= REGION_PACE;
         }
+        if (metrics->elapsed_s != g_app_state.workout.elapsed_s) {
+            format_duration(g_app_state.text.time, metrics->elapsed_s);
+            regions |= REGION_TIME;
+        }
+        g_app_state.workout = *metrics;
+        if (regions) {
+            mark_regions_dirty(regions);
+        }
+    }
+}
+
+void ui_update_elapsed(uint32_t elapsed_s) {
+    if (g_app_state.workout.elapsed_s != elapsed_s) {
+        g_app_state.workout.elapsed_s = elapsed_s;
+        format_duration(g_app_state.text.time, elapsed_s);
+        mark_regions_dirty(REGION_TIME);
+    }
+}
+
+void ui_update_state(WorkoutState state) {
+    if (g_app_state.state != state) {
+        g_app_state.state = state;
+        // Nothing ticks while paused, so HR can wait for longer frames
+        s_frame_interval_ms = state == WORKOUT_PAUSED ? UI_FRAME_INTERVAL_PAUSED_MS : UI_FRAME_INTERVAL_MS;
+        mark_regions_dirty(REGION_STATUS);
     }
 }
 
 void ui_show_window(void) {
     if (s_main_window) {
-        window_stack_push(s_main_window, true);
+        // Set before the push so the first frame already shows the dot
         g_app_state.is_active = true;
-        if (s_canvas_layer) {
-            layer_mark_dirty(s_canvas_layer);
-        }
+        window_stack_push(s_main_window, true);
+        mark_regions_dirty(REGION_STATUS);
     }
 }
 
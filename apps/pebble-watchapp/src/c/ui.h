@@ -1,6 +1,16 @@
 #pragma once
 
 #include <pebble.h>
+#include "common.h"
+
+// Changes are collected and committed as at most one render per frame slot,
+// aligned to wall-clock multiples of the interval (longer while paused). The
+// seconds tick commits the time band immediately; other deferred changes are
+// flushed UI_FRAME_TICK_GRACE_MS after the next boundary unless a tick
+// flushes them first.
+#define UI_FRAME_INTERVAL_MS 1000
+#define UI_FRAME_INTERVAL_PAUSED_MS 5000
+#define UI_FRAME_TICK_GRACE_MS 50
 
 // UI initialization and cleanup
 void ui_init(void);
@@ -8,8 +18,11 @@ void ui_deinit(void);
 
 // Update display functions
 void ui_update_hr(uint16_t hr);
-void ui_update_pace(const char* pace);
-void ui_update_time(const char* time);
+void ui_update_hr_zone(uint8_t zone);
+void ui_update_hr_stats(uint16_t rolling_bpm, uint16_t avg_bpm, uint16_t max_bpm);
+void ui_update_workout(const WorkoutMetrics *metrics);
+void ui_update_elapsed(uint32_t elapsed_s);
+void ui_update_state(WorkoutState state);
 
 // Window management
 void ui_show_window(void);
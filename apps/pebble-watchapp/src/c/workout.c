@@ -0,0 +1,171 @@
+#include "workout.h"
+#include "ui.h"
+#include "hr.h"
+#include "appmsg.h"
+#include "session.h"
+#include "datalog.h"
+#include "log.h"
+
+static WorkoutState s_state = WORKOUT_IDLE;
+
+// Drain polling while stopping
+static AppTimer *s_stop_timer = NULL;
+static uint32_t s_stop_waited_ms = 0;
+
+static const char *state_name(WorkoutState state) {
+    switch (state) {
+        case WORKOUT_IDLE: return "idle";
+        case WORKOUT_RUNNING: return "running";
+        case WORKOUT_PAUSED: return "paused";
+        case WORKOUT_STOPPING: return "stopping";
+    }
+    return "?";
+}
+
+static void cancel_stop_timer(void) {
+    if (s_stop_timer) {
+        app_timer_cancel(s_stop_timer);
+        s_stop_timer = NULL;
+    }
+}
+
+// Applies the per-state sensor, uplink and redraw policies
+static void enter_state(WorkoutState state) {
+    LOG(APP_LOG_LEVEL_INFO, "Workout %s -> %s", state_name(s_state), state_name(state));
+    LOG_EVENT(LOG_EVENT_WORKOUT_STATE, s_state, state);
+    s_state = state;
+    
+    hr_set_workout_paused(state == WORKOUT_PAUSED);
+    ui_update_state(state);
+}
+
+static void finish_stop(void) {
+    cancel_stop_timer();
+    enter_state(WORKOUT_IDLE);
+    
+    ui_hide_window();
+    // Return to default watchface by removing all windows
+    window_stack_pop_all(false);
+}
+
+static void stop_timer_callback(void *data) {
+    s_stop_timer = NULL;
+    s_stop_waited_ms += WORKOUT_STOP_POLL_MS;
+    
+    if (appmsg_queue_depth() == 0) {
+        finish_stop();
+    } else if (s_stop_waited_ms >= WORKOUT_STOP_TIMEOUT_MS) {
+        LOG(APP_LOG_LEVEL_WARNING, "Stopping with %d messages unsent", appmsg_queue_depth());
+        finish_stop();
+    } else {
+        s_stop_timer = app_timer_register(WORKOUT_STOP_POLL_MS, stop_timer_callback, NULL);
+    }
+}
+
+static void start(void) {
+    cancel_stop_timer();
+    ui_show_window();
+    session_start();
+    datalog_begin((uint32_t)time(NULL));
+    hr_start_monitoring();
+    enter_state(WORKOUT_RUNNING);
+}
+
+static void stop(void) {
+    // Hand buffered HR to the queue, then keep the app alive until it drains
+    hr_stop_monitoring();
+    hr_send_summary();
+    datalog_end();
+    session_stop();
+    enter_state(WORKOUT_STOPPING);
+    
+    if (appmsg_queue_depth() == 0) {
+        finish_stop();
+        return;
+    }
+    s_stop_waited_ms = 0;
+    s_stop_timer = app_timer_register(WORKOUT_STOP_POLL_MS, stop_timer_callback, NULL);
+}
+
+void workout_init(void) {
+    s_state = WORKOUT_IDLE;
+    s_stop_timer = NULL;
+    s_stop_waited_ms = 0;
+}
+
+void workout_deinit(void) {
+    cancel_stop_timer();
+    s_state = WORKOUT_IDLE;
+}
+
+void workout_handle_command(uint8_t cmd) {
+    switch (cmd) {
+        case CMD_START:
+            if (s_state == WORKOUT_IDLE || s_state == WORKOUT_STOPPING) {
+                LOG(APP_LOG_LEVEL_INFO, "Starting workout session");
+                start();
+                return;
+            }
+            break;
+            
+        case CMD_STOP:
+            if (s_state == WORKOUT_RUNNING || s_state == WORKOUT_PAUSED) {
+                LOG(APP_LOG_LEVEL_INFO, "Stopping workout session");
+                stop();
+                return;
+            }
+            break;
+            
+        case CMD_PAUSE:
+            if (s_state == WORKOUT_RUNNING) {
+                session_pause();
+                enter_state(WORKOUT_PAUSED);
+                return;
+            }
+            break;
+            
+        case CMD_RESUME:
+            if (s_state == WORKOUT_PAUSED) {
+                session_resume();
+                enter_state(WORKOUT_RUNNING);
+                return;
+            }
+            break;
+            
+        default:
+            LOG(APP_LOG_LEVEL_WARNING, "Unknown command: %d", cmd);
+            return;
+    }
+    
+    LOG(APP_LOG_LEVEL_WARNING, "Ignoring command %d while %s", cmd, state_name(s_state));
+}
+
+void workout_sync(uint32_t phone_elapsed_s, bool paused) {
+    switch (s_state) {
+        case WORKOUT_STOPPING:
+            // Late frame from before the STOP
+            return;
+    
+        case WORKOUT_IDLE:
+            LOG(APP_LOG_LEVEL_INFO, "Joining workout in progress");
+            ui_show_window();
+            // The DataLogging session of the run before a relaunch carries on
+            datalog_join((uint32_t)time(NULL) - phone_elapsed_s);
+            hr_start_monitoring();
+            session_sync(phone_elapsed_s, paused);
+            enter_state(paused ? WORKOUT_PAUSED : WORKOUT_RUNNING);
+            return;
+            
+        case WORKOUT_RUNNING:
+        case WORKOUT_PAUSED:
+            // Only PAUSE and RESUME change the state once joined; phones that
+            // never set the flag would otherwise undo every pause. The frame
+            // still corrects clock drift.
+            session_sync(phone_elapsed_s, paused);
+            return;
+    }
+}
+
+WorkoutState workout_state(void) {
+    return s_state;
+}
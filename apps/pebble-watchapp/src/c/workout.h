@@ -0,0 +1,33 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// Workout state machine. Commands and WORKOUT frames from the phone move it
+// between states; each state sets the HR sample rate, uplink batching and
+// redraw rate:
+//
+//   IDLE     -> START          -> RUNNING
+//   RUNNING  -> PAUSE          -> PAUSED    (slow sensor, slow frames)
+//   PAUSED   -> RESUME         -> RUNNING
+//   RUNNING, PAUSED -> STOP    -> STOPPING  (flush buffered HR)
+//   STOPPING -> queue drained or WORKOUT_STOP_TIMEOUT_MS -> IDLE
+//
+// A WORKOUT frame received while idle joins the workout in the state it
+// reports, e.g. after the watchapp was restarted mid-run. Later frames only
+// correct the session clock; their paused flag is not a transition.
+
+// While stopping, how often to check the outgoing queue and how long to wait
+#define WORKOUT_STOP_POLL_MS 250
+#define WORKOUT_STOP_TIMEOUT_MS 5000
+
+void workout_init(void);
+void workout_deinit(void);
+
+void workout_handle_command(uint8_t cmd);
+
+// Elapsed time and pause state from a phone WORKOUT frame; the pause state
+// is only used when joining from idle
+void workout_sync(uint32_t phone_elapsed_s, bool paused);
+
+WorkoutState workout_state(void);
@@ -0,0 +1,126 @@
+#include "zones.h"
+#include "log.h"
+
+#include <string.h>
+
+// Percent of max HR at which zones 2 to 5 start
+static const uint8_t s_zone_percent[HR_STATS_ZONE_COUNT - 1] = { 60, 70, 80, 90 };
+
+// Lowest BPM of each zone
+static uint8_t s_lower[HR_STATS_ZONE_COUNT];
+
+static uint8_t s_current = 0;
+static bool s_has_current = false;
+
+// Zone the readings have been pointing at instead, and since when
+static uint8_t s_pending = 0;
+static uint32_t s_pending_since = 0;
+
+// Bounds from a max HR, rounded up so a reading exactly at a percentage
+// starts the zone above
+static void derive_bounds(uint8_t *lower, uint8_t max_hr_bpm) {
+    lower[0] = 0;
+    for (uint8_t i = 1; i < HR_STATS_ZONE_COUNT; i++) {
+        lower[i] = (uint8_t)(((uint16_t)max_hr_bpm * s_zone_percent[i - 1] + 99) / 100);
+    }
+}
+
+static bool bounds_rise(const uint8_t *lower) {
+    for (uint8_t i = 1; i < HR_STATS_ZONE_COUNT; i++) {
+        if (lower[i] <= lower[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void apply_bounds(const uint8_t *lower) {
+    if (memcmp(lower, s_lower, sizeof(s_lower)) == 0) {
+        return;
+    }
+    memcpy(s_lower, lower, sizeof(s_lower));
+    // The next reading picks the zone afresh against the new bounds
+    s_has_current = false;
+    
+    if (persist_write_data(ZONES_PERSIST_KEY, s_lower, sizeof(s_lower)) < 0) {
+        LOG(APP_LOG_LEVEL_ERROR, "Failed to persist HR zones");
+    }
+}
+
+void zones_init(void) {
+    zones_reset();
+    
+    uint8_t lower[HR_STATS_ZONE_COUNT];
+    if (persist_read_data(ZONES_PERSIST_KEY, lower, sizeof(lower)) == sizeof(lower) && bounds_rise(lower)) {
+        memcpy(s_lower, lower, sizeof(s_lower));
+    } else {
+        derive_bounds(s_lower, ZONES_DEFAULT_MAX_HR_BPM);
+    }
+}
+
+void zones_set_max_hr(uint8_t max_hr_bpm) {
+    uint8_t lower[HR_STATS_ZONE_COUNT];
+    derive_bounds(lower, max_hr_bpm);
+    if (!bounds_rise(lower)) {
+        LOG(APP_LOG_LEVEL_WARNING, "Invalid max HR: %d BPM", max_hr_bpm);
+        return;
+    }
+    apply_bounds(lower);
+}
+
+bool zones_set_thresholds(const uint8_t *lower_bpm) {
+    if (!bounds_rise(lower_bpm)) {
+        LOG(APP_LOG_LEVEL_WARNING, "Invalid HR zone bounds");
+        return false;
+    }
+    apply_bounds(lower_bpm);
+    return true;
+}
+
+uint8_t zones_classify(uint16_t bpm) {
+    uint8_t zone = 0;
+    while (zone < HR_STATS_ZONE_COUNT && bpm >= s_lower[zone]) {
+        zone++;
+    }
+    return zone;
+}
+
+bool zones_update(uint32_t timestamp, uint16_t bpm) {
+    if (!s_has_current) {
+        s_current = zones_classify(bpm);
+        s_pending = s_current;
+        s_has_current = true;
+        return false;
+    }
+    
+    // Up only past a bound plus the margin, down only below one minus it
+    uint8_t zone = s_current;
+    uint8_t up = zones_classify(bpm > ZONES_HYSTERESIS_BPM ? bpm - ZONES_HYSTERESIS_BPM : 0);
+    uint8_t down = zones_classify(bpm + ZONES_HYSTERESIS_BPM);
+    if (up > s_current) {
+        zone = up;
+    } else if (down < s_current) {
+        zone = down;
+    }
+    
+    // The hold restarts whenever the readings point somewhere else
+    if (zone != s_pending) {
+        s_pending = zone;
+        s_pending_since = timestamp;
+    }
+    if (zone == s_current || timestamp - s_pending_since < ZONES_CONFIRM_S) {
+        return false;
+    }
+    s_current = zone;
+    return true;
+}
+
+uint8_t zones_current(void) {
+    return s_has_current ? s_current : 0;
+}
+
+void zones_reset(void) {
+    s_current = 0;
+    s_pending = 0;
+    s_has_current = false;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <pebble.h>
+#include "common.h"
+
+// HR zones, classified on the watch so colors and alerts need nothing from
+// the phone once it has sent its ZONES frame.
+//
+// The table holds the lowest BPM of zones 1 to HR_STATS_ZONE_COUNT, rising;
+// readings below zone 1 are zone 0. The phone sends either the five bounds
+// or only a max HR, from which they are derived as on the phone: 60, 70, 80
+// and 90 percent start zones 2 to 5. The table is persisted until the next
+// ZONES frame.
+
+#define ZONES_PERSIST_KEY 0x4D00
+#define ZONES_DEFAULT_MAX_HR_BPM 190
+
+// A reading has to clear a bound by this much, and the new zone has to hold
+// for ZONES_CONFIRM_S, before the current zone changes, so HR hovering on a
+// bound does not flicker or buzz
+#define ZONES_HYSTERESIS_BPM 3
+#define ZONES_CONFIRM_S 10
+
+void zones_init(void);
+
+void zones_set_max_hr(uint8_t max_hr_bpm);
+
+// Rejects bounds that do not rise
+bool zones_set_thresholds(const uint8_t *lower_bpm);
+
+// 0 to HR_STATS_ZONE_COUNT, ignoring hysteresis
+uint8_t zones_classify(uint16_t bpm);
+
+// Tracks the current zone; returns true when a reading moves it out of a
+// zone it was already in, not for the first reading after zones_reset()
+bool zones_update(uint32_t timestamp, uint16_t bpm);
+uint8_t zones_current(void);
+void zones_reset(void);
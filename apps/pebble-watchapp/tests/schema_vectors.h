@@ -0,0 +1,103 @@
+#pragma once
+
+// Generated by shared/proto/schema/generate.py from appmessage.json. Do not edit.
+//
+// Conformance vectors; the Kotlin tests check the same bytes.
+
+#include "common.h"
+
+static const uint8_t VECTOR_WORKOUT_PAUSED[] = { 0x01, 0xfd, 0x02, 0x00, 0x00, 0x56, 0x01, 0xc0, 0x08, 0x00, 0x00, 0x01 };
+#define VECTOR_WORKOUT_PAUSED_VERSION 1
+#define VECTOR_WORKOUT_PAUSED_ELAPSED 765
+#define VECTOR_WORKOUT_PAUSED_PACE 342
+#define VECTOR_WORKOUT_PAUSED_DISTANCE 2240
+#define VECTOR_WORKOUT_PAUSED_FLAGS 1
+
+static const uint8_t VECTOR_WORKOUT_NO_PACE[] = { 0x01, 0x7f, 0x51, 0x01, 0x00, 0x00, 0x00, 0xd3, 0xa4, 0x00, 0x00, 0x00 };
+#define VECTOR_WORKOUT_NO_PACE_VERSION 1
+#define VECTOR_WORKOUT_NO_PACE_ELAPSED 86399
+#define VECTOR_WORKOUT_NO_PACE_PACE 0
+#define VECTOR_WORKOUT_NO_PACE_DISTANCE 42195
+#define VECTOR_WORKOUT_NO_PACE_FLAGS 0
+
+static const uint8_t VECTOR_HR_BATCH_GAPS[] = { 0x04, 0x07, 0x00, 0x00, 0xf1, 0x53, 0x65, 0x01, 0x02, 0x8c, 0x2f, 0x24, 0xf1, 0xa4 };
+static const HRSample VECTOR_HR_BATCH_GAPS_SAMPLES[] = { { 1700000000, 140, 2 }, { 1700000001, 141, 2 }, { 1700000003, 143, 2 }, { 1700000004, 160, 2 } };
+#define VECTOR_HR_BATCH_GAPS_SEQ 7
+#define VECTOR_HR_BATCH_GAPS_STEP 1
+#define VECTOR_HR_BATCH_GAPS_QUALITY 2
+
+static const uint8_t VECTOR_HR_BATCH_MINUTE[] = { 0x3c, 0x08, 0x00, 0x64, 0xf1, 0x53, 0x65, 0x01, 0x01, 0x96, 0x20, 0x22, 0x01, 0x11, 0x02, 0x24, 0x20, 0x11, 0x10, 0x22, 0x42, 0x20, 0x11, 0x11, 0x02, 0x20, 0x22, 0x22, 0x01, 0x11, 0x01, 0x10, 0x11, 0x02, 0x22, 0x22, 0x01, 0x10, 0x10, 0x20 };
+static const HRSample VECTOR_HR_BATCH_MINUTE_SAMPLES[] = { { 1700000100, 150, 1 }, { 1700000101, 151, 1 }, { 1700000102, 151, 1 }, { 1700000103, 152, 1 }, { 1700000104, 153, 1 }, { 1700000105, 153, 1 }, { 1700000106, 152, 1 }, { 1700000107, 151, 1 }, { 1700000108, 150, 1 }, { 1700000109, 150, 1 }, { 1700000110, 151, 1 }, { 1700000111, 152, 1 }, { 1700000112, 154, 1 }, { 1700000113, 155, 1 }, { 1700000114, 155, 1 }, { 1700000115, 154, 1 }, { 1700000116, 153, 1 }, { 1700000117, 152, 1 }, { 1700000118, 152, 1 }, { 1700000119, 153, 1 }, { 1700000120, 154, 1 }, { 1700000121, 156, 1 }, { 1700000122, 157, 1 }, { 1700000123, 158, 1 }, { 1700000124, 158, 1 }, { 1700000125, 157, 1 }, { 1700000126, 156, 1 }, { 1700000127, 155, 1 }, { 1700000128, 154, 1 }, { 1700000129, 154, 1 }, { 1700000130, 155, 1 }, { 1700000131, 156, 1 }, { 1700000132, 156, 1 }, { 1700000133, 157, 1 }, { 1700000134, 158, 1 }, { 1700000135, 159, 1 }, { 1700000136, 160, 1 }, { 1700000137, 160, 1 }, { 1700000138, 159, 1 }, { 1700000139, 158, 1 }, { 1700000140, 157, 1 }, { 1700000141, 157, 1 }, { 1700000142, 156, 1 }, { 1700000143, 155, 1 }, { 1700000144, 155, 1 }, { 1700000145, 154, 1 }, { 1700000146, 153, 1 }, { 1700000147, 153, 1 }, { 1700000148, 154, 1 }, { 1700000149, 155, 1 }, { 1700000150, 156, 1 }, { 1700000151, 157, 1 }, { 1700000152, 158, 1 }, { 1700000153, 158, 1 }, { 1700000154, 157, 1 }, { 1700000155, 156, 1 }, { 1700000156, 156, 1 }, { 1700000157, 155, 1 }, { 1700000158, 155, 1 }, { 1700000159, 156, 1 } };
+#define VECTOR_HR_BATCH_MINUTE_SEQ 8
+#define VECTOR_HR_BATCH_MINUTE_STEP 1
+#define VECTOR_HR_BATCH_MINUTE_QUALITY 1
+
+static const uint8_t VECTOR_HR_MINUTES_HOLE[] = { 0x03, 0xec, 0xf0, 0x53, 0x65, 0x96, 0x00, 0x98 };
+static const uint8_t VECTOR_HR_MINUTES_HOLE_BPM[] = { 150, 0, 152 };
+#define VECTOR_HR_MINUTES_HOLE_BASE_TIME 1699999980
+
+static const uint8_t VECTOR_HELLO_DEFAULT[] = { 0x05, 0x37, 0x00, 0x4f, 0x00 };
+#define VECTOR_HELLO_DEFAULT_PROTOCOL 5
+#define VECTOR_HELLO_DEFAULT_MAX_VALUE 55
+#define VECTOR_HELLO_DEFAULT_INBOX 79
+
+static const uint8_t VECTOR_HR_SUMMARY_HOUR[] = { 0x10, 0x0e, 0x00, 0x00, 0x94, 0x5c, 0xb5, 0x2c, 0x01, 0x00, 0x00, 0x84, 0x03, 0x00, 0x00, 0xdc, 0x05, 0x00, 0x00, 0xd0, 0x02, 0x00, 0x00, 0xb4, 0x00, 0x00, 0x00 };
+#define VECTOR_HR_SUMMARY_HOUR_SECONDS 3600
+#define VECTOR_HR_SUMMARY_HOUR_AVG 148
+#define VECTOR_HR_SUMMARY_HOUR_MIN 92
+#define VECTOR_HR_SUMMARY_HOUR_MAX 181
+#define VECTOR_HR_SUMMARY_HOUR_ZONE1 300
+#define VECTOR_HR_SUMMARY_HOUR_ZONE2 900
+#define VECTOR_HR_SUMMARY_HOUR_ZONE3 1500
+#define VECTOR_HR_SUMMARY_HOUR_ZONE4 720
+#define VECTOR_HR_SUMMARY_HOUR_ZONE5 180
+
+static const uint8_t VECTOR_ZONES_MAX_HR[] = { 0xc8, 0x00, 0x00, 0x00, 0x00, 0x00 };
+#define VECTOR_ZONES_MAX_HR_MAX_HR 200
+#define VECTOR_ZONES_MAX_HR_ZONE1 0
+#define VECTOR_ZONES_MAX_HR_ZONE2 0
+#define VECTOR_ZONES_MAX_HR_ZONE3 0
+#define VECTOR_ZONES_MAX_HR_ZONE4 0
+#define VECTOR_ZONES_MAX_HR_ZONE5 0
+
+static const uint8_t VECTOR_ZONES_THRESHOLDS[] = { 0xb9, 0x5d, 0x6f, 0x82, 0x94, 0xa7 };
+#define VECTOR_ZONES_THRESHOLDS_MAX_HR 185
+#define VECTOR_ZONES_THRESHOLDS_ZONE1 93
+#define VECTOR_ZONES_THRESHOLDS_ZONE2 111
+#define VECTOR_ZONES_THRESHOLDS_ZONE3 130
+#define VECTOR_ZONES_THRESHOLDS_ZONE4 148
+#define VECTOR_ZONES_THRESHOLDS_ZONE5 167
+
+static const uint8_t VECTOR_RESEND_WRAP[] = { 0xfe, 0xff, 0x03 };
+#define VECTOR_RESEND_WRAP_FIRST_SEQ 65534
+#define VECTOR_RESEND_WRAP_COUNT 3
+
+static const uint8_t VECTOR_HR_RECORD_GOOD[] = { 0x00, 0xf1, 0x53, 0x65, 0x8e, 0x02 };
+#define VECTOR_HR_RECORD_GOOD_TIME 1700000000
+#define VECTOR_HR_RECORD_GOOD_BPM 142
+#define VECTOR_HR_RECORD_GOOD_QUALITY 2
+
+static const uint8_t VECTOR_PERF_HOUR[] = { 0x02, 0x10, 0x0e, 0x00, 0x00, 0x00, 0x48, 0x03, 0x00, 0x01, 0x00, 0x0c, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x30, 0x2a, 0x00, 0x00, 0x29, 0x00, 0x00, 0x00, 0x48, 0x0d, 0xbe, 0x00, 0x0a, 0x00, 0x01, 0xf0, 0x00, 0x00, 0x00, 0xe0, 0x01, 0x00, 0x00, 0x09, 0x00, 0x78, 0x00, 0x6e, 0x00, 0x0a, 0x00, 0x00, 0x00 };
+#define VECTOR_PERF_HOUR_UPTIME 3600
+#define VECTOR_PERF_HOUR_HEAP_PEAK 18432
+#define VECTOR_PERF_HOUR_FAIL_TIMEOUT 3
+#define VECTOR_PERF_HOUR_FAIL_NACK 1
+#define VECTOR_PERF_HOUR_FAIL_OFFLINE 12
+#define VECTOR_PERF_HOUR_FAIL_OTHER 0
+#define VECTOR_PERF_HOUR_SNIFF_REDUCED 240
+#define VECTOR_PERF_HOUR_PROBE0_ID 0
+#define VECTOR_PERF_HOUR_PROBE0_CALLS 3600
+#define VECTOR_PERF_HOUR_PROBE0_TOTAL_MS 10800
+#define VECTOR_PERF_HOUR_PROBE0_MAX_MS 41
+#define VECTOR_PERF_HOUR_PROBE0_UNDER_2MS 0
+#define VECTOR_PERF_HOUR_PROBE0_UNDER_8MS 3400
+#define VECTOR_PERF_HOUR_PROBE0_UNDER_32MS 190
+#define VECTOR_PERF_HOUR_PROBE0_OVER_32MS 10
+#define VECTOR_PERF_HOUR_PROBE1_ID 1
+#define VECTOR_PERF_HOUR_PROBE1_CALLS 240
+#define VECTOR_PERF_HOUR_PROBE1_TOTAL_MS 480
+#define VECTOR_PERF_HOUR_PROBE1_MAX_MS 9
+#define VECTOR_PERF_HOUR_PROBE1_UNDER_2MS 120
+#define VECTOR_PERF_HOUR_PROBE1_UNDER_8MS 110
+#define VECTOR_PERF_HOUR_PROBE1_UNDER_32MS 10
+#define VECTOR_PERF_HOUR_PROBE1_OVER_32MS 0
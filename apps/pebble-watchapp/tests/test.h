@@ -0,0 +1,78 @@
+#pragma once
+
+#include <pebble_stub.h>
+
+#include "common.h"
+
+// Minimal assertion helpers for the host test runner.
+// Each suite exposes a run_*_tests() entry point called from test_main.c.
+
+extern int g_test_failures;
+extern int g_test_checks;
+
+#define CHECK(cond) \
+    do { \
+        g_test_checks++; \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ_INT(expected, actual) \
+    do { \
+        long long expected_value_ = (long long)(expected); \
+        long long actual_value_ = (long long)(actual); \
+        g_test_checks++; \
+        if (expected_value_ != actual_value_) { \
+            fprintf(stderr, "%s:%d: expected %s == %lld, got %lld\n", \
+                    __FILE__, __LINE__, #actual, expected_value_, actual_value_); \
+            g_test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ_STR(expected, actual) \
+    do { \
+        const char *expected_value_ = (expected); \
+        const char *actual_value_ = (actual); \
+        g_test_checks++; \
+        if (strcmp(expected_value_, actual_value_) != 0) { \
+            fprintf(stderr, "%s:%d: expected %s == \"%s\", got \"%s\"\n", \
+                    __FILE__, __LINE__, #actual, expected_value_, actual_value_); \
+            g_test_failures++; \
+        } \
+    } while (0)
+
+#define RUN_TEST(fn) test_run(#fn, fn)
+
+typedef void (*TestFn)(void);
+
+// Resets the SDK fake and g_app_state, then runs the test body
+void test_run(const char *name, TestFn fn);
+
+// Runs the watchapp's main() with the scenario as its event loop
+void test_run_app(StubEventLoop scenario);
+
+// Message helpers for driving inbox_received_callback
+AppMessageResult test_deliver_uint8(uint32_t key, uint8_t value);
+AppMessageResult test_deliver_data(uint32_t key, const uint8_t *data, uint16_t size);
+
+// Suites
+void run_stub_tests(void);
+void run_hr_tests(void);
+void run_hrpack_tests(void);
+void run_hrquality_tests(void);
+void run_hrstats_tests(void);
+void run_zones_tests(void);
+void run_datalog_tests(void);
+void run_log_tests(void);
+void run_perf_tests(void);
+void run_journal_tests(void);
+void run_backfill_tests(void);
+void run_appmsg_tests(void);
+void run_ui_tests(void);
+void run_format_tests(void);
+void run_session_tests(void);
+void run_workout_tests(void);
+void run_replay_tests(void);
+void run_schema_tests(void);
@@ -0,0 +1,441 @@
+#include "test.h"
+
+#include "appmsg.h"
+#include "hr.h"
+#include "journal.h"
+
+// BPM of the last live value or one-sample batch sent
+static uint16_t last_sent_hr(void) {
+    DictionaryIterator sent;
+    if (!stub_appmsg_last_sent(&sent)) {
+        return 0;
+    }
+    Tuple *live = dict_find(&sent, KEY_HR_LIVE);
+    if (live && live->length == HR_RECORD_SIZE) {
+        return live->value->data[HR_RECORD_BPM_OFFSET];
+    }
+    Tuple *batch = dict_find(&sent, KEY_HR_BATCH);
+    if (!batch || batch->length != HR_BATCH_HEADER_SIZE) {
+        return 0;
+    }
+    return batch->value->data[HR_BATCH_BPM_OFFSET];
+}
+
+static void send_one_sample(uint16_t bpm) {
+    HRSample sample = { .timestamp = (uint32_t)time(NULL), .bpm = bpm, .quality = HR_BATCH_QUALITY_GOOD };
+    CHECK_EQ_INT(1, appmsg_send_hr_batch(&sample, 1));
+}
+
+static void scenario_start_command_opens_session(void) {
+    CHECK_EQ_INT(APP_MSG_OK, test_deliver_uint8(KEY_CMD, CMD_START));
+    CHECK(window_stack_get_top_window() != NULL);
+    CHECK(g_app_state.is_active);
+    CHECK_EQ_INT(1, stub_health_sample_period());
+}
+
+static void test_start_command_opens_session(void) {
+    test_run_app(scenario_start_command_opens_session);
+}
+
+static void scenario_stop_command_closes_session(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+    CHECK(window_stack_get_top_window() == NULL);
+    CHECK(!g_app_state.is_active);
+    CHECK_EQ_INT(0, stub_health_sample_period());
+
+    // Late health events must not touch the unloaded window
+    stub_health_set_value(HealthMetricHeartRateBPM, 120);
+    stub_health_emit(HealthEventHeartRateUpdate);
+}
+
+static void test_stop_command_closes_session(void) {
+    test_run_app(scenario_stop_command_closes_session);
+}
+
+static void scenario_workout_frame_updates_state(void) {
+    // 765 s elapsed, 5:42/km, 2240 m, paused
+    uint8_t frame[WORKOUT_FRAME_SIZE] = {
+        WORKOUT_FRAME_VERSION, 0xfd, 0x02, 0x00, 0x00, 0x56, 0x01,
+        0xc0, 0x08, 0x00, 0x00, WORKOUT_FLAG_PAUSED
+    };
+    CHECK_EQ_INT(APP_MSG_OK, test_deliver_data(KEY_WORKOUT, frame, sizeof(frame)));
+    CHECK_EQ_INT(765, g_app_state.workout.elapsed_s);
+    CHECK_EQ_INT(342, g_app_state.workout.pace_s_per_km);
+    CHECK_EQ_INT(2240, g_app_state.workout.distance_m);
+    CHECK_EQ_INT(WORKOUT_FLAG_PAUSED, g_app_state.workout.flags);
+}
+
+static void test_workout_frame_updates_state(void) {
+    test_run_app(scenario_workout_frame_updates_state);
+}
+
+static void scenario_workout_frame_versions(void) {
+    uint8_t frame[WORKOUT_FRAME_SIZE + 4] = { WORKOUT_FRAME_VERSION + 1, 10 };
+
+    // A newer, longer frame still yields the fields this build knows about
+    CHECK(appmsg_handle_workout_frame(frame, sizeof(frame)));
+    CHECK_EQ_INT(10, g_app_state.workout.elapsed_s);
+
+    frame[1] = 20;
+    CHECK(!appmsg_handle_workout_frame(frame, WORKOUT_FRAME_SIZE - 1));
+    frame[0] = 0;
+    CHECK(!appmsg_handle_workout_frame(frame, sizeof(frame)));
+    CHECK_EQ_INT(10, g_app_state.workout.elapsed_s);
+}
+
+static void test_workout_frame_versions(void) {
+    test_run_app(scenario_workout_frame_versions);
+}
+
+static void scenario_oversized_message_is_dropped(void) {
+    uint8_t frame[200] = { WORKOUT_FRAME_VERSION };
+    CHECK_EQ_INT(APP_MSG_BUFFER_OVERFLOW, test_deliver_data(KEY_WORKOUT, frame, sizeof(frame)));
+    CHECK_EQ_INT(1, stub_get_stats()->inbox_dropped);
+}
+
+static void test_oversized_message_is_dropped(void) {
+    test_run_app(scenario_oversized_message_is_dropped);
+}
+
+static void scenario_ack_releases_next_message(void) {
+    appmsg_send_hr(100, HR_BATCH_QUALITY_GOOD);
+    CHECK_EQ_INT(1, stub_get_stats()->outbox_sends);
+
+    // Stale live values are coalesced while the first one is in flight
+    appmsg_send_hr(101, HR_BATCH_QUALITY_GOOD);
+    appmsg_send_hr(102, HR_BATCH_QUALITY_GOOD);
+    CHECK_EQ_INT(2, appmsg_queue_depth());
+    CHECK_EQ_INT(0, stub_get_stats()->outbox_busy);
+
+    stub_appmsg_ack();
+    CHECK_EQ_INT(2, stub_get_stats()->outbox_sends);
+    CHECK_EQ_INT(102, last_sent_hr());
+
+    stub_appmsg_ack();
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+}
+
+static void test_ack_releases_next_message(void) {
+    test_run_app(scenario_ack_releases_next_message);
+}
+
+static void scenario_failed_send_retries_with_backoff(void) {
+    appmsg_send_hr(110, HR_BATCH_QUALITY_GOOD);
+    stub_appmsg_nack(APP_MSG_SEND_TIMEOUT);
+    CHECK_EQ_INT(1, stub_get_stats()->outbox_sends);
+
+    stub_advance_ms(APPMSG_RETRY_BASE_MS - 1);
+    CHECK_EQ_INT(1, stub_get_stats()->outbox_sends);
+    stub_advance_ms(1);
+    CHECK_EQ_INT(2, stub_get_stats()->outbox_sends);
+    CHECK_EQ_INT(110, last_sent_hr());
+
+    // Second failure doubles the delay
+    stub_appmsg_nack(APP_MSG_SEND_TIMEOUT);
+    stub_advance_ms(APPMSG_RETRY_BASE_MS);
+    CHECK_EQ_INT(2, stub_get_stats()->outbox_sends);
+    stub_advance_ms(APPMSG_RETRY_BASE_MS);
+    CHECK_EQ_INT(3, stub_get_stats()->outbox_sends);
+}
+
+static void test_failed_send_retries_with_backoff(void) {
+    test_run_app(scenario_failed_send_retries_with_backoff);
+}
+
+static void scenario_message_dropped_after_max_retries(void) {
+    appmsg_send_hr(120, HR_BATCH_QUALITY_GOOD);
+    for (int attempt = 0; attempt <= APPMSG_MAX_RETRIES; attempt++) {
+        CHECK_EQ_INT(1, appmsg_queue_depth());
+        stub_appmsg_nack(APP_MSG_NOT_CONNECTED);
+        stub_advance_ms(APPMSG_RETRY_MAX_MS);
+    }
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+    CHECK_EQ_INT(APPMSG_MAX_RETRIES + 1, stub_get_stats()->outbox_sends);
+}
+
+static void test_message_dropped_after_max_retries(void) {
+    test_run_app(scenario_message_dropped_after_max_retries);
+}
+
+static void scenario_sniff_interval_follows_the_queue(void) {
+    CHECK_EQ_INT(SNIFF_INTERVAL_NORMAL, app_comm_get_sniff_interval());
+    uint32_t reduced_before = appmsg_sniff_ms(SNIFF_INTERVAL_REDUCED);
+
+    // Reduced from the send until the queue drains
+    appmsg_send_hr(120, HR_BATCH_QUALITY_GOOD);
+    appmsg_send_hr(121, HR_BATCH_QUALITY_GOOD);
+    CHECK_EQ_INT(SNIFF_INTERVAL_REDUCED, app_comm_get_sniff_interval());
+    stub_advance_ms(200);
+    stub_appmsg_ack();
+    CHECK_EQ_INT(SNIFF_INTERVAL_REDUCED, app_comm_get_sniff_interval());
+    stub_advance_ms(300);
+    stub_appmsg_ack();
+    CHECK_EQ_INT(SNIFF_INTERVAL_NORMAL, app_comm_get_sniff_interval());
+    CHECK_EQ_INT(reduced_before + 500, appmsg_sniff_ms(SNIFF_INTERVAL_REDUCED));
+
+    // Idle time counts as normal
+    uint32_t normal_before = appmsg_sniff_ms(SNIFF_INTERVAL_NORMAL);
+    stub_advance_ms(60000);
+    CHECK_EQ_INT(normal_before + 60000, appmsg_sniff_ms(SNIFF_INTERVAL_NORMAL));
+
+    // Backing off after a failure waits at the normal interval
+    appmsg_send_hr(122, HR_BATCH_QUALITY_GOOD);
+    stub_appmsg_nack(APP_MSG_NOT_CONNECTED);
+    CHECK_EQ_INT(1, appmsg_queue_depth());
+    CHECK_EQ_INT(SNIFF_INTERVAL_NORMAL, app_comm_get_sniff_interval());
+    stub_advance_ms(APPMSG_RETRY_MAX_MS);
+    stub_appmsg_ack();
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+    CHECK_EQ_INT(SNIFF_INTERVAL_NORMAL, app_comm_get_sniff_interval());
+    CHECK_EQ_INT(4, stub_get_stats()->sniff_switches);
+}
+
+static void test_sniff_interval_follows_the_queue(void) {
+    test_run_app(scenario_sniff_interval_follows_the_queue);
+}
+
+static void scenario_exit_restores_normal_sniff(void) {
+    appmsg_send_hr(120, HR_BATCH_QUALITY_GOOD);
+    CHECK_EQ_INT(SNIFF_INTERVAL_REDUCED, app_comm_get_sniff_interval());
+}
+
+static void test_exit_restores_normal_sniff(void) {
+    test_run_app(scenario_exit_restores_normal_sniff);
+    CHECK_EQ_INT(SNIFF_INTERVAL_NORMAL, app_comm_get_sniff_interval());
+}
+
+static void scenario_disconnect_holds_the_uplink(void) {
+    CHECK(stub_connection_is_subscribed());
+    CHECK(appmsg_is_connected());
+
+    // The live value in flight fails with the link and is dropped, neither
+    // retried nor journaled
+    appmsg_send_hr(100, HR_BATCH_QUALITY_GOOD);
+    stub_connection_set(false);
+    CHECK(!appmsg_is_connected());
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+    CHECK_EQ_INT(0, journal_sample_count());
+
+    // Live values are dropped and batches go straight to the journal
+    uint32_t sends = stub_get_stats()->outbox_sends;
+    appmsg_send_hr(101, HR_BATCH_QUALITY_GOOD);
+    HRSample samples[10];
+    for (int i = 0; i < 10; i++) {
+        samples[i] = (HRSample){ .timestamp = 1700000000 + i, .bpm = 140, .quality = HR_BATCH_QUALITY_GOOD };
+    }
+    CHECK_EQ_INT(10, appmsg_send_hr_batch(samples, 10));
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+    CHECK_EQ_INT(10, journal_sample_count());
+
+    // A long dropout costs no send attempts and no reduced sniff time
+    stub_advance_ms(20 * 60 * 1000);
+    CHECK_EQ_INT(sends, stub_get_stats()->outbox_sends);
+    CHECK_EQ_INT(0, stub_get_stats()->outbox_offline);
+    CHECK_EQ_INT(SNIFF_INTERVAL_NORMAL, app_comm_get_sniff_interval());
+}
+
+static void test_disconnect_holds_the_uplink(void) {
+    test_run_app(scenario_disconnect_holds_the_uplink);
+}
+
+// HR_BATCH base times in the order the frames went out
+static uint32_t s_batch_times[32];
+static uint8_t s_batch_count;
+
+static void record_batch(const uint8_t *data, uint16_t size, void *context) {
+    DictionaryIterator iter;
+    dict_read_begin_from_buffer(&iter, data, size);
+    Tuple *batch = dict_find(&iter, KEY_HR_BATCH);
+    if (batch && batch->length >= HR_BATCH_HEADER_SIZE && s_batch_count < 32) {
+        const uint8_t *time = &batch->value->data[HR_BATCH_BASE_TIME_OFFSET];
+        s_batch_times[s_batch_count++] = (uint32_t)time[0] | ((uint32_t)time[1] << 8) |
+                                         ((uint32_t)time[2] << 16) | ((uint32_t)time[3] << 24);
+    }
+}
+
+static void scenario_reconnect_catches_up_latest_first(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    stub_appmsg_set_auto_ack(true, 50);
+    stub_connection_set(false);
+
+    // A full batch is journaled, the rest stays in RAM
+    uint32_t first_time = (uint32_t)time(NULL);
+    for (int i = 0; i < HR_BATCH_SIZE + 20; i++) {
+        stub_health_set_value(HealthMetricHeartRateBPM, 150);
+        stub_health_emit(HealthEventHeartRateUpdate);
+        stub_advance_ms(1000);
+    }
+    CHECK_EQ_INT(HR_BATCH_SIZE, journal_sample_count());
+    CHECK_EQ_INT(20, hr_pending_samples());
+    CHECK_EQ_INT(0, stub_get_stats()->outbox_offline);
+
+    s_batch_count = 0;
+    stub_appmsg_set_outbox_observer(record_batch, NULL);
+    stub_connection_set(true);
+    stub_advance_ms(5000);
+
+    // The newest samples go first, then the journal from its oldest
+    CHECK_EQ_INT(0, hr_pending_samples());
+    CHECK_EQ_INT(0, journal_sample_count());
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+    CHECK(s_batch_count >= 2);
+    CHECK_EQ_INT(first_time + HR_BATCH_SIZE, s_batch_times[0]);
+    CHECK_EQ_INT(first_time, s_batch_times[1]);
+    stub_appmsg_set_outbox_observer(NULL, NULL);
+}
+
+static void test_reconnect_catches_up_latest_first(void) {
+    test_run_app(scenario_reconnect_catches_up_latest_first);
+}
+
+static uint16_t last_sent_seq(void) {
+    DictionaryIterator sent;
+    if (!stub_appmsg_last_sent(&sent)) {
+        return 0xFFFF;
+    }
+    Tuple *batch = dict_find(&sent, KEY_HR_BATCH);
+    if (!batch || batch->length < HR_BATCH_HEADER_SIZE) {
+        return 0xFFFF;
+    }
+    const uint8_t *seq = &batch->value->data[HR_BATCH_SEQ_OFFSET];
+    return (uint16_t)(seq[0] | (seq[1] << 8));
+}
+
+static void request_resend(uint16_t first, uint8_t count) {
+    uint8_t frame[RESEND_FRAME_SIZE];
+    frame[RESEND_FIRST_SEQ_OFFSET] = (uint8_t)first;
+    frame[RESEND_FIRST_SEQ_OFFSET + 1] = (uint8_t)(first >> 8);
+    frame[RESEND_COUNT_OFFSET] = count;
+    test_deliver_data(KEY_RESEND, frame, sizeof(frame));
+}
+
+static void scenario_batches_are_sequenced(void) {
+    send_one_sample(100);
+    CHECK_EQ_INT(0, last_sent_seq());
+
+    // A retry keeps its number
+    stub_appmsg_nack(APP_MSG_SEND_TIMEOUT);
+    send_one_sample(101);
+    stub_advance_ms(APPMSG_RETRY_BASE_MS);
+    CHECK_EQ_INT(0, last_sent_seq());
+    CHECK_EQ_INT(100, last_sent_hr());
+
+    stub_appmsg_ack();
+    CHECK_EQ_INT(1, last_sent_seq());
+    CHECK_EQ_INT(101, last_sent_hr());
+    stub_appmsg_ack();
+
+    // Live values go out under their own key and take no number
+    appmsg_send_hr(102, HR_BATCH_QUALITY_GOOD);
+    CHECK_EQ_INT(0xFFFF, last_sent_seq());
+    CHECK_EQ_INT(102, last_sent_hr());
+    stub_appmsg_ack();
+    send_one_sample(103);
+    CHECK_EQ_INT(2, last_sent_seq());
+    stub_appmsg_ack();
+}
+
+static void test_batches_are_sequenced(void) {
+    test_run_app(scenario_batches_are_sequenced);
+}
+
+static void scenario_resend_replays_acknowledged_frames(void) {
+    for (int i = 0; i < APPMSG_RESEND_HISTORY + 2; i++) {
+        send_one_sample((uint16_t)(100 + i));
+        stub_appmsg_ack();
+    }
+
+    // 0 and 1 have aged out of the history
+    request_resend(0, 4);
+    CHECK_EQ_INT(2, appmsg_queue_depth());
+    CHECK_EQ_INT(2, last_sent_seq());
+    CHECK_EQ_INT(102, last_sent_hr());
+    stub_appmsg_ack();
+    CHECK_EQ_INT(3, last_sent_seq());
+    stub_appmsg_ack();
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+
+    // Resent frames keep their numbers and do not push out the history
+    send_one_sample(120);
+    CHECK_EQ_INT(APPMSG_RESEND_HISTORY + 2, last_sent_seq());
+    stub_appmsg_ack();
+    request_resend(4, 1);
+    CHECK_EQ_INT(4, last_sent_seq());
+    stub_appmsg_ack();
+}
+
+static void test_resend_replays_acknowledged_frames(void) {
+    test_run_app(scenario_resend_replays_acknowledged_frames);
+}
+
+static void scenario_sequence_survives_exit(void) {
+    send_one_sample(100);
+    stub_appmsg_ack();
+    send_one_sample(101);
+    stub_appmsg_ack();
+}
+
+static void scenario_sequence_continues(void) {
+    send_one_sample(102);
+    CHECK_EQ_INT(2, last_sent_seq());
+}
+
+static void test_sequence_survives_exit(void) {
+    test_run_app(scenario_sequence_survives_exit);
+    stub_app_exit();
+    test_run_app(scenario_sequence_continues);
+}
+
+static void scenario_small_buffers_shrink_frames(void) {
+    CHECK_EQ_INT(40, stub_appmsg_inbox_size());
+    CHECK_EQ_INT(40, stub_appmsg_outbox_size());
+
+    // The launch HELLO reports the capped sizes
+    DictionaryIterator sent;
+    CHECK(stub_appmsg_last_sent(&sent));
+    Tuple *hello = dict_find(&sent, KEY_HELLO);
+    CHECK(hello != NULL);
+    if (hello) {
+        const uint8_t *data = hello->value->data;
+        CHECK_EQ_INT(PROTOCOL_VERSION, data[HELLO_PROTOCOL_OFFSET]);
+        CHECK_EQ_INT(40 - 8, data[HELLO_MAX_VALUE_OFFSET] | (data[HELLO_MAX_VALUE_OFFSET + 1] << 8));
+        CHECK_EQ_INT(40, data[HELLO_INBOX_OFFSET] | (data[HELLO_INBOX_OFFSET + 1] << 8));
+    }
+
+    // A steady minute no longer fits one frame; the rest goes in the next
+    HRSample samples[60];
+    for (int i = 0; i < 60; i++) {
+        samples[i].timestamp = 1700000000 + i;
+        samples[i].bpm = 140;
+        samples[i].quality = HR_BATCH_QUALITY_GOOD;
+    }
+    uint8_t packed = appmsg_send_hr_batch(samples, 60);
+    CHECK_EQ_INT(1 + (40 - 8 - HR_BATCH_HEADER_SIZE) * 2, packed);
+    CHECK_EQ_INT(1, stub_get_stats()->outbox_sends);
+    CHECK_EQ_INT(60 - packed, appmsg_send_hr_batch(&samples[packed], (uint8_t)(60 - packed)));
+}
+
+static void test_small_buffers_shrink_frames(void) {
+    stub_appmsg_set_size_maximum(40, 40);
+    test_run_app(scenario_small_buffers_shrink_frames);
+}
+
+void run_appmsg_tests(void) {
+    RUN_TEST(test_start_command_opens_session);
+    RUN_TEST(test_stop_command_closes_session);
+    RUN_TEST(test_workout_frame_updates_state);
+    RUN_TEST(test_workout_frame_versions);
+    RUN_TEST(test_oversized_message_is_dropped);
+    RUN_TEST(test_ack_releases_next_message);
+    RUN_TEST(test_failed_send_retries_with_backoff);
+    RUN_TEST(test_message_dropped_after_max_retries);
+    RUN_TEST(test_sniff_interval_follows_the_queue);
+    RUN_TEST(test_exit_restores_normal_sniff);
+    RUN_TEST(test_disconnect_holds_the_uplink);
+    RUN_TEST(test_reconnect_catches_up_latest_first);
+    RUN_TEST(test_batches_are_sequenced);
+    RUN_TEST(test_resend_replays_acknowledged_frames);
+    RUN_TEST(test_sequence_survives_exit);
+    RUN_TEST(test_small_buffers_shrink_frames);
+}
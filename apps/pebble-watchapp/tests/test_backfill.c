@@ -0,0 +1,220 @@
+#include "test.h"
+
+#include "appmsg.h"
+#include "backfill.h"
+#include "hr.h"
+#include "journal.h"
+
+#include <string.h>
+
+// Minutes received by the phone in HR_MINUTES frames, and HR batches seen
+typedef struct {
+    uint32_t frames;
+    uint32_t minutes;
+    uint32_t first_minute;
+    uint32_t batches;
+    uint32_t batch_samples;
+} SentMinutes;
+
+static void observe_outbox(const uint8_t *data, uint16_t size, void *context) {
+    SentMinutes *sent = context;
+    DictionaryIterator iter;
+    for (Tuple *tuple = dict_read_begin_from_buffer(&iter, data, size); tuple; tuple = dict_read_next(&iter)) {
+        if (tuple->key == KEY_HR_BATCH) {
+            sent->batches++;
+            sent->batch_samples += tuple->value->data[HR_BATCH_COUNT_OFFSET];
+        }
+        if (tuple->key != KEY_HR_MINUTES) {
+            continue;
+        }
+        const uint8_t *frame = tuple->value->data;
+        uint32_t base = frame[1] | (frame[2] << 8) | (frame[3] << 16) | ((uint32_t)frame[4] << 24);
+        if (sent->frames == 0) {
+            sent->first_minute = base;
+        }
+        sent->frames++;
+        sent->minutes += frame[HR_MINUTES_COUNT_OFFSET];
+    }
+}
+
+static uint32_t minute_start(void) {
+    uint32_t now = (uint32_t)time(NULL);
+    return now - now % 60;
+}
+
+static void test_gap_becomes_minute_range(void) {
+    backfill_init();
+    uint32_t start = minute_start();
+    for (int i = 0; i < 5; i++) {
+        stub_health_record_minute(start + i * 60, (uint8_t)(140 + i));
+    }
+    stub_health_record_minute(start + 5 * 60, 0);
+
+    backfill_gap_begin(BACKFILL_GAP_LOW_BATTERY);
+    stub_advance_ms(6 * 60 * 1000);
+    CHECK(!backfill_pending());
+    backfill_gap_end(BACKFILL_GAP_LOW_BATTERY);
+    CHECK(backfill_pending());
+
+    // The minute the gap ended in is still being recorded
+    uint8_t bpm[HR_MINUTES_MAX_MINUTES];
+    uint32_t base_time = 0;
+    CHECK_EQ_INT(6, backfill_peek(bpm, HR_MINUTES_MAX_MINUTES, &base_time));
+    CHECK_EQ_INT(start, base_time);
+    CHECK_EQ_INT(140, bpm[0]);
+    CHECK_EQ_INT(144, bpm[4]);
+    CHECK_EQ_INT(0, bpm[5]);
+
+    backfill_consume(6);
+    CHECK(backfill_pending());
+    CHECK_EQ_INT(0, backfill_peek(bpm, HR_MINUTES_MAX_MINUTES, &base_time));
+
+    stub_advance_ms(60 * 1000);
+    CHECK_EQ_INT(1, backfill_peek(bpm, HR_MINUTES_MAX_MINUTES, &base_time));
+    CHECK_EQ_INT(start + 6 * 60, base_time);
+    backfill_consume(1);
+    CHECK(!backfill_pending());
+}
+
+static void test_short_gap_is_ignored(void) {
+    backfill_init();
+    backfill_gap_begin(BACKFILL_GAP_LOW_BATTERY);
+    stub_advance_ms((BACKFILL_MIN_GAP_S - 1) * 1000);
+    backfill_gap_end(BACKFILL_GAP_LOW_BATTERY);
+    CHECK(!backfill_pending());
+}
+
+static void test_overwritten_journal_chunk_is_backfilled(void) {
+    backfill_init();
+    journal_init();
+    uint32_t start = minute_start();
+    HRSample sample = { .bpm = 140 };
+    for (uint32_t i = 0; i < JOURNAL_CHUNK_COUNT * JOURNAL_CHUNK_SAMPLES; i++) {
+        sample.timestamp = start + i;
+        journal_append(&sample, 1);
+    }
+    CHECK(!backfill_pending());
+
+    // The first chunk goes, and with it the minutes its samples covered
+    journal_consume(3);
+    journal_append(&sample, 1);
+    CHECK(backfill_pending());
+    stub_advance_ms(JOURNAL_CHUNK_COUNT * JOURNAL_CHUNK_SAMPLES * 1000);
+    uint8_t bpm[HR_MINUTES_MAX_MINUTES];
+    uint32_t base_time = 0;
+    uint8_t minutes = backfill_peek(bpm, HR_MINUTES_MAX_MINUTES, &base_time);
+    CHECK_EQ_INT(start, base_time);
+    CHECK_EQ_INT((JOURNAL_CHUNK_SAMPLES + 59) / 60, minutes);
+}
+
+static void test_long_gap_keeps_newest_minutes(void) {
+    backfill_init();
+    uint32_t start = minute_start();
+    backfill_add_range(start, start + (BACKFILL_MAX_MINUTES + 30) * 60);
+    stub_advance_ms((BACKFILL_MAX_MINUTES + 31) * 60 * 1000);
+
+    uint8_t bpm[HR_MINUTES_MAX_MINUTES];
+    uint32_t base_time = 0;
+    CHECK_EQ_INT(HR_MINUTES_MAX_MINUTES, backfill_peek(bpm, HR_MINUTES_MAX_MINUTES, &base_time));
+    CHECK_EQ_INT(start + 30 * 60, base_time);
+}
+
+static void test_open_gap_survives_restart(void) {
+    backfill_init();
+    backfill_gap_begin(BACKFILL_GAP_LOW_BATTERY);
+    stub_advance_ms(3 * 60 * 1000);
+    backfill_deinit();
+
+    backfill_init();
+    CHECK(backfill_pending());
+    CHECK(!persist_exists(BACKFILL_PERSIST_KEY));
+    backfill_deinit();
+    CHECK(persist_exists(BACKFILL_PERSIST_KEY));
+}
+
+static void emit_hr(HealthValue bpm) {
+    stub_health_set_value(HealthMetricHeartRateBPM, bpm);
+    stub_health_emit(HealthEventHeartRateUpdate);
+}
+
+static SentMinutes s_sent;
+
+static void scenario_dropout_is_resent_not_backfilled(void) {
+    stub_appmsg_set_outbox_observer(observe_outbox, &s_sent);
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    stub_appmsg_set_auto_ack(true, 50);
+
+    // Three minutes out of range; what fails is journaled
+    stub_appmsg_set_auto_nack_percent(100);
+    for (int i = 0; i < 3 * 60; i++) {
+        emit_hr(150);
+        stub_advance_ms(1000);
+    }
+    CHECK(journal_sample_count() > 0);
+
+    // Back in range: the samples themselves go out, so there is nothing to
+    // backfill
+    stub_appmsg_set_auto_nack_percent(0);
+    s_sent.batch_samples = 0;
+    for (int i = 0; i < 2 * 60; i++) {
+        emit_hr(150);
+        stub_advance_ms(1000);
+    }
+    hr_flush_samples();
+    stub_advance_ms(1000);
+    CHECK(s_sent.batch_samples >= 3 * 60);
+    CHECK_EQ_INT(0, journal_sample_count());
+    CHECK_EQ_INT(0, s_sent.frames);
+    CHECK(!backfill_pending());
+}
+
+static void test_dropout_is_resent_not_backfilled(void) {
+    memset(&s_sent, 0, sizeof(s_sent));
+    test_run_app(scenario_dropout_is_resent_not_backfilled);
+}
+
+static void scenario_low_battery_replaces_live_upload(void) {
+    stub_appmsg_set_outbox_observer(observe_outbox, &s_sent);
+    stub_appmsg_set_auto_ack(true, 50);
+    stub_battery_set(HR_BATTERY_LOW_PERCENT, false);
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    CHECK(hr_uplink_is_off());
+
+    // HR still shows, but nothing goes out until a slice is due
+    for (uint32_t i = 0; i < HR_LOW_BATTERY_BACKFILL_S; i++) {
+        emit_hr(140);
+        stub_advance_ms(1000);
+    }
+    CHECK_EQ_INT(140, g_app_state.current_hr);
+    CHECK_EQ_INT(0, s_sent.batches);
+    CHECK_EQ_INT(0, s_sent.frames);
+
+    emit_hr(140);
+    stub_advance_ms(1000);
+    CHECK(s_sent.frames > 0);
+    CHECK(s_sent.minutes >= HR_LOW_BATTERY_BACKFILL_S / 60 - 1);
+
+    // Charging brings the live upload back
+    stub_battery_set(HR_BATTERY_LOW_PERCENT, true);
+    CHECK(!hr_uplink_is_off());
+    for (int i = 0; i < HR_BATCH_SIZE; i++) {
+        emit_hr(141);
+        stub_advance_ms(1000);
+    }
+    CHECK_EQ_INT(1, s_sent.batches);
+}
+
+static void test_low_battery_replaces_live_upload(void) {
+    memset(&s_sent, 0, sizeof(s_sent));
+    test_run_app(scenario_low_battery_replaces_live_upload);
+}
+
+void run_backfill_tests(void) {
+    RUN_TEST(test_gap_becomes_minute_range);
+    RUN_TEST(test_short_gap_is_ignored);
+    RUN_TEST(test_overwritten_journal_chunk_is_backfilled);
+    RUN_TEST(test_long_gap_keeps_newest_minutes);
+    RUN_TEST(test_open_gap_survives_restart);
+    RUN_TEST(test_dropout_is_resent_not_backfilled);
+    RUN_TEST(test_low_battery_replaces_live_upload);
+}
@@ -0,0 +1,326 @@
+#include "test.h"
+
+#include "appmsg.h"
+#include "datalog.h"
+#include "hr.h"
+#include "hrpack.h"
+#include "journal.h"
+#include "workout.h"
+
+#define T0 1700000000
+
+static void test_uplink_survives_a_restart(void) {
+    datalog_init();
+    CHECK(!datalog_enabled());
+    CHECK(!datalog_set_uplink(7));
+    CHECK(datalog_set_uplink(UPLINK_DATALOG));
+    CHECK(datalog_enabled());
+    CHECK(persist_exists(DATALOG_PERSIST_KEY));
+
+    datalog_init();
+    CHECK(datalog_enabled());
+    CHECK(datalog_set_uplink(UPLINK_APPMESSAGE));
+    datalog_init();
+    CHECK(!datalog_enabled());
+}
+
+static void test_writes_need_a_workout(void) {
+    HRSample samples[3] = {
+        { T0, 140, HR_BATCH_QUALITY_GOOD }, { T0 + 1, 300, HR_BATCH_QUALITY_OK }, { T0 + 2, 142, HR_BATCH_QUALITY_GOOD }
+    };
+    datalog_init();
+    datalog_begin(T0);
+    CHECK_EQ_INT(0, datalog_write(samples, 3));
+
+    datalog_set_uplink(UPLINK_DATALOG);
+    datalog_end();
+    CHECK_EQ_INT(0, datalog_write(samples, 3));
+
+    // Opened at the first write, one record per sample
+    datalog_begin(T0);
+    CHECK(!stub_datalog_is_open(T0));
+    CHECK_EQ_INT(3, datalog_write(samples, 3));
+    CHECK(stub_datalog_is_open(T0));
+
+    uint32_t count;
+    const uint8_t *items = stub_datalog_items(T0, &count);
+    CHECK_EQ_INT(3, count);
+    if (items) {
+        const uint8_t *second = &items[HR_RECORD_SIZE];
+        CHECK_EQ_INT((T0 + 1) & 0xFF, second[HR_RECORD_TIME_OFFSET]);
+        CHECK_EQ_INT(UINT8_MAX, second[HR_RECORD_BPM_OFFSET]);
+        CHECK_EQ_INT(HR_BATCH_QUALITY_OK, second[HR_RECORD_QUALITY_OFFSET]);
+    }
+
+    datalog_end();
+    CHECK(!stub_datalog_is_open(T0));
+}
+
+static void deliver_uplink_and_start(void) {
+    uint8_t buffer[32];
+    DictionaryIterator iter;
+    dict_write_begin(&iter, buffer, sizeof(buffer));
+    dict_write_uint8(&iter, KEY_UPLINK, UPLINK_DATALOG);
+    dict_write_uint8(&iter, KEY_CMD, CMD_START);
+    uint32_t size = dict_write_end(&iter);
+    CHECK_EQ_INT(APP_MSG_OK, stub_appmsg_deliver(buffer, (uint16_t)size));
+}
+
+static void emit_hr(int seconds) {
+    for (int i = 0; i < seconds; i++) {
+        stub_health_set_value(HealthMetricHeartRateBPM, 150 + i % 3);
+        stub_health_emit(HealthEventHeartRateUpdate);
+        stub_advance_ms(1000);
+    }
+}
+
+static void deliver_frame(uint32_t elapsed_s) {
+    uint8_t frame[WORKOUT_FRAME_SIZE] = { WORKOUT_FRAME_VERSION };
+    frame[WORKOUT_ELAPSED_OFFSET] = (uint8_t)elapsed_s;
+    frame[WORKOUT_ELAPSED_OFFSET + 1] = (uint8_t)(elapsed_s >> 8);
+    test_deliver_data(KEY_WORKOUT, frame, sizeof(frame));
+}
+
+static uint32_t persisted_tag(void) {
+    uint32_t tag = 0;
+    persist_read_data(DATALOG_PERSIST_KEY_TAG, &tag, sizeof(tag));
+    return tag;
+}
+
+static uint32_t s_tag;
+
+static void scenario_workout_before_relaunch(void) {
+    s_tag = (uint32_t)time(NULL);
+    deliver_uplink_and_start();
+    emit_hr(20);
+
+    // A pause puts the start implied by the elapsed time a minute later
+    test_deliver_uint8(KEY_CMD, CMD_PAUSE);
+    stub_advance_ms(60 * 1000);
+    test_deliver_uint8(KEY_CMD, CMD_RESUME);
+    emit_hr(10);
+    CHECK_EQ_INT(s_tag, persisted_tag());
+}
+
+static void scenario_relaunch_joins_the_session(void) {
+    // The phone's next frame joins the workout in progress
+    deliver_frame(30);
+    CHECK_EQ_INT(WORKOUT_RUNNING, workout_state());
+    emit_hr(10);
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+
+    // One session for the whole workout, forgotten at STOP
+    uint32_t count;
+    stub_datalog_items(s_tag, &count);
+    CHECK_EQ_INT(40, count);
+    CHECK(!stub_datalog_is_open(s_tag));
+    CHECK(stub_datalog_items(s_tag + 60, &count) == NULL || count == 0);
+    CHECK(!persist_exists(DATALOG_PERSIST_KEY_TAG));
+}
+
+static void test_relaunch_resumes_the_session(void) {
+    test_run_app(scenario_workout_before_relaunch);
+    stub_app_exit();
+    test_run_app(scenario_relaunch_joins_the_session);
+}
+
+static void scenario_join_without_a_session(void) {
+    uint32_t started_by = (uint32_t)time(NULL) - 300;
+    deliver_frame(300);
+    emit_hr(5);
+    CHECK_EQ_INT(started_by, persisted_tag());
+
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+    uint32_t count;
+    stub_datalog_items(started_by, &count);
+    CHECK_EQ_INT(5, count);
+}
+
+static void test_join_without_a_session(void) {
+    datalog_init();
+    datalog_set_uplink(UPLINK_DATALOG);
+    test_run_app(scenario_join_without_a_session);
+}
+
+static void test_join_ignores_an_earlier_workout(void) {
+    // Left behind by a workout that never saw STOP
+    uint32_t stale = T0 - DATALOG_JOIN_MAX_PAUSED_S - 1;
+    persist_write_data(DATALOG_PERSIST_KEY_TAG, &stale, sizeof(stale));
+    datalog_init();
+    datalog_join(T0);
+    CHECK_EQ_INT(T0, persisted_tag());
+
+    // One a pause or two earlier is the same workout
+    datalog_join(T0 + 600);
+    CHECK_EQ_INT(T0, persisted_tag());
+    datalog_end();
+    CHECK(!persist_exists(DATALOG_PERSIST_KEY_TAG));
+}
+
+static uint32_t s_batches;
+static uint32_t s_live_values;
+
+static void count_batches(const uint8_t *data, uint16_t size, void *context) {
+    DictionaryIterator iter;
+    dict_read_begin_from_buffer(&iter, data, size);
+    if (dict_find(&iter, KEY_HR_BATCH)) {
+        s_batches++;
+    }
+    if (dict_find(&iter, KEY_HR_LIVE)) {
+        s_live_values++;
+    }
+}
+
+static void scenario_workout_history_goes_to_the_spool(void) {
+    stub_appmsg_set_auto_ack(true, 50);
+    s_batches = 0;
+    s_live_values = 0;
+    stub_appmsg_set_outbox_observer(count_batches, NULL);
+
+    uint32_t tag = (uint32_t)time(NULL);
+    deliver_uplink_and_start();
+    emit_hr(2 * HR_BATCH_SIZE);
+
+    // History in the spool; AppMessage only carries the display value
+    uint32_t count;
+    stub_datalog_items(tag, &count);
+    CHECK_EQ_INT(2 * HR_BATCH_SIZE, count);
+    CHECK_EQ_INT(0, s_batches);
+    CHECK_EQ_INT(2 * HR_BATCH_SIZE / HR_LIVE_INTERVAL_S, s_live_values);
+
+    // STOP flushes the rest and finishes the session
+    emit_hr(10);
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+    stub_datalog_items(tag, &count);
+    CHECK_EQ_INT(2 * HR_BATCH_SIZE + 10, count);
+    CHECK(!stub_datalog_is_open(tag));
+    CHECK_EQ_INT(0, s_batches);
+    stub_appmsg_set_outbox_observer(NULL, NULL);
+}
+
+static void test_workout_history_goes_to_the_spool(void) {
+    test_run_app(scenario_workout_history_goes_to_the_spool);
+}
+
+static void scenario_full_spool_falls_back_to_appmessage(void) {
+    stub_appmsg_set_auto_ack(true, 50);
+    stub_datalog_set_capacity(HR_BATCH_SIZE * HR_RECORD_SIZE);
+    s_batches = 0;
+    s_live_values = 0;
+    stub_appmsg_set_outbox_observer(count_batches, NULL);
+
+    deliver_uplink_and_start();
+    emit_hr(2 * HR_BATCH_SIZE);
+    CHECK_EQ_INT(HR_BATCH_SIZE, stub_get_stats()->datalog_items);
+    CHECK_EQ_INT(1, s_batches);
+    CHECK_EQ_INT(0, hr_pending_samples());
+    stub_appmsg_set_outbox_observer(NULL, NULL);
+}
+
+static void test_full_spool_falls_back_to_appmessage(void) {
+    test_run_app(scenario_full_spool_falls_back_to_appmessage);
+}
+
+static void scenario_live_value_is_not_journaled(void) {
+    uint32_t tag = (uint32_t)time(NULL);
+    deliver_uplink_and_start();
+    stub_appmsg_ack();
+
+    // One live value in flight, a newer one queued behind it
+    emit_hr(2 * HR_LIVE_INTERVAL_S);
+    CHECK(stub_appmsg_outbox_pending());
+    CHECK(appmsg_queue_depth() >= 2);
+
+    // Both are stale once the phone is gone; the history is in the spool
+    stub_connection_set(false);
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+    CHECK_EQ_INT(0, journal_sample_count());
+    uint32_t count;
+    stub_datalog_items(tag, &count);
+    CHECK_EQ_INT(2 * HR_LIVE_INTERVAL_S, count);
+}
+
+static void test_live_value_is_not_journaled(void) {
+    test_run_app(scenario_live_value_is_not_journaled);
+}
+
+// Times the phone stores a sample at each second from the start: HR_BATCH
+// samples and DataLogging records are history, HR_LIVE is not
+static uint8_t s_stored[2 * HR_LIVE_INTERVAL_S];
+static uint32_t s_start;
+
+static void store_sample(uint32_t timestamp) {
+    if (timestamp - s_start < sizeof(s_stored)) {
+        s_stored[timestamp - s_start]++;
+    }
+}
+
+static void store_batches(const uint8_t *data, uint16_t size, void *context) {
+    DictionaryIterator iter;
+    dict_read_begin_from_buffer(&iter, data, size);
+    Tuple *batch = dict_find(&iter, KEY_HR_BATCH);
+    if (batch && batch->length >= HR_BATCH_HEADER_SIZE) {
+        const uint8_t *frame = batch->value->data;
+        HRSample sample = {
+            .timestamp = (uint32_t)frame[HR_BATCH_BASE_TIME_OFFSET] |
+                         ((uint32_t)frame[HR_BATCH_BASE_TIME_OFFSET + 1] << 8) |
+                         ((uint32_t)frame[HR_BATCH_BASE_TIME_OFFSET + 2] << 16) |
+                         ((uint32_t)frame[HR_BATCH_BASE_TIME_OFFSET + 3] << 24),
+            .bpm = frame[HR_BATCH_BPM_OFFSET]
+        };
+        store_sample(sample.timestamp);
+        HRPackReader reader;
+        hrpack_reader_init(&reader, &frame[HR_BATCH_HEADER_SIZE], batch->length - HR_BATCH_HEADER_SIZE,
+                           frame[HR_BATCH_STEP_OFFSET], sample);
+        for (uint8_t i = 1; i < frame[HR_BATCH_COUNT_OFFSET] && hrpack_next(&reader, &sample); i++) {
+            store_sample(sample.timestamp);
+        }
+    }
+    if (dict_find(&iter, KEY_HR_LIVE)) {
+        s_live_values++;
+    }
+}
+
+static void scenario_each_sample_is_stored_once(void) {
+    stub_appmsg_set_auto_ack(true, 50);
+    memset(s_stored, 0, sizeof(s_stored));
+    s_live_values = 0;
+    s_start = (uint32_t)time(NULL);
+    stub_appmsg_set_outbox_observer(store_batches, NULL);
+
+    deliver_uplink_and_start();
+    emit_hr(HR_LIVE_INTERVAL_S);
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+    stub_advance_ms(1000);
+    stub_appmsg_set_outbox_observer(NULL, NULL);
+
+    uint32_t count;
+    const uint8_t *items = stub_datalog_items(s_start, &count);
+    for (uint32_t i = 0; items && i < count; i++) {
+        const uint8_t *time = &items[i * HR_RECORD_SIZE + HR_RECORD_TIME_OFFSET];
+        store_sample((uint32_t)time[0] | ((uint32_t)time[1] << 8) | ((uint32_t)time[2] << 16) |
+                     ((uint32_t)time[3] << 24));
+    }
+
+    // The display got its live value, and history holds every second once
+    CHECK_EQ_INT(1, s_live_values);
+    for (int i = 0; i < HR_LIVE_INTERVAL_S; i++) {
+        CHECK_EQ_INT(1, s_stored[i]);
+    }
+}
+
+static void test_each_sample_is_stored_once(void) {
+    test_run_app(scenario_each_sample_is_stored_once);
+}
+
+void run_datalog_tests(void) {
+    RUN_TEST(test_uplink_survives_a_restart);
+    RUN_TEST(test_writes_need_a_workout);
+    RUN_TEST(test_relaunch_resumes_the_session);
+    RUN_TEST(test_join_without_a_session);
+    RUN_TEST(test_join_ignores_an_earlier_workout);
+    RUN_TEST(test_workout_history_goes_to_the_spool);
+    RUN_TEST(test_full_spool_falls_back_to_appmessage);
+    RUN_TEST(test_live_value_is_not_journaled);
+    RUN_TEST(test_each_sample_is_stored_once);
+}
@@ -0,0 +1,72 @@
+#include "test.h"
+
+#include "format.h"
+
+static void test_hr_text(void) {
+    char text[DISPLAY_TEXT_SIZE];
+    format_hr(text, 150);
+    CHECK_EQ_STR("150 BPM", text);
+    format_hr(text, 7);
+    CHECK_EQ_STR("7 BPM", text);
+    format_hr(text, 0);
+    CHECK_EQ_STR("-- BPM", text);
+}
+
+static void test_hr_stats_text(void) {
+    char text[DISPLAY_TEXT_SIZE];
+    format_hr_stats(text, 152, 148, 171);
+    CHECK_EQ_STR("30s 152 avg 148 max 171", text);
+    format_hr_stats(text, 0, 148, 171);
+    CHECK_EQ_STR("avg 148 max 171", text);
+    format_hr_stats(text, 0, 0, 0);
+    CHECK_EQ_STR("", text);
+
+    // Out-of-range values are clamped rather than overrunning the buffer
+    format_hr_stats(text, 9999, 1000, UINT16_MAX);
+    CHECK_EQ_STR("30s 220 avg 220 max 220", text);
+    CHECK(strlen(text) < DISPLAY_TEXT_SIZE);
+}
+
+static void test_pace_text(void) {
+    char text[DISPLAY_TEXT_SIZE];
+    format_pace(text, 330);
+    CHECK_EQ_STR("5:30/km", text);
+    format_pace(text, 605);
+    CHECK_EQ_STR("10:05/km", text);
+    format_pace(text, PACE_MAX);
+    CHECK(strlen(text) < DISPLAY_TEXT_SIZE);
+    format_pace(text, 0);
+    CHECK_EQ_STR("--:--/km", text);
+}
+
+static void test_duration_text(void) {
+    char text[DISPLAY_TEXT_SIZE];
+    format_duration(text, 0);
+    CHECK_EQ_STR("00:00:00", text);
+    format_duration(text, 3723);
+    CHECK_EQ_STR("01:02:03", text);
+    format_duration(text, 100 * 3600 + 59);
+    CHECK_EQ_STR("100:00:59", text);
+    format_duration(text, UINT32_MAX);
+    CHECK_EQ_STR("1193046:28:15", text);
+}
+
+static void test_matches_printf(void) {
+    // Spot-check against the snprintf formats these helpers replace
+    char text[DISPLAY_TEXT_SIZE];
+    char expected[32];
+    for (uint32_t s = 0; s < 7200; s += 241) {
+        format_duration(text, s);
+        snprintf(expected, sizeof(expected), "%02d:%02d:%02d",
+                 (int)(s / 3600), (int)(s / 60 % 60), (int)(s % 60));
+        CHECK_EQ_STR(expected, text);
+    }
+}
+
+void run_format_tests(void) {
+    RUN_TEST(test_hr_text);
+    RUN_TEST(test_hr_stats_text);
+    RUN_TEST(test_pace_text);
+    RUN_TEST(test_duration_text);
+    RUN_TEST(test_matches_printf);
+}
@@ -0,0 +1,331 @@
+#include "test.h"
+
+#include "appmsg.h"
+#include "hr.h"
+#include "journal.h"
+#include "hrpack.h"
+#include "hrquality.h"
+#include "zones.h"
+
+// Decodes the KEY_HR_BATCH tuple of the last sent message
+static int last_sent_batch(HRSample *samples, int max_samples) {
+    DictionaryIterator sent;
+    if (!stub_appmsg_last_sent(&sent)) {
+        return -1;
+    }
+    Tuple *batch = dict_find(&sent, KEY_HR_BATCH);
+    if (!batch || batch->type != TUPLE_BYTE_ARRAY) {
+        return -1;
+    }
+
+    const uint8_t *data = batch->value->data;
+    const uint8_t *base = &data[HR_BATCH_BASE_TIME_OFFSET];
+    HRSample first = {
+        .timestamp = base[0] | (base[1] << 8) | (base[2] << 16) | ((uint32_t)base[3] << 24),
+        .bpm = data[HR_BATCH_BPM_OFFSET],
+        .quality = data[HR_BATCH_QUALITY_OFFSET]
+    };
+    int count = data[HR_BATCH_COUNT_OFFSET];
+    HRPackReader reader;
+    hrpack_reader_init(&reader, &data[HR_BATCH_HEADER_SIZE], batch->length - HR_BATCH_HEADER_SIZE,
+                       data[HR_BATCH_STEP_OFFSET], first);
+    for (int i = 0; i < count && i < max_samples; i++) {
+        if (i == 0) {
+            samples[i] = first;
+        } else {
+            CHECK(hrpack_next(&reader, &samples[i]));
+        }
+    }
+    return count;
+}
+
+static void emit_hr(HealthValue bpm) {
+    stub_health_set_value(HealthMetricHeartRateBPM, bpm);
+    stub_health_emit(HealthEventHeartRateUpdate);
+}
+
+// One reading a second, as the sensor delivers them at the fast period
+static void emit_hr_each_second(HealthValue bpm, int count) {
+    for (int i = 0; i < count; i++) {
+        emit_hr(bpm);
+        stub_advance_ms(1000);
+    }
+}
+
+static void scenario_samples_upload_in_one_batch(void) {
+    hr_start_monitoring();
+    CHECK_EQ_INT(1, stub_health_sample_period());
+
+    uint32_t start = (uint32_t)time(NULL);
+    for (int i = 0; i < HR_BATCH_SIZE; i++) {
+        emit_hr(140 + i);
+        CHECK_EQ_INT(140 + i, g_app_state.current_hr);
+        if (i < HR_BATCH_SIZE - 1) {
+            CHECK_EQ_INT(0, stub_get_stats()->outbox_sends);
+        }
+        stub_advance_ms(1000);
+    }
+
+    HRSample samples[HR_BATCH_SIZE];
+    CHECK_EQ_INT(1, stub_get_stats()->outbox_sends);
+    CHECK_EQ_INT(HR_BATCH_SIZE, last_sent_batch(samples, HR_BATCH_SIZE));
+    CHECK_EQ_INT(start, samples[0].timestamp);
+    CHECK_EQ_INT(140, samples[0].bpm);
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, samples[0].quality);
+    CHECK_EQ_INT(start + HR_BATCH_SIZE - 1, samples[HR_BATCH_SIZE - 1].timestamp);
+    CHECK_EQ_INT(140 + HR_BATCH_SIZE - 1, samples[HR_BATCH_SIZE - 1].bpm);
+    CHECK_EQ_INT(0, hr_pending_samples());
+}
+
+static void test_samples_upload_in_one_batch(void) {
+    test_run_app(scenario_samples_upload_in_one_batch);
+}
+
+static void scenario_partial_batch_flushes_on_age(void) {
+    hr_start_monitoring();
+    emit_hr(120);
+    emit_hr(121);
+
+    stub_advance_ms(HR_BATCH_MAX_AGE_MS - 1);
+    CHECK_EQ_INT(0, stub_get_stats()->outbox_sends);
+    stub_advance_ms(1);
+    CHECK_EQ_INT(1, stub_get_stats()->outbox_sends);
+
+    HRSample samples[2];
+    CHECK_EQ_INT(2, last_sent_batch(samples, 2));
+    CHECK_EQ_INT(121, samples[1].bpm);
+}
+
+static void test_partial_batch_flushes_on_age(void) {
+    test_run_app(scenario_partial_batch_flushes_on_age);
+}
+
+static void scenario_batches_queue_behind_unacked_message(void) {
+    hr_start_monitoring();
+    emit_hr_each_second(130, HR_BATCH_SIZE);
+    CHECK_EQ_INT(1, stub_get_stats()->outbox_sends);
+
+    // Previous batch is still waiting for its ACK
+    emit_hr_each_second(131, HR_BATCH_SIZE);
+    CHECK_EQ_INT(0, hr_pending_samples());
+    CHECK_EQ_INT(2, appmsg_queue_depth());
+    CHECK_EQ_INT(0, stub_get_stats()->outbox_busy);
+
+    stub_appmsg_ack();
+    CHECK_EQ_INT(2, stub_get_stats()->outbox_sends);
+    HRSample samples[HR_BATCH_SIZE];
+    CHECK_EQ_INT(HR_BATCH_SIZE, last_sent_batch(samples, HR_BATCH_SIZE));
+    CHECK_EQ_INT(131, samples[0].bpm);
+}
+
+static void test_batches_queue_behind_unacked_message(void) {
+    test_run_app(scenario_batches_queue_behind_unacked_message);
+}
+
+static void scenario_full_ring_journals_oldest(void) {
+    hr_start_monitoring();
+    int queued = APPMSG_QUEUE_CAPACITY * HR_BATCH_SIZE;
+    emit_hr_each_second(101, queued + HR_RING_CAPACITY + HR_BATCH_SIZE);
+    CHECK_EQ_INT(APPMSG_QUEUE_CAPACITY, appmsg_queue_depth());
+    CHECK_EQ_INT(HR_RING_CAPACITY, hr_pending_samples());
+    CHECK_EQ_INT(HR_BATCH_SIZE, journal_sample_count());
+}
+
+static void test_full_ring_journals_oldest(void) {
+    test_run_app(scenario_full_ring_journals_oldest);
+}
+
+static void scenario_invalid_reading_is_ignored(void) {
+    hr_start_monitoring();
+    emit_hr(HealthValueInvalid);
+
+    CHECK_EQ_INT(0, g_app_state.current_hr);
+    CHECK_EQ_INT(0, hr_pending_samples());
+}
+
+static void test_invalid_reading_is_ignored(void) {
+    test_run_app(scenario_invalid_reading_is_ignored);
+}
+
+static void scenario_implausible_reading_is_dropped(void) {
+    hr_start_monitoring();
+    emit_hr_each_second(140, 3);
+    emit_hr(140 + HR_QUALITY_JUMP_BAD_BPM + 1);
+    CHECK_EQ_INT(140, g_app_state.current_hr);
+    CHECK_EQ_INT(3, hr_pending_samples());
+
+    // Repeated sensor dropouts mark the readings after them down, but keep them
+    stub_advance_ms(1000);
+    emit_hr(HealthValueInvalid);
+    emit_hr(HealthValueInvalid);
+    emit_hr(141);
+    CHECK_EQ_INT(141, g_app_state.current_hr);
+    CHECK_EQ_INT(4, hr_pending_samples());
+
+    HRSample samples[4];
+    hr_flush_samples();
+    CHECK_EQ_INT(3, last_sent_batch(samples, 4));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, samples[0].quality);
+
+    // A frame carries one quality, so the OK reading goes in its own
+    stub_appmsg_ack();
+    CHECK_EQ_INT(1, last_sent_batch(samples, 4));
+    CHECK_EQ_INT(141, samples[0].bpm);
+    CHECK_EQ_INT(HR_BATCH_QUALITY_OK, samples[0].quality);
+}
+
+static void test_implausible_reading_is_dropped(void) {
+    test_run_app(scenario_implausible_reading_is_dropped);
+}
+
+static void scenario_stats_leave_out_paused_time(void) {
+    hr_start_monitoring();
+    CHECK_EQ_STR("", g_app_state.text.hr_stats);
+    emit_hr_each_second(140, 10);
+    CHECK_EQ_STR("30s 140 avg 140 max 140", g_app_state.text.hr_stats);
+
+    hr_set_workout_paused(true);
+    emit_hr(100);
+    stub_advance_ms(60000);
+    hr_set_workout_paused(false);
+    emit_hr(160);
+    CHECK_EQ_STR("30s 142 avg 142 max 160", g_app_state.text.hr_stats);
+
+    // A new workout starts over
+    hr_stop_monitoring();
+    hr_start_monitoring();
+    CHECK_EQ_STR("", g_app_state.text.hr_stats);
+}
+
+static void test_stats_leave_out_paused_time(void) {
+    test_run_app(scenario_stats_leave_out_paused_time);
+}
+
+static void scenario_zone_transitions_color_and_buzz(void) {
+    hr_start_monitoring();
+    emit_hr_each_second(130, 3);
+    CHECK_EQ_INT(2, g_app_state.hr_zone);
+
+    // Up into zone 3 and then 4, one pulse each once the zone holds
+    for (HealthValue bpm = 132; bpm <= 140; bpm += 2) {
+        emit_hr_each_second(bpm, 1);
+    }
+    emit_hr_each_second(140, ZONES_CONFIRM_S);
+    CHECK_EQ_INT(3, g_app_state.hr_zone);
+    CHECK_EQ_INT(1, stub_get_stats()->vibe_pulses);
+    for (HealthValue bpm = 142; bpm <= 160; bpm += 2) {
+        emit_hr_each_second(bpm, 1);
+    }
+    emit_hr_each_second(160, ZONES_CONFIRM_S);
+    CHECK_EQ_INT(4, g_app_state.hr_zone);
+    CHECK_EQ_INT(2, stub_get_stats()->vibe_pulses);
+
+    // Paused readings neither change the zone nor buzz
+    hr_set_workout_paused(true);
+    emit_hr_each_second(100, 2 * ZONES_CONFIRM_S);
+    CHECK_EQ_INT(4, g_app_state.hr_zone);
+    hr_set_workout_paused(false);
+
+    // Straight down through zone 3 to 2, two pulses
+    emit_hr_each_second(160, 1);
+    for (HealthValue bpm = 158; bpm >= 126; bpm -= 2) {
+        emit_hr_each_second(bpm, 1);
+    }
+    emit_hr_each_second(126, ZONES_CONFIRM_S);
+    CHECK_EQ_INT(2, g_app_state.hr_zone);
+    CHECK_EQ_INT(4, stub_get_stats()->vibe_pulses);
+
+    hr_stop_monitoring();
+    CHECK_EQ_INT(0, g_app_state.hr_zone);
+}
+
+static void test_zone_transitions_color_and_buzz(void) {
+    test_run_app(scenario_zone_transitions_color_and_buzz);
+}
+
+static void scenario_stop_resets_sample_period(void) {
+    hr_start_monitoring();
+    hr_stop_monitoring();
+    CHECK_EQ_INT(0, stub_health_sample_period());
+}
+
+static void test_stop_resets_sample_period(void) {
+    test_run_app(scenario_stop_resets_sample_period);
+    CHECK(!stub_health_is_subscribed());
+}
+
+static void emit_steady_hr(int count, HealthValue bpm) {
+    for (int i = 0; i < count; i++) {
+        emit_hr(bpm + (i % 2) * 2);
+        stub_advance_ms(1000);
+    }
+}
+
+static void scenario_stable_hr_relaxes_sample_period(void) {
+    hr_start_monitoring();
+    emit_steady_hr(HR_STABLE_WINDOW - 1, 150);
+    CHECK_EQ_INT(HR_PERIOD_FAST_S, stub_health_sample_period());
+
+    emit_steady_hr(1, 150);
+    CHECK_EQ_INT(HR_PERIOD_STABLE_S, stub_health_sample_period());
+    CHECK_EQ_INT(HR_PERIOD_STABLE_S, hr_sample_period());
+
+    // A jump is a transition: back to 1 s until the window refills
+    emit_hr(150 + HR_TRANSITION_BPM);
+    CHECK_EQ_INT(HR_PERIOD_FAST_S, stub_health_sample_period());
+}
+
+static void test_stable_hr_relaxes_sample_period(void) {
+    test_run_app(scenario_stable_hr_relaxes_sample_period);
+}
+
+static void scenario_pause_slows_sampling_until_resume(void) {
+    hr_start_monitoring();
+    hr_set_workout_paused(true);
+    CHECK_EQ_INT(HR_PERIOD_SLOW_S, stub_health_sample_period());
+
+    emit_steady_hr(HR_STABLE_WINDOW, 150);
+    CHECK_EQ_INT(HR_PERIOD_SLOW_S, stub_health_sample_period());
+
+    hr_set_workout_paused(false);
+    CHECK_EQ_INT(HR_PERIOD_FAST_S, stub_health_sample_period());
+}
+
+static void test_pause_slows_sampling_until_resume(void) {
+    test_run_app(scenario_pause_slows_sampling_until_resume);
+}
+
+static void scenario_low_battery_slows_stable_sampling(void) {
+    hr_start_monitoring();
+    CHECK(stub_battery_is_subscribed());
+    emit_steady_hr(HR_STABLE_WINDOW, 150);
+    CHECK_EQ_INT(HR_PERIOD_STABLE_S, stub_health_sample_period());
+
+    stub_battery_set(HR_BATTERY_LOW_PERCENT, false);
+    CHECK_EQ_INT(HR_PERIOD_SLOW_S, stub_health_sample_period());
+
+    stub_battery_set(HR_BATTERY_LOW_PERCENT, true);
+    CHECK_EQ_INT(HR_PERIOD_STABLE_S, stub_health_sample_period());
+
+    hr_stop_monitoring();
+    CHECK(!stub_battery_is_subscribed());
+}
+
+static void test_low_battery_slows_stable_sampling(void) {
+    test_run_app(scenario_low_battery_slows_stable_sampling);
+}
+
+void run_hr_tests(void) {
+    RUN_TEST(test_samples_upload_in_one_batch);
+    RUN_TEST(test_partial_batch_flushes_on_age);
+    RUN_TEST(test_batches_queue_behind_unacked_message);
+    RUN_TEST(test_full_ring_journals_oldest);
+    RUN_TEST(test_invalid_reading_is_ignored);
+    RUN_TEST(test_implausible_reading_is_dropped);
+    RUN_TEST(test_stats_leave_out_paused_time);
+    RUN_TEST(test_zone_transitions_color_and_buzz);
+    RUN_TEST(test_stop_resets_sample_period);
+    RUN_TEST(test_stable_hr_relaxes_sample_period);
+    RUN_TEST(test_pause_slows_sampling_until_resume);
+    RUN_TEST(test_low_battery_slows_stable_sampling);
+}
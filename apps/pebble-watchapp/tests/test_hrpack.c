@@ -0,0 +1,122 @@
+#include "test.h"
+
+#include "hrpack.h"
+
+// Packs samples into a stream of max_bytes, then decodes it back
+static uint8_t round_trip(const HRSample *samples, uint8_t count, uint8_t max_bytes, HRSample *decoded,
+                          uint8_t *length) {
+    uint8_t stream[HR_BATCH_STREAM_MAX];
+    uint8_t step = hrpack_choose_step(samples, count);
+    uint8_t packed = hrpack_encode(samples, count, step, stream, max_bytes, length);
+    if (packed == 0) {
+        return 0;
+    }
+
+    HRPackReader reader;
+    hrpack_reader_init(&reader, stream, *length, step, samples[0]);
+    decoded[0] = samples[0];
+    for (uint8_t i = 1; i < packed; i++) {
+        CHECK(hrpack_next(&reader, &decoded[i]));
+    }
+    return packed;
+}
+
+static void test_steady_minute_packs_in_nibbles(void) {
+    HRSample samples[60];
+    for (int i = 0; i < 60; i++) {
+        samples[i].timestamp = 1700000000 + i;
+        samples[i].bpm = (uint16_t)(150 + (i % 8 < 4 ? i % 4 : 4 - i % 4));
+    }
+
+    HRSample decoded[60];
+    uint8_t length;
+    CHECK_EQ_INT(60, round_trip(samples, 60, HR_BATCH_STREAM_MAX, decoded, &length));
+    // One nibble per sample after the first, the last byte half padding
+    CHECK_EQ_INT(30, length);
+    for (int i = 0; i < 60; i++) {
+        CHECK_EQ_INT(samples[i].timestamp, decoded[i].timestamp);
+        CHECK_EQ_INT(samples[i].bpm, decoded[i].bpm);
+    }
+}
+
+static void test_gaps_and_jumps_escape(void) {
+    HRSample samples[] = {
+        { 1700000000, 140, HR_BATCH_QUALITY_GOOD }, { 1700000005, 141, HR_BATCH_QUALITY_GOOD }, { 1700000010, 133, HR_BATCH_QUALITY_GOOD },
+        { 1700000011, 133, HR_BATCH_QUALITY_GOOD }, { 1700000311, 60, HR_BATCH_QUALITY_GOOD }, { 1700000316, 255, HR_BATCH_QUALITY_GOOD }
+    };
+    uint8_t count = sizeof(samples) / sizeof(samples[0]);
+    CHECK_EQ_INT(5, hrpack_choose_step(samples, count));
+
+    HRSample decoded[6];
+    uint8_t length;
+    CHECK_EQ_INT(count, round_trip(samples, count, HR_BATCH_STREAM_MAX, decoded, &length));
+    for (int i = 0; i < count; i++) {
+        CHECK_EQ_INT(samples[i].timestamp, decoded[i].timestamp);
+        CHECK_EQ_INT(samples[i].bpm, decoded[i].bpm);
+    }
+}
+
+static void test_stops_when_full(void) {
+    HRSample samples[20];
+    for (int i = 0; i < 20; i++) {
+        samples[i].timestamp = 1700000000 + i;
+        samples[i].bpm = 140;
+    }
+
+    // Four bytes hold eight plain codes
+    HRSample decoded[20];
+    uint8_t length;
+    CHECK_EQ_INT(9, round_trip(samples, 20, 4, decoded, &length));
+    CHECK_EQ_INT(4, length);
+
+    // An escape that would straddle the end waits for the next frame
+    samples[8].timestamp = samples[7].timestamp + 2;
+    CHECK_EQ_INT(8, round_trip(samples, 20, 4, decoded, &length));
+}
+
+static void test_clock_going_back_ends_frame(void) {
+    HRSample samples[] = { { 1700000010, 140, HR_BATCH_QUALITY_GOOD }, { 1700000011, 141, HR_BATCH_QUALITY_GOOD }, { 1700000005, 142, HR_BATCH_QUALITY_GOOD } };
+    uint8_t stream[HR_BATCH_STREAM_MAX];
+    uint8_t length;
+    CHECK_EQ_INT(1, hrpack_choose_step(samples, 3));
+    CHECK_EQ_INT(2, hrpack_encode(samples, 3, 1, stream, sizeof(stream), &length));
+    CHECK_EQ_INT(1, length);
+}
+
+static void test_clamps_bpm_to_a_byte(void) {
+    HRSample samples[] = { { 1700000000, 250, HR_BATCH_QUALITY_GOOD }, { 1700000001, 300, HR_BATCH_QUALITY_GOOD } };
+    HRSample decoded[2];
+    uint8_t length;
+    CHECK_EQ_INT(2, round_trip(samples, 2, HR_BATCH_STREAM_MAX, decoded, &length));
+    CHECK_EQ_INT(UINT8_MAX, decoded[1].bpm);
+}
+
+static void test_malformed_stream_stops(void) {
+    HRSample first = { 1700000000, 140, HR_BATCH_QUALITY_GOOD };
+    HRSample sample;
+    HRPackReader reader;
+
+    // Escape with its delta cut off
+    uint8_t truncated[] = { 0xF1 };
+    hrpack_reader_init(&reader, truncated, sizeof(truncated), 1, first);
+    CHECK(!hrpack_next(&reader, &sample));
+
+    // Varint that never ends
+    uint8_t endless[] = { 0xF8, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88 };
+    hrpack_reader_init(&reader, endless, sizeof(endless), 1, first);
+    CHECK(!hrpack_next(&reader, &sample));
+
+    // Delta below zero BPM
+    uint8_t negative[] = { 0xF1, 0xFF, 0x84, 0x00 };
+    hrpack_reader_init(&reader, negative, sizeof(negative), 1, first);
+    CHECK(!hrpack_next(&reader, &sample));
+}
+
+void run_hrpack_tests(void) {
+    RUN_TEST(test_steady_minute_packs_in_nibbles);
+    RUN_TEST(test_gaps_and_jumps_escape);
+    RUN_TEST(test_stops_when_full);
+    RUN_TEST(test_clock_going_back_ends_frame);
+    RUN_TEST(test_clamps_bpm_to_a_byte);
+    RUN_TEST(test_malformed_stream_stops);
+}
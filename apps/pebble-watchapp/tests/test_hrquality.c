@@ -0,0 +1,85 @@
+#include "test.h"
+
+#include "hrquality.h"
+
+#define T0 1700000000
+
+static void test_steady_readings_are_good(void) {
+    hrquality_reset();
+    for (int i = 0; i < 10; i++) {
+        CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0 + i, (uint16_t)(140 + i % 3), 1));
+    }
+}
+
+static void test_out_of_range_is_bad(void) {
+    hrquality_reset();
+    CHECK_EQ_INT(HR_BATCH_QUALITY_BAD, hrquality_rate(T0, HR_QUALITY_MIN_BPM - 1, 1));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_BAD, hrquality_rate(T0 + 1, HR_QUALITY_MAX_BPM + 1, 1));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0 + 2, HR_QUALITY_MAX_BPM, 1));
+}
+
+static void test_spike_is_rejected(void) {
+    hrquality_reset();
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0, 140, 1));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_OK, hrquality_rate(T0 + 1, 140 + HR_QUALITY_JUMP_GOOD_BPM + 1, 1));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_BAD, hrquality_rate(T0 + 2, 200, 1));
+
+    // Judged against the last accepted reading, not the spike
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0 + 3, 150, 1));
+}
+
+static void test_second_reading_confirms_new_level(void) {
+    hrquality_reset();
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0, 100, 1));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_BAD, hrquality_rate(T0 + 1, 160, 1));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_OK, hrquality_rate(T0 + 2, 162, 1));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0 + 3, 163, 1));
+}
+
+static void test_jump_allowance_grows_with_gap(void) {
+    hrquality_reset();
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0, 120, 5));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0 + 5, 120 + HR_QUALITY_JUMP_GOOD_BPM + 4 * HR_QUALITY_SLEW_BPM_PER_S, 5));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_OK, hrquality_rate(T0 + 10, 170, 5));
+}
+
+static void test_dropout_skips_jump_check(void) {
+    hrquality_reset();
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0, 100, 1));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0 + HR_QUALITY_DROPOUT_PERIODS + 1, 170, 1));
+}
+
+static void test_invalid_readings_cap_quality(void) {
+    hrquality_reset();
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0, 140, 1));
+
+    // An isolated dropout costs nothing, two in a row a reading at OK
+    hrquality_note_invalid();
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0 + 1, 140, 1));
+    for (int i = 2; i < 2 + HR_QUALITY_INVALID_WEIGHT; i++) {
+        CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0 + i, 140, 1));
+    }
+    hrquality_note_invalid();
+    hrquality_note_invalid();
+    CHECK_EQ_INT(HR_BATCH_QUALITY_OK, hrquality_rate(T0 + 8, 140, 1));
+    for (int i = 9; i < 9 + HR_QUALITY_INVALID_OK; i++) {
+        CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, hrquality_rate(T0 + i, 140, 1));
+    }
+
+    // A run of them marks readings BAD until the score decays
+    for (int i = 0; i < HR_QUALITY_INVALID_BAD / HR_QUALITY_INVALID_WEIGHT; i++) {
+        hrquality_note_invalid();
+    }
+    CHECK_EQ_INT(HR_BATCH_QUALITY_BAD, hrquality_rate(T0 + 30, 140, 1));
+    CHECK_EQ_INT(HR_BATCH_QUALITY_OK, hrquality_rate(T0 + 31, 140, 1));
+}
+
+void run_hrquality_tests(void) {
+    RUN_TEST(test_steady_readings_are_good);
+    RUN_TEST(test_out_of_range_is_bad);
+    RUN_TEST(test_spike_is_rejected);
+    RUN_TEST(test_second_reading_confirms_new_level);
+    RUN_TEST(test_jump_allowance_grows_with_gap);
+    RUN_TEST(test_dropout_skips_jump_check);
+    RUN_TEST(test_invalid_readings_cap_quality);
+}
@@ -0,0 +1,118 @@
+#include "test.h"
+
+#include "hrstats.h"
+#include "zones.h"
+
+#define T0 1700000000
+
+static void test_average_is_time_weighted(void) {
+    hrstats_reset();
+    // 140 for one second, then 160 standing for nine
+    hrstats_add(T0, 140);
+    hrstats_add(T0 + 9, 160);
+
+    HRStats stats;
+    hrstats_get(&stats);
+    CHECK_EQ_INT(10, stats.seconds);
+    CHECK_EQ_INT(158, stats.avg_bpm);
+    CHECK_EQ_INT(140, stats.min_bpm);
+    CHECK_EQ_INT(160, stats.max_bpm);
+}
+
+static void test_empty_stats_are_zero(void) {
+    hrstats_reset();
+    HRStats stats;
+    hrstats_get(&stats);
+    CHECK_EQ_INT(0, stats.seconds);
+    CHECK_EQ_INT(0, stats.avg_bpm);
+    CHECK_EQ_INT(0, stats.max_bpm);
+    CHECK_EQ_INT(0, hrstats_rolling_mean());
+}
+
+static void test_zone_time_adds_up(void) {
+    zones_init();
+    hrstats_reset();
+    uint32_t t = T0;
+    hrstats_add(t, 100);
+    for (int i = 0; i < 20; i++) {
+        hrstats_add(t += 1, 120);
+    }
+    for (int i = 0; i < 6; i++) {
+        hrstats_add(t += 5, 180);
+    }
+
+    HRStats stats;
+    hrstats_get(&stats);
+    CHECK_EQ_INT(1, stats.zone_s[0]);
+    CHECK_EQ_INT(20, stats.zone_s[1]);
+    CHECK_EQ_INT(30, stats.zone_s[4]);
+    CHECK_EQ_INT(51, stats.seconds);
+}
+
+static void test_time_below_zone_one_is_in_no_zone(void) {
+    const uint8_t lower[HR_STATS_ZONE_COUNT] = { 100, 120, 140, 160, 180 };
+    zones_init();
+    CHECK(zones_set_thresholds(lower));
+    hrstats_reset();
+    hrstats_add(T0, 90);
+    hrstats_add(T0 + 10, 130);
+
+    HRStats stats;
+    hrstats_get(&stats);
+    CHECK_EQ_INT(11, stats.seconds);
+    CHECK_EQ_INT(0, stats.zone_s[0]);
+    CHECK_EQ_INT(10, stats.zone_s[1]);
+}
+
+static void test_rolling_mean_covers_the_window(void) {
+    hrstats_reset();
+    uint32_t t = T0;
+    hrstats_add(t, 100);
+    for (int i = 1; i < HR_STATS_WINDOW_S; i++) {
+        hrstats_add(t += 1, 100);
+    }
+    CHECK_EQ_INT(100, hrstats_rolling_mean());
+
+    // Half the window at 160
+    for (int i = 0; i < HR_STATS_WINDOW_S / 2; i++) {
+        hrstats_add(t += 1, 160);
+    }
+    CHECK_EQ_INT(130, hrstats_rolling_mean());
+
+    // A whole window later only 160 is left
+    hrstats_add(t += HR_STATS_WINDOW_S, 160);
+    CHECK_EQ_INT(160, hrstats_rolling_mean());
+}
+
+static void test_long_gap_holds_at_most_the_limit(void) {
+    hrstats_reset();
+    hrstats_add(T0, 150);
+    hrstats_add(T0 + 600, 150);
+
+    HRStats stats;
+    hrstats_get(&stats);
+    CHECK_EQ_INT(1 + HR_STATS_HOLD_MAX_S, stats.seconds);
+    CHECK_EQ_INT(150, hrstats_rolling_mean());
+}
+
+static void test_break_drops_the_time_between(void) {
+    hrstats_reset();
+    hrstats_add(T0, 150);
+    hrstats_break();
+    hrstats_add(T0 + 20, 120);
+
+    HRStats stats;
+    hrstats_get(&stats);
+    CHECK_EQ_INT(2, stats.seconds);
+    CHECK_EQ_INT(135, stats.avg_bpm);
+}
+
+void run_hrstats_tests(void) {
+    RUN_TEST(test_average_is_time_weighted);
+    RUN_TEST(test_empty_stats_are_zero);
+    RUN_TEST(test_zone_time_adds_up);
+    RUN_TEST(test_time_below_zone_one_is_in_no_zone);
+    RUN_TEST(test_rolling_mean_covers_the_window);
+    RUN_TEST(test_long_gap_holds_at_most_the_limit);
+    RUN_TEST(test_break_drops_the_time_between);
+}
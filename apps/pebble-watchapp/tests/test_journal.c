@@ -0,0 +1,195 @@
+#include "test.h"
+
+#include "appmsg.h"
+#include "hr.h"
+#include "journal.h"
+
+static void append_run(uint32_t start, uint16_t count, uint16_t bpm) {
+    for (uint16_t i = 0; i < count; i++) {
+        HRSample sample = { .timestamp = start + i, .bpm = (uint16_t)(bpm + i % 3) };
+        journal_append(&sample, 1);
+    }
+}
+
+static void test_samples_come_back_in_order(void) {
+    journal_init();
+    append_run(1000, 30, 140);
+    CHECK_EQ_INT(30, journal_sample_count());
+
+    HRSample samples[20];
+    CHECK_EQ_INT(20, journal_peek(samples, 20));
+    CHECK_EQ_INT(1000, samples[0].timestamp);
+    CHECK_EQ_INT(140, samples[0].bpm);
+    CHECK_EQ_INT(1019, samples[19].timestamp);
+    CHECK_EQ_INT(141, samples[19].bpm);
+
+    journal_consume(20);
+    CHECK_EQ_INT(10, journal_sample_count());
+    CHECK_EQ_INT(10, journal_peek(samples, 20));
+    CHECK_EQ_INT(1020, samples[0].timestamp);
+
+    journal_consume(10);
+    CHECK_EQ_INT(0, journal_sample_count());
+    CHECK_EQ_INT(0, journal_peek(samples, 20));
+}
+
+static void test_survives_restart(void) {
+    journal_init();
+    append_run(5000, JOURNAL_CHUNK_SAMPLES + 7, 150);
+    journal_consume(3);
+    journal_deinit();
+
+    journal_init();
+    CHECK_EQ_INT(JOURNAL_CHUNK_SAMPLES + 4, journal_sample_count());
+    HRSample sample;
+    CHECK_EQ_INT(1, journal_peek(&sample, 1));
+    CHECK_EQ_INT(5003, sample.timestamp);
+
+    // Appending continues the reopened chunk
+    append_run(5000 + JOURNAL_CHUNK_SAMPLES + 7, 1, 150);
+    CHECK_EQ_INT(JOURNAL_CHUNK_SAMPLES + 5, journal_sample_count());
+}
+
+static void test_unsynced_samples_are_lost_cleanly(void) {
+    journal_init();
+    append_run(100, JOURNAL_SYNC_SAMPLES + 3, 120);
+    CHECK(stub_get_stats()->persist_writes > 0);
+
+    // Restart without journal_deinit, as after a crash
+    journal_init();
+    CHECK_EQ_INT(JOURNAL_SYNC_SAMPLES, journal_sample_count());
+    append_run(200, 1, 120);
+    CHECK_EQ_INT(JOURNAL_SYNC_SAMPLES + 1, journal_sample_count());
+
+    HRSample samples[JOURNAL_SYNC_SAMPLES + 1];
+    CHECK_EQ_INT(JOURNAL_SYNC_SAMPLES + 1, journal_peek(samples, JOURNAL_SYNC_SAMPLES + 1));
+    CHECK_EQ_INT(200, samples[JOURNAL_SYNC_SAMPLES].timestamp);
+}
+
+static void test_gap_starts_new_chunk(void) {
+    journal_init();
+    append_run(1000, 2, 130);
+    append_run(1000 + 10 * 60, 2, 130);
+    append_run(500, 1, 130);
+    CHECK_EQ_INT(5, journal_sample_count());
+
+    HRSample samples[4];
+    CHECK_EQ_INT(2, journal_peek(samples, 4));
+    journal_consume(2);
+    CHECK_EQ_INT(2, journal_peek(samples, 4));
+    CHECK_EQ_INT(1600, samples[0].timestamp);
+    CHECK_EQ_INT(1601, samples[1].timestamp);
+    journal_consume(2);
+    CHECK_EQ_INT(1, journal_peek(samples, 4));
+    CHECK_EQ_INT(500, samples[0].timestamp);
+}
+
+static void test_full_journal_overwrites_oldest(void) {
+    journal_init();
+    uint32_t capacity = JOURNAL_CHUNK_COUNT * JOURNAL_CHUNK_SAMPLES;
+    append_run(0, (uint16_t)(capacity + 5), 100);
+    journal_sync();
+
+    CHECK_EQ_INT(capacity - JOURNAL_CHUNK_SAMPLES + 5, journal_sample_count());
+    CHECK(stub_persist_used_bytes() <= STUB_PERSIST_MAX_BYTES);
+    HRSample sample;
+    journal_peek(&sample, 1);
+    CHECK_EQ_INT(JOURNAL_CHUNK_SAMPLES, sample.timestamp);
+}
+
+static void test_drain_deletes_only_chunks_in_use(void) {
+    journal_init();
+    append_run(1000, 2, 130);
+    append_run(1000 + 10 * 60, 2, 130);
+    journal_sync();
+
+    // One chunk each, deleted as it is drained; the rest were never written
+    stub_reset_stats();
+    journal_consume(4);
+    CHECK_EQ_INT(0, journal_sample_count());
+    CHECK_EQ_INT(2, stub_get_stats()->persist_deletes);
+
+    append_run(2000, 1, 130);
+    journal_sync();
+    stub_reset_stats();
+    journal_consume(1);
+    CHECK_EQ_INT(1, stub_get_stats()->persist_deletes);
+}
+
+static void emit_hr(HealthValue bpm) {
+    stub_health_set_value(HealthMetricHeartRateBPM, bpm);
+    stub_health_emit(HealthEventHeartRateUpdate);
+}
+
+static void scenario_undeliverable_batches_drain_after_reconnect(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    stub_appmsg_set_auto_ack(true, 50);
+    stub_appmsg_set_auto_nack_percent(100);
+    for (int i = 0; i < HR_BATCH_SIZE; i++) {
+        emit_hr(150);
+        stub_advance_ms(1000);
+    }
+
+    // Out of range: the batch exhausts its retries and is journaled
+    stub_advance_ms(60 * 1000);
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+    CHECK_EQ_INT(HR_BATCH_SIZE, journal_sample_count());
+
+    // Back in range: the next ACK drains the journal
+    stub_appmsg_set_auto_nack_percent(0);
+    for (int i = 0; i < HR_BATCH_SIZE; i++) {
+        emit_hr(151);
+        stub_advance_ms(1000);
+    }
+    stub_advance_ms(1000);
+    CHECK_EQ_INT(0, journal_sample_count());
+    CHECK_EQ_INT(0, appmsg_queue_depth());
+}
+
+static void test_undeliverable_batches_drain_after_reconnect(void) {
+    test_run_app(scenario_undeliverable_batches_drain_after_reconnect);
+}
+
+static void scenario_exit_with_unsent_samples(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    for (int i = 0; i < 4; i++) {
+        emit_hr(120 + i);
+        stub_advance_ms(1000);
+    }
+    // The app exits without the phone ever acknowledging
+}
+
+static void scenario_relaunch_drains_journal(void) {
+    // Drained at launch and sent right after the HELLO
+    CHECK_EQ_INT(0, journal_sample_count());
+    CHECK_EQ_INT(1, appmsg_queue_depth());
+    CHECK(stub_appmsg_outbox_pending());
+
+    DictionaryIterator sent;
+    CHECK(stub_appmsg_last_sent(&sent));
+    Tuple *batch = dict_find(&sent, KEY_HR_BATCH);
+    CHECK(batch != NULL);
+    if (batch) {
+        CHECK_EQ_INT(4, batch->value->data[HR_BATCH_COUNT_OFFSET]);
+    }
+}
+
+static void test_samples_survive_app_exit(void) {
+    test_run_app(scenario_exit_with_unsent_samples);
+    CHECK(persist_exists(JOURNAL_PERSIST_KEY_META));
+
+    stub_app_exit();
+    stub_reset_stats();
+    test_run_app(scenario_relaunch_drains_journal);
+}
+
+void run_journal_tests(void) {
+    RUN_TEST(test_samples_come_back_in_order);
+    RUN_TEST(test_survives_restart);
+    RUN_TEST(test_unsynced_samples_are_lost_cleanly);
+    RUN_TEST(test_gap_starts_new_chunk);
+    RUN_TEST(test_full_journal_overwrites_oldest);
+    RUN_TEST(test_drain_deletes_only_chunks_in_use);
+    RUN_TEST(test_undeliverable_batches_drain_after_reconnect);
+    RUN_TEST(test_samples_survive_app_exit);
+}
@@ -0,0 +1,104 @@
+#include "test.h"
+
+#include "log.h"
+#include "workout.h"
+
+#define T0 1700000000
+
+static void test_levels_below_the_floor_are_compiled_out(void) {
+    // Host tests build with the default floor
+    CHECK_EQ_INT(APP_LOG_LEVEL_INFO, LOG_LEVEL);
+    LOG(APP_LOG_LEVEL_DEBUG, "dropped %d", 1);
+    CHECK_EQ_INT(0, stub_get_stats()->log_calls);
+
+    LOG(APP_LOG_LEVEL_INFO, "kept %d", 2);
+    LOG(APP_LOG_LEVEL_ERROR, "kept %d", 3);
+    CHECK_EQ_INT(2, stub_get_stats()->log_calls);
+}
+
+static void test_ring_keeps_the_newest_records(void) {
+    log_ring_clear();
+    for (int i = 0; i < LOG_RING_SIZE + 3; i++) {
+        LOG_EVENT(LOG_EVENT_HR_READING, i, HR_BATCH_QUALITY_GOOD);
+    }
+    CHECK_EQ_INT(LOG_RING_SIZE, log_ring_count());
+
+    LogRecord record;
+    CHECK(log_ring_get(0, &record));
+    CHECK_EQ_INT(3, record.args[0]);
+    CHECK(log_ring_get(LOG_RING_SIZE - 1, &record));
+    CHECK_EQ_INT(LOG_RING_SIZE + 2, record.args[0]);
+    CHECK_EQ_INT(HR_BATCH_QUALITY_GOOD, record.args[1]);
+    CHECK(!log_ring_get(LOG_RING_SIZE, &record));
+
+    // Recording formats nothing
+    CHECK_EQ_INT(0, stub_get_stats()->log_calls);
+}
+
+static void test_records_carry_the_time(void) {
+    log_ring_clear();
+    stub_clock_set_ms((uint64_t)T0 * 1000 + 250);
+    LOG_EVENT(LOG_EVENT_OUTBOX_FAILED, KEY_HR_BATCH, APP_MSG_SEND_TIMEOUT);
+
+    LogRecord record;
+    CHECK(log_ring_get(0, &record));
+    CHECK_EQ_INT(T0, record.time);
+    CHECK_EQ_INT(250, record.ms);
+    CHECK_EQ_INT(LOG_EVENT_OUTBOX_FAILED, record.event);
+    CHECK_EQ_INT(KEY_HR_BATCH, record.args[0]);
+}
+
+static void test_dump_prints_and_clears(void) {
+    log_ring_clear();
+    LOG_EVENT(LOG_EVENT_HR_INVALID, 0, 0);
+    LOG_EVENT(LOG_EVENT_HR_REJECTED, 250, 0);
+    log_ring_dump();
+    CHECK_EQ_INT(2, stub_get_stats()->log_calls);
+    CHECK_EQ_INT(0, log_ring_count());
+}
+
+static void scenario_readings_go_to_the_ring(void) {
+    stub_appmsg_set_auto_ack(true, 50);
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    stub_advance_ms(1000);
+    uint32_t log_calls = stub_get_stats()->log_calls;
+
+    for (int i = 0; i < 60; i++) {
+        stub_health_set_value(HealthMetricHeartRateBPM, 140 + i % 3);
+        stub_health_emit(HealthEventHeartRateUpdate);
+        stub_advance_ms(1000);
+    }
+    CHECK_EQ_INT(log_calls, stub_get_stats()->log_calls);
+
+    // The newest record is the last reading, unless an ACK came after it
+    LogRecord record;
+    bool found = false;
+    for (uint16_t i = log_ring_count(); i > 0 && !found; i--) {
+        found = log_ring_get(i - 1, &record) && record.event == LOG_EVENT_HR_READING;
+    }
+    CHECK(found);
+    CHECK_EQ_INT(142, record.args[0]);
+
+    // Dumping is not a workout command
+    test_deliver_uint8(KEY_CMD, CMD_DUMP_LOG);
+    CHECK_EQ_INT(WORKOUT_RUNNING, workout_state());
+    CHECK(stub_get_stats()->log_calls > log_calls + 1);
+
+    // Only the dump request itself is left
+    CHECK_EQ_INT(1, log_ring_count());
+    CHECK(log_ring_get(0, &record));
+    CHECK_EQ_INT(LOG_EVENT_INBOX, record.event);
+    CHECK_EQ_INT(CMD_DUMP_LOG, record.args[0]);
+}
+
+static void test_readings_go_to_the_ring(void) {
+    test_run_app(scenario_readings_go_to_the_ring);
+}
+
+void run_log_tests(void) {
+    RUN_TEST(test_levels_below_the_floor_are_compiled_out);
+    RUN_TEST(test_ring_keeps_the_newest_records);
+    RUN_TEST(test_records_carry_the_time);
+    RUN_TEST(test_dump_prints_and_clears);
+    RUN_TEST(test_readings_go_to_the_ring);
+}
@@ -0,0 +1,79 @@
+#include "test.h"
+
+int g_test_failures = 0;
+int g_test_checks = 0;
+
+static AppState s_initial_app_state;
+
+void test_run(const char *name, TestFn fn) {
+    int failures_before = g_test_failures;
+
+    stub_reset();
+    g_app_state = s_initial_app_state;
+    fn();
+
+    printf("%s %s\n", g_test_failures == failures_before ? "PASS" : "FAIL", name);
+}
+
+static StubEventLoop s_scenario;
+
+// A phone that is already listening answers the launch HELLO straight away,
+// so scenarios start with an idle outbox and count only their own traffic
+static void answer_hello_then_run(void) {
+    if (stub_appmsg_outbox_pending()) {
+        stub_appmsg_ack();
+    }
+    stub_reset_stats();
+    s_scenario();
+}
+
+void test_run_app(StubEventLoop scenario) {
+    s_scenario = scenario;
+    stub_set_event_loop(answer_hello_then_run);
+    pebblerun_main();
+}
+
+AppMessageResult test_deliver_uint8(uint32_t key, uint8_t value) {
+    uint8_t buffer[32];
+    DictionaryIterator iter;
+    dict_write_begin(&iter, buffer, sizeof(buffer));
+    dict_write_uint8(&iter, key, value);
+    uint32_t size = dict_write_end(&iter);
+    return stub_appmsg_deliver(buffer, (uint16_t)size);
+}
+
+AppMessageResult test_deliver_data(uint32_t key, const uint8_t *data, uint16_t size) {
+    uint8_t buffer[256];
+    DictionaryIterator iter;
+    dict_write_begin(&iter, buffer, sizeof(buffer));
+    dict_write_data(&iter, key, data, size);
+    uint32_t total = dict_write_end(&iter);
+    return stub_appmsg_deliver(buffer, (uint16_t)total);
+}
+
+int main(void) {
+    // Snapshot the static initializer from main.c before any test mutates it
+    s_initial_app_state = g_app_state;
+
+    run_stub_tests();
+    run_hr_tests();
+    run_hrpack_tests();
+    run_hrquality_tests();
+    run_hrstats_tests();
+    run_zones_tests();
+    run_datalog_tests();
+    run_log_tests();
+    run_perf_tests();
+    run_journal_tests();
+    run_backfill_tests();
+    run_appmsg_tests();
+    run_ui_tests();
+    run_format_tests();
+    run_session_tests();
+    run_workout_tests();
+    run_replay_tests();
+    run_schema_tests();
+
+    printf("\n%d checks, %d failures\n", g_test_checks, g_test_failures);
+    return g_test_failures == 0 ? 0 : 1;
+}
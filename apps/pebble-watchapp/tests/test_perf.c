@@ -0,0 +1,213 @@
+#include "test.h"
+
+#include "perf.h"
+#include "appmsg.h"
+#include "workout.h"
+
+#define T0 1700000000
+
+static void time_probe(PerfProbe probe, uint32_t duration_ms) {
+    uint32_t started = perf_begin();
+    stub_advance_ms(duration_ms);
+    perf_end(probe, started);
+}
+
+static void test_probe_counts_durations_into_buckets(void) {
+    stub_clock_set_ms((uint64_t)T0 * 1000);
+    perf_init();
+    time_probe(PERF_PROBE_CANVAS, 0);
+    time_probe(PERF_PROBE_CANVAS, 1);
+    time_probe(PERF_PROBE_CANVAS, 2);
+    time_probe(PERF_PROBE_CANVAS, 31);
+    time_probe(PERF_PROBE_CANVAS, 32);
+    time_probe(PERF_PROBE_CANVAS, 120);
+
+    PerfSnapshot snapshot;
+    perf_snapshot(&snapshot);
+    const PerfProbeStats *canvas = &snapshot.probes[PERF_PROBE_CANVAS];
+    CHECK_EQ_INT(6, canvas->calls);
+    CHECK_EQ_INT(186, canvas->total_ms);
+    CHECK_EQ_INT(120, canvas->max_ms);
+    CHECK_EQ_INT(2, canvas->buckets[0]);
+    CHECK_EQ_INT(1, canvas->buckets[1]);
+    CHECK_EQ_INT(1, canvas->buckets[2]);
+    CHECK_EQ_INT(2, canvas->buckets[3]);
+
+    // Other probes are untouched
+    CHECK_EQ_INT(0, snapshot.probes[PERF_PROBE_INBOX].calls);
+    CHECK_EQ_INT(0, snapshot.probes[PERF_PROBE_HR_EVENT].calls);
+}
+
+static void test_max_saturates(void) {
+    stub_clock_set_ms((uint64_t)T0 * 1000);
+    perf_init();
+    time_probe(PERF_PROBE_INBOX, 70000);
+
+    PerfSnapshot snapshot;
+    perf_snapshot(&snapshot);
+    CHECK_EQ_INT(UINT16_MAX, snapshot.probes[PERF_PROBE_INBOX].max_ms);
+    CHECK_EQ_INT(70000, snapshot.probes[PERF_PROBE_INBOX].total_ms);
+}
+
+static void test_failures_by_reason(void) {
+    perf_init();
+    perf_count_failure(APP_MSG_SEND_TIMEOUT);
+    perf_count_failure(APP_MSG_SEND_TIMEOUT);
+    perf_count_failure(APP_MSG_SEND_REJECTED);
+    perf_count_failure(APP_MSG_NOT_CONNECTED);
+    perf_count_failure(APP_MSG_APP_NOT_RUNNING);
+    perf_count_failure(APP_MSG_BUSY);
+
+    PerfSnapshot snapshot;
+    perf_snapshot(&snapshot);
+    CHECK_EQ_INT(2, snapshot.fail_timeout);
+    CHECK_EQ_INT(1, snapshot.fail_nack);
+    CHECK_EQ_INT(2, snapshot.fail_offline);
+    CHECK_EQ_INT(1, snapshot.fail_other);
+}
+
+static void test_heap_peak_and_uptime(void) {
+    stub_clock_set_ms((uint64_t)T0 * 1000);
+    perf_init();
+    stub_heap_set_used(12000);
+    time_probe(PERF_PROBE_HR_EVENT, 1);
+    stub_heap_set_used(8000);
+    time_probe(PERF_PROBE_HR_EVENT, 1);
+    stub_advance_ms(90 * 1000);
+
+    PerfSnapshot snapshot;
+    perf_snapshot(&snapshot);
+    CHECK_EQ_INT(12000, snapshot.heap_peak);
+    CHECK_EQ_INT(90, snapshot.uptime_s);
+}
+
+#define MAX_FRAMES 4
+
+static uint8_t s_frames[MAX_FRAMES][PERF_VALUE_MAX];
+static uint16_t s_frame_sizes[MAX_FRAMES];
+static uint8_t s_frame_count;
+
+static void record_perf(const uint8_t *data, uint16_t size, void *context) {
+    DictionaryIterator iter;
+    dict_read_begin_from_buffer(&iter, data, size);
+    Tuple *perf = dict_find(&iter, KEY_PERF);
+    if (perf && s_frame_count < MAX_FRAMES) {
+        memcpy(s_frames[s_frame_count], perf->value->data, perf->length);
+        s_frame_sizes[s_frame_count] = perf->length;
+        s_frame_count++;
+    }
+}
+
+static uint16_t read_uint16(const uint8_t *data) {
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static uint32_t read_uint32(const uint8_t *data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) |
+           ((uint32_t)data[3] << 24);
+}
+
+static void scenario_snapshot_on_request(void) {
+    stub_appmsg_set_auto_ack(true, 50);
+    s_frame_count = 0;
+    stub_appmsg_set_outbox_observer(record_perf, NULL);
+
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    for (int i = 0; i < 30; i++) {
+        stub_health_set_value(HealthMetricHeartRateBPM, 140 + i % 3);
+        stub_health_emit(HealthEventHeartRateUpdate);
+        stub_advance_ms(1000);
+    }
+    test_deliver_uint8(KEY_CMD, CMD_PERF_SNAPSHOT);
+    stub_advance_ms(1000);
+    stub_appmsg_set_outbox_observer(NULL, NULL);
+
+    // Not a workout command
+    CHECK_EQ_INT(WORKOUT_RUNNING, workout_state());
+
+    // Three probes, two to a frame, each frame with the header
+    CHECK_EQ_INT(2, s_frame_count);
+    CHECK_EQ_INT(PERF_HEADER_SIZE + 2 * PERF_PROBE_SIZE, s_frame_sizes[0]);
+    CHECK_EQ_INT(PERF_HEADER_SIZE + PERF_PROBE_SIZE, s_frame_sizes[1]);
+    CHECK_EQ_INT(2, s_frames[0][PERF_COUNT_OFFSET]);
+    CHECK_EQ_INT(1, s_frames[1][PERF_COUNT_OFFSET]);
+    CHECK_EQ_INT(30, read_uint32(&s_frames[0][PERF_UPTIME_OFFSET]));
+    CHECK(memcmp(&s_frames[0][PERF_UPTIME_OFFSET], &s_frames[1][PERF_UPTIME_OFFSET],
+                 PERF_HEADER_SIZE - PERF_UPTIME_OFFSET) == 0);
+
+    const uint8_t *canvas = &s_frames[0][PERF_HEADER_SIZE];
+    const uint8_t *inbox = &s_frames[0][PERF_HEADER_SIZE + PERF_PROBE_SIZE];
+    const uint8_t *hr_event = &s_frames[1][PERF_HEADER_SIZE];
+    CHECK_EQ_INT(PERF_PROBE_CANVAS, canvas[PERF_PROBE_ID_OFFSET]);
+    CHECK_EQ_INT(PERF_PROBE_INBOX, inbox[PERF_PROBE_ID_OFFSET]);
+    CHECK_EQ_INT(PERF_PROBE_HR_EVENT, hr_event[PERF_PROBE_ID_OFFSET]);
+
+    // START only; the request itself ends after the snapshot is taken
+    CHECK_EQ_INT(1, read_uint32(&inbox[PERF_PROBE_CALLS_OFFSET]));
+    CHECK_EQ_INT(30, read_uint32(&hr_event[PERF_PROBE_CALLS_OFFSET]));
+    uint32_t redraws = read_uint32(&canvas[PERF_PROBE_CALLS_OFFSET]);
+    CHECK(redraws > 0);
+    CHECK(redraws <= stub_get_stats()->renders);
+}
+
+static void test_snapshot_on_request(void) {
+    test_run_app(scenario_snapshot_on_request);
+}
+
+static void scenario_small_outbox_sends_a_probe_per_frame(void) {
+    stub_appmsg_set_auto_ack(true, 50);
+    s_frame_count = 0;
+    stub_appmsg_set_outbox_observer(record_perf, NULL);
+
+    test_deliver_uint8(KEY_CMD, CMD_PERF_SNAPSHOT);
+    stub_advance_ms(1000);
+    stub_appmsg_set_outbox_observer(NULL, NULL);
+
+    CHECK_EQ_INT(PERF_PROBE_COUNT, s_frame_count);
+    for (uint8_t i = 0; i < s_frame_count; i++) {
+        CHECK_EQ_INT(1, s_frames[i][PERF_COUNT_OFFSET]);
+        CHECK_EQ_INT(i, s_frames[i][PERF_HEADER_SIZE + PERF_PROBE_ID_OFFSET]);
+    }
+}
+
+static void scenario_snapshot_carries_sniff_time(void) {
+    // A message the phone takes 90 s to acknowledge holds the radio at the
+    // reduced interval
+    test_deliver_uint8(KEY_CMD, CMD_PERF_SNAPSHOT);
+    stub_advance_ms(90 * 1000);
+    while (stub_appmsg_outbox_pending()) {
+        stub_appmsg_ack();
+    }
+
+    stub_appmsg_set_auto_ack(true, 50);
+    s_frame_count = 0;
+    stub_appmsg_set_outbox_observer(record_perf, NULL);
+    test_deliver_uint8(KEY_CMD, CMD_PERF_SNAPSHOT);
+    stub_advance_ms(1000);
+    stub_appmsg_set_outbox_observer(NULL, NULL);
+
+    CHECK(s_frame_count > 0);
+    CHECK_EQ_INT(90, read_uint16(&s_frames[0][PERF_SNIFF_REDUCED_OFFSET]));
+    CHECK_EQ_INT(90, read_uint32(&s_frames[0][PERF_UPTIME_OFFSET]));
+}
+
+static void test_snapshot_carries_sniff_time(void) {
+    test_run_app(scenario_snapshot_carries_sniff_time);
+}
+
+static void test_small_outbox_sends_a_probe_per_frame(void) {
+    // Room for the header and one probe, not two
+    stub_appmsg_set_size_maximum(MESSAGE_INBOX_SIZE,
+                                 dict_calc_buffer_size(1, PERF_HEADER_SIZE + PERF_PROBE_SIZE));
+    test_run_app(scenario_small_outbox_sends_a_probe_per_frame);
+}
+
+void run_perf_tests(void) {
+    RUN_TEST(test_probe_counts_durations_into_buckets);
+    RUN_TEST(test_max_saturates);
+    RUN_TEST(test_failures_by_reason);
+    RUN_TEST(test_heap_peak_and_uptime);
+    RUN_TEST(test_snapshot_on_request);
+    RUN_TEST(test_snapshot_carries_sniff_time);
+    RUN_TEST(test_small_outbox_sends_a_probe_per_frame);
+}
@@ -0,0 +1,149 @@
+#include "test.h"
+
+#include "replay.h"
+
+static void test_parse_rejects_malformed_lines(void) {
+    ReplayTrace trace;
+    replay_trace_init(&trace);
+
+    CHECK(replay_trace_parse_line(&trace, "# header"));
+    CHECK(replay_trace_parse_line(&trace, "   "));
+    CHECK(replay_trace_parse_line(&trace, "1000 hr 140"));
+    CHECK(!replay_trace_parse_line(&trace, "500 hr 141"));
+    CHECK(!replay_trace_parse_line(&trace, "2000 in speed=3"));
+    CHECK(!replay_trace_parse_line(&trace, "2000 in cmd=one"));
+    CHECK(!replay_trace_parse_line(&trace, "2000 in pace=5:30/km"));
+    CHECK(!replay_trace_parse_line(&trace, "2000 jump"));
+    CHECK(!replay_trace_parse_line(&trace, "2000 link 2"));
+    CHECK(!replay_trace_parse_line(&trace, "later hr 140"));
+    CHECK_EQ_INT(1, trace.count);
+
+    replay_trace_free(&trace);
+}
+
+static void test_parse_builds_inbound_dictionary(void) {
+    ReplayTrace trace;
+    replay_trace_init(&trace);
+
+    CHECK(replay_trace_parse_line(&trace, "1500 in cmd=1 time=61 pace=330 dist=185 # two tuples"));
+    CHECK_EQ_INT(1, trace.count);
+
+    const ReplayEvent *event = &trace.events[0];
+    CHECK_EQ_INT(REPLAY_EVENT_INBOX, event->type);
+    CHECK_EQ_INT(1500, event->t_ms);
+
+    DictionaryIterator iter;
+    dict_read_begin_from_buffer(&iter, event->payload, event->size);
+    CHECK_EQ_INT(CMD_START, dict_find(&iter, KEY_CMD)->value->uint8);
+    Tuple *workout = dict_find(&iter, KEY_WORKOUT);
+    CHECK(workout != NULL);
+    CHECK_EQ_INT(TUPLE_BYTE_ARRAY, workout->type);
+    CHECK_EQ_INT(WORKOUT_FRAME_SIZE, workout->length);
+    const uint8_t expected[WORKOUT_FRAME_SIZE] = {
+        WORKOUT_FRAME_VERSION, 61, 0, 0, 0, 0x4a, 0x01, 185, 0, 0, 0, 0
+    };
+    CHECK(memcmp(expected, workout->value->data, WORKOUT_FRAME_SIZE) == 0);
+
+    replay_trace_free(&trace);
+}
+
+static void test_replay_counts_session_traffic(void) {
+    static const char *lines[] = {
+        "0 in cmd=1",
+        "1000 hr 120",
+        "1500 in time=1 pace=360 dist=2",
+        "2000 hr 121",
+        "2500 in time=2 pace=361 dist=5",
+        "3000 hr 0",
+        "3500 in cmd=2",
+    };
+    ReplayTrace trace;
+    replay_trace_init(&trace);
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+        CHECK(replay_trace_parse_line(&trace, lines[i]));
+    }
+
+    ReplayOptions options;
+    replay_options_default(&options);
+    ReplayReport report;
+    replay_run(&trace, &options, &report);
+
+    CHECK_EQ_INT(7, report.events);
+    CHECK_EQ_INT(3, report.stats.health_events);
+    CHECK_EQ_INT(4, report.stats.inbox_messages);
+    // The launch HELLO, both valid samples in one batch when STOP flushes
+    // the buffer, then the HR summary
+    CHECK_EQ_INT(3, report.stats.outbox_sends);
+    CHECK_EQ_INT(3, report.stats.outbox_acks);
+    CHECK(report.duration_ms >= 3500);
+    CHECK(report.stats.renders > 0);
+
+    replay_trace_free(&trace);
+}
+
+// Half an hour at 1 Hz, optionally with the phone away from minute 5 to 25
+static void build_session(ReplayTrace *trace, bool dropout) {
+    char line[64];
+    replay_trace_parse_line(trace, "0 in cmd=1");
+    for (uint32_t second = 1; second <= 30 * 60; second++) {
+        if (dropout && (second == 5 * 60 || second == 25 * 60)) {
+            snprintf(line, sizeof(line), "%u link %d", second * 1000, second == 25 * 60);
+            CHECK(replay_trace_parse_line(trace, line));
+        }
+        snprintf(line, sizeof(line), "%u hr %u", second * 1000, 140 + second % 7);
+        replay_trace_parse_line(trace, line);
+    }
+    replay_trace_parse_line(trace, "1800900 in cmd=2");
+}
+
+static void test_replay_dropout_sends_nothing(void) {
+    ReplayTrace steady;
+    ReplayTrace dropout;
+    replay_trace_init(&steady);
+    replay_trace_init(&dropout);
+    build_session(&steady, false);
+    build_session(&dropout, true);
+    CHECK_EQ_INT(steady.count + 2, dropout.count);
+
+    ReplayOptions options;
+    replay_options_default(&options);
+    ReplayReport connected;
+    ReplayReport report;
+    replay_run(&steady, &options, &connected);
+    replay_run(&dropout, &options, &report);
+
+    // No attempts while away, and the catch-up packs the journal into full
+    // frames instead of the minute batches it missed
+    CHECK_EQ_INT(0, report.stats.outbox_offline);
+    CHECK_EQ_INT(0, report.stats.outbox_nacks);
+    CHECK(report.stats.outbox_sends <= connected.stats.outbox_sends);
+
+    replay_trace_free(&dropout);
+    replay_trace_free(&steady);
+}
+
+static void test_synthetic_trace_is_deterministic(void) {
+    ReplayTrace first;
+    ReplayTrace second;
+    replay_trace_init(&first);
+    replay_trace_init(&second);
+
+    replay_trace_synthesize(&first, 120, 7);
+    replay_trace_synthesize(&second, 120, 7);
+    // START, STOP, one HR event per second and a throttled stream of frames
+    CHECK(first.count > 2 + 120 + 120 / 30);
+    CHECK(first.count < 2 + 2 * 120);
+    CHECK_EQ_INT(first.count, second.count);
+    CHECK(memcmp(first.events, second.events, first.count * sizeof(ReplayEvent)) == 0);
+
+    replay_trace_free(&first);
+    replay_trace_free(&second);
+}
+
+void run_replay_tests(void) {
+    RUN_TEST(test_parse_rejects_malformed_lines);
+    RUN_TEST(test_parse_builds_inbound_dictionary);
+    RUN_TEST(test_replay_counts_session_traffic);
+    RUN_TEST(test_replay_dropout_sends_nothing);
+    RUN_TEST(test_synthetic_trace_is_deterministic);
+}
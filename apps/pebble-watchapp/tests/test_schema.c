@@ -0,0 +1,257 @@
+#include "test.h"
+
+#include "appmsg.h"
+#include "zones.h"
+#include "datalog.h"
+#include "schema_vectors.h"
+
+// Conformance against the vectors generated from shared/proto/schema; the
+// Kotlin side checks the same bytes in WireFormatConformanceTest.
+
+static void test_buffer_sizes_match_sdk(void) {
+    CHECK_EQ_INT(dict_calc_buffer_size(5, (uint32_t)CMD_VALUE_MAX, (uint32_t)WORKOUT_VALUE_MAX,
+                                       (uint32_t)RESEND_VALUE_MAX, (uint32_t)ZONES_VALUE_MAX,
+                                       (uint32_t)UPLINK_VALUE_MAX),
+                 MESSAGE_INBOX_SIZE);
+    CHECK_EQ_INT(dict_calc_buffer_size(1, (uint32_t)HR_BATCH_VALUE_MAX), MESSAGE_OUTBOX_SIZE);
+    CHECK_EQ_INT(HR_BATCH_VALUE_MAX, HR_BATCH_HEADER_SIZE + HR_BATCH_STREAM_MAX);
+    CHECK(WORKOUT_FRAME_SIZE <= WORKOUT_VALUE_MAX);
+    CHECK(RESEND_FRAME_SIZE <= RESEND_VALUE_MAX);
+    CHECK(HELLO_FRAME_SIZE <= HELLO_VALUE_MAX);
+    CHECK(HR_SUMMARY_FRAME_SIZE <= HR_SUMMARY_VALUE_MAX);
+    CHECK(ZONES_FRAME_SIZE <= ZONES_VALUE_MAX);
+    CHECK(PERF_HEADER_SIZE + PERF_MAX_PROBES * PERF_PROBE_SIZE <= PERF_VALUE_MAX);
+}
+
+static void scenario_workout_vectors_decode(void) {
+    CHECK_EQ_INT(APP_MSG_OK, test_deliver_data(KEY_WORKOUT, VECTOR_WORKOUT_PAUSED,
+                                               sizeof(VECTOR_WORKOUT_PAUSED)));
+    CHECK_EQ_INT(VECTOR_WORKOUT_PAUSED_ELAPSED, g_app_state.workout.elapsed_s);
+    CHECK_EQ_INT(VECTOR_WORKOUT_PAUSED_PACE, g_app_state.workout.pace_s_per_km);
+    CHECK_EQ_INT(VECTOR_WORKOUT_PAUSED_DISTANCE, g_app_state.workout.distance_m);
+    CHECK_EQ_INT(VECTOR_WORKOUT_PAUSED_FLAGS, g_app_state.workout.flags);
+
+    CHECK_EQ_INT(APP_MSG_OK, test_deliver_data(KEY_WORKOUT, VECTOR_WORKOUT_NO_PACE,
+                                               sizeof(VECTOR_WORKOUT_NO_PACE)));
+    CHECK_EQ_INT(VECTOR_WORKOUT_NO_PACE_ELAPSED, g_app_state.workout.elapsed_s);
+    CHECK_EQ_INT(VECTOR_WORKOUT_NO_PACE_PACE, g_app_state.workout.pace_s_per_km);
+    CHECK_EQ_INT(VECTOR_WORKOUT_NO_PACE_DISTANCE, g_app_state.workout.distance_m);
+    CHECK_EQ_INT(VECTOR_WORKOUT_NO_PACE_FLAGS, g_app_state.workout.flags);
+}
+
+static void test_workout_vectors_decode(void) {
+    test_run_app(scenario_workout_vectors_decode);
+}
+
+static void check_hr_batch_sent(const uint8_t *expected, size_t size) {
+    DictionaryIterator sent;
+    CHECK(stub_appmsg_last_sent(&sent));
+    Tuple *batch = dict_find(&sent, KEY_HR_BATCH);
+    CHECK(batch != NULL);
+    if (batch) {
+        CHECK_EQ_INT(size, batch->length);
+        CHECK(memcmp(expected, batch->value->data, size) == 0);
+    }
+}
+
+static void scenario_hr_batch_vector_encodes(void) {
+    uint8_t count = sizeof(VECTOR_HR_BATCH_GAPS_SAMPLES) / sizeof(VECTOR_HR_BATCH_GAPS_SAMPLES[0]);
+    CHECK_EQ_INT(count, appmsg_send_hr_batch(VECTOR_HR_BATCH_GAPS_SAMPLES, count));
+    check_hr_batch_sent(VECTOR_HR_BATCH_GAPS, sizeof(VECTOR_HR_BATCH_GAPS));
+    stub_appmsg_ack();
+
+    // A steady minute at 1 s fits one frame with room to spare
+    count = sizeof(VECTOR_HR_BATCH_MINUTE_SAMPLES) / sizeof(VECTOR_HR_BATCH_MINUTE_SAMPLES[0]);
+    CHECK_EQ_INT(60, count);
+    CHECK_EQ_INT(count, appmsg_send_hr_batch(VECTOR_HR_BATCH_MINUTE_SAMPLES, count));
+    check_hr_batch_sent(VECTOR_HR_BATCH_MINUTE, sizeof(VECTOR_HR_BATCH_MINUTE));
+    CHECK(sizeof(VECTOR_HR_BATCH_MINUTE) < HR_BATCH_VALUE_MAX);
+}
+
+static void test_hr_batch_vector_encodes(void) {
+    // Sequence numbers carry on from the last run
+    uint8_t seq[2] = { VECTOR_HR_BATCH_GAPS_SEQ & 0xFF, VECTOR_HR_BATCH_GAPS_SEQ >> 8 };
+    persist_write_data(APPMSG_PERSIST_KEY_SEQ, seq, sizeof(seq));
+    test_run_app(scenario_hr_batch_vector_encodes);
+}
+
+static void scenario_hr_summary_vector_encodes(void) {
+    HRStats stats = {
+        .seconds = VECTOR_HR_SUMMARY_HOUR_SECONDS,
+        .avg_bpm = VECTOR_HR_SUMMARY_HOUR_AVG,
+        .min_bpm = VECTOR_HR_SUMMARY_HOUR_MIN,
+        .max_bpm = VECTOR_HR_SUMMARY_HOUR_MAX,
+        .zone_s = {
+            VECTOR_HR_SUMMARY_HOUR_ZONE1, VECTOR_HR_SUMMARY_HOUR_ZONE2, VECTOR_HR_SUMMARY_HOUR_ZONE3,
+            VECTOR_HR_SUMMARY_HOUR_ZONE4, VECTOR_HR_SUMMARY_HOUR_ZONE5
+        }
+    };
+    CHECK(appmsg_send_hr_summary(&stats));
+
+    DictionaryIterator sent;
+    CHECK(stub_appmsg_last_sent(&sent));
+    Tuple *summary = dict_find(&sent, KEY_HR_SUMMARY);
+    CHECK(summary != NULL);
+    if (summary) {
+        CHECK_EQ_INT(sizeof(VECTOR_HR_SUMMARY_HOUR), summary->length);
+        CHECK(memcmp(VECTOR_HR_SUMMARY_HOUR, summary->value->data, sizeof(VECTOR_HR_SUMMARY_HOUR)) == 0);
+    }
+}
+
+static void test_hr_summary_vector_encodes(void) {
+    test_run_app(scenario_hr_summary_vector_encodes);
+}
+
+static void scenario_perf_vector_encodes(void) {
+    PerfSnapshot snapshot = {
+        .uptime_s = VECTOR_PERF_HOUR_UPTIME,
+        .heap_peak = VECTOR_PERF_HOUR_HEAP_PEAK,
+        .fail_timeout = VECTOR_PERF_HOUR_FAIL_TIMEOUT,
+        .fail_nack = VECTOR_PERF_HOUR_FAIL_NACK,
+        .fail_offline = VECTOR_PERF_HOUR_FAIL_OFFLINE,
+        .fail_other = VECTOR_PERF_HOUR_FAIL_OTHER,
+        .sniff_reduced_s = VECTOR_PERF_HOUR_SNIFF_REDUCED,
+        .probes = {
+            [VECTOR_PERF_HOUR_PROBE0_ID] = {
+                .calls = VECTOR_PERF_HOUR_PROBE0_CALLS,
+                .total_ms = VECTOR_PERF_HOUR_PROBE0_TOTAL_MS,
+                .max_ms = VECTOR_PERF_HOUR_PROBE0_MAX_MS,
+                .buckets = {
+                    VECTOR_PERF_HOUR_PROBE0_UNDER_2MS, VECTOR_PERF_HOUR_PROBE0_UNDER_8MS,
+                    VECTOR_PERF_HOUR_PROBE0_UNDER_32MS, VECTOR_PERF_HOUR_PROBE0_OVER_32MS
+                }
+            },
+            [VECTOR_PERF_HOUR_PROBE1_ID] = {
+                .calls = VECTOR_PERF_HOUR_PROBE1_CALLS,
+                .total_ms = VECTOR_PERF_HOUR_PROBE1_TOTAL_MS,
+                .max_ms = VECTOR_PERF_HOUR_PROBE1_MAX_MS,
+                .buckets = {
+                    VECTOR_PERF_HOUR_PROBE1_UNDER_2MS, VECTOR_PERF_HOUR_PROBE1_UNDER_8MS,
+                    VECTOR_PERF_HOUR_PROBE1_UNDER_32MS, VECTOR_PERF_HOUR_PROBE1_OVER_32MS
+                }
+            }
+        }
+    };
+    CHECK(appmsg_send_perf(&snapshot));
+
+    // The vector is the first of the frames, with the first two probes
+    DictionaryIterator sent;
+    CHECK(stub_appmsg_last_sent(&sent));
+    Tuple *perf = dict_find(&sent, KEY_PERF);
+    CHECK(perf != NULL);
+    if (perf) {
+        CHECK_EQ_INT(sizeof(VECTOR_PERF_HOUR), perf->length);
+        CHECK(memcmp(VECTOR_PERF_HOUR, perf->value->data, sizeof(VECTOR_PERF_HOUR)) == 0);
+    }
+}
+
+static void test_perf_vector_encodes(void) {
+    test_run_app(scenario_perf_vector_encodes);
+}
+
+static void scenario_hello_vector_at_launch(void) {
+    DictionaryIterator sent;
+    CHECK(stub_appmsg_last_sent(&sent));
+    Tuple *hello = dict_find(&sent, KEY_HELLO);
+    CHECK(hello != NULL);
+    if (hello) {
+        CHECK_EQ_INT(sizeof(VECTOR_HELLO_DEFAULT), hello->length);
+        CHECK(memcmp(VECTOR_HELLO_DEFAULT, hello->value->data, sizeof(VECTOR_HELLO_DEFAULT)) == 0);
+    }
+    CHECK_EQ_INT(VECTOR_HELLO_DEFAULT_PROTOCOL, PROTOCOL_VERSION);
+    CHECK_EQ_INT(VECTOR_HELLO_DEFAULT_INBOX, stub_appmsg_inbox_size());
+    CHECK_EQ_INT(VECTOR_HELLO_DEFAULT_MAX_VALUE, HR_BATCH_VALUE_MAX);
+}
+
+static void test_hello_vector_at_launch(void) {
+    test_run_app(scenario_hello_vector_at_launch);
+}
+
+static void scenario_resend_vector_decodes(void) {
+    // Sent as 65534, 65535 and 0 across the wrap
+    HRSample sample = { .timestamp = 1700000000, .bpm = 140 };
+    for (int i = 0; i < VECTOR_RESEND_WRAP_COUNT; i++) {
+        appmsg_send_hr_batch(&sample, 1);
+        stub_appmsg_ack();
+    }
+    uint32_t sends = stub_get_stats()->outbox_sends;
+
+    CHECK_EQ_INT(APP_MSG_OK, test_deliver_data(KEY_RESEND, VECTOR_RESEND_WRAP, sizeof(VECTOR_RESEND_WRAP)));
+    CHECK_EQ_INT(sends + 1, stub_get_stats()->outbox_sends);
+    CHECK_EQ_INT(VECTOR_RESEND_WRAP_COUNT, appmsg_queue_depth());
+}
+
+static void test_resend_vector_decodes(void) {
+    uint8_t seq[2] = { VECTOR_RESEND_WRAP_FIRST_SEQ & 0xFF, VECTOR_RESEND_WRAP_FIRST_SEQ >> 8 };
+    persist_write_data(APPMSG_PERSIST_KEY_SEQ, seq, sizeof(seq));
+    test_run_app(scenario_resend_vector_decodes);
+}
+
+static void scenario_hr_minutes_vector_encodes(void) {
+    CHECK(appmsg_send_hr_minutes(VECTOR_HR_MINUTES_HOLE_BASE_TIME, VECTOR_HR_MINUTES_HOLE_BPM,
+                                 sizeof(VECTOR_HR_MINUTES_HOLE_BPM)));
+
+    DictionaryIterator sent;
+    CHECK(stub_appmsg_last_sent(&sent));
+    Tuple *minutes = dict_find(&sent, KEY_HR_MINUTES);
+    CHECK(minutes != NULL);
+    if (minutes) {
+        CHECK_EQ_INT(sizeof(VECTOR_HR_MINUTES_HOLE), minutes->length);
+        CHECK(memcmp(VECTOR_HR_MINUTES_HOLE, minutes->value->data, sizeof(VECTOR_HR_MINUTES_HOLE)) == 0);
+    }
+}
+
+static void test_hr_minutes_vector_encodes(void) {
+    test_run_app(scenario_hr_minutes_vector_encodes);
+}
+
+static void scenario_zones_vectors_decode(void) {
+    CHECK_EQ_INT(APP_MSG_OK, test_deliver_data(KEY_ZONES, VECTOR_ZONES_THRESHOLDS,
+                                               sizeof(VECTOR_ZONES_THRESHOLDS)));
+    CHECK_EQ_INT(0, zones_classify(VECTOR_ZONES_THRESHOLDS_ZONE1 - 1));
+    CHECK_EQ_INT(1, zones_classify(VECTOR_ZONES_THRESHOLDS_ZONE1));
+    CHECK_EQ_INT(4, zones_classify(VECTOR_ZONES_THRESHOLDS_ZONE5 - 1));
+    CHECK_EQ_INT(5, zones_classify(VECTOR_ZONES_THRESHOLDS_ZONE5));
+
+    // 90 percent of the max HR starts zone 5
+    CHECK_EQ_INT(APP_MSG_OK, test_deliver_data(KEY_ZONES, VECTOR_ZONES_MAX_HR, sizeof(VECTOR_ZONES_MAX_HR)));
+    CHECK_EQ_INT(1, zones_classify(0));
+    CHECK_EQ_INT(4, zones_classify(VECTOR_ZONES_MAX_HR_MAX_HR * 9 / 10 - 1));
+    CHECK_EQ_INT(5, zones_classify(VECTOR_ZONES_MAX_HR_MAX_HR * 9 / 10));
+}
+
+static void test_zones_vectors_decode(void) {
+    test_run_app(scenario_zones_vectors_decode);
+}
+
+static void test_hr_record_vector_encodes(void) {
+    HRSample sample = {
+        .timestamp = VECTOR_HR_RECORD_GOOD_TIME,
+        .bpm = VECTOR_HR_RECORD_GOOD_BPM,
+        .quality = VECTOR_HR_RECORD_GOOD_QUALITY
+    };
+    datalog_init();
+    datalog_set_uplink(UPLINK_DATALOG);
+    datalog_begin(VECTOR_HR_RECORD_GOOD_TIME);
+    CHECK_EQ_INT(1, datalog_write(&sample, 1));
+
+    uint32_t count;
+    const uint8_t *items = stub_datalog_items(VECTOR_HR_RECORD_GOOD_TIME, &count);
+    CHECK_EQ_INT(1, count);
+    CHECK_EQ_INT(HR_RECORD_SIZE, sizeof(VECTOR_HR_RECORD_GOOD));
+    CHECK(items && memcmp(VECTOR_HR_RECORD_GOOD, items, HR_RECORD_SIZE) == 0);
+    datalog_deinit();
+}
+
+void run_schema_tests(void) {
+    RUN_TEST(test_buffer_sizes_match_sdk);
+    RUN_TEST(test_workout_vectors_decode);
+    RUN_TEST(test_hr_batch_vector_encodes);
+    RUN_TEST(test_hr_minutes_vector_encodes);
+    RUN_TEST(test_hr_summary_vector_encodes);
+    RUN_TEST(test_hello_vector_at_launch);
+    RUN_TEST(test_resend_vector_decodes);
+    RUN_TEST(test_zones_vectors_decode);
+    RUN_TEST(test_hr_record_vector_encodes);
+    RUN_TEST(test_perf_vector_encodes);
+}
@@ -0,0 +1,130 @@
+#include "test.h"
+
+#include "hr.h"
+#include "session.h"
+
+static void deliver_frame(uint32_t elapsed_s, uint8_t flags) {
+    uint8_t frame[WORKOUT_FRAME_SIZE] = { WORKOUT_FRAME_VERSION };
+    frame[WORKOUT_ELAPSED_OFFSET] = (uint8_t)elapsed_s;
+    frame[WORKOUT_ELAPSED_OFFSET + 1] = (uint8_t)(elapsed_s >> 8);
+    frame[WORKOUT_FLAGS_OFFSET] = flags;
+    test_deliver_data(KEY_WORKOUT, frame, sizeof(frame));
+}
+
+static void scenario_clock_ticks_without_phone(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    CHECK(stub_tick_is_subscribed());
+    CHECK_EQ_INT(0, g_app_state.workout.elapsed_s);
+
+    stub_advance_ms(65 * 1000);
+    CHECK_EQ_INT(65, g_app_state.workout.elapsed_s);
+    CHECK_EQ_INT(1, stub_get_stats()->inbox_messages);
+
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+    CHECK(!stub_tick_is_subscribed());
+}
+
+static void test_clock_ticks_without_phone(void) {
+    test_run_app(scenario_clock_ticks_without_phone);
+}
+
+static void scenario_small_drift_is_ignored(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    stub_advance_ms(10 * 1000);
+
+    deliver_frame(10 + SESSION_DRIFT_MAX_S, 0);
+    CHECK_EQ_INT(10, session_elapsed_s());
+    CHECK_EQ_INT(10, g_app_state.workout.elapsed_s);
+}
+
+static void test_small_drift_is_ignored(void) {
+    test_run_app(scenario_small_drift_is_ignored);
+}
+
+static void scenario_large_drift_resyncs(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    stub_advance_ms(10 * 1000);
+
+    deliver_frame(40, 0);
+    CHECK_EQ_INT(40, g_app_state.workout.elapsed_s);
+    stub_advance_ms(5 * 1000);
+    CHECK_EQ_INT(45, g_app_state.workout.elapsed_s);
+}
+
+static void test_large_drift_resyncs(void) {
+    test_run_app(scenario_large_drift_resyncs);
+}
+
+static void scenario_pause_freezes_clock(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    stub_advance_ms(20 * 1000);
+
+    test_deliver_uint8(KEY_CMD, CMD_PAUSE);
+    CHECK(!session_is_running());
+    CHECK(!stub_tick_is_subscribed());
+    CHECK_EQ_INT(HR_PERIOD_SLOW_S, stub_health_sample_period());
+    stub_advance_ms(30 * 1000);
+    CHECK_EQ_INT(20, g_app_state.workout.elapsed_s);
+
+    // A paused clock still takes the phone's time when it is off
+    deliver_frame(20 + SESSION_DRIFT_MAX_S + 1, 0);
+    CHECK(!session_is_running());
+    CHECK_EQ_INT(23, g_app_state.workout.elapsed_s);
+
+    // Resuming starts ticking again
+    test_deliver_uint8(KEY_CMD, CMD_RESUME);
+    CHECK(stub_tick_is_subscribed());
+    CHECK_EQ_INT(HR_PERIOD_FAST_S, stub_health_sample_period());
+    stub_advance_ms(3 * 1000);
+    CHECK_EQ_INT(26, g_app_state.workout.elapsed_s);
+}
+
+static void test_pause_freezes_clock(void) {
+    test_run_app(scenario_pause_freezes_clock);
+}
+
+static void scenario_pause_drift_follows_the_phone(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    stub_advance_ms(20 * 1000);
+
+    // The watch paused at 20 s, the phone at 17 s
+    test_deliver_uint8(KEY_CMD, CMD_PAUSE);
+    stub_advance_ms(5 * 1000);
+    deliver_frame(17, WORKOUT_FLAG_PAUSED);
+    CHECK(!session_is_running());
+    CHECK_EQ_INT(17, g_app_state.workout.elapsed_s);
+
+    // Within the tolerance the paused clock is left alone, flag or not
+    deliver_frame(17 + SESSION_DRIFT_MAX_S, 0);
+    CHECK(!session_is_running());
+    CHECK(!stub_tick_is_subscribed());
+    CHECK_EQ_INT(17, g_app_state.workout.elapsed_s);
+
+    test_deliver_uint8(KEY_CMD, CMD_RESUME);
+    stub_advance_ms(3 * 1000);
+    CHECK_EQ_INT(20, g_app_state.workout.elapsed_s);
+}
+
+static void test_pause_drift_follows_the_phone(void) {
+    test_run_app(scenario_pause_drift_follows_the_phone);
+}
+
+static void scenario_frame_joins_running_workout(void) {
+    deliver_frame(300, 0);
+    CHECK(session_is_running());
+    stub_advance_ms(2 * 1000);
+    CHECK_EQ_INT(302, g_app_state.workout.elapsed_s);
+}
+
+static void test_frame_joins_running_workout(void) {
+    test_run_app(scenario_frame_joins_running_workout);
+}
+
+void run_session_tests(void) {
+    RUN_TEST(test_clock_ticks_without_phone);
+    RUN_TEST(test_small_drift_is_ignored);
+    RUN_TEST(test_large_drift_resyncs);
+    RUN_TEST(test_pause_freezes_clock);
+    RUN_TEST(test_pause_drift_follows_the_phone);
+    RUN_TEST(test_frame_joins_running_workout);
+}
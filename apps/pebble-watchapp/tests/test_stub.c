@@ -0,0 +1,85 @@
+#include "test.h"
+
+// Sanity checks for the SDK fake itself, so watchapp tests can trust it
+
+// Any keys work for exercising string and integer tuples
+#define KEY_TEXT 0
+#define KEY_NUMBER 2
+
+static void test_dict_layout_matches_sdk(void) {
+    CHECK_EQ_INT(1 + 7 + 2, dict_calc_buffer_size(1, (uint32_t)sizeof(uint16_t)));
+    CHECK_EQ_INT(1 + 7 + 9 + 7 + 1, dict_calc_buffer_size(2, (uint32_t)9, (uint32_t)1));
+
+    uint8_t buffer[32];
+    DictionaryIterator iter;
+    CHECK_EQ_INT(DICT_OK, dict_write_begin(&iter, buffer, sizeof(buffer)));
+    CHECK_EQ_INT(DICT_OK, dict_write_uint16(&iter, KEY_NUMBER, 151));
+    CHECK_EQ_INT(DICT_OK, dict_write_cstring(&iter, KEY_TEXT, "5:30/km"));
+    CHECK_EQ_INT(1 + 7 + 2 + 7 + 8, dict_write_end(&iter));
+
+    DictionaryIterator read;
+    Tuple *first = dict_read_begin_from_buffer(&read, buffer, (uint16_t)dict_size(&iter));
+    CHECK(first != NULL);
+    CHECK_EQ_INT(KEY_NUMBER, first->key);
+    CHECK_EQ_INT(TUPLE_UINT, first->type);
+    CHECK_EQ_INT(151, first->value->uint16);
+
+    Tuple *pace = dict_find(&read, KEY_TEXT);
+    CHECK(pace != NULL);
+    CHECK_EQ_INT(TUPLE_CSTRING, pace->type);
+    CHECK_EQ_STR("5:30/km", pace->value->cstring);
+    CHECK(dict_find(&read, KEY_CMD) == NULL);
+}
+
+static void test_dict_write_reports_overflow(void) {
+    uint8_t buffer[10];
+    DictionaryIterator iter;
+    dict_write_begin(&iter, buffer, sizeof(buffer));
+    CHECK_EQ_INT(DICT_OK, dict_write_uint16(&iter, KEY_NUMBER, 60));
+    CHECK_EQ_INT(DICT_NOT_ENOUGH_STORAGE, dict_write_uint8(&iter, KEY_CMD, 1));
+}
+
+static int s_timer_hits;
+
+static void count_timer(void *data) {
+    s_timer_hits += (int)(intptr_t)data;
+}
+
+static void test_timers_follow_virtual_clock(void) {
+    s_timer_hits = 0;
+    uint64_t start = stub_clock_now_ms();
+    app_timer_register(1500, count_timer, (void *)1);
+    AppTimer *cancelled = app_timer_register(500, count_timer, (void *)100);
+    app_timer_cancel(cancelled);
+
+    stub_advance_ms(1000);
+    CHECK_EQ_INT(0, s_timer_hits);
+    CHECK_EQ_INT(start / 1000 + 1, time(NULL));
+
+    stub_advance_ms(500);
+    CHECK_EQ_INT(1, s_timer_hits);
+    CHECK_EQ_INT(1, stub_get_stats()->timers_fired);
+}
+
+static void test_outbox_is_busy_until_acked(void) {
+    CHECK_EQ_INT(APP_MSG_OK, app_message_open(64, 64));
+
+    DictionaryIterator *iter;
+    CHECK_EQ_INT(APP_MSG_OK, app_message_outbox_begin(&iter));
+    dict_write_uint8(iter, KEY_CMD, CMD_START);
+    CHECK_EQ_INT(APP_MSG_OK, app_message_outbox_send());
+    CHECK(stub_appmsg_outbox_pending());
+    CHECK_EQ_INT(APP_MSG_BUSY, app_message_outbox_begin(&iter));
+
+    stub_appmsg_ack();
+    CHECK(!stub_appmsg_outbox_pending());
+    CHECK_EQ_INT(APP_MSG_OK, app_message_outbox_begin(&iter));
+    CHECK_EQ_INT(1, stub_get_stats()->outbox_acks);
+}
+
+void run_stub_tests(void) {
+    RUN_TEST(test_dict_layout_matches_sdk);
+    RUN_TEST(test_dict_write_reports_overflow);
+    RUN_TEST(test_timers_follow_virtual_clock);
+    RUN_TEST(test_outbox_is_busy_until_acked);
+}
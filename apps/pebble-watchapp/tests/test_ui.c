@@ -0,0 +1,168 @@
+#include "test.h"
+
+#include "ui.h"
+
+static void scenario_show_renders_full_frame(void) {
+    ui_show_window();
+    stub_render();
+
+    const StubStats *stats = stub_get_stats();
+    CHECK_EQ_INT(1, stats->renders);
+    CHECK_EQ_INT(3, stats->text_draws);
+    CHECK(stats->fill_pixels >= STUB_SCREEN_WIDTH * STUB_SCREEN_HEIGHT);
+}
+
+static void test_show_renders_full_frame(void) {
+    test_run_app(scenario_show_renders_full_frame);
+}
+
+static void scenario_hr_update_repaints_hr_band(void) {
+    ui_show_window();
+    stub_render();
+    stub_advance_ms(UI_FRAME_INTERVAL_MS);
+    stub_reset_stats();
+
+    ui_update_hr(150);
+    stub_render();
+
+    const StubStats *stats = stub_get_stats();
+    CHECK_EQ_INT(1, stats->renders);
+    CHECK_EQ_INT(1, stats->text_draws);
+    CHECK_EQ_INT(STUB_SCREEN_WIDTH * 40, stats->fill_pixels);
+}
+
+static void test_hr_update_repaints_hr_band(void) {
+    test_run_app(scenario_hr_update_repaints_hr_band);
+}
+
+static void scenario_tick_repaints_time_band(void) {
+    ui_show_window();
+    stub_render();
+    stub_reset_stats();
+
+    ui_update_elapsed(1);
+    stub_render();
+
+    const StubStats *stats = stub_get_stats();
+    CHECK_EQ_INT(1, stats->renders);
+    CHECK_EQ_INT(1, stats->text_draws);
+    CHECK_EQ_INT(STUB_SCREEN_WIDTH * 30, stats->fill_pixels);
+
+    // Unchanged values do not invalidate anything
+    ui_update_elapsed(1);
+    ui_update_hr(g_app_state.current_hr);
+    CHECK(!stub_window_is_dirty());
+}
+
+static void test_tick_repaints_time_band(void) {
+    test_run_app(scenario_tick_repaints_time_band);
+}
+
+static void scenario_stats_update_repaints_stats_band(void) {
+    ui_show_window();
+    stub_render();
+    stub_advance_ms(UI_FRAME_INTERVAL_MS);
+    stub_reset_stats();
+
+    // Rolling mean, average and maximum share the bottom band
+    ui_update_hr_stats(152, 148, 171);
+    CHECK_EQ_STR("30s 152 avg 148 max 171", g_app_state.text.hr_stats);
+    stub_render();
+
+    const StubStats *stats = stub_get_stats();
+    CHECK_EQ_INT(1, stats->renders);
+    CHECK_EQ_INT(1, stats->text_draws);
+    CHECK_EQ_INT(strlen("30s 152 avg 148 max 171"), stats->text_bytes);
+    CHECK_EQ_INT(STUB_SCREEN_WIDTH * 24, stats->fill_pixels);
+}
+
+static void test_stats_update_repaints_stats_band(void) {
+    test_run_app(scenario_stats_update_repaints_stats_band);
+}
+
+static void scenario_updates_within_a_frame_coalesce(void) {
+    ui_show_window();
+    stub_render();
+    stub_reset_stats();
+
+    // Everything after the first frame of a slot waits for the next one
+    ui_update_hr(150);
+    WorkoutMetrics metrics = g_app_state.workout;
+    metrics.pace_s_per_km = 330;
+    ui_update_workout(&metrics);
+    stub_advance_ms(UI_FRAME_INTERVAL_MS / 2);
+    CHECK_EQ_INT(0, stub_get_stats()->renders);
+
+    stub_advance_ms(UI_FRAME_INTERVAL_MS / 2 + UI_FRAME_TICK_GRACE_MS);
+    const StubStats *stats = stub_get_stats();
+    CHECK_EQ_INT(1, stats->renders);
+    CHECK_EQ_INT(2, stats->text_draws);
+    CHECK_EQ_INT(150, g_app_state.current_hr);
+}
+
+static void test_updates_within_a_frame_coalesce(void) {
+    test_run_app(scenario_updates_within_a_frame_coalesce);
+}
+
+static void scenario_tick_flushes_deferred_changes(void) {
+    ui_show_window();
+    stub_render();
+    stub_reset_stats();
+
+    ui_update_hr(150);
+    stub_advance_ms(UI_FRAME_INTERVAL_MS);
+    ui_update_elapsed(1);
+    stub_render();
+
+    const StubStats *stats = stub_get_stats();
+    CHECK_EQ_INT(1, stats->renders);
+    CHECK_EQ_INT(2, stats->text_draws);
+
+    // The pending flush timer was cancelled by the tick's commit
+    stub_advance_ms(UI_FRAME_INTERVAL_MS);
+    CHECK_EQ_INT(1, stub_get_stats()->renders);
+}
+
+static void test_tick_flushes_deferred_changes(void) {
+    test_run_app(scenario_tick_flushes_deferred_changes);
+}
+
+static void scenario_identical_text_skips_render(void) {
+    ui_show_window();
+    stub_render();
+    stub_reset_stats();
+
+    ui_update_hr(150);
+    ui_update_hr(0);
+    stub_advance_ms(UI_FRAME_INTERVAL_MS + UI_FRAME_TICK_GRACE_MS);
+
+    CHECK_EQ_INT(0, stub_get_stats()->renders);
+    CHECK_EQ_INT(0, stub_get_stats()->text_draws);
+}
+
+static void test_identical_text_skips_render(void) {
+    test_run_app(scenario_identical_text_skips_render);
+}
+
+static void scenario_hidden_window_does_not_render(void) {
+    WorkoutMetrics metrics = { .elapsed_s = 1 };
+    ui_update_workout(&metrics);
+    stub_render();
+    CHECK_EQ_INT(0, stub_get_stats()->renders);
+    CHECK_EQ_INT(1, g_app_state.workout.elapsed_s);
+}
+
+static void test_hidden_window_does_not_render(void) {
+    test_run_app(scenario_hidden_window_does_not_render);
+}
+
+void run_ui_tests(void) {
+    RUN_TEST(test_show_renders_full_frame);
+    RUN_TEST(test_hr_update_repaints_hr_band);
+    RUN_TEST(test_tick_repaints_time_band);
+    RUN_TEST(test_stats_update_repaints_stats_band);
+    RUN_TEST(test_updates_within_a_frame_coalesce);
+    RUN_TEST(test_tick_flushes_deferred_changes);
+    RUN_TEST(test_identical_text_skips_render);
+    RUN_TEST(test_hidden_window_does_not_render);
+}
@@ -0,0 +1,218 @@
+#include "test.h"
+
+#include "appmsg.h"
+#include "hr.h"
+#include "session.h"
+#include "ui.h"
+#include "workout.h"
+
+static void emit_hr(HealthValue bpm) {
+    stub_health_set_value(HealthMetricHeartRateBPM, bpm);
+    stub_health_emit(HealthEventHeartRateUpdate);
+}
+
+static void deliver_frame(uint32_t elapsed_s, uint8_t flags) {
+    uint8_t frame[WORKOUT_FRAME_SIZE] = { WORKOUT_FRAME_VERSION };
+    frame[WORKOUT_ELAPSED_OFFSET] = (uint8_t)elapsed_s;
+    frame[WORKOUT_ELAPSED_OFFSET + 1] = (uint8_t)(elapsed_s >> 8);
+    frame[WORKOUT_FLAGS_OFFSET] = flags;
+    test_deliver_data(KEY_WORKOUT, frame, sizeof(frame));
+}
+
+static void scenario_pause_and_resume_commands(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    CHECK_EQ_INT(WORKOUT_RUNNING, workout_state());
+    stub_advance_ms(10 * 1000);
+
+    test_deliver_uint8(KEY_CMD, CMD_PAUSE);
+    CHECK_EQ_INT(WORKOUT_PAUSED, workout_state());
+    CHECK_EQ_INT(WORKOUT_PAUSED, g_app_state.state);
+    CHECK_EQ_INT(HR_PERIOD_SLOW_S, stub_health_sample_period());
+    CHECK(!stub_tick_is_subscribed());
+    stub_advance_ms(30 * 1000);
+    CHECK_EQ_INT(10, g_app_state.workout.elapsed_s);
+
+    test_deliver_uint8(KEY_CMD, CMD_RESUME);
+    CHECK_EQ_INT(WORKOUT_RUNNING, workout_state());
+    CHECK_EQ_INT(HR_PERIOD_FAST_S, stub_health_sample_period());
+    stub_advance_ms(5 * 1000);
+    CHECK_EQ_INT(15, g_app_state.workout.elapsed_s);
+}
+
+static void test_pause_and_resume_commands(void) {
+    test_run_app(scenario_pause_and_resume_commands);
+}
+
+static void scenario_out_of_state_commands_are_ignored(void) {
+    test_deliver_uint8(KEY_CMD, CMD_PAUSE);
+    test_deliver_uint8(KEY_CMD, CMD_RESUME);
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+    CHECK_EQ_INT(WORKOUT_IDLE, workout_state());
+    CHECK(window_stack_get_top_window() == NULL);
+
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    test_deliver_uint8(KEY_CMD, CMD_RESUME);
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    CHECK_EQ_INT(WORKOUT_RUNNING, workout_state());
+    CHECK(session_is_running());
+}
+
+static void test_out_of_state_commands_are_ignored(void) {
+    test_run_app(scenario_out_of_state_commands_are_ignored);
+}
+
+static void scenario_paused_batches_wait_longer(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    test_deliver_uint8(KEY_CMD, CMD_PAUSE);
+    stub_reset_stats();
+
+    emit_hr(90);
+    stub_advance_ms(HR_BATCH_MAX_AGE_MS);
+    CHECK_EQ_INT(0, stub_get_stats()->outbox_sends);
+    CHECK_EQ_INT(1, hr_pending_samples());
+
+    stub_advance_ms(HR_BATCH_PAUSED_MAX_AGE_MS - HR_BATCH_MAX_AGE_MS);
+    CHECK_EQ_INT(1, stub_get_stats()->outbox_sends);
+    CHECK_EQ_INT(0, hr_pending_samples());
+}
+
+static void test_paused_batches_wait_longer(void) {
+    test_run_app(scenario_paused_batches_wait_longer);
+}
+
+static void scenario_stop_waits_for_queue_to_drain(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    emit_hr(140);
+    emit_hr(141);
+
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+    CHECK_EQ_INT(WORKOUT_STOPPING, workout_state());
+    CHECK(stub_appmsg_outbox_pending());
+    CHECK(window_stack_get_top_window() != NULL);
+
+    // The HR summary follows the last batch
+    stub_appmsg_ack();
+    stub_advance_ms(WORKOUT_STOP_POLL_MS);
+    CHECK_EQ_INT(WORKOUT_STOPPING, workout_state());
+    DictionaryIterator sent;
+    CHECK(stub_appmsg_last_sent(&sent));
+    CHECK(dict_find(&sent, KEY_HR_SUMMARY) != NULL);
+
+    stub_appmsg_ack();
+    stub_advance_ms(WORKOUT_STOP_POLL_MS);
+    CHECK_EQ_INT(WORKOUT_IDLE, workout_state());
+    CHECK(window_stack_get_top_window() == NULL);
+    CHECK(!g_app_state.is_active);
+}
+
+static void test_stop_waits_for_queue_to_drain(void) {
+    test_run_app(scenario_stop_waits_for_queue_to_drain);
+}
+
+static void scenario_stop_gives_up_after_timeout(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    emit_hr(140);
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+
+    stub_advance_ms(WORKOUT_STOP_TIMEOUT_MS - WORKOUT_STOP_POLL_MS);
+    CHECK_EQ_INT(WORKOUT_STOPPING, workout_state());
+    stub_advance_ms(WORKOUT_STOP_POLL_MS);
+    CHECK_EQ_INT(WORKOUT_IDLE, workout_state());
+    CHECK(window_stack_get_top_window() == NULL);
+}
+
+static void test_stop_gives_up_after_timeout(void) {
+    test_run_app(scenario_stop_gives_up_after_timeout);
+}
+
+static void scenario_stop_while_disconnected(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    for (int i = 0; i < 5; i++) {
+        emit_hr(140);
+        stub_advance_ms(1000);
+    }
+    stub_connection_set(false);
+    test_deliver_uint8(KEY_CMD, CMD_STOP);
+    stub_advance_ms(WORKOUT_STOP_TIMEOUT_MS);
+    CHECK_EQ_INT(WORKOUT_IDLE, workout_state());
+    CHECK(persist_exists(APPMSG_PERSIST_KEY_SUMMARY));
+}
+
+static void scenario_relaunch_sends_the_summary(void) {
+    // Sent right after the HELLO, and forgotten once acknowledged
+    DictionaryIterator sent;
+    CHECK(stub_appmsg_last_sent(&sent));
+    Tuple *summary = dict_find(&sent, KEY_HR_SUMMARY);
+    CHECK(summary != NULL);
+    if (summary) {
+        CHECK_EQ_INT(140, summary->value->data[HR_SUMMARY_AVG_OFFSET]);
+    }
+    stub_appmsg_ack();
+    CHECK(!persist_exists(APPMSG_PERSIST_KEY_SUMMARY));
+}
+
+static void test_summary_outlives_an_undelivered_stop(void) {
+    test_run_app(scenario_stop_while_disconnected);
+    stub_app_exit();
+    stub_connection_set(true);
+    test_run_app(scenario_relaunch_sends_the_summary);
+}
+
+static void scenario_frame_joins_paused_workout(void) {
+    deliver_frame(600, WORKOUT_FLAG_PAUSED);
+    CHECK_EQ_INT(WORKOUT_PAUSED, workout_state());
+    CHECK(window_stack_get_top_window() != NULL);
+    CHECK_EQ_INT(HR_PERIOD_SLOW_S, stub_health_sample_period());
+    CHECK_EQ_INT(600, g_app_state.workout.elapsed_s);
+
+    // Once joined, only RESUME leaves the pause
+    deliver_frame(601, 0);
+    CHECK_EQ_INT(WORKOUT_PAUSED, workout_state());
+    CHECK(!session_is_running());
+    test_deliver_uint8(KEY_CMD, CMD_RESUME);
+    CHECK_EQ_INT(WORKOUT_RUNNING, workout_state());
+    CHECK(session_is_running());
+}
+
+static void test_frame_joins_paused_workout(void) {
+    test_run_app(scenario_frame_joins_paused_workout);
+}
+
+static void scenario_frames_do_not_undo_a_pause(void) {
+    test_deliver_uint8(KEY_CMD, CMD_START);
+    stub_advance_ms(20 * 1000);
+    test_deliver_uint8(KEY_CMD, CMD_PAUSE);
+
+    // The phone's periodic resend carries no paused flag
+    stub_advance_ms(30 * 1000);
+    deliver_frame(20, 0);
+    CHECK_EQ_INT(WORKOUT_PAUSED, workout_state());
+    CHECK_EQ_INT(WORKOUT_PAUSED, g_app_state.state);
+    CHECK(!session_is_running());
+    CHECK(!stub_tick_is_subscribed());
+    CHECK_EQ_INT(HR_PERIOD_SLOW_S, stub_health_sample_period());
+    stub_advance_ms(30 * 1000);
+    CHECK_EQ_INT(20, g_app_state.workout.elapsed_s);
+
+    // Nor does a paused flag pause a running workout
+    test_deliver_uint8(KEY_CMD, CMD_RESUME);
+    deliver_frame(20, WORKOUT_FLAG_PAUSED);
+    CHECK_EQ_INT(WORKOUT_RUNNING, workout_state());
+    CHECK(session_is_running());
+    CHECK_EQ_INT(HR_PERIOD_FAST_S, stub_health_sample_period());
+}
+
+static void test_frames_do_not_undo_a_pause(void) {
+    test_run_app(scenario_frames_do_not_undo_a_pause);
+}
+
+void run_workout_tests(void) {
+    RUN_TEST(test_pause_and_resume_commands);
+    RUN_TEST(test_out_of_state_commands_are_ignored);
+    RUN_TEST(test_paused_batches_wait_longer);
+    RUN_TEST(test_stop_waits_for_queue_to_drain);
+    RUN_TEST(test_stop_gives_up_after_timeout);
+    RUN_TEST(test_summary_outlives_an_undelivered_stop);
+    RUN_TEST(test_frame_joins_paused_workout);
+    RUN_TEST(test_frames_do_not_undo_a_pause);
+}
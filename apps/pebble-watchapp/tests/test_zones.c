@@ -0,0 +1,124 @@
+#include "test.h"
+
+#include "zones.h"
+
+static void test_default_bounds_match_the_phone(void) {
+    zones_init();
+    // Percent of ZONES_DEFAULT_MAX_HR_BPM = 190
+    CHECK_EQ_INT(1, zones_classify(40));
+    CHECK_EQ_INT(1, zones_classify(113));
+    CHECK_EQ_INT(2, zones_classify(114));
+    CHECK_EQ_INT(3, zones_classify(133));
+    CHECK_EQ_INT(4, zones_classify(152));
+    CHECK_EQ_INT(4, zones_classify(170));
+    CHECK_EQ_INT(5, zones_classify(171));
+    CHECK_EQ_INT(5, zones_classify(250));
+}
+
+static void test_max_hr_derives_bounds(void) {
+    zones_init();
+    zones_set_max_hr(200);
+    CHECK_EQ_INT(1, zones_classify(119));
+    CHECK_EQ_INT(2, zones_classify(120));
+    CHECK_EQ_INT(3, zones_classify(140));
+    CHECK_EQ_INT(4, zones_classify(160));
+    CHECK_EQ_INT(5, zones_classify(180));
+
+    // Too low to give rising bounds, so ignored
+    zones_set_max_hr(3);
+    CHECK_EQ_INT(5, zones_classify(180));
+}
+
+static void test_thresholds_and_zone_zero(void) {
+    const uint8_t lower[HR_STATS_ZONE_COUNT] = { 93, 111, 130, 148, 167 };
+    zones_init();
+    CHECK(zones_set_thresholds(lower));
+    CHECK_EQ_INT(0, zones_classify(92));
+    CHECK_EQ_INT(1, zones_classify(93));
+    CHECK_EQ_INT(4, zones_classify(166));
+    CHECK_EQ_INT(5, zones_classify(167));
+
+    const uint8_t falling[HR_STATS_ZONE_COUNT] = { 93, 111, 110, 148, 167 };
+    CHECK(!zones_set_thresholds(falling));
+    CHECK_EQ_INT(1, zones_classify(93));
+}
+
+static void test_bounds_survive_a_restart(void) {
+    const uint8_t lower[HR_STATS_ZONE_COUNT] = { 93, 111, 130, 148, 167 };
+    zones_init();
+    CHECK(zones_set_thresholds(lower));
+    CHECK(persist_exists(ZONES_PERSIST_KEY));
+
+    zones_init();
+    CHECK_EQ_INT(0, zones_classify(92));
+    CHECK_EQ_INT(5, zones_classify(167));
+}
+
+#define T0 1700000000
+
+static void test_transitions_need_the_margin(void) {
+    zones_init();
+    uint32_t t = T0;
+    CHECK(!zones_update(t, 150));
+    CHECK_EQ_INT(3, zones_current());
+
+    // On and just past the zone 4 bound at 152 never starts the hold
+    for (int i = 0; i < 2 * ZONES_CONFIRM_S; i++) {
+        CHECK(!zones_update(++t, 152 + i % ZONES_HYSTERESIS_BPM));
+    }
+    CHECK_EQ_INT(3, zones_current());
+
+    // Clear of the margin, the change waits out the hold
+    uint32_t since = ++t;
+    CHECK(!zones_update(since, 152 + ZONES_HYSTERESIS_BPM));
+    while (++t < since + ZONES_CONFIRM_S) {
+        CHECK(!zones_update(t, 152 + ZONES_HYSTERESIS_BPM));
+    }
+    CHECK(zones_update(t, 152 + ZONES_HYSTERESIS_BPM));
+    CHECK_EQ_INT(4, zones_current());
+
+    // Back under the bound stays in zone 4 until clear of the margin
+    CHECK(!zones_update(t += ZONES_CONFIRM_S, 151));
+    CHECK(!zones_update(t += ZONES_CONFIRM_S, 152 - ZONES_HYSTERESIS_BPM));
+    CHECK_EQ_INT(4, zones_current());
+}
+
+static void test_dips_shorter_than_the_hold_are_ignored(void) {
+    zones_init();
+    uint32_t t = T0;
+    zones_update(t, 160);
+
+    // Each return to zone 4 restarts the hold
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < ZONES_CONFIRM_S - 1; j++) {
+            CHECK(!zones_update(++t, 140));
+        }
+        CHECK(!zones_update(++t, 160));
+    }
+    CHECK_EQ_INT(4, zones_current());
+
+    // A big jump that holds skips zones in one transition
+    uint32_t since = ++t;
+    zones_update(since, 100);
+    CHECK(zones_update(since + ZONES_CONFIRM_S, 100));
+    CHECK_EQ_INT(1, zones_current());
+}
+
+static void test_new_bounds_restart_tracking(void) {
+    zones_init();
+    zones_update(T0, 150);
+    zones_set_max_hr(160);
+    CHECK_EQ_INT(0, zones_current());
+    CHECK(!zones_update(T0 + 1, 150));
+    CHECK_EQ_INT(5, zones_current());
+}
+
+void run_zones_tests(void) {
+    RUN_TEST(test_default_bounds_match_the_phone);
+    RUN_TEST(test_max_hr_derives_bounds);
+    RUN_TEST(test_thresholds_and_zone_zero);
+    RUN_TEST(test_bounds_survive_a_restart);
+    RUN_TEST(test_transitions_need_the_margin);
+    RUN_TEST(test_dips_shorter_than_the_hold_are_ignored);
+    RUN_TEST(test_new_bounds_restart_tracking);
+}
@@ -7,7 +7,17 @@ import com.arikachmad.pebblerun.bridge.pebble.model.PebbleConnectionState
 import com.arikachmad.pebblerun.bridge.pebble.model.PebbleResult
 import com.arikachmad.pebblerun.bridge.pebble.model.WorkoutCommand
 import com.arikachmad.pebblerun.bridge.pebble.model.WorkoutDataToPebble
+import com.arikachmad.pebblerun.proto.FrameSequenceTracker
+import com.arikachmad.pebblerun.proto.HRBatchFrame
+import com.arikachmad.pebblerun.proto.HRMinutesFrame
+import com.arikachmad.pebblerun.proto.HRRecord
+import com.arikachmad.pebblerun.proto.HRSummaryFrame
+import com.arikachmad.pebblerun.proto.HelloFrame
 import com.arikachmad.pebblerun.proto.PebbleMessageKeys
+import com.arikachmad.pebblerun.proto.PerfFrame
+import com.arikachmad.pebblerun.proto.ResendRequest
+import com.arikachmad.pebblerun.proto.WorkoutFrame
+import com.arikachmad.pebblerun.proto.ZoneConfigFrame
 // PebbleKit imports - now enabled
 import com.getpebble.android.kit.PebbleKit
 import com.getpebble.android.kit.util.PebbleDictionary
@@ -17,7 +27,7 @@ import kotlinx.coroutines.flow.asStateFlow
 import kotlinx.coroutines.channels.awaitClose
 import kotlinx.coroutines.flow.callbackFlow
 import kotlinx.coroutines.delay
-import kotlinx.datetime.Clock
+import kotlinx.datetime.Instant
 import java.util.UUID
 
 /**
@@ -41,28 +51,104 @@ actual class PebbleTransport(private val context: Context) {
     actual val connectionStateFlow: Flow<PebbleConnectionState> = _connectionStateFlow.asStateFlow()
     
     private var messageReceiver: BroadcastReceiver? = null
+    private var dataLogReceiver: BroadcastReceiver? = null
     private var connectionReceiver: BroadcastReceiver? = null
     private var nackReceiver: BroadcastReceiver? = null
     
+    // What the watch announced at launch; null until its HELLO arrives
+    private var watchHello: HelloFrame? = null
+    
+    private val _liveHeartRateFlow = MutableStateFlow<HRDataFromPebble?>(null)
+    actual val liveHeartRateFlow: Flow<HRDataFromPebble?> = _liveHeartRateFlow.asStateFlow()
+    
+    private val _hrSummaryFlow = MutableStateFlow<HRSummaryFrame?>(null)
+    actual val hrSummaryFlow: Flow<HRSummaryFrame?> = _hrSummaryFlow.asStateFlow()
+    
+    private val _perfFlow = MutableStateFlow<PerfFrame?>(null)
+    actual val perfFlow: Flow<PerfFrame?> = _perfFlow.asStateFlow()
+    
     /**
      * Flow of HR data from Pebble device.
      * Uses callbackFlow to convert PebbleKit callbacks to Flow.
      * Does not leak platform callbacks to domain layer per bridge instructions.
      */
     actual val heartRateFlow: Flow<HRDataFromPebble> = callbackFlow {
+        val sequenceTracker = FrameSequenceTracker()
         val receiver = object : PebbleKit.PebbleDataReceiver(PEBBLERUN_UUID) {
             override fun receiveData(context: Context?, transactionId: Int, data: PebbleDictionary?) {
                 try {
-                    val heartRate = data?.getInteger(PebbleMessageKeys.KEY_HEART_RATE)
-                    val quality = data?.getInteger(PebbleMessageKeys.KEY_HR_QUALITY) ?: 1L
+                    data?.getBytes(PebbleMessageKeys.KEY_HELLO)?.let { payload ->
+                        watchHello = HelloFrame.decode(payload)
+                    }
                     
-                    if (heartRate != null && PebbleMessageKeys.isValidHeartRate(heartRate.toInt())) {
-                        val hrData = HRDataFromPebble(
-                            heartRate = heartRate.toInt(),
-                            quality = quality.toInt(),
-                            timestamp = Clock.System.now()
-                        )
-                        trySend(hrData)
+                    // Frames from a watch on another protocol version do not decode
+                    // with these layouts; they are acknowledged and dropped
+                    if (watchHello?.isCompatible == false) {
+                        PebbleKit.sendAckToPebble(context, transactionId)
+                        return
+                    }
+                    
+                    // Samples carry their own watch timestamps and the frame their
+                    // quality; sequence gaps are requested again and retransmitted
+                    // duplicates dropped
+                    data?.getBytes(PebbleMessageKeys.KEY_HR_BATCH)?.let { payload ->
+                        val batch = HRBatchFrame.decode(payload) ?: return@let
+                        val sequence = sequenceTracker.accept(batch.sequence)
+                        sequence.missing.forEach { request -> requestResend(request) }
+                        if (!sequence.isNew) {
+                            return@let
+                        }
+                        batch.samples
+                            .filter { PebbleMessageKeys.isValidHeartRate(it.heartRate) }
+                            .forEach { sample ->
+                                trySend(
+                                    HRDataFromPebble(
+                                        heartRate = sample.heartRate,
+                                        quality = batch.quality,
+                                        timestamp = Instant.fromEpochSeconds(sample.epochSeconds)
+                                    )
+                                )
+                            }
+                    }
+                    
+                    // Minute averages from the watch's health history cover only time it
+                    // kept no samples for (a low battery, an overflowing journal), so they
+                    // never overlap the batches; they are averages, so never better than OK
+                    data?.getBytes(PebbleMessageKeys.KEY_HR_MINUTES)?.let { payload ->
+                        HRMinutesFrame.decode(payload)?.minutes
+                            ?.filter { PebbleMessageKeys.isValidHeartRate(it.heartRate) }
+                            ?.forEach { minute ->
+                                trySend(
+                                    HRDataFromPebble(
+                                        heartRate = minute.heartRate,
+                                        quality = PebbleMessageKeys.HR_BATCH_QUALITY_OK,
+                                        timestamp = Instant.fromEpochSeconds(minute.epochSeconds)
+                                    )
+                                )
+                            }
+                    }
+                    
+                    // Display only: with DataLogging as the uplink the same sample
+                    // also arrives through the spool, so it is not history
+                    data?.getBytes(PebbleMessageKeys.KEY_HR_LIVE)?.let { payload ->
+                        val record = HRRecord.decode(payload) ?: return@let
+                        if (PebbleMessageKeys.isValidHeartRate(record.heartRate)) {
+                            _liveHeartRateFlow.value = HRDataFromPebble(
+                                heartRate = record.heartRate,
+                                quality = record.quality,
+                                timestamp = Instant.fromEpochSeconds(record.epochSeconds)
+                            )
+                        }
+                    }
+                    
+                    data?.getBytes(PebbleMessageKeys.KEY_HR_SUMMARY)?.let { payload ->
+                        HRSummaryFrame.decode(payload)?.let { _hrSummaryFlow.value = it }
+                    }
+                    
+                    // A snapshot spans frames with the same header
+                    data?.getBytes(PebbleMessageKeys.KEY_PERF)?.let { payload ->
+                        val frame = PerfFrame.decode(payload) ?: return@let
+                        _perfFlow.value = _perfFlow.value?.mergedWith(frame) ?: frame
                     }
                     
                     // Always ACK the message to confirm receipt
@@ -74,13 +160,36 @@ actual class PebbleTransport(private val context: Context) {
             }
         }
         
-        // Register the data receiver with PebbleKit
+        // After sendUplink(true) the watch spools history into a DataLogging session
+        // tagged with the workout's start; the firmware delivers it in the background,
+        // so records can arrive after the workout. Each sample comes only this way or,
+        // when the spool is full, in an HR_BATCH; the live value is kept out of history
+        val logReceiver = object : PebbleKit.PebbleDataLogReceiver(PEBBLERUN_UUID) {
+            override fun receiveData(context: Context?, logUuid: UUID?, timestamp: Long?, tag: Long?, data: ByteArray?) {
+                val record = data?.let { HRRecord.decode(it) } ?: return
+                if (PebbleMessageKeys.isValidHeartRate(record.heartRate)) {
+                    trySend(
+                        HRDataFromPebble(
+                            heartRate = record.heartRate,
+                            quality = record.quality,
+                            timestamp = Instant.fromEpochSeconds(record.epochSeconds)
+                        )
+                    )
+                }
+            }
+        }
+        
+        // Register the data receivers with PebbleKit
         messageReceiver = PebbleKit.registerReceivedDataHandler(context, receiver)
+        dataLogReceiver = PebbleKit.registerDataLogReceiver(context, logReceiver)
         
         awaitClose {
             messageReceiver?.let { 
                 context.unregisterReceiver(it)
             }
+            dataLogReceiver?.let {
+                context.unregisterReceiver(it)
+            }
         }
     }
     
@@ -131,14 +240,14 @@ actual class PebbleTransport(private val context: Context) {
         }
         
         val commandValue = when (command) {
-            WorkoutCommand.START -> PebbleMessageKeys.COMMAND_START_WORKOUT
-            WorkoutCommand.STOP -> PebbleMessageKeys.COMMAND_STOP_WORKOUT
-            WorkoutCommand.PAUSE -> PebbleMessageKeys.COMMAND_PAUSE_WORKOUT
-            WorkoutCommand.RESUME -> PebbleMessageKeys.COMMAND_RESUME_WORKOUT
+            WorkoutCommand.START -> PebbleMessageKeys.CMD_START
+            WorkoutCommand.STOP -> PebbleMessageKeys.CMD_STOP
+            WorkoutCommand.PAUSE -> PebbleMessageKeys.CMD_PAUSE
+            WorkoutCommand.RESUME -> PebbleMessageKeys.CMD_RESUME
         }
         
         val data = PebbleDictionary().apply {
-            addInt32(PebbleMessageKeys.KEY_COMMAND, commandValue)
+            addUint8(PebbleMessageKeys.KEY_CMD, commandValue.toByte())
         }
         
         return sendMessageWithRetry(data, "workout command")
@@ -158,15 +267,72 @@ actual class PebbleTransport(private val context: Context) {
             return PebbleResult.Error("Invalid pace value: ${data.pace}")
         }
         
+        val frame = WorkoutFrame(
+            elapsedSeconds = data.duration,
+            paceSecondsPerKm = data.pace.toInt(),
+            distanceMeters = data.distance.toInt()
+        )
         val pebbleData = PebbleDictionary().apply {
-            addInt32(PebbleMessageKeys.KEY_PACE, (data.pace * 100).toInt()) // Send as centiseconds
-            addInt32(PebbleMessageKeys.KEY_DURATION, data.duration)
-            addInt32(PebbleMessageKeys.KEY_DISTANCE, data.distance.toInt())
+            addBytes(PebbleMessageKeys.KEY_WORKOUT, frame.encode())
         }
         
         return sendMessageWithRetry(pebbleData, "workout data")
     }
     
+    /**
+     * Send the user's HR zones; the watch classifies readings against them locally.
+     */
+    actual suspend fun sendZoneConfig(config: ZoneConfigFrame): PebbleResult<Unit> {
+        if (!isConnected()) {
+            return PebbleResult.Disconnected
+        }
+        
+        val data = PebbleDictionary().apply {
+            addBytes(PebbleMessageKeys.KEY_ZONES, config.encode())
+        }
+        return sendMessageWithRetry(data, "zone config")
+    }
+    
+    /**
+     * Choose the channel for the watch's HR history; the watch keeps the choice.
+     */
+    actual suspend fun sendUplink(useDataLogging: Boolean): PebbleResult<Unit> {
+        if (!isConnected()) {
+            return PebbleResult.Disconnected
+        }
+        
+        val uplink = if (useDataLogging) PebbleMessageKeys.UPLINK_DATALOG else PebbleMessageKeys.UPLINK_APPMESSAGE
+        val data = PebbleDictionary().apply {
+            addUint8(PebbleMessageKeys.KEY_UPLINK, uplink.toByte())
+        }
+        return sendMessageWithRetry(data, "uplink")
+    }
+    
+    /**
+     * Ask the watch for a PERF snapshot; it arrives on [perfFlow].
+     */
+    actual suspend fun requestPerfSnapshot(): PebbleResult<Unit> {
+        if (!isConnected()) {
+            return PebbleResult.Disconnected
+        }
+        
+        val data = PebbleDictionary().apply {
+            addUint8(PebbleMessageKeys.KEY_CMD, PebbleMessageKeys.CMD_PERF_SNAPSHOT.toByte())
+        }
+        return sendMessageWithRetry(data, "perf snapshot request")
+    }
+    
+    /**
+     * Ask the watch to retransmit HR batch frames that never arrived.
+     * Fire and forget: frames the watch no longer holds are recovered by its journal and backfill.
+     */
+    private fun requestResend(request: ResendRequest) {
+        val data = PebbleDictionary().apply {
+            addBytes(PebbleMessageKeys.KEY_RESEND, request.encode())
+        }
+        PebbleKit.sendDataToPebble(context, PEBBLERUN_UUID, data)
+    }
+    
     /**
      * Check if Pebble is connected and ready for communication.
      */
@@ -186,6 +352,11 @@ actual class PebbleTransport(private val context: Context) {
             messageReceiver = null
         }
         
+        dataLogReceiver?.let {
+            context.unregisterReceiver(it)
+            dataLogReceiver = null
+        }
+        
         connectionReceiver?.let {
             context.unregisterReceiver(it)
             connectionReceiver = null
@@ -5,6 +5,9 @@ import com.arikachmad.pebblerun.bridge.pebble.model.PebbleConnectionState
 import com.arikachmad.pebblerun.bridge.pebble.model.PebbleResult
 import com.arikachmad.pebblerun.bridge.pebble.model.WorkoutCommand
 import com.arikachmad.pebblerun.bridge.pebble.model.WorkoutDataToPebble
+import com.arikachmad.pebblerun.proto.HRSummaryFrame
+import com.arikachmad.pebblerun.proto.PerfFrame
+import com.arikachmad.pebblerun.proto.ZoneConfigFrame
 import kotlinx.coroutines.flow.Flow
 
 /**
@@ -24,6 +27,25 @@ expect class PebbleTransport {
      */
     val heartRateFlow: Flow<HRDataFromPebble>
     
+    /**
+     * The watch's latest reading for display while it uploads history through DataLogging;
+     * null until one arrives. Not history: the same sample also reaches [heartRateFlow]
+     * through the spool. Received alongside [heartRateFlow].
+     */
+    val liveHeartRateFlow: Flow<HRDataFromPebble?>
+    
+    /**
+     * The watch's HR statistics for the last workout, sent at STOP; null until one arrives.
+     * Received alongside [heartRateFlow], so only while that is collected.
+     */
+    val hrSummaryFlow: Flow<HRSummaryFrame?>
+    
+    /**
+     * The watch's debug counters from the last [requestPerfSnapshot], its frames merged;
+     * null until one arrives. Received alongside [heartRateFlow].
+     */
+    val perfFlow: Flow<PerfFrame?>
+    
     /**
      * Flow of connection state changes.
      * Supports CON-004 (Graceful handling of Pebble disconnections).
@@ -50,6 +72,25 @@ expect class PebbleTransport {
      */
     suspend fun sendWorkoutData(data: WorkoutDataToPebble): PebbleResult<Unit>
     
+    /**
+     * Send the user's HR zones; the watch keeps them, so this is only needed when they change
+     * or before a workout.
+     */
+    suspend fun sendZoneConfig(config: ZoneConfigFrame): PebbleResult<Unit>
+    
+    /**
+     * Choose how the watch uploads HR history: DataLogging lets the firmware spool it
+     * in the background, leaving AppMessage with a live value a minute on [liveHeartRateFlow].
+     * Persisted on the watch.
+     */
+    suspend fun sendUplink(useDataLogging: Boolean): PebbleResult<Unit>
+    
+    /**
+     * Ask the watch for its handler timings and send failure counts, for comparing
+     * builds on real runs. The answer arrives on [perfFlow].
+     */
+    suspend fun requestPerfSnapshot(): PebbleResult<Unit>
+    
     /**
      * Check if Pebble is connected and ready for communication.
      * Supports connection state management requirements.
@@ -5,6 +5,7 @@ import com.arikachmad.pebblerun.bridge.pebble.model.PebbleConnectionState
 import com.arikachmad.pebblerun.bridge.pebble.model.PebbleResult
 import com.arikachmad.pebblerun.bridge.pebble.model.WorkoutCommand
 import com.arikachmad.pebblerun.bridge.pebble.model.WorkoutDataToPebble
+import com.arikachmad.pebblerun.proto.ZoneConfigFrame
 import kotlinx.coroutines.*
 import kotlinx.coroutines.flow.*
 import kotlin.time.Duration.Companion.seconds
@@ -23,6 +24,11 @@ class PebbleConnectionManager(
         private const val MAX_RECONNECT_ATTEMPTS = 10
         private const val CONNECTION_TIMEOUT_SECONDS = 30L
         private const val HEALTH_CHECK_INTERVAL_SECONDS = 10L
+        
+        // The watch counts elapsed time itself; workout data is only resent when
+        // the displayed pace moves or as a periodic drift correction
+        private const val WORKOUT_RESEND_INTERVAL_SECONDS = 30
+        private const val WORKOUT_PACE_RESEND_DELTA = 5
     }
     
     private val _connectionState = MutableStateFlow(PebbleConnectionState.DISCONNECTED)
@@ -34,6 +40,7 @@ class PebbleConnectionManager(
     private var reconnectJob: Job? = null
     private var healthCheckJob: Job? = null
     private var isAutoReconnectEnabled = true
+    private var lastSentWorkoutData: WorkoutDataToPebble? = null
     
     /**
      * Initialize connection manager and start monitoring.
@@ -130,19 +137,65 @@ class PebbleConnectionManager(
      * Automatically handles disconnections and retries.
      */
     suspend fun sendWorkoutCommand(command: WorkoutCommand): PebbleResult<Unit> {
+        if (command == WorkoutCommand.START || command == WorkoutCommand.STOP) {
+            lastSentWorkoutData = null
+        }
         return executeWithConnectionCheck {
             pebbleTransport.sendWorkoutCommand(command)
         }
     }
     
+    /**
+     * Send the user's HR zones with connection state management.
+     */
+    suspend fun sendZoneConfig(config: ZoneConfigFrame): PebbleResult<Unit> {
+        return executeWithConnectionCheck {
+            pebbleTransport.sendZoneConfig(config)
+        }
+    }
+    
+    /**
+     * Choose the watch's HR history channel with connection state management.
+     */
+    suspend fun sendUplink(useDataLogging: Boolean): PebbleResult<Unit> {
+        return executeWithConnectionCheck {
+            pebbleTransport.sendUplink(useDataLogging)
+        }
+    }
+    
+    /**
+     * Ask the watch for its debug counters with connection state management.
+     */
+    suspend fun requestPerfSnapshot(): PebbleResult<Unit> {
+        return executeWithConnectionCheck {
+            pebbleTransport.requestPerfSnapshot()
+        }
+    }
+    
     /**
      * Send workout data with connection state management.
+     * Skips updates the watch can derive from its own session clock.
      * Automatically handles disconnections and retries.
      */
     suspend fun sendWorkoutData(data: WorkoutDataToPebble): PebbleResult<Unit> {
-        return executeWithConnectionCheck {
+        if (!needsWorkoutResend(data)) {
+            return PebbleResult.Success(Unit)
+        }
+        
+        val result = executeWithConnectionCheck {
             pebbleTransport.sendWorkoutData(data)
         }
+        if (result is PebbleResult.Success) {
+            lastSentWorkoutData = data
+        }
+        return result
+    }
+    
+    private fun needsWorkoutResend(data: WorkoutDataToPebble): Boolean {
+        val last = lastSentWorkoutData ?: return true
+        return data.duration < last.duration ||
+            data.duration - last.duration >= WORKOUT_RESEND_INTERVAL_SECONDS ||
+            kotlin.math.abs(data.pace.toInt() - last.pace.toInt()) >= WORKOUT_PACE_RESEND_DELTA
     }
     
     /**
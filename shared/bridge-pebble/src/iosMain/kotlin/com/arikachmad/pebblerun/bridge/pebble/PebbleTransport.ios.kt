@@ -5,7 +5,10 @@ import com.arikachmad.pebblerun.bridge.pebble.model.PebbleConnectionState
 import com.arikachmad.pebblerun.bridge.pebble.model.PebbleResult
 import com.arikachmad.pebblerun.bridge.pebble.model.WorkoutCommand
 import com.arikachmad.pebblerun.bridge.pebble.model.WorkoutDataToPebble
+import com.arikachmad.pebblerun.proto.HRSummaryFrame
 import com.arikachmad.pebblerun.proto.PebbleMessageKeys
+import com.arikachmad.pebblerun.proto.PerfFrame
+import com.arikachmad.pebblerun.proto.ZoneConfigFrame
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.asStateFlow
@@ -61,6 +64,21 @@ actual class PebbleTransport {
         emptyFlow() // Placeholder for now
     }
     
+    /**
+     * The watch's latest reading for display; arrives with the HR data, so not yet on iOS.
+     */
+    actual val liveHeartRateFlow: Flow<HRDataFromPebble?> = emptyFlow()
+    
+    /**
+     * The watch's HR statistics at STOP; arrives with the HR data, so not yet on iOS.
+     */
+    actual val hrSummaryFlow: Flow<HRSummaryFrame?> = emptyFlow()
+    
+    /**
+     * The watch's debug counters; arrive with the HR data, so not yet on iOS.
+     */
+    actual val perfFlow: Flow<PerfFrame?> = emptyFlow()
+    
     /**
      * Initialize PebbleKit and start listening for device connections.
      * Simulator: Returns error indicating PebbleKit not supported
@@ -104,10 +122,10 @@ actual class PebbleTransport {
         
         return try {
             val commandValue = when (command) {
-                WorkoutCommand.START -> PebbleMessageKeys.COMMAND_START_WORKOUT
-                WorkoutCommand.STOP -> PebbleMessageKeys.COMMAND_STOP_WORKOUT
-                WorkoutCommand.PAUSE -> PebbleMessageKeys.COMMAND_PAUSE_WORKOUT
-                WorkoutCommand.RESUME -> PebbleMessageKeys.COMMAND_RESUME_WORKOUT
+                WorkoutCommand.START -> PebbleMessageKeys.CMD_START
+                WorkoutCommand.STOP -> PebbleMessageKeys.CMD_STOP
+                WorkoutCommand.PAUSE -> PebbleMessageKeys.CMD_PAUSE
+                WorkoutCommand.RESUME -> PebbleMessageKeys.CMD_RESUME
             }
             
             // TODO: Implement actual PebbleKit message sending for real device
@@ -150,6 +168,36 @@ actual class PebbleTransport {
         }
     }
     
+    /**
+     * Send the user's HR zones.
+     * Not implemented on iOS yet: returns an error rather than reporting a send
+     * that never happened.
+     */
+    actual suspend fun sendZoneConfig(config: ZoneConfigFrame): PebbleResult<Unit> {
+        // TODO: Send config.encode() under KEY_ZONES once PebbleKit sending is implemented
+        return PebbleResult.Error("Zone config not implemented on iOS")
+    }
+    
+    /**
+     * Choose the watch's HR history channel.
+     * Not implemented on iOS yet: returns an error rather than reporting a send
+     * that never happened.
+     */
+    actual suspend fun sendUplink(useDataLogging: Boolean): PebbleResult<Unit> {
+        // TODO: Send KEY_UPLINK once PebbleKit sending is implemented
+        return PebbleResult.Error("Uplink selection not implemented on iOS")
+    }
+    
+    /**
+     * Ask the watch for its debug counters.
+     * Not implemented on iOS yet: returns an error rather than reporting a send
+     * that never happened.
+     */
+    actual suspend fun requestPerfSnapshot(): PebbleResult<Unit> {
+        // TODO: Send CMD_PERF_SNAPSHOT once PebbleKit sending is implemented
+        return PebbleResult.Error("Perf snapshot request not implemented on iOS")
+    }
+    
     /**
      * Check if Pebble watch is connected.
      * Simulator: Always returns false
@@ -0,0 +1,499 @@
+#!/usr/bin/env python3
+"""Generates the AppMessage key headers for both sides from appmessage.json.
+
+    generate.py          rewrite the generated files
+    generate.py --check  exit non-zero if any generated file is stale
+
+Outputs the watchapp C header, the appKeys table in the watchapp's
+package.json, the Kotlin PebbleMessageKeys object and the conformance vectors
+consumed by the C and Kotlin tests.
+"""
+
+import json
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.normpath(os.path.join(HERE, "..", "..", ".."))
+SCHEMA = os.path.join(HERE, "appmessage.json")
+
+WATCH_DIR = os.path.join(ROOT, "apps", "pebble-watchapp")
+KOTLIN_PACKAGE = "com.arikachmad.pebblerun.proto"
+KOTLIN_DIR = "shared/proto/src/{}/kotlin/com/arikachmad/pebblerun/proto"
+
+OUTPUTS = {
+    "c_keys": os.path.join(WATCH_DIR, "src", "c", "message_keys.h"),
+    "c_vectors": os.path.join(WATCH_DIR, "tests", "schema_vectors.h"),
+    "app_keys": os.path.join(WATCH_DIR, "package.json"),
+    "kotlin_keys": os.path.join(ROOT, KOTLIN_DIR.format("commonMain"), "PebbleMessageKeys.kt"),
+    "kotlin_vectors": os.path.join(ROOT, KOTLIN_DIR.format("commonTest"), "SchemaVectors.kt"),
+}
+
+BANNER = "Generated by shared/proto/schema/generate.py from appmessage.json. Do not edit."
+
+TYPE_SIZES = {"uint8": 1, "uint16": 2, "uint32": 4}
+
+# Dictionary header (1) plus per tuple header (7), as dict_calc_buffer_size
+DICT_HEADER_SIZE = 1
+TUPLE_HEADER_SIZE = 7
+
+
+class SchemaError(Exception):
+    pass
+
+
+def camel(name):
+    return "".join(part.capitalize() for part in name.split("_"))
+
+
+def value_max(key):
+    if key["type"] == "bytes":
+        return key["max_size"]
+    return TYPE_SIZES[key["type"]]
+
+
+def dict_size(sizes):
+    return DICT_HEADER_SIZE + sum(TUPLE_HEADER_SIZE + size for size in sizes)
+
+
+def layout(fields):
+    offsets = []
+    offset = 0
+    for field in fields:
+        offsets.append((field["name"], offset, field["type"]))
+        offset += TYPE_SIZES[field["type"]]
+    return offsets, offset
+
+
+def load():
+    with open(SCHEMA) as f:
+        schema = json.load(f)
+
+    ids = [key["id"] for key in schema["keys"]]
+    if len(ids) != len(set(ids)):
+        raise SchemaError("duplicate key ids")
+
+    keys = {key["name"]: key for key in schema["keys"]}
+    for frame in schema["frames"]:
+        key = keys.get(frame["name"])
+        if not key or key["type"] != "bytes":
+            raise SchemaError("frame %s has no byte array key" % frame["name"])
+        _, size = layout(frame["header"])
+        if size > key["max_size"]:
+            raise SchemaError("frame %s does not fit its key" % frame["name"])
+
+    for record in schema["datalog"]:
+        if record["name"] in keys:
+            raise SchemaError("record %s clashes with a key" % record["name"])
+
+    for vector in schema["vectors"]:
+        expected = bytes.fromhex(vector["bytes"].replace(" ", ""))
+        if encode_vector(schema, vector) != expected:
+            raise SchemaError("vector %s does not match its frame layout" % vector["name"])
+    return schema
+
+
+def find_frame(schema, name):
+    for frame in schema["frames"]:
+        if frame["name"] == name:
+            return frame
+    raise SchemaError("unknown frame %s" % name)
+
+
+def find_record(schema, name):
+    for record in schema["datalog"]:
+        if record["name"] == name:
+            return record
+    raise SchemaError("unknown record %s" % name)
+
+
+def encode_fields(fields, values):
+    out = b""
+    for field in fields:
+        out += values[field["name"]].to_bytes(TYPE_SIZES[field["type"]], "little")
+    return out
+
+
+def zigzag(delta):
+    return delta * 2 if delta >= 0 else -delta * 2 - 1
+
+
+def nibble_varint(value, more):
+    nibbles = []
+    while True:
+        nibble = value & (more - 1)
+        value >>= 3
+        if value == 0:
+            return nibbles + [nibble]
+        nibbles.append(nibble | more)
+
+
+def pack_samples(frame, samples, step):
+    """Nibble stream for every sample after the first, as hrpack.c writes it."""
+    codes = {code["name"]: code["value"] for code in frame["codes"]}
+    nibbles = []
+    for (previous, last), (timestamp, bpm) in zip(samples, samples[1:]):
+        gap = timestamp - previous
+        delta = zigzag(bpm - last)
+        if gap == step and delta < codes["ESCAPE"]:
+            nibbles.append(delta)
+        else:
+            nibbles.append(codes["ESCAPE"])
+            nibbles += nibble_varint(gap, codes["VARINT_MORE"])
+            nibbles += nibble_varint(delta, codes["VARINT_MORE"])
+    if len(nibbles) % 2:
+        nibbles.append(0)
+    return bytes(nibbles[i] << 4 | nibbles[i + 1] for i in range(0, len(nibbles), 2))
+
+
+def encode_vector(schema, vector):
+    if "record" in vector:
+        return encode_fields(find_record(schema, vector["record"])["fields"], vector["values"])
+    frame = find_frame(schema, vector["frame"])
+    if "minutes" in vector:
+        minutes = vector["minutes"]
+        out = encode_fields(frame["header"], {"COUNT": len(minutes["bpm"]), "BASE_TIME": minutes["base_time"]})
+        for bpm in minutes["bpm"]:
+            out += encode_fields(frame["record"], {"BPM": bpm})
+        return out
+    if "records" in vector:
+        out = encode_fields(frame["header"], dict(vector["values"], COUNT=len(vector["records"])))
+        for record in vector["records"]:
+            out += encode_fields(frame["record"], record)
+        return out
+    if "samples" not in vector:
+        return encode_fields(frame["header"], vector["values"])
+
+    samples = vector["samples"]
+    header = dict(vector["values"], COUNT=len(samples), BASE_TIME=samples[0][0], BPM=samples[0][1])
+    return encode_fields(frame["header"], header) + pack_samples(frame, samples, vector["values"]["STEP"])
+
+
+def record_values(schema, vector):
+    """(PROBE0, values) per record of a vector that lists them, named after the frame's records."""
+    if "records" not in vector:
+        return []
+    record_name = find_frame(schema, vector["frame"])["record_name"]
+    return [("%s%d" % (record_name, i), record) for i, record in enumerate(vector["records"])]
+
+
+def frame_constants(frame, key):
+    """(name, value, comment) for a frame's layout, shared by C and Kotlin."""
+    name = frame["name"]
+    constants = []
+    if "version" in frame:
+        constants.append(("%s_FRAME_VERSION" % name, frame["version"], None))
+    offsets, size = layout(frame["header"])
+    for field, offset, field_type in offsets:
+        constants.append(("%s_%s_OFFSET" % (name, field), offset, field_type))
+    if "record" in frame:
+        record = frame["record_name"]
+        constants.append(("%s_HEADER_SIZE" % name, size, None))
+        record_offsets, record_size = layout(frame["record"])
+        for field, offset, field_type in record_offsets:
+            constants.append(("%s_%s_%s_OFFSET" % (name, record, field), offset, field_type))
+        constants.append(("%s_%s_SIZE" % (name, record), record_size, None))
+        constants.append(("%s_MAX_%sS" % (name, record), (key["max_size"] - size) // record_size, None))
+    elif "packed_name" in frame:
+        # The header carries the first value and each stream byte up to two more
+        stream = key["max_size"] - size
+        constants.append(("%s_HEADER_SIZE" % name, size, None))
+        constants.append(("%s_STREAM_MAX" % name, stream, None))
+        constants.append(("%s_MAX_%sS" % (name, frame["packed_name"]), 1 + 2 * stream, None))
+        for code in frame["codes"]:
+            constants.append(("%s_CODE_%s" % (name, code["name"]), code["value"], None))
+    else:
+        constants.append(("%s_FRAME_SIZE" % name, size, None))
+    return constants
+
+
+def record_constants(record):
+    """(name, value, comment) for a DataLogging item, whose size is fixed per session."""
+    offsets, size = layout(record["fields"])
+    constants = [("%s_%s_OFFSET" % (record["name"], field), offset, field_type)
+                 for field, offset, field_type in offsets]
+    constants.append(("%s_SIZE" % record["name"], size, None))
+    return constants
+
+
+def message_sizes(schema):
+    inbound = [value_max(k) for k in schema["keys"] if k["direction"] == "phone_to_watch"]
+    outbound = [value_max(k) for k in schema["keys"] if k["direction"] == "watch_to_phone"]
+    return inbound, max(outbound)
+
+
+# C
+
+def c_keys(schema):
+    keys = {key["name"]: key for key in schema["keys"]}
+    inbound, outbound = message_sizes(schema)
+    lines = ["#pragma once", "", "// " + BANNER, ""]
+
+    lines.append("// AppMessage keys")
+    lines.append("typedef enum {")
+    entries = ["    KEY_%s = %d" % (k["name"], k["id"]) for k in schema["keys"]]
+    for i, key in enumerate(schema["keys"]):
+        comma = "," if i < len(entries) - 1 else ""
+        lines.append("%s%s  // %s %s" % (entries[i], comma, key["type"], key["doc"]))
+    lines.append("} AppMessageKey;")
+    lines.append("")
+
+    lines.append("// Largest value per key, in bytes")
+    for key in schema["keys"]:
+        lines.append("#define %s_VALUE_MAX %d" % (key["name"], value_max(key)))
+    lines.append("")
+
+    lines.append("// Buffer sizes: every inbound key at once, and the largest single outbound tuple")
+    lines.append("#define MESSAGE_INBOX_SIZE %d  // dict_calc_buffer_size(%d, %s)"
+                 % (dict_size(inbound), len(inbound), ", ".join(str(s) for s in inbound)))
+    lines.append("#define MESSAGE_OUTBOX_SIZE %d  // dict_calc_buffer_size(1, %d)"
+                 % (dict_size([outbound]), outbound))
+    lines.append("")
+
+    lines.append("// Bumped whenever a frame layout changes incompatibly")
+    lines.append("#define PROTOCOL_VERSION %d" % schema["protocol_version"])
+    lines.append("")
+
+    lines.append("// Commands")
+    lines.append("typedef enum {")
+    for i, command in enumerate(schema["commands"]):
+        comma = "," if i < len(schema["commands"]) - 1 else ""
+        lines.append("    CMD_%s = %d%s" % (command["name"], command["value"], comma))
+    lines.append("} Command;")
+    lines.append("")
+
+    lines.append("// Uplinks for HR history")
+    lines.append("typedef enum {")
+    for i, uplink in enumerate(schema["uplinks"]):
+        comma = "," if i < len(schema["uplinks"]) - 1 else ""
+        lines.append("    UPLINK_%s = %d%s" % (uplink["name"], uplink["value"], comma))
+    lines.append("} Uplink;")
+
+    for frame in schema["frames"]:
+        lines.append("")
+        lines.append("// %s frame: %s" % (frame["name"], frame["doc"]))
+        for name, value, field_type in frame_constants(frame, keys[frame["name"]]):
+            comment = "  // %s, little endian" % field_type if field_type and field_type != "uint8" else ""
+            lines.append("#define %s %d%s" % (name, value, comment))
+        if "flags" in frame:
+            lines.append("")
+            lines.append("typedef enum {")
+            for i, flag in enumerate(frame["flags"]):
+                comma = "," if i < len(frame["flags"]) - 1 else ""
+                lines.append("    %s_FLAG_%s = %d%s" % (frame["name"], flag["name"], flag["value"], comma))
+            lines.append("} %sFlag;" % camel(frame["name"]))
+        for enum in frame.get("enums", []):
+            lines.append("")
+            lines.append("typedef enum {")
+            for i, value in enumerate(enum["values"]):
+                comma = "," if i < len(enum["values"]) - 1 else ""
+                lines.append("    %s_%s_%s = %d%s" % (frame["name"], enum["name"], value["name"], value["value"], comma))
+            lines.append("} %s%s;" % (camel(frame["name"]), camel(enum["name"])))
+
+    for record in schema["datalog"]:
+        lines.append("")
+        lines.append("// %s DataLogging item: %s" % (record["name"], record["doc"]))
+        for name, value, field_type in record_constants(record):
+            comment = "  // %s, little endian" % field_type if field_type and field_type != "uint8" else ""
+            lines.append("#define %s %d%s" % (name, value, comment))
+
+    lines.append("")
+    lines.append("// Value ranges")
+    for limit in schema["limits"]:
+        lines.append("#define %s %d" % (limit["name"], limit["value"]))
+    return "\n".join(lines) + "\n"
+
+
+def c_bytes(data):
+    return ", ".join("0x%02x" % b for b in data)
+
+
+def c_vectors(schema):
+    lines = ["#pragma once", "", "// " + BANNER, "//",
+             "// Conformance vectors; the Kotlin tests check the same bytes.", "",
+             '#include "common.h"']
+    for vector in schema["vectors"]:
+        name = "VECTOR_" + vector["name"]
+        data = encode_vector(schema, vector)
+        lines.append("")
+        lines.append("static const uint8_t %s[] = { %s };" % (name, c_bytes(data)))
+        if "samples" in vector:
+            quality = vector["values"]["QUALITY"]
+            samples = ", ".join("{ %d, %d, %d }" % (t, b, quality) for t, b in vector["samples"])
+            lines.append("static const HRSample %s_SAMPLES[] = { %s };" % (name, samples))
+        elif "minutes" in vector:
+            minutes = vector["minutes"]
+            lines.append("static const uint8_t %s_BPM[] = { %s };" % (name, ", ".join(str(b) for b in minutes["bpm"])))
+            lines.append("#define %s_BASE_TIME %d" % (name, minutes["base_time"]))
+        for field, value in vector.get("values", {}).items():
+            lines.append("#define %s_%s %d" % (name, field, value))
+        for prefix, record in record_values(schema, vector):
+            for field, value in record.items():
+                lines.append("#define %s_%s_%s %d" % (name, prefix, field, value))
+    return "\n".join(lines) + "\n"
+
+
+def app_keys(schema, current):
+    # Only the appKeys block is owned by the schema; the rest of package.json is hand-written
+    entries = ",\n".join('      "%s": %d' % (k["name"], k["id"]) for k in schema["keys"])
+    block = '"appKeys": {\n%s\n    }' % entries
+    return re.sub(r'"appKeys": \{[^}]*\}', lambda _: block, current, count=1)
+
+
+# Kotlin
+
+def kotlin_keys(schema):
+    keys = {key["name"]: key for key in schema["keys"]}
+    inbound, outbound = message_sizes(schema)
+    commands = schema["commands"]
+    lines = ["package " + KOTLIN_PACKAGE, "", "// " + BANNER, "",
+             "/**",
+             " * AppMessage keys for communication between PebbleRun mobile app and Pebble watchapp.",
+             " * Satisfies REQ-001 (Real-time HR data collection) and REQ-006 (Real-time data synchronization).",
+             " */",
+             "object PebbleMessageKeys {"]
+
+    lines.append("    // Keys")
+    for key in schema["keys"]:
+        lines.append("    const val KEY_%s = %d // %s %s" % (key["name"], key["id"], key["type"], key["doc"]))
+    lines.append("")
+    lines.append("    // Largest value per key, in bytes")
+    for key in schema["keys"]:
+        lines.append("    const val %s_VALUE_MAX = %d" % (key["name"], value_max(key)))
+    lines.append("    const val MESSAGE_INBOX_SIZE = %d" % dict_size(inbound))
+    lines.append("    const val MESSAGE_OUTBOX_SIZE = %d" % dict_size([outbound]))
+    lines.append("")
+    lines.append("    // Bumped whenever a frame layout changes incompatibly")
+    lines.append("    const val PROTOCOL_VERSION = %d" % schema["protocol_version"])
+    lines.append("")
+    lines.append("    // Commands")
+    for command in commands:
+        lines.append("    const val CMD_%s = %d" % (command["name"], command["value"]))
+    lines.append("")
+    lines.append("    // Uplinks for HR history")
+    for uplink in schema["uplinks"]:
+        lines.append("    const val UPLINK_%s = %d" % (uplink["name"], uplink["value"]))
+
+    for frame in schema["frames"]:
+        lines.append("")
+        lines.append("    // %s frame: %s" % (frame["name"], frame["doc"]))
+        for name, value, _ in frame_constants(frame, keys[frame["name"]]):
+            lines.append("    const val %s = %d" % (name, value))
+        for flag in frame.get("flags", []):
+            lines.append("    const val %s_FLAG_%s = %d" % (frame["name"], flag["name"], flag["value"]))
+        for enum in frame.get("enums", []):
+            for value in enum["values"]:
+                lines.append("    const val %s_%s_%s = %d" % (frame["name"], enum["name"], value["name"], value["value"]))
+
+    for record in schema["datalog"]:
+        lines.append("")
+        lines.append("    // %s DataLogging item: %s" % (record["name"], record["doc"]))
+        for name, value, _ in record_constants(record):
+            lines.append("    const val %s = %d" % (name, value))
+
+    lines.append("")
+    lines.append("    // Value ranges")
+    for limit in schema["limits"]:
+        lines.append("    const val %s = %d" % (limit["name"], limit["value"]))
+
+    lines += [
+        "",
+        "    // Validation",
+        "    fun isValidCommand(command: Int): Boolean {",
+        "        return command in CMD_%s..CMD_%s" % (commands[0]["name"], commands[-1]["name"]),
+        "    }",
+        "    ",
+        "    fun isValidHeartRate(heartRate: Int): Boolean {",
+        "        return heartRate in HR_MIN..HR_MAX",
+        "    }",
+        "    ",
+        "    fun isValidPace(pace: Float): Boolean {",
+        "        return pace >= 0f && pace <= PACE_MAX",
+        "    }",
+        "}",
+    ]
+    return "\n".join(lines) + "\n"
+
+
+def kotlin_bytes(data):
+    return ", ".join("0x%02x" % b for b in data)
+
+
+def kotlin_vectors(schema):
+    lines = ["package " + KOTLIN_PACKAGE, "", "// " + BANNER, "",
+             "/**",
+             " * Conformance vectors; the watchapp host tests check the same bytes.",
+             " */",
+             "object SchemaVectors {"]
+    for i, vector in enumerate(schema["vectors"]):
+        name = vector["name"]
+        data = encode_vector(schema, vector)
+        if i > 0:
+            lines.append("    ")
+        lines.append("    val %s: ByteArray = bytes(%s)" % (name, kotlin_bytes(data)))
+        if "samples" in vector:
+            samples = ", ".join("%dL to %d" % (t, b) for t, b in vector["samples"])
+            lines.append("    val %s_SAMPLES: List<Pair<Long, Int>> = listOf(%s)" % (name, samples))
+        elif "minutes" in vector:
+            minutes = vector["minutes"]
+            lines.append("    val %s_BPM: List<Int> = listOf(%s)" % (name, ", ".join(str(b) for b in minutes["bpm"])))
+            lines.append("    const val %s_BASE_TIME = %dL" % (name, minutes["base_time"]))
+        for field, value in vector.get("values", {}).items():
+            lines.append("    const val %s_%s = %d" % (name, field, value))
+        for prefix, record in record_values(schema, vector):
+            for field, value in record.items():
+                lines.append("    const val %s_%s_%s = %d" % (name, prefix, field, value))
+    lines += [
+        "    ",
+        "    private fun bytes(vararg values: Int): ByteArray = ByteArray(values.size) { values[it].toByte() }",
+        "}",
+    ]
+    return "\n".join(lines) + "\n"
+
+
+GENERATORS = {
+    "c_keys": c_keys,
+    "c_vectors": c_vectors,
+    "kotlin_keys": kotlin_keys,
+    "kotlin_vectors": kotlin_vectors,
+}
+
+
+def main(argv):
+    check = "--check" in argv[1:]
+    try:
+        schema = load()
+    except SchemaError as error:
+        print("generate.py: %s" % error, file=sys.stderr)
+        return 1
+
+    stale = []
+    for output, path in OUTPUTS.items():
+        current = None
+        if os.path.exists(path):
+            with open(path) as f:
+                current = f.read()
+        if output == "app_keys":
+            text = app_keys(schema, current)
+        else:
+            text = GENERATORS[output](schema)
+        if current == text:
+            continue
+        if check:
+            stale.append(os.path.relpath(path, ROOT))
+        else:
+            os.makedirs(os.path.dirname(path), exist_ok=True)
+            with open(path, "w") as f:
+                f.write(text)
+
+    if stale:
+        print("generate.py: stale generated files, run shared/proto/schema/generate.py:", file=sys.stderr)
+        for path in stale:
+            print("  " + path, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,65 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * Follows the 16-bit sequence numbers of HR batch frames from one watch.
+ * Reports which frames are new, drops duplicates from retransmits and returns the
+ * missing ranges to request with [ResendRequest]. A jump larger than [maxGap] in either
+ * direction is taken as a restart of the numbering rather than a loss.
+ */
+class FrameSequenceTracker(
+    private val maxGap: Int = DEFAULT_MAX_GAP
+) {
+    data class Result(
+        val isNew: Boolean,
+        val missing: List<ResendRequest>
+    )
+    
+    private var expected: Int? = null
+    private val missing = mutableSetOf<Int>()
+    
+    fun accept(sequence: Int): Result {
+        val seq = sequence and SEQUENCE_MASK
+        val next = expected
+        if (next == null) {
+            restart(seq)
+            return Result(isNew = true, missing = emptyList())
+        }
+        
+        val ahead = (seq - next) and SEQUENCE_MASK
+        val behind = (next - seq) and SEQUENCE_MASK
+        return when {
+            ahead == 0 -> {
+                expected = (seq + 1) and SEQUENCE_MASK
+                Result(isNew = true, missing = emptyList())
+            }
+            ahead <= maxGap -> {
+                val skipped = (0 until ahead).map { (next + it) and SEQUENCE_MASK }
+                missing.addAll(skipped)
+                expected = (seq + 1) and SEQUENCE_MASK
+                // Frames this far back are out of the watch's history anyway
+                missing.removeAll { ((seq - it) and SEQUENCE_MASK) > maxGap }
+                Result(isNew = true, missing = listOf(ResendRequest(next, ahead)))
+            }
+            behind <= maxGap -> Result(isNew = missing.remove(seq), missing = emptyList())
+            else -> {
+                restart(seq)
+                Result(isNew = true, missing = emptyList())
+            }
+        }
+    }
+    
+    /**
+     * Frames reported missing that have not arrived since.
+     */
+    fun outstanding(): Set<Int> = missing.toSet()
+    
+    private fun restart(seq: Int) {
+        missing.clear()
+        expected = (seq + 1) and SEQUENCE_MASK
+    }
+    
+    companion object {
+        const val DEFAULT_MAX_GAP = 64
+        private const val SEQUENCE_MASK = 0xFFFF
+    }
+}
@@ -0,0 +1,97 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * Buffered HR samples received from the watch under [PebbleMessageKeys.KEY_HR_BATCH].
+ * [sequence] numbers frames for [FrameSequenceTracker]; [quality] is the watch's
+ * confidence in every sample, one of the HR_BATCH_QUALITY values. Layout comes from
+ * the generated [PebbleMessageKeys]; the nibble stream mirrors the watchapp's hrpack.c.
+ */
+data class HRBatchFrame(
+    val sequence: Int,
+    val quality: Int,
+    val samples: List<Sample>
+) {
+    data class Sample(
+        val epochSeconds: Long,
+        val heartRate: Int
+    )
+    
+    companion object {
+        /**
+         * Decodes a batch payload, or returns null if it is truncated or malformed.
+         */
+        fun decode(bytes: ByteArray): HRBatchFrame? {
+            if (bytes.size < PebbleMessageKeys.HR_BATCH_HEADER_SIZE) {
+                return null
+            }
+            val count = WireFormat.getUnsigned(bytes, PebbleMessageKeys.HR_BATCH_COUNT_OFFSET)
+            val sequence = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.HR_BATCH_SEQ_OFFSET, 2).toInt()
+            val quality = WireFormat.getUnsigned(bytes, PebbleMessageKeys.HR_BATCH_QUALITY_OFFSET)
+            if (count == 0) {
+                return HRBatchFrame(sequence, quality, emptyList())
+            }
+            
+            val step = WireFormat.getUnsigned(bytes, PebbleMessageKeys.HR_BATCH_STEP_OFFSET).toLong()
+            var timestamp = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.HR_BATCH_BASE_TIME_OFFSET, 4)
+            var heartRate = WireFormat.getUnsigned(bytes, PebbleMessageKeys.HR_BATCH_BPM_OFFSET)
+            val samples = ArrayList<Sample>(count)
+            samples.add(Sample(timestamp, heartRate))
+            
+            val stream = NibbleReader(bytes, PebbleMessageKeys.HR_BATCH_HEADER_SIZE)
+            while (samples.size < count) {
+                val code = stream.next() ?: return null
+                var gap = step
+                var delta = code.toLong()
+                if (code == PebbleMessageKeys.HR_BATCH_CODE_ESCAPE) {
+                    gap = stream.varint() ?: return null
+                    delta = stream.varint() ?: return null
+                }
+                heartRate += unzigzag(delta)
+                if (heartRate !in 0..255) {
+                    return null
+                }
+                timestamp += gap
+                samples.add(Sample(timestamp, heartRate))
+            }
+            return HRBatchFrame(sequence, quality, samples)
+        }
+        
+        private fun unzigzag(value: Long): Int = ((value ushr 1) xor -(value and 1)).toInt()
+    }
+    
+    /**
+     * Nibbles from [offset] on, high half of each byte first.
+     */
+    private class NibbleReader(private val bytes: ByteArray, offset: Int) {
+        private var index = offset * 2
+        
+        fun next(): Int? {
+            if (index >= bytes.size * 2) {
+                return null
+            }
+            val byte = WireFormat.getUnsigned(bytes, index / 2)
+            val nibble = if (index % 2 == 0) byte shr 4 else byte and 0x0F
+            index++
+            return nibble
+        }
+        
+        /**
+         * 3 bits per nibble, low bits first, until a nibble without the continuation bit.
+         */
+        fun varint(): Long? {
+            var value = 0L
+            for (i in 0 until VARINT_MAX_NIBBLES) {
+                val nibble = next() ?: return null
+                value = value or ((nibble and (PebbleMessageKeys.HR_BATCH_CODE_VARINT_MORE - 1)).toLong() shl (3 * i))
+                if ((nibble and PebbleMessageKeys.HR_BATCH_CODE_VARINT_MORE) == 0) {
+                    return value
+                }
+            }
+            return null
+        }
+        
+        companion object {
+            private const val VARINT_MAX_NIBBLES = 11
+        }
+    }
+}
@@ -0,0 +1,39 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * Per-minute HR backfilled from the watch's health history under [PebbleMessageKeys.KEY_HR_MINUTES].
+ * Minutes without a reading are skipped. Layout comes from the generated [PebbleMessageKeys].
+ */
+data class HRMinutesFrame(
+    val minutes: List<Minute>
+) {
+    data class Minute(
+        val epochSeconds: Long,
+        val heartRate: Int
+    )
+    
+    companion object {
+        private const val SECONDS_PER_MINUTE = 60L
+        
+        /**
+         * Decodes a minutes payload, or returns null if it is truncated.
+         */
+        fun decode(bytes: ByteArray): HRMinutesFrame? {
+            if (bytes.size < PebbleMessageKeys.HR_MINUTES_HEADER_SIZE) {
+                return null
+            }
+            val count = WireFormat.getUnsigned(bytes, PebbleMessageKeys.HR_MINUTES_COUNT_OFFSET)
+            if (bytes.size < PebbleMessageKeys.HR_MINUTES_HEADER_SIZE + count * PebbleMessageKeys.HR_MINUTES_MINUTE_SIZE) {
+                return null
+            }
+            
+            val base = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.HR_MINUTES_BASE_TIME_OFFSET, 4)
+            val minutes = (0 until count).mapNotNull { index ->
+                val offset = PebbleMessageKeys.HR_MINUTES_HEADER_SIZE + index * PebbleMessageKeys.HR_MINUTES_MINUTE_SIZE
+                val heartRate = WireFormat.getUnsigned(bytes, offset + PebbleMessageKeys.HR_MINUTES_MINUTE_BPM_OFFSET)
+                if (heartRate == 0) null else Minute(base + index * SECONDS_PER_MINUTE, heartRate)
+            }
+            return HRMinutesFrame(minutes)
+        }
+    }
+}
@@ -0,0 +1,29 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * One HR sample from the watch's DataLogging session, used instead of [HRBatchFrame]
+ * after the phone selects [PebbleMessageKeys.UPLINK_DATALOG]. The session's tag is the
+ * workout's start in UTC seconds; [quality] is one of the HR_BATCH_QUALITY values.
+ * Layout comes from the generated [PebbleMessageKeys].
+ */
+data class HRRecord(
+    val epochSeconds: Long,
+    val heartRate: Int,
+    val quality: Int
+) {
+    companion object {
+        /**
+         * Decodes the item at [offset], or returns null if it is truncated.
+         */
+        fun decode(bytes: ByteArray, offset: Int = 0): HRRecord? {
+            if (offset < 0 || bytes.size - offset < PebbleMessageKeys.HR_RECORD_SIZE) {
+                return null
+            }
+            return HRRecord(
+                epochSeconds = WireFormat.getLittleEndian(bytes, offset + PebbleMessageKeys.HR_RECORD_TIME_OFFSET, 4),
+                heartRate = WireFormat.getUnsigned(bytes, offset + PebbleMessageKeys.HR_RECORD_BPM_OFFSET),
+                quality = WireFormat.getUnsigned(bytes, offset + PebbleMessageKeys.HR_RECORD_QUALITY_OFFSET)
+            )
+        }
+    }
+}
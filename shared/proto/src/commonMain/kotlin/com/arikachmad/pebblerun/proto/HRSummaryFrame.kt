@@ -0,0 +1,41 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * The watch's own HR statistics for a workout, sent under [PebbleMessageKeys.KEY_HR_SUMMARY]
+ * at STOP. [seconds] is the running time its readings covered; the average and zone times
+ * are weighted by time. A cheap cross-check against the statistics computed from the
+ * uploaded samples. Layout comes from the generated [PebbleMessageKeys].
+ */
+data class HRSummaryFrame(
+    val seconds: Long,
+    val averageHeartRate: Int,
+    val minHeartRate: Int,
+    val maxHeartRate: Int,
+    val zoneSeconds: List<Long>
+) {
+    companion object {
+        private val ZONE_OFFSETS = listOf(
+            PebbleMessageKeys.HR_SUMMARY_ZONE1_OFFSET,
+            PebbleMessageKeys.HR_SUMMARY_ZONE2_OFFSET,
+            PebbleMessageKeys.HR_SUMMARY_ZONE3_OFFSET,
+            PebbleMessageKeys.HR_SUMMARY_ZONE4_OFFSET,
+            PebbleMessageKeys.HR_SUMMARY_ZONE5_OFFSET
+        )
+        
+        /**
+         * Decodes a summary payload, or returns null if it is truncated.
+         */
+        fun decode(bytes: ByteArray): HRSummaryFrame? {
+            if (bytes.size < PebbleMessageKeys.HR_SUMMARY_FRAME_SIZE) {
+                return null
+            }
+            return HRSummaryFrame(
+                seconds = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.HR_SUMMARY_SECONDS_OFFSET, 4),
+                averageHeartRate = WireFormat.getUnsigned(bytes, PebbleMessageKeys.HR_SUMMARY_AVG_OFFSET),
+                minHeartRate = WireFormat.getUnsigned(bytes, PebbleMessageKeys.HR_SUMMARY_MIN_OFFSET),
+                maxHeartRate = WireFormat.getUnsigned(bytes, PebbleMessageKeys.HR_SUMMARY_MAX_OFFSET),
+                zoneSeconds = ZONE_OFFSETS.map { WireFormat.getLittleEndian(bytes, it, 4) }
+            )
+        }
+    }
+}
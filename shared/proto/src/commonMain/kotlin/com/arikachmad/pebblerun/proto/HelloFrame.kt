@@ -0,0 +1,34 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * Capabilities the watch announces under [PebbleMessageKeys.KEY_HELLO] when it launches:
+ * its protocol version, the largest value it sends in one tuple and the largest message
+ * it accepts. Layout comes from the generated [PebbleMessageKeys].
+ */
+data class HelloFrame(
+    val protocolVersion: Int,
+    val maxValueBytes: Int,
+    val inboxBytes: Int
+) {
+    /**
+     * Whether the watch's frames decode with this build's layouts.
+     */
+    val isCompatible: Boolean
+        get() = protocolVersion == PebbleMessageKeys.PROTOCOL_VERSION
+    
+    companion object {
+        /**
+         * Decodes a hello payload, or returns null if it is truncated.
+         */
+        fun decode(bytes: ByteArray): HelloFrame? {
+            if (bytes.size < PebbleMessageKeys.HELLO_FRAME_SIZE) {
+                return null
+            }
+            return HelloFrame(
+                protocolVersion = WireFormat.getUnsigned(bytes, PebbleMessageKeys.HELLO_PROTOCOL_OFFSET),
+                maxValueBytes = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.HELLO_MAX_VALUE_OFFSET, 2).toInt(),
+                inboxBytes = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.HELLO_INBOX_OFFSET, 2).toInt()
+            )
+        }
+    }
+}
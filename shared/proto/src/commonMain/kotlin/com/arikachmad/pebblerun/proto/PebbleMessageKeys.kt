@@ -1,43 +1,166 @@
 package com.arikachmad.pebblerun.proto
 
+// Generated by shared/proto/schema/generate.py from appmessage.json. Do not edit.
+
 /**
  * AppMessage keys for communication between PebbleRun mobile app and Pebble watchapp.
  * Satisfies REQ-001 (Real-time HR data collection) and REQ-006 (Real-time data synchronization).
  */
 object PebbleMessageKeys {
-    // Commands from mobile to Pebble
-    const val KEY_COMMAND = 0x01
-    const val COMMAND_START_WORKOUT = 1
-    const val COMMAND_STOP_WORKOUT = 2
-    const val COMMAND_PAUSE_WORKOUT = 3
-    const val COMMAND_RESUME_WORKOUT = 4
-    
-    // Data from mobile to Pebble
-    const val KEY_PACE = 0x02          // Current pace in seconds per kilometer
-    const val KEY_DURATION = 0x03      // Workout duration in seconds
-    const val KEY_DISTANCE = 0x04      // Distance in meters
-    
-    // Data from Pebble to mobile
-    const val KEY_HEART_RATE = 0x10    // Heart rate in BPM
-    const val KEY_HR_QUALITY = 0x11    // HR quality indicator (0=bad, 1=ok, 2=good)
-    const val KEY_WATCHAPP_STATE = 0x12 // Watchapp state (0=stopped, 1=running, 2=paused)
-    
-    // Status and error codes
-    const val KEY_STATUS = 0x20
-    const val STATUS_OK = 0
-    const val STATUS_ERROR = 1
-    const val STATUS_NOT_READY = 2
-    
+    // Keys
+    const val KEY_CMD = 3 // uint8 Workout command, see commands
+    const val KEY_HR_BATCH = 4 // bytes Buffered HR samples, see the HR_BATCH frame
+    const val KEY_WORKOUT = 5 // bytes Elapsed time, pace and distance, see the WORKOUT frame
+    const val KEY_HR_MINUTES = 7 // bytes Backfilled per-minute HR from the health history, see the HR_MINUTES frame
+    const val KEY_RESEND = 8 // bytes Retransmit request for missing HR_BATCH frames, see the RESEND frame
+    const val KEY_HELLO = 9 // bytes Protocol version and buffer sizes, sent at launch, see the HELLO frame
+    const val KEY_HR_SUMMARY = 10 // bytes Workout HR statistics, sent at STOP, see the HR_SUMMARY frame
+    const val KEY_ZONES = 11 // bytes HR zone configuration, see the ZONES frame
+    const val KEY_UPLINK = 12 // uint8 Channel for HR history, see uplinks
+    const val KEY_PERF = 13 // bytes Debug counters and handler timings, sent on PERF_SNAPSHOT, see the PERF frame
+    const val KEY_HR_LIVE = 14 // bytes Latest HR reading for display only, laid out as an HR_RECORD; not history, which the phone takes from HR_BATCH or DataLogging
+
+    // Largest value per key, in bytes
+    const val CMD_VALUE_MAX = 1
+    const val HR_BATCH_VALUE_MAX = 55
+    const val WORKOUT_VALUE_MAX = 32
+    const val HR_MINUTES_VALUE_MAX = 55
+    const val RESEND_VALUE_MAX = 3
+    const val HELLO_VALUE_MAX = 5
+    const val HR_SUMMARY_VALUE_MAX = 27
+    const val ZONES_VALUE_MAX = 6
+    const val UPLINK_VALUE_MAX = 1
+    const val PERF_VALUE_MAX = 55
+    const val HR_LIVE_VALUE_MAX = 6
+    const val MESSAGE_INBOX_SIZE = 79
+    const val MESSAGE_OUTBOX_SIZE = 63
+
+    // Bumped whenever a frame layout changes incompatibly
+    const val PROTOCOL_VERSION = 5
+
+    // Commands
+    const val CMD_START = 1
+    const val CMD_STOP = 2
+    const val CMD_PAUSE = 3
+    const val CMD_RESUME = 4
+    const val CMD_DUMP_LOG = 5
+    const val CMD_PERF_SNAPSHOT = 6
+
+    // Uplinks for HR history
+    const val UPLINK_APPMESSAGE = 0
+    const val UPLINK_DATALOG = 1
+
+    // HR_BATCH frame: Header with the first sample, then the rest as nibble codes; SEQ counts frames, STEP is the gap a plain code implies, QUALITY applies to every sample
+    const val HR_BATCH_COUNT_OFFSET = 0
+    const val HR_BATCH_SEQ_OFFSET = 1
+    const val HR_BATCH_BASE_TIME_OFFSET = 3
+    const val HR_BATCH_STEP_OFFSET = 7
+    const val HR_BATCH_QUALITY_OFFSET = 8
+    const val HR_BATCH_BPM_OFFSET = 9
+    const val HR_BATCH_HEADER_SIZE = 10
+    const val HR_BATCH_STREAM_MAX = 45
+    const val HR_BATCH_MAX_SAMPLES = 91
+    const val HR_BATCH_CODE_ESCAPE = 15
+    const val HR_BATCH_CODE_VARINT_MORE = 8
+    const val HR_BATCH_QUALITY_BAD = 0
+    const val HR_BATCH_QUALITY_OK = 1
+    const val HR_BATCH_QUALITY_GOOD = 2
+
+    // HR_MINUTES frame: Header, then one BPM per consecutive minute from BASE_TIME; 0 means no reading
+    const val HR_MINUTES_COUNT_OFFSET = 0
+    const val HR_MINUTES_BASE_TIME_OFFSET = 1
+    const val HR_MINUTES_HEADER_SIZE = 5
+    const val HR_MINUTES_MINUTE_BPM_OFFSET = 0
+    const val HR_MINUTES_MINUTE_SIZE = 1
+    const val HR_MINUTES_MAX_MINUTES = 50
+
+    // RESEND frame: COUNT frames from FIRST_SEQ, wrapping at 65536
+    const val RESEND_FIRST_SEQ_OFFSET = 0
+    const val RESEND_COUNT_OFFSET = 2
+    const val RESEND_FRAME_SIZE = 3
+
+    // HELLO frame: PROTOCOL is PROTOCOL_VERSION; MAX_VALUE is the largest value the watch sends in one tuple, INBOX the largest message it accepts
+    const val HELLO_PROTOCOL_OFFSET = 0
+    const val HELLO_MAX_VALUE_OFFSET = 1
+    const val HELLO_INBOX_OFFSET = 3
+    const val HELLO_FRAME_SIZE = 5
+
+    // HR_SUMMARY frame: SECONDS of running time covered by readings, time-weighted AVG, MIN and MAX BPM, and seconds in each of the five zones
+    const val HR_SUMMARY_SECONDS_OFFSET = 0
+    const val HR_SUMMARY_AVG_OFFSET = 4
+    const val HR_SUMMARY_MIN_OFFSET = 5
+    const val HR_SUMMARY_MAX_OFFSET = 6
+    const val HR_SUMMARY_ZONE1_OFFSET = 7
+    const val HR_SUMMARY_ZONE2_OFFSET = 11
+    const val HR_SUMMARY_ZONE3_OFFSET = 15
+    const val HR_SUMMARY_ZONE4_OFFSET = 19
+    const val HR_SUMMARY_ZONE5_OFFSET = 23
+    const val HR_SUMMARY_FRAME_SIZE = 27
+
+    // ZONES frame: ZONE1 to ZONE5 are the lowest BPM of each zone, rising; all zero derives them from MAX_HR as 0 and 60, 70, 80 and 90 percent
+    const val ZONES_MAX_HR_OFFSET = 0
+    const val ZONES_ZONE1_OFFSET = 1
+    const val ZONES_ZONE2_OFFSET = 2
+    const val ZONES_ZONE3_OFFSET = 3
+    const val ZONES_ZONE4_OFFSET = 4
+    const val ZONES_ZONE5_OFFSET = 5
+    const val ZONES_FRAME_SIZE = 6
+
+    // WORKOUT frame: Later versions only append fields, so a longer frame still decodes
+    const val WORKOUT_FRAME_VERSION = 1
+    const val WORKOUT_VERSION_OFFSET = 0
+    const val WORKOUT_ELAPSED_OFFSET = 1
+    const val WORKOUT_PACE_OFFSET = 5
+    const val WORKOUT_DISTANCE_OFFSET = 7
+    const val WORKOUT_FLAGS_OFFSET = 11
+    const val WORKOUT_FRAME_SIZE = 12
+    const val WORKOUT_FLAG_PAUSED = 1
+
+    // PERF frame: Counters since launch, then COUNT probes; a snapshot spans as many frames as the probes need, each with the same header. SNIFF_REDUCED is the seconds spent at the reduced Bluetooth sniff interval, the rest of UPTIME at the normal one. Durations are in ms, UNDER_* and OVER_* count calls per duration bucket, all saturating
+    const val PERF_COUNT_OFFSET = 0
+    const val PERF_UPTIME_OFFSET = 1
+    const val PERF_HEAP_PEAK_OFFSET = 5
+    const val PERF_FAIL_TIMEOUT_OFFSET = 7
+    const val PERF_FAIL_NACK_OFFSET = 9
+    const val PERF_FAIL_OFFLINE_OFFSET = 11
+    const val PERF_FAIL_OTHER_OFFSET = 13
+    const val PERF_SNIFF_REDUCED_OFFSET = 15
+    const val PERF_HEADER_SIZE = 17
+    const val PERF_PROBE_ID_OFFSET = 0
+    const val PERF_PROBE_CALLS_OFFSET = 1
+    const val PERF_PROBE_TOTAL_MS_OFFSET = 5
+    const val PERF_PROBE_MAX_MS_OFFSET = 9
+    const val PERF_PROBE_UNDER_2MS_OFFSET = 11
+    const val PERF_PROBE_UNDER_8MS_OFFSET = 13
+    const val PERF_PROBE_UNDER_32MS_OFFSET = 15
+    const val PERF_PROBE_OVER_32MS_OFFSET = 17
+    const val PERF_PROBE_SIZE = 19
+    const val PERF_MAX_PROBES = 2
+    const val PERF_PROBE_CANVAS = 0
+    const val PERF_PROBE_INBOX = 1
+    const val PERF_PROBE_HR_EVENT = 2
+
+    // HR_RECORD DataLogging item: One HR sample per item of a DataLogging session tagged with the workout's start in UTC seconds; QUALITY as in HR_BATCH
+    const val HR_RECORD_TIME_OFFSET = 0
+    const val HR_RECORD_BPM_OFFSET = 4
+    const val HR_RECORD_QUALITY_OFFSET = 5
+    const val HR_RECORD_SIZE = 6
+
+    // Value ranges
+    const val HR_MIN = 30
+    const val HR_MAX = 220
+    const val PACE_MAX = 3600
+
     // Validation
     fun isValidCommand(command: Int): Boolean {
-        return command in COMMAND_START_WORKOUT..COMMAND_RESUME_WORKOUT
+        return command in CMD_START..CMD_PERF_SNAPSHOT
     }
     
     fun isValidHeartRate(heartRate: Int): Boolean {
-        return heartRate in 30..220
+        return heartRate in HR_MIN..HR_MAX
     }
     
     fun isValidPace(pace: Float): Boolean {
-        return pace >= 0f && pace <= 3600f // Max 1 hour per km
+        return pace >= 0f && pace <= PACE_MAX
     }
 }
@@ -0,0 +1,91 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * Debug counters sent under [PebbleMessageKeys.KEY_PERF] in reply to CMD_PERF_SNAPSHOT.
+ * A snapshot spans several frames with the same header, each carrying some of the
+ * [probes]; merge them by [Probe.id], one of the PERF_PROBE values. Counters run from
+ * launch, so canvas calls over [uptimeSeconds] gives the redraw rate, and
+ * [sniffReducedSeconds] over it the share of time the radio spent at the reduced sniff
+ * interval. Layout comes from the generated [PebbleMessageKeys].
+ */
+data class PerfFrame(
+    val uptimeSeconds: Long,
+    val heapPeakBytes: Int,
+    val failedTimeout: Int,
+    val failedNack: Int,
+    val failedOffline: Int,
+    val failedOther: Int,
+    val sniffReducedSeconds: Int,
+    val probes: List<Probe>
+) {
+    /**
+     * Seconds at the normal sniff interval: the rest of the uptime.
+     */
+    val sniffNormalSeconds: Long
+        get() = (uptimeSeconds - sniffReducedSeconds).coerceAtLeast(0)
+    
+    /**
+     * One handler's timings; [buckets] count calls under 2, 8 and 32 ms, then the rest.
+     */
+    data class Probe(
+        val id: Int,
+        val calls: Long,
+        val totalMillis: Long,
+        val maxMillis: Int,
+        val buckets: List<Int>
+    )
+    
+    /**
+     * Adds the probes of [next] if it is another frame of this snapshot; otherwise
+     * [next] starts a new one.
+     */
+    fun mergedWith(next: PerfFrame): PerfFrame {
+        if (next.copy(probes = probes) != this) {
+            return next
+        }
+        val merged = (probes + next.probes).associateBy { it.id }
+        return next.copy(probes = merged.values.sortedBy { it.id })
+    }
+    
+    companion object {
+        private val BUCKET_OFFSETS = listOf(
+            PebbleMessageKeys.PERF_PROBE_UNDER_2MS_OFFSET,
+            PebbleMessageKeys.PERF_PROBE_UNDER_8MS_OFFSET,
+            PebbleMessageKeys.PERF_PROBE_UNDER_32MS_OFFSET,
+            PebbleMessageKeys.PERF_PROBE_OVER_32MS_OFFSET
+        )
+        
+        /**
+         * Decodes a PERF payload, or returns null if it is shorter than its COUNT says.
+         */
+        fun decode(bytes: ByteArray): PerfFrame? {
+            if (bytes.size < PebbleMessageKeys.PERF_HEADER_SIZE) {
+                return null
+            }
+            val count = WireFormat.getUnsigned(bytes, PebbleMessageKeys.PERF_COUNT_OFFSET)
+            if (bytes.size < PebbleMessageKeys.PERF_HEADER_SIZE + count * PebbleMessageKeys.PERF_PROBE_SIZE) {
+                return null
+            }
+            val probes = (0 until count).map { index ->
+                val base = PebbleMessageKeys.PERF_HEADER_SIZE + index * PebbleMessageKeys.PERF_PROBE_SIZE
+                Probe(
+                    id = WireFormat.getUnsigned(bytes, base + PebbleMessageKeys.PERF_PROBE_ID_OFFSET),
+                    calls = WireFormat.getLittleEndian(bytes, base + PebbleMessageKeys.PERF_PROBE_CALLS_OFFSET, 4),
+                    totalMillis = WireFormat.getLittleEndian(bytes, base + PebbleMessageKeys.PERF_PROBE_TOTAL_MS_OFFSET, 4),
+                    maxMillis = WireFormat.getLittleEndian(bytes, base + PebbleMessageKeys.PERF_PROBE_MAX_MS_OFFSET, 2).toInt(),
+                    buckets = BUCKET_OFFSETS.map { WireFormat.getLittleEndian(bytes, base + it, 2).toInt() }
+                )
+            }
+            return PerfFrame(
+                uptimeSeconds = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.PERF_UPTIME_OFFSET, 4),
+                heapPeakBytes = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.PERF_HEAP_PEAK_OFFSET, 2).toInt(),
+                failedTimeout = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.PERF_FAIL_TIMEOUT_OFFSET, 2).toInt(),
+                failedNack = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.PERF_FAIL_NACK_OFFSET, 2).toInt(),
+                failedOffline = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.PERF_FAIL_OFFLINE_OFFSET, 2).toInt(),
+                failedOther = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.PERF_FAIL_OTHER_OFFSET, 2).toInt(),
+                sniffReducedSeconds = WireFormat.getLittleEndian(bytes, PebbleMessageKeys.PERF_SNIFF_REDUCED_OFFSET, 2).toInt(),
+                probes = probes
+            )
+        }
+    }
+}
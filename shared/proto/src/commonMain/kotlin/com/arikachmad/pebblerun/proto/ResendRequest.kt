@@ -0,0 +1,18 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * Asks the watch under [PebbleMessageKeys.KEY_RESEND] to retransmit [count] HR batch frames
+ * starting at [firstSequence]. The watch only keeps its last few acknowledged frames, so
+ * older ones are silently skipped.
+ */
+data class ResendRequest(
+    val firstSequence: Int,
+    val count: Int
+) {
+    fun encode(): ByteArray {
+        val bytes = ByteArray(PebbleMessageKeys.RESEND_FRAME_SIZE)
+        WireFormat.putLittleEndian(bytes, PebbleMessageKeys.RESEND_FIRST_SEQ_OFFSET, (firstSequence and 0xFFFF).toLong(), 2)
+        bytes[PebbleMessageKeys.RESEND_COUNT_OFFSET] = count.coerceIn(0, 0xFF).toByte()
+        return bytes
+    }
+}
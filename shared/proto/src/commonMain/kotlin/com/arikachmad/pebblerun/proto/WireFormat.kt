@@ -0,0 +1,22 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * Little endian helpers for the AppMessage byte array frames.
+ */
+internal object WireFormat {
+    fun putLittleEndian(bytes: ByteArray, offset: Int, value: Long, width: Int) {
+        for (i in 0 until width) {
+            bytes[offset + i] = (value shr (8 * i)).toByte()
+        }
+    }
+    
+    fun getLittleEndian(bytes: ByteArray, offset: Int, width: Int): Long {
+        var value = 0L
+        for (i in 0 until width) {
+            value = value or (getUnsigned(bytes, offset + i).toLong() shl (8 * i))
+        }
+        return value
+    }
+    
+    fun getUnsigned(bytes: ByteArray, offset: Int): Int = bytes[offset].toInt() and 0xFF
+}
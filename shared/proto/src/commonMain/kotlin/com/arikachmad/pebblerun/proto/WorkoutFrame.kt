@@ -0,0 +1,24 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * Binary workout update sent to the watch under [PebbleMessageKeys.KEY_WORKOUT].
+ * Replaces the per-second pace/duration strings; the watch formats values only when drawn.
+ * Field offsets come from the generated [PebbleMessageKeys]; new fields are appended
+ * with a higher version.
+ */
+data class WorkoutFrame(
+    val elapsedSeconds: Int,
+    val paceSecondsPerKm: Int,
+    val distanceMeters: Int,
+    val paused: Boolean = false
+) {
+    fun encode(): ByteArray {
+        val bytes = ByteArray(PebbleMessageKeys.WORKOUT_FRAME_SIZE)
+        bytes[PebbleMessageKeys.WORKOUT_VERSION_OFFSET] = PebbleMessageKeys.WORKOUT_FRAME_VERSION.toByte()
+        WireFormat.putLittleEndian(bytes, PebbleMessageKeys.WORKOUT_ELAPSED_OFFSET, elapsedSeconds.coerceAtLeast(0).toLong(), 4)
+        WireFormat.putLittleEndian(bytes, PebbleMessageKeys.WORKOUT_PACE_OFFSET, paceSecondsPerKm.coerceIn(0, 0xFFFF).toLong(), 2)
+        WireFormat.putLittleEndian(bytes, PebbleMessageKeys.WORKOUT_DISTANCE_OFFSET, distanceMeters.coerceAtLeast(0).toLong(), 4)
+        bytes[PebbleMessageKeys.WORKOUT_FLAGS_OFFSET] = (if (paused) PebbleMessageKeys.WORKOUT_FLAG_PAUSED else 0).toByte()
+        return bytes
+    }
+}
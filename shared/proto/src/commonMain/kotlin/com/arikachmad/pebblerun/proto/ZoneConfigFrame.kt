@@ -0,0 +1,32 @@
+package com.arikachmad.pebblerun.proto
+
+/**
+ * HR zones for the watch under [PebbleMessageKeys.KEY_ZONES]. The watch classifies every
+ * reading against them itself, so zone colors and alerts need no per-second updates and
+ * keep working while disconnected; it keeps the last configuration across launches.
+ * [zoneLowerBounds] are the lowest BPM of zones 1 to 5, rising. Left empty, the watch
+ * derives them from [maxHeartRate] with the percentages of HRProcessor.getHRZone.
+ */
+data class ZoneConfigFrame(
+    val maxHeartRate: Int,
+    val zoneLowerBounds: List<Int> = emptyList()
+) {
+    init {
+        require(zoneLowerBounds.isEmpty() || zoneLowerBounds.size == ZONE_COUNT) {
+            "Expected $ZONE_COUNT zone bounds, got ${zoneLowerBounds.size}"
+        }
+    }
+    
+    fun encode(): ByteArray {
+        val bytes = ByteArray(PebbleMessageKeys.ZONES_FRAME_SIZE)
+        bytes[PebbleMessageKeys.ZONES_MAX_HR_OFFSET] = maxHeartRate.coerceIn(0, 0xFF).toByte()
+        zoneLowerBounds.forEachIndexed { index, bpm ->
+            bytes[PebbleMessageKeys.ZONES_ZONE1_OFFSET + index] = bpm.coerceIn(0, 0xFF).toByte()
+        }
+        return bytes
+    }
+    
+    companion object {
+        const val ZONE_COUNT = 5
+    }
+}
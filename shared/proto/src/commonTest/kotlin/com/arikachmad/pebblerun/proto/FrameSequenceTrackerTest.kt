@@ -0,0 +1,63 @@
+package com.arikachmad.pebblerun.proto
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class FrameSequenceTrackerTest {
+    
+    @Test
+    fun consecutiveFramesAreNew() {
+        val tracker = FrameSequenceTracker()
+        for (seq in 10..13) {
+            val result = tracker.accept(seq)
+            assertTrue(result.isNew)
+            assertTrue(result.missing.isEmpty())
+        }
+    }
+    
+    @Test
+    fun gapRequestsMissingRangeAndRetransmitFillsIt() {
+        val tracker = FrameSequenceTracker()
+        tracker.accept(1)
+        
+        val result = tracker.accept(5)
+        assertTrue(result.isNew)
+        assertEquals(listOf(ResendRequest(2, 3)), result.missing)
+        assertEquals(setOf(2, 3, 4), tracker.outstanding())
+        
+        assertTrue(tracker.accept(3).isNew)
+        assertFalse(tracker.accept(3).isNew)
+        assertEquals(setOf(2, 4), tracker.outstanding())
+    }
+    
+    @Test
+    fun duplicatesAreDropped() {
+        val tracker = FrameSequenceTracker()
+        tracker.accept(7)
+        tracker.accept(8)
+        assertFalse(tracker.accept(7).isNew)
+    }
+    
+    @Test
+    fun numberingWrapsAt16Bits() {
+        val tracker = FrameSequenceTracker()
+        tracker.accept(0xFFFE)
+        
+        val result = tracker.accept(1)
+        assertEquals(listOf(ResendRequest(0xFFFF, 2)), result.missing)
+        assertTrue(tracker.accept(0).isNew)
+    }
+    
+    @Test
+    fun largeJumpRestartsNumbering() {
+        val tracker = FrameSequenceTracker(maxGap = 8)
+        tracker.accept(500)
+        
+        val result = tracker.accept(3)
+        assertTrue(result.isNew)
+        assertTrue(result.missing.isEmpty())
+        assertTrue(tracker.accept(4).isNew)
+    }
+}
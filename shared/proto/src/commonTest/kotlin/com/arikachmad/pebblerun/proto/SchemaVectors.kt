@@ -0,0 +1,106 @@
+package com.arikachmad.pebblerun.proto
+
+// Generated by shared/proto/schema/generate.py from appmessage.json. Do not edit.
+
+/**
+ * Conformance vectors; the watchapp host tests check the same bytes.
+ */
+object SchemaVectors {
+    val WORKOUT_PAUSED: ByteArray = bytes(0x01, 0xfd, 0x02, 0x00, 0x00, 0x56, 0x01, 0xc0, 0x08, 0x00, 0x00, 0x01)
+    const val WORKOUT_PAUSED_VERSION = 1
+    const val WORKOUT_PAUSED_ELAPSED = 765
+    const val WORKOUT_PAUSED_PACE = 342
+    const val WORKOUT_PAUSED_DISTANCE = 2240
+    const val WORKOUT_PAUSED_FLAGS = 1
+    
+    val WORKOUT_NO_PACE: ByteArray = bytes(0x01, 0x7f, 0x51, 0x01, 0x00, 0x00, 0x00, 0xd3, 0xa4, 0x00, 0x00, 0x00)
+    const val WORKOUT_NO_PACE_VERSION = 1
+    const val WORKOUT_NO_PACE_ELAPSED = 86399
+    const val WORKOUT_NO_PACE_PACE = 0
+    const val WORKOUT_NO_PACE_DISTANCE = 42195
+    const val WORKOUT_NO_PACE_FLAGS = 0
+    
+    val HR_BATCH_GAPS: ByteArray = bytes(0x04, 0x07, 0x00, 0x00, 0xf1, 0x53, 0x65, 0x01, 0x02, 0x8c, 0x2f, 0x24, 0xf1, 0xa4)
+    val HR_BATCH_GAPS_SAMPLES: List<Pair<Long, Int>> = listOf(1700000000L to 140, 1700000001L to 141, 1700000003L to 143, 1700000004L to 160)
+    const val HR_BATCH_GAPS_SEQ = 7
+    const val HR_BATCH_GAPS_STEP = 1
+    const val HR_BATCH_GAPS_QUALITY = 2
+    
+    val HR_BATCH_MINUTE: ByteArray = bytes(0x3c, 0x08, 0x00, 0x64, 0xf1, 0x53, 0x65, 0x01, 0x01, 0x96, 0x20, 0x22, 0x01, 0x11, 0x02, 0x24, 0x20, 0x11, 0x10, 0x22, 0x42, 0x20, 0x11, 0x11, 0x02, 0x20, 0x22, 0x22, 0x01, 0x11, 0x01, 0x10, 0x11, 0x02, 0x22, 0x22, 0x01, 0x10, 0x10, 0x20)
+    val HR_BATCH_MINUTE_SAMPLES: List<Pair<Long, Int>> = listOf(1700000100L to 150, 1700000101L to 151, 1700000102L to 151, 1700000103L to 152, 1700000104L to 153, 1700000105L to 153, 1700000106L to 152, 1700000107L to 151, 1700000108L to 150, 1700000109L to 150, 1700000110L to 151, 1700000111L to 152, 1700000112L to 154, 1700000113L to 155, 1700000114L to 155, 1700000115L to 154, 1700000116L to 153, 1700000117L to 152, 1700000118L to 152, 1700000119L to 153, 1700000120L to 154, 1700000121L to 156, 1700000122L to 157, 1700000123L to 158, 1700000124L to 158, 1700000125L to 157, 1700000126L to 156, 1700000127L to 155, 1700000128L to 154, 1700000129L to 154, 1700000130L to 155, 1700000131L to 156, 1700000132L to 156, 1700000133L to 157, 1700000134L to 158, 1700000135L to 159, 1700000136L to 160, 1700000137L to 160, 1700000138L to 159, 1700000139L to 158, 1700000140L to 157, 1700000141L to 157, 1700000142L to 156, 1700000143L to 155, 1700000144L to 155, 1700000145L to 154, 1700000146L to 153, 1700000147L to 153, 1700000148L to 154, 1700000149L to 155, 1700000150L to 156, 1700000151L to 157, 1700000152L to 158, 1700000153L to 158, 1700000154L to 157, 1700000155L to 156, 1700000156L to 156, 1700000157L to 155, 1700000158L to 155, 1700000159L to 156)
+    const val HR_BATCH_MINUTE_SEQ = 8
+    const val HR_BATCH_MINUTE_STEP = 1
+    const val HR_BATCH_MINUTE_QUALITY = 1
+    
+    val HR_MINUTES_HOLE: ByteArray = bytes(0x03, 0xec, 0xf0, 0x53, 0x65, 0x96, 0x00, 0x98)
+    val HR_MINUTES_HOLE_BPM: List<Int> = listOf(150, 0, 152)
+    const val HR_MINUTES_HOLE_BASE_TIME = 1699999980L
+    
+    val HELLO_DEFAULT: ByteArray = bytes(0x05, 0x37, 0x00, 0x4f, 0x00)
+    const val HELLO_DEFAULT_PROTOCOL = 5
+    const val HELLO_DEFAULT_MAX_VALUE = 55
+    const val HELLO_DEFAULT_INBOX = 79
+    
+    val HR_SUMMARY_HOUR: ByteArray = bytes(0x10, 0x0e, 0x00, 0x00, 0x94, 0x5c, 0xb5, 0x2c, 0x01, 0x00, 0x00, 0x84, 0x03, 0x00, 0x00, 0xdc, 0x05, 0x00, 0x00, 0xd0, 0x02, 0x00, 0x00, 0xb4, 0x00, 0x00, 0x00)
+    const val HR_SUMMARY_HOUR_SECONDS = 3600
+    const val HR_SUMMARY_HOUR_AVG = 148
+    const val HR_SUMMARY_HOUR_MIN = 92
+    const val HR_SUMMARY_HOUR_MAX = 181
+    const val HR_SUMMARY_HOUR_ZONE1 = 300
+    const val HR_SUMMARY_HOUR_ZONE2 = 900
+    const val HR_SUMMARY_HOUR_ZONE3 = 1500
+    const val HR_SUMMARY_HOUR_ZONE4 = 720
+    const val HR_SUMMARY_HOUR_ZONE5 = 180
+    
+    val ZONES_MAX_HR: ByteArray = bytes(0xc8, 0x00, 0x00, 0x00, 0x00, 0x00)
+    const val ZONES_MAX_HR_MAX_HR = 200
+    const val ZONES_MAX_HR_ZONE1 = 0
+    const val ZONES_MAX_HR_ZONE2 = 0
+    const val ZONES_MAX_HR_ZONE3 = 0
+    const val ZONES_MAX_HR_ZONE4 = 0
+    const val ZONES_MAX_HR_ZONE5 = 0
+    
+    val ZONES_THRESHOLDS: ByteArray = bytes(0xb9, 0x5d, 0x6f, 0x82, 0x94, 0xa7)
+    const val ZONES_THRESHOLDS_MAX_HR = 185
+    const val ZONES_THRESHOLDS_ZONE1 = 93
+    const val ZONES_THRESHOLDS_ZONE2 = 111
+    const val ZONES_THRESHOLDS_ZONE3 = 130
+    const val ZONES_THRESHOLDS_ZONE4 = 148
+    const val ZONES_THRESHOLDS_ZONE5 = 167
+    
+    val RESEND_WRAP: ByteArray = bytes(0xfe, 0xff, 0x03)
+    const val RESEND_WRAP_FIRST_SEQ = 65534
+    const val RESEND_WRAP_COUNT = 3
+    
+    val HR_RECORD_GOOD: ByteArray = bytes(0x00, 0xf1, 0x53, 0x65, 0x8e, 0x02)
+    const val HR_RECORD_GOOD_TIME = 1700000000
+    const val HR_RECORD_GOOD_BPM = 142
+    const val HR_RECORD_GOOD_QUALITY = 2
+    
+    val PERF_HOUR: ByteArray = bytes(0x02, 0x10, 0x0e, 0x00, 0x00, 0x00, 0x48, 0x03, 0x00, 0x01, 0x00, 0x0c, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x30, 0x2a, 0x00, 0x00, 0x29, 0x00, 0x00, 0x00, 0x48, 0x0d, 0xbe, 0x00, 0x0a, 0x00, 0x01, 0xf0, 0x00, 0x00, 0x00, 0xe0, 0x01, 0x00, 0x00, 0x09, 0x00, 0x78, 0x00, 0x6e, 0x00, 0x0a, 0x00, 0x00, 0x00)
+    const val PERF_HOUR_UPTIME = 3600
+    const val PERF_HOUR_HEAP_PEAK = 18432
+    const val PERF_HOUR_FAIL_TIMEOUT = 3
+    const val PERF_HOUR_FAIL_NACK = 1
+    const val PERF_HOUR_FAIL_OFFLINE = 12
+    const val PERF_HOUR_FAIL_OTHER = 0
+    const val PERF_HOUR_SNIFF_REDUCED = 240
+    const val PERF_HOUR_PROBE0_ID = 0
+    const val PERF_HOUR_PROBE0_CALLS = 3600
+    const val PERF_HOUR_PROBE0_TOTAL_MS = 10800
+    const val PERF_HOUR_PROBE0_MAX_MS = 41
+    const val PERF_HOUR_PROBE0_UNDER_2MS = 0
+    const val PERF_HOUR_PROBE0_UNDER_8MS = 3400
+    const val PERF_HOUR_PROBE0_UNDER_32MS = 190
+    const val PERF_HOUR_PROBE0_OVER_32MS = 10
+    const val PERF_HOUR_PROBE1_ID = 1
+    const val PERF_HOUR_PROBE1_CALLS = 240
+    const val PERF_HOUR_PROBE1_TOTAL_MS = 480
+    const val PERF_HOUR_PROBE1_MAX_MS = 9
+    const val PERF_HOUR_PROBE1_UNDER_2MS = 120
+    const val PERF_HOUR_PROBE1_UNDER_8MS = 110
+    const val PERF_HOUR_PROBE1_UNDER_32MS = 10
+    const val PERF_HOUR_PROBE1_OVER_32MS = 0
+    
+    private fun bytes(vararg values: Int): ByteArray = ByteArray(values.size) { values[it].toByte() }
+}
@@ -0,0 +1,197 @@
+package com.arikachmad.pebblerun.proto
+
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+/**
+ * Checks the Kotlin codecs against the vectors generated from shared/proto/schema.
+ * The watchapp host tests (tests/test_schema.c) check the same bytes in C.
+ */
+class WireFormatConformanceTest {
+    
+    @Test
+    fun workoutFrameEncodesPausedVector() {
+        val frame = WorkoutFrame(
+            elapsedSeconds = SchemaVectors.WORKOUT_PAUSED_ELAPSED,
+            paceSecondsPerKm = SchemaVectors.WORKOUT_PAUSED_PACE,
+            distanceMeters = SchemaVectors.WORKOUT_PAUSED_DISTANCE,
+            paused = (SchemaVectors.WORKOUT_PAUSED_FLAGS and PebbleMessageKeys.WORKOUT_FLAG_PAUSED) != 0
+        )
+        assertContentEquals(SchemaVectors.WORKOUT_PAUSED, frame.encode())
+    }
+    
+    @Test
+    fun workoutFrameEncodesNoPaceVector() {
+        val frame = WorkoutFrame(
+            elapsedSeconds = SchemaVectors.WORKOUT_NO_PACE_ELAPSED,
+            paceSecondsPerKm = SchemaVectors.WORKOUT_NO_PACE_PACE,
+            distanceMeters = SchemaVectors.WORKOUT_NO_PACE_DISTANCE
+        )
+        assertContentEquals(SchemaVectors.WORKOUT_NO_PACE, frame.encode())
+    }
+    
+    @Test
+    fun hrBatchDecodesVector() {
+        val batch = HRBatchFrame.decode(SchemaVectors.HR_BATCH_GAPS)
+        val expected = SchemaVectors.HR_BATCH_GAPS_SAMPLES.map { (time, bpm) -> HRBatchFrame.Sample(time, bpm) }
+        assertEquals(expected, batch?.samples)
+        assertEquals(SchemaVectors.HR_BATCH_GAPS_SEQ, batch?.sequence)
+        assertEquals(SchemaVectors.HR_BATCH_GAPS_QUALITY, batch?.quality)
+    }
+    
+    @Test
+    fun hrBatchDecodesPackedMinute() {
+        val batch = HRBatchFrame.decode(SchemaVectors.HR_BATCH_MINUTE)
+        val expected = SchemaVectors.HR_BATCH_MINUTE_SAMPLES.map { (time, bpm) -> HRBatchFrame.Sample(time, bpm) }
+        assertEquals(expected, batch?.samples)
+        assertEquals(SchemaVectors.HR_BATCH_MINUTE_SEQ, batch?.sequence)
+        assertEquals(SchemaVectors.HR_BATCH_MINUTE_QUALITY, batch?.quality)
+    }
+    
+    @Test
+    fun hrBatchRejectsTruncatedPayload() {
+        val truncated = SchemaVectors.HR_BATCH_GAPS.copyOf(SchemaVectors.HR_BATCH_GAPS.size - 1)
+        assertNull(HRBatchFrame.decode(truncated))
+    }
+    
+    @Test
+    fun resendRequestEncodesWrapVector() {
+        val request = ResendRequest(SchemaVectors.RESEND_WRAP_FIRST_SEQ, SchemaVectors.RESEND_WRAP_COUNT)
+        assertContentEquals(SchemaVectors.RESEND_WRAP, request.encode())
+    }
+    
+    @Test
+    fun zoneConfigEncodesThresholdsVector() {
+        val config = ZoneConfigFrame(
+            maxHeartRate = SchemaVectors.ZONES_THRESHOLDS_MAX_HR,
+            zoneLowerBounds = listOf(
+                SchemaVectors.ZONES_THRESHOLDS_ZONE1,
+                SchemaVectors.ZONES_THRESHOLDS_ZONE2,
+                SchemaVectors.ZONES_THRESHOLDS_ZONE3,
+                SchemaVectors.ZONES_THRESHOLDS_ZONE4,
+                SchemaVectors.ZONES_THRESHOLDS_ZONE5
+            )
+        )
+        assertContentEquals(SchemaVectors.ZONES_THRESHOLDS, config.encode())
+    }
+    
+    @Test
+    fun zoneConfigEncodesMaxHeartRateVector() {
+        val config = ZoneConfigFrame(maxHeartRate = SchemaVectors.ZONES_MAX_HR_MAX_HR)
+        assertContentEquals(SchemaVectors.ZONES_MAX_HR, config.encode())
+    }
+    
+    @Test
+    fun hrMinutesDecodesVectorSkippingEmptyMinutes() {
+        val frame = HRMinutesFrame.decode(SchemaVectors.HR_MINUTES_HOLE)
+        val expected = SchemaVectors.HR_MINUTES_HOLE_BPM.mapIndexedNotNull { index, bpm ->
+            if (bpm == 0) null else HRMinutesFrame.Minute(SchemaVectors.HR_MINUTES_HOLE_BASE_TIME + index * 60L, bpm)
+        }
+        assertEquals(expected, frame?.minutes)
+    }
+    
+    @Test
+    fun hrMinutesRejectsTruncatedPayload() {
+        val truncated = SchemaVectors.HR_MINUTES_HOLE.copyOf(SchemaVectors.HR_MINUTES_HOLE.size - 1)
+        assertNull(HRMinutesFrame.decode(truncated))
+    }
+    
+    @Test
+    fun hrSummaryDecodesVector() {
+        val summary = HRSummaryFrame.decode(SchemaVectors.HR_SUMMARY_HOUR)
+        assertEquals(
+            HRSummaryFrame(
+                seconds = SchemaVectors.HR_SUMMARY_HOUR_SECONDS.toLong(),
+                averageHeartRate = SchemaVectors.HR_SUMMARY_HOUR_AVG,
+                minHeartRate = SchemaVectors.HR_SUMMARY_HOUR_MIN,
+                maxHeartRate = SchemaVectors.HR_SUMMARY_HOUR_MAX,
+                zoneSeconds = listOf(
+                    SchemaVectors.HR_SUMMARY_HOUR_ZONE1,
+                    SchemaVectors.HR_SUMMARY_HOUR_ZONE2,
+                    SchemaVectors.HR_SUMMARY_HOUR_ZONE3,
+                    SchemaVectors.HR_SUMMARY_HOUR_ZONE4,
+                    SchemaVectors.HR_SUMMARY_HOUR_ZONE5
+                ).map { it.toLong() }
+            ),
+            summary
+        )
+        assertEquals(summary?.seconds, summary?.zoneSeconds?.sum())
+    }
+    
+    @Test
+    fun hrRecordDecodesVector() {
+        assertEquals(
+            HRRecord(
+                epochSeconds = SchemaVectors.HR_RECORD_GOOD_TIME.toLong(),
+                heartRate = SchemaVectors.HR_RECORD_GOOD_BPM,
+                quality = SchemaVectors.HR_RECORD_GOOD_QUALITY
+            ),
+            HRRecord.decode(SchemaVectors.HR_RECORD_GOOD)
+        )
+        assertNull(HRRecord.decode(SchemaVectors.HR_RECORD_GOOD.copyOf(PebbleMessageKeys.HR_RECORD_SIZE - 1)))
+    }
+    
+    @Test
+    fun perfDecodesVector() {
+        val perf = PerfFrame.decode(SchemaVectors.PERF_HOUR)
+        assertEquals(
+            PerfFrame(
+                uptimeSeconds = SchemaVectors.PERF_HOUR_UPTIME.toLong(),
+                heapPeakBytes = SchemaVectors.PERF_HOUR_HEAP_PEAK,
+                failedTimeout = SchemaVectors.PERF_HOUR_FAIL_TIMEOUT,
+                failedNack = SchemaVectors.PERF_HOUR_FAIL_NACK,
+                failedOffline = SchemaVectors.PERF_HOUR_FAIL_OFFLINE,
+                failedOther = SchemaVectors.PERF_HOUR_FAIL_OTHER,
+                sniffReducedSeconds = SchemaVectors.PERF_HOUR_SNIFF_REDUCED,
+                probes = listOf(
+                    PerfFrame.Probe(
+                        id = SchemaVectors.PERF_HOUR_PROBE0_ID,
+                        calls = SchemaVectors.PERF_HOUR_PROBE0_CALLS.toLong(),
+                        totalMillis = SchemaVectors.PERF_HOUR_PROBE0_TOTAL_MS.toLong(),
+                        maxMillis = SchemaVectors.PERF_HOUR_PROBE0_MAX_MS,
+                        buckets = listOf(
+                            SchemaVectors.PERF_HOUR_PROBE0_UNDER_2MS,
+                            SchemaVectors.PERF_HOUR_PROBE0_UNDER_8MS,
+                            SchemaVectors.PERF_HOUR_PROBE0_UNDER_32MS,
+                            SchemaVectors.PERF_HOUR_PROBE0_OVER_32MS
+                        )
+                    ),
+                    PerfFrame.Probe(
+                        id = SchemaVectors.PERF_HOUR_PROBE1_ID,
+                        calls = SchemaVectors.PERF_HOUR_PROBE1_CALLS.toLong(),
+                        totalMillis = SchemaVectors.PERF_HOUR_PROBE1_TOTAL_MS.toLong(),
+                        maxMillis = SchemaVectors.PERF_HOUR_PROBE1_MAX_MS,
+                        buckets = listOf(
+                            SchemaVectors.PERF_HOUR_PROBE1_UNDER_2MS,
+                            SchemaVectors.PERF_HOUR_PROBE1_UNDER_8MS,
+                            SchemaVectors.PERF_HOUR_PROBE1_UNDER_32MS,
+                            SchemaVectors.PERF_HOUR_PROBE1_OVER_32MS
+                        )
+                    )
+                )
+            ),
+            perf
+        )
+        assertEquals(
+            (SchemaVectors.PERF_HOUR_UPTIME - SchemaVectors.PERF_HOUR_SNIFF_REDUCED).toLong(),
+            perf?.sniffNormalSeconds
+        )
+        assertNull(PerfFrame.decode(SchemaVectors.PERF_HOUR.copyOf(SchemaVectors.PERF_HOUR.size - 1)))
+    }
+    
+    @Test
+    fun helloDecodesVector() {
+        val hello = HelloFrame.decode(SchemaVectors.HELLO_DEFAULT)
+        assertEquals(
+            HelloFrame(
+                protocolVersion = SchemaVectors.HELLO_DEFAULT_PROTOCOL,
+                maxValueBytes = SchemaVectors.HELLO_DEFAULT_MAX_VALUE,
+                inboxBytes = SchemaVectors.HELLO_DEFAULT_INBOX
+            ),
+            hello
+        )
+        assertEquals(true, hello?.isCompatible)
+    }
+}